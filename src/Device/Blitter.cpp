@@ -24,6 +24,10 @@
 #include "Vulkan/VkImage.hpp"
 #include "Vulkan/VkImageView.hpp"
 
+#include "marl/defer.h"
+#include "marl/scheduler.h"
+#include "marl/waitgroup.h"
+
 #include <utility>
 
 #if defined(__i386__) || defined(__x86_64__)
@@ -64,21 +68,7 @@ void Blitter::clear(void *pixel, vk::Format format, vk::Image *dest, const vk::F
 		return;
 	}
 
-	float *pPixel = static_cast<float *>(pixel);
-	if(viewFormat.isUnsignedNormalized() || viewFormat.isSRGBformat())
-	{
-		pPixel[0] = sw::clamp(pPixel[0], 0.0f, 1.0f);
-		pPixel[1] = sw::clamp(pPixel[1], 0.0f, 1.0f);
-		pPixel[2] = sw::clamp(pPixel[2], 0.0f, 1.0f);
-		pPixel[3] = sw::clamp(pPixel[3], 0.0f, 1.0f);
-	}
-	else if(viewFormat.isSignedNormalized())
-	{
-		pPixel[0] = sw::clamp(pPixel[0], -1.0f, 1.0f);
-		pPixel[1] = sw::clamp(pPixel[1], -1.0f, 1.0f);
-		pPixel[2] = sw::clamp(pPixel[2], -1.0f, 1.0f);
-		pPixel[3] = sw::clamp(pPixel[3], -1.0f, 1.0f);
-	}
+	clampClearValue(pixel, viewFormat);
 
 	if(fastClear(pixel, format, dest, dstFormat, subresourceRange, renderArea))
 	{
@@ -120,10 +110,12 @@ void Blitter::clear(void *pixel, vk::Format format, vk::Image *dest, const vk::F
 		BlitData data = {
 			pixel, nullptr,  // source, dest
 
-			format.bytes(),                                  // sPitchB
-			dest->rowPitchBytes(aspect, subres.mipLevel),    // dPitchB
-			0,                                               // sSliceB (unused in clear operations)
-			dest->slicePitchBytes(aspect, subres.mipLevel),  // dSliceB
+			format.bytes(),                                   // sPitchB
+			dest->rowPitchBytes(aspect, subres.mipLevel),     // dPitchB
+			0,                                                // sSliceB (unused in clear operations)
+			dest->slicePitchBytes(aspect, subres.mipLevel),   // dSliceB
+			0,                                                // sSamplePitchB (unused in clear operations)
+			dest->samplePitchBytes(aspect, subres.mipLevel),  // dSamplePitchB
 
 			0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 0.0f,  // x0, y0, z0, w, h, d
 
@@ -162,6 +154,66 @@ void Blitter::clear(void *pixel, vk::Format format, vk::Image *dest, const vk::F
 	dest->contentsChanged(subresourceRange);
 }
 
+void Blitter::packClearValue(const void *clearValue, vk::Format clearFormat, const vk::Format &viewFormat, VkImageAspectFlagBits aspect, void *texel)
+{
+	vk::Format dstFormat = viewFormat.getAspectFormat(aspect);
+	ASSERT(dstFormat != VK_FORMAT_UNDEFINED);
+
+	// Clamping is done in place, so it's applied to a copy
+	float pixel[4] = {};
+	memcpy(pixel, clearValue, clearFormat.bytes());
+	clampClearValue(pixel, viewFormat);
+
+	State state(clearFormat, dstFormat, 1, VK_SAMPLE_COUNT_1_BIT, Options{ 0xF });
+	auto blitRoutine = getBlitRoutine(state);
+	if(!blitRoutine)
+	{
+		return;
+	}
+
+	BlitData data = {
+		pixel, texel,  // source, dest
+
+		clearFormat.bytes(),  // sPitchB
+		dstFormat.bytes(),    // dPitchB
+		0,                    // sSliceB (unused in clear operations)
+		dstFormat.bytes(),    // dSliceB
+		0,                    // sSamplePitchB (unused in clear operations)
+		0,                    // dSamplePitchB
+
+		0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 0.0f,  // x0, y0, z0, w, h, d
+
+		0, 1,  // x0d, x1d
+		0, 1,  // y0d, y1d
+		0, 1,  // z0d, z1d
+
+		0, 0, 0,  // sWidth, sHeight, sDepth
+
+		false,  // filter3D
+	};
+
+	blitRoutine(&data);
+}
+
+void Blitter::clampClearValue(void *clearValue, const vk::Format &viewFormat)
+{
+	float *pPixel = static_cast<float *>(clearValue);
+	if(viewFormat.isUnsignedNormalized() || viewFormat.isSRGBformat())
+	{
+		pPixel[0] = sw::clamp(pPixel[0], 0.0f, 1.0f);
+		pPixel[1] = sw::clamp(pPixel[1], 0.0f, 1.0f);
+		pPixel[2] = sw::clamp(pPixel[2], 0.0f, 1.0f);
+		pPixel[3] = sw::clamp(pPixel[3], 0.0f, 1.0f);
+	}
+	else if(viewFormat.isSignedNormalized())
+	{
+		pPixel[0] = sw::clamp(pPixel[0], -1.0f, 1.0f);
+		pPixel[1] = sw::clamp(pPixel[1], -1.0f, 1.0f);
+		pPixel[2] = sw::clamp(pPixel[2], -1.0f, 1.0f);
+		pPixel[3] = sw::clamp(pPixel[3], -1.0f, 1.0f);
+	}
+}
+
 bool Blitter::fastClear(void *clearValue, vk::Format clearFormat, vk::Image *dest, const vk::Format &viewFormat, const VkImageSubresourceRange &subresourceRange, const VkRect2D *renderArea)
 {
 	if(clearFormat != VK_FORMAT_R32G32B32A32_SFLOAT &&
@@ -256,7 +308,7 @@ bool Blitter::fastClear(void *clearValue, vk::Format clearFormat, vk::Image *des
 	for(; subres.mipLevel <= lastMipLevel; subres.mipLevel++)
 	{
 		int rowPitchBytes = dest->rowPitchBytes(aspect, subres.mipLevel);
-		int slicePitchBytes = dest->slicePitchBytes(aspect, subres.mipLevel);
+		int samplePitchBytes = dest->samplePitchBytes(aspect, subres.mipLevel);
 		VkExtent3D extent = dest->getMipLevelExtent(aspect, subres.mipLevel);
 		if(!renderArea)
 		{
@@ -309,7 +361,7 @@ bool Blitter::fastClear(void *clearValue, vk::Format clearFormat, vk::Image *des
 							assert(false);
 					}
 
-					slice += slicePitchBytes;
+					slice += samplePitchBytes;
 				}
 			}
 		}
@@ -1427,7 +1479,7 @@ Float4 Blitter::sRGBtoLinear(const Float4 &c)
 
 Float4 Blitter::sample(Pointer<Byte> &source, Float &x, Float &y, Float &z,
                        Int &sWidth, Int &sHeight, Int &sDepth,
-                       Int &sSliceB, Int &sPitchB, const State &state)
+                       Int &sSliceB, Int &sPitchB, Int &sSamplePitchB, const State &state)
 {
 	bool intSrc = state.sourceFormat.isUnnormalizedInteger();
 	int srcBytes = state.sourceFormat.bytes();
@@ -1462,7 +1514,7 @@ Float4 Blitter::sample(Pointer<Byte> &source, Float &x, Float &y, Float &z,
 			Float4 accum = color;
 			for(int sample = 1; sample < state.srcSamples; sample++)
 			{
-				s += sSliceB;
+				s += sSamplePitchB;
 				color = readFloat4(s, state);
 
 				if(state.allowSRGBConversion && state.sourceFormat.isSRGBformat())  // sRGB -> RGB
@@ -1599,6 +1651,8 @@ Blitter::BlitRoutineType Blitter::generate(const State &state)
 		Int dPitchB = *Pointer<Int>(blit + OFFSET(BlitData, dPitchB));
 		Int sSliceB = *Pointer<Int>(blit + OFFSET(BlitData, sSliceB));
 		Int dSliceB = *Pointer<Int>(blit + OFFSET(BlitData, dSliceB));
+		Int sSamplePitchB = *Pointer<Int>(blit + OFFSET(BlitData, sSamplePitchB));
+		Int dSamplePitchB = *Pointer<Int>(blit + OFFSET(BlitData, dSamplePitchB));
 
 		Float x0 = *Pointer<Float>(blit + OFFSET(BlitData, x0));
 		Float y0 = *Pointer<Float>(blit + OFFSET(BlitData, y0));
@@ -1665,7 +1719,7 @@ Blitter::BlitRoutineType Blitter::generate(const State &state)
 						{
 							write(constantColorI, d, state);
 
-							d += dSliceB;
+							d += dSamplePitchB;
 						}
 					}
 					else if(hasConstantColorF)
@@ -1674,7 +1728,7 @@ Blitter::BlitRoutineType Blitter::generate(const State &state)
 						{
 							write(constantColorF, d, state);
 
-							d += dSliceB;
+							d += dSamplePitchB;
 						}
 					}
 					else if(intBoth)  // Integer types do not support filtering
@@ -1698,18 +1752,18 @@ Blitter::BlitRoutineType Blitter::generate(const State &state)
 						{
 							write(color, d, state);
 
-							d += dSliceB;
+							d += dSamplePitchB;
 						}
 					}
 					else
 					{
-						Float4 color = sample(source, x, y, z, sWidth, sHeight, sDepth, sSliceB, sPitchB, state);
+						Float4 color = sample(source, x, y, z, sWidth, sHeight, sDepth, sSliceB, sPitchB, sSamplePitchB, state);
 
 						for(int s = 0; s < state.destSamples; s++)
 						{
 							write(color, d, state);
 
-							d += dSliceB;
+							d += dSamplePitchB;
 						}
 					}
 				}
@@ -1817,12 +1871,14 @@ void Blitter::blit(const vk::Image *src, vk::Image *dst, VkImageBlit region, VkF
 	}
 
 	BlitData data = {
-		nullptr,                                                          // source
-		nullptr,                                                          // dest
-		src->rowPitchBytes(srcAspect, region.srcSubresource.mipLevel),    // sPitchB
-		dst->rowPitchBytes(dstAspect, region.dstSubresource.mipLevel),    // dPitchB
-		src->slicePitchBytes(srcAspect, region.srcSubresource.mipLevel),  // sSliceB
-		dst->slicePitchBytes(dstAspect, region.dstSubresource.mipLevel),  // dSliceB
+		nullptr,                                                           // source
+		nullptr,                                                           // dest
+		src->rowPitchBytes(srcAspect, region.srcSubresource.mipLevel),     // sPitchB
+		dst->rowPitchBytes(dstAspect, region.dstSubresource.mipLevel),     // dPitchB
+		src->slicePitchBytes(srcAspect, region.srcSubresource.mipLevel),   // sSliceB
+		dst->slicePitchBytes(dstAspect, region.dstSubresource.mipLevel),   // dSliceB
+		src->samplePitchBytes(srcAspect, region.srcSubresource.mipLevel),  // sSamplePitchB
+		dst->samplePitchBytes(dstAspect, region.dstSubresource.mipLevel),  // dSamplePitchB
 
 		x0,
 		y0,
@@ -1867,6 +1923,17 @@ void Blitter::blit(const vk::Image *src, vk::Image *dst, VkImageBlit region, VkF
 
 	uint32_t lastLayer = src->getLastLayerIndex(dstSubresRange);
 
+	// Large blits, like the upper levels of a mipmap chain, are split into bands of rows
+	// which are processed in parallel. The source coordinates of each row only depend on
+	// its destination row, so the result is the same as blitting the region in one pass.
+	constexpr int maxBandCount = 16;
+	constexpr int minTexelsPerBand = 16384;
+	int texelsPerRow = (region.dstOffsets[1].x - region.dstOffsets[0].x) * (region.dstOffsets[1].z - region.dstOffsets[0].z);
+	int rowCount = region.dstOffsets[1].y - region.dstOffsets[0].y;
+	int rowsPerBand = std::max(std::max((rowCount + maxBandCount - 1) / maxBandCount, minTexelsPerBand / std::max(texelsPerRow, 1)), 1);
+
+	marl::WaitGroup wg;
+
 	for(; dstSubres.arrayLayer <= lastLayer; srcSubres.arrayLayer++, dstSubres.arrayLayer++)
 	{
 		data.source = src->getTexelPointer({ 0, 0, 0 }, srcSubres);
@@ -1875,10 +1942,32 @@ void Blitter::blit(const vk::Image *src, vk::Image *dst, VkImageBlit region, VkF
 		ASSERT(data.source < src->end());
 		ASSERT(data.dest < dst->end());
 
-		blitRoutine(&data);
+		if(rowsPerBand >= rowCount)
+		{
+			blitRoutine(&data);
+			continue;
+		}
+
+		for(int y = region.dstOffsets[0].y; y < region.dstOffsets[1].y; y += rowsPerBand)
+		{
+			BlitData band = data;
+			band.y0d = y;
+			band.y1d = std::min(y + rowsPerBand, region.dstOffsets[1].y);
+
+			wg.add(1);
+			marl::schedule([=] {
+				defer(wg.done());
+				blitRoutine(&band);
+			});
+		}
 	}
 
-	dst->contentsChanged(dstSubresRange);
+	wg.wait();
+
+	dst->contentsChanged(region.dstSubresource, region.dstOffsets[0],
+	                     { static_cast<uint32_t>(region.dstOffsets[1].x - region.dstOffsets[0].x),
+	                       static_cast<uint32_t>(region.dstOffsets[1].y - region.dstOffsets[0].y),
+	                       static_cast<uint32_t>(region.dstOffsets[1].z - region.dstOffsets[0].z) });
 }
 
 static void resolveDepth(const vk::ImageView *src, vk::ImageView *dst, const VkSubpassDescriptionDepthStencilResolve &dsrDesc)
@@ -1893,8 +1982,9 @@ static void resolveDepth(const vk::ImageView *src, vk::ImageView *dst, const VkS
 	int width = extent.width;
 	int height = extent.height;
 	int pitch = src->rowPitchBytes(VK_IMAGE_ASPECT_DEPTH_BIT, 0);
+	int dstPitch = dst->rowPitchBytes(VK_IMAGE_ASPECT_DEPTH_BIT, 0);
 
-	// To support other resolve modes, get the slice bytes and get a pointer to each sample plane.
+	// To support other resolve modes, get the sample pitch bytes and get a pointer to each sample's row.
 	// Then modify the loop below to include logic for handling each new mode.
 	uint8_t *source = (uint8_t *)src->getOffsetPointer({ 0, 0, 0 }, VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0);
 	uint8_t *dest = (uint8_t *)dst->getOffsetPointer({ 0, 0, 0 }, VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0);
@@ -1907,7 +1997,7 @@ static void resolveDepth(const vk::ImageView *src, vk::ImageView *dst, const VkS
 		memcpy(dest, source, formatSize * width);
 
 		source += pitch;
-		dest += pitch;
+		dest += dstPitch;
 	}
 
 	dst->contentsChanged();
@@ -1924,8 +2014,9 @@ static void resolveStencil(const vk::ImageView *src, vk::ImageView *dst, const V
 	int width = extent.width;
 	int height = extent.height;
 	int pitch = src->rowPitchBytes(VK_IMAGE_ASPECT_STENCIL_BIT, 0);
+	int dstPitch = dst->rowPitchBytes(VK_IMAGE_ASPECT_STENCIL_BIT, 0);
 
-	// To support other resolve modes, use src->slicePitchBytes() and get a pointer to each sample's slice.
+	// To support other resolve modes, use src->samplePitchBytes() and get a pointer to each sample's row.
 	// Then modify the loop below to include logic for handling each new mode.
 	uint8_t *source = reinterpret_cast<uint8_t *>(src->getOffsetPointer({ 0, 0, 0 }, VK_IMAGE_ASPECT_STENCIL_BIT, 0, 0));
 	uint8_t *dest = reinterpret_cast<uint8_t *>(dst->getOffsetPointer({ 0, 0, 0 }, VK_IMAGE_ASPECT_STENCIL_BIT, 0, 0));
@@ -1939,7 +2030,7 @@ static void resolveStencil(const vk::ImageView *src, vk::ImageView *dst, const V
 		memcpy(dest, source, width);
 
 		source += pitch;
-		dest += pitch;
+		dest += dstPitch;
 	}
 
 	dst->contentsChanged();
@@ -2059,12 +2150,14 @@ bool Blitter::fastResolve(const vk::Image *src, vk::Image *dst, VkImageResolve r
 	int width = extent.width;
 	int height = extent.height;
 	int pitch = src->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, region.srcSubresource.mipLevel);
-	int slice = src->slicePitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, region.srcSubresource.mipLevel);
+	int dstPitch = dst->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, region.dstSubresource.mipLevel);
+	int samplePitch = src->samplePitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, region.srcSubresource.mipLevel);
 
+	// The samples of each row are in consecutive rows of memory
 	uint8_t *source0 = (uint8_t *)source;
-	uint8_t *source1 = source0 + slice;
-	uint8_t *source2 = source1 + slice;
-	uint8_t *source3 = source2 + slice;
+	uint8_t *source1 = source0 + samplePitch;
+	uint8_t *source2 = source1 + samplePitch;
+	uint8_t *source3 = source2 + samplePitch;
 
 	[[maybe_unused]] const bool SSE2 = CPUID::supportsSSE2();
 
@@ -2113,7 +2206,7 @@ bool Blitter::fastResolve(const vk::Image *src, vk::Image *dst, VkImageResolve r
 				source1 += pitch;
 				source2 += pitch;
 				source3 += pitch;
-				dest += pitch;
+				dest += dstPitch;
 
 				ASSERT(source0 < src->end());
 				ASSERT(source3 < src->end());
@@ -2200,7 +2293,7 @@ Blitter::CornerUpdateRoutineType Blitter::generateCornerUpdate(const State &stat
 	return function("BlitRoutine");
 }
 
-void Blitter::updateBorders(vk::Image *image, const VkImageSubresource &subresource)
+void Blitter::updateBorders(vk::Image *image, const VkImageSubresource &subresource, const std::array<VkRect2D, 6> &changedRegions)
 {
 	ASSERT(image->getArrayLayers() >= (subresource.arrayLayer + 6));
 
@@ -2219,38 +2312,64 @@ void Blitter::updateBorders(vk::Image *image, const VkImageSubresource &subresou
 	VkImageSubresource negZ = posZ;
 	negZ.arrayLayer++;
 
+	VkImageAspectFlagBits aspect = static_cast<VkImageAspectFlagBits>(subresource.aspectMask);
+	VkExtent3D extent = image->getMipLevelExtent(aspect, subresource.mipLevel);
+
+	// Only edges touched by the changed region of their source face need to be copied.
+	auto copyChangedEdge = [&](const VkImageSubresource &dstSubresource, Edge dstEdge,
+	                           const VkImageSubresource &srcSubresource, Edge srcEdge) {
+		const VkRect2D &region = changedRegions[srcSubresource.arrayLayer - subresource.arrayLayer];
+		if((region.extent.width == 0) || (region.extent.height == 0))
+		{
+			return;
+		}
+
+		bool touchesEdge = false;
+		switch(srcEdge)
+		{
+			case TOP: touchesEdge = (region.offset.y == 0); break;
+			case BOTTOM: touchesEdge = (region.offset.y + region.extent.height >= extent.height); break;
+			case RIGHT: touchesEdge = (region.offset.x + region.extent.width >= extent.width); break;
+			case LEFT: touchesEdge = (region.offset.x == 0); break;
+		}
+
+		if(touchesEdge)
+		{
+			copyCubeEdge(image, dstSubresource, dstEdge, srcSubresource, srcEdge);
+		}
+	};
+
 	// Copy top / bottom
-	copyCubeEdge(image, posX, BOTTOM, negY, RIGHT);
-	copyCubeEdge(image, posY, BOTTOM, posZ, TOP);
-	copyCubeEdge(image, posZ, BOTTOM, negY, TOP);
-	copyCubeEdge(image, negX, BOTTOM, negY, LEFT);
-	copyCubeEdge(image, negY, BOTTOM, negZ, BOTTOM);
-	copyCubeEdge(image, negZ, BOTTOM, negY, BOTTOM);
-
-	copyCubeEdge(image, posX, TOP, posY, RIGHT);
-	copyCubeEdge(image, posY, TOP, negZ, TOP);
-	copyCubeEdge(image, posZ, TOP, posY, BOTTOM);
-	copyCubeEdge(image, negX, TOP, posY, LEFT);
-	copyCubeEdge(image, negY, TOP, posZ, BOTTOM);
-	copyCubeEdge(image, negZ, TOP, posY, TOP);
+	copyChangedEdge(posX, BOTTOM, negY, RIGHT);
+	copyChangedEdge(posY, BOTTOM, posZ, TOP);
+	copyChangedEdge(posZ, BOTTOM, negY, TOP);
+	copyChangedEdge(negX, BOTTOM, negY, LEFT);
+	copyChangedEdge(negY, BOTTOM, negZ, BOTTOM);
+	copyChangedEdge(negZ, BOTTOM, negY, BOTTOM);
+
+	copyChangedEdge(posX, TOP, posY, RIGHT);
+	copyChangedEdge(posY, TOP, negZ, TOP);
+	copyChangedEdge(posZ, TOP, posY, BOTTOM);
+	copyChangedEdge(negX, TOP, posY, LEFT);
+	copyChangedEdge(negY, TOP, posZ, BOTTOM);
+	copyChangedEdge(negZ, TOP, posY, TOP);
 
 	// Copy left / right
-	copyCubeEdge(image, posX, RIGHT, negZ, LEFT);
-	copyCubeEdge(image, posY, RIGHT, posX, TOP);
-	copyCubeEdge(image, posZ, RIGHT, posX, LEFT);
-	copyCubeEdge(image, negX, RIGHT, posZ, LEFT);
-	copyCubeEdge(image, negY, RIGHT, posX, BOTTOM);
-	copyCubeEdge(image, negZ, RIGHT, negX, LEFT);
-
-	copyCubeEdge(image, posX, LEFT, posZ, RIGHT);
-	copyCubeEdge(image, posY, LEFT, negX, TOP);
-	copyCubeEdge(image, posZ, LEFT, negX, RIGHT);
-	copyCubeEdge(image, negX, LEFT, negZ, RIGHT);
-	copyCubeEdge(image, negY, LEFT, negX, BOTTOM);
-	copyCubeEdge(image, negZ, LEFT, posX, RIGHT);
+	copyChangedEdge(posX, RIGHT, negZ, LEFT);
+	copyChangedEdge(posY, RIGHT, posX, TOP);
+	copyChangedEdge(posZ, RIGHT, posX, LEFT);
+	copyChangedEdge(negX, RIGHT, posZ, LEFT);
+	copyChangedEdge(negY, RIGHT, posX, BOTTOM);
+	copyChangedEdge(negZ, RIGHT, negX, LEFT);
+
+	copyChangedEdge(posX, LEFT, posZ, RIGHT);
+	copyChangedEdge(posY, LEFT, negX, TOP);
+	copyChangedEdge(posZ, LEFT, negX, RIGHT);
+	copyChangedEdge(negX, LEFT, negZ, RIGHT);
+	copyChangedEdge(negY, LEFT, negX, BOTTOM);
+	copyChangedEdge(negZ, LEFT, posX, RIGHT);
 
 	// Compute corner colors
-	VkImageAspectFlagBits aspect = static_cast<VkImageAspectFlagBits>(subresource.aspectMask);
 	vk::Format format = image->getFormat(aspect);
 	VkSampleCountFlagBits samples = image->getSampleCountFlagBits();
 	State state(format, format, samples, samples, Options{ 0xF });
@@ -2265,7 +2384,6 @@ void Blitter::updateBorders(vk::Image *image, const VkImageSubresource &subresou
 		return;
 	}
 
-	VkExtent3D extent = image->getMipLevelExtent(aspect, subresource.mipLevel);
 	CubeBorderData data = {
 		image->getTexelPointer({ 0, 0, 0 }, posX),
 		image->rowPitchBytes(aspect, subresource.mipLevel),
@@ -23,6 +23,7 @@
 #include "marl/mutex.h"
 #include "marl/tsa.h"
 
+#include <array>
 #include <cstring>
 
 namespace vk {
@@ -108,6 +109,8 @@ class Blitter
 		int dPitchB;
 		int sSliceB;
 		int dSliceB;
+		int sSamplePitchB;
+		int dSamplePitchB;
 
 		float x0;
 		float y0;
@@ -143,13 +146,15 @@ public:
 	virtual ~Blitter();
 
 	void clear(void *clearValue, vk::Format clearFormat, vk::Image *dest, const vk::Format &viewFormat, const VkImageSubresourceRange &subresourceRange, const VkRect2D *renderArea = nullptr);
+	// Converts a clear value into the texel which clear() writes to the view format's aspect.
+	void packClearValue(const void *clearValue, vk::Format clearFormat, const vk::Format &viewFormat, VkImageAspectFlagBits aspect, void *texel);
 
 	void blit(const vk::Image *src, vk::Image *dst, VkImageBlit region, VkFilter filter);
 	void resolve(const vk::Image *src, vk::Image *dst, VkImageResolve region);
 	void resolveDepthStencil(const vk::ImageView *src, vk::ImageView *dst, const VkSubpassDescriptionDepthStencilResolve &dsrDesc);
 	void copy(const vk::Image *src, uint8_t *dst, unsigned int dstPitch);
 
-	void updateBorders(vk::Image *image, const VkImageSubresource &subresource);
+	void updateBorders(vk::Image *image, const VkImageSubresource &subresource, const std::array<VkRect2D, 6> &changedRegions);
 
 private:
 	enum Edge
@@ -160,6 +165,7 @@ private:
 		LEFT
 	};
 
+	static void clampClearValue(void *clearValue, const vk::Format &viewFormat);
 	bool fastClear(void *clearValue, vk::Format clearFormat, vk::Image *dest, const vk::Format &viewFormat, const VkImageSubresourceRange &subresourceRange, const VkRect2D *renderArea);
 	bool fastResolve(const vk::Image *src, vk::Image *dst, VkImageResolve region);
 
@@ -179,7 +185,7 @@ private:
 	BlitRoutineType generate(const State &state);
 	Float4 sample(Pointer<Byte> &source, Float &x, Float &y, Float &z,
 	              Int &sWidth, Int &sHeight, Int &sDepth,
-	              Int &sSliceB, Int &sPitchB, const State &state);
+	              Int &sSliceB, Int &sPitchB, Int &sSamplePitchB, const State &state);
 
 	using CornerUpdateFunction = FunctionT<void(const CubeBorderData *)>;
 	using CornerUpdateRoutineType = CornerUpdateFunction::RoutineType;
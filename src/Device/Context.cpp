@@ -19,6 +19,12 @@
 #include "Vulkan/VkRenderPass.hpp"
 #include "Vulkan/VkStringify.hpp"
 
+#if defined(__i386__) || defined(__x86_64__)
+#	include <emmintrin.h>
+#elif defined(__aarch64__)
+#	include <arm_neon.h>
+#endif
+
 namespace {
 
 uint32_t ComputePrimitiveCount(VkPrimitiveTopology topology, uint32_t vertexCount)
@@ -44,48 +50,89 @@ uint32_t ComputePrimitiveCount(VkPrimitiveTopology topology, uint32_t vertexCoun
 	return 0;
 }
 
+// Returns true if any of the 16 bytes of indices starting at |indices| is
+// the restart index.
+#if defined(__i386__) || defined(__x86_64__)
+bool HasRestartIndex(const uint16_t *indices)
+{
+	__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(indices));
+	return _mm_movemask_epi8(_mm_cmpeq_epi16(v, _mm_set1_epi16(-1))) != 0;
+}
+
+bool HasRestartIndex(const uint32_t *indices)
+{
+	__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(indices));
+	return _mm_movemask_epi8(_mm_cmpeq_epi32(v, _mm_set1_epi32(-1))) != 0;
+}
+#elif defined(__aarch64__)
+bool HasRestartIndex(const uint16_t *indices)
+{
+	return vmaxvq_u16(vceqq_u16(vld1q_u16(indices), vdupq_n_u16(0xFFFF))) != 0;
+}
+
+bool HasRestartIndex(const uint32_t *indices)
+{
+	return vmaxvq_u32(vceqq_u32(vld1q_u32(indices), vdupq_n_u32(0xFFFFFFFF))) != 0;
+}
+#else
+template<typename T>
+bool HasRestartIndex(const T *indices)
+{
+	for(uint32_t i = 0; i < 16 / sizeof(T); i++)
+	{
+		if(indices[i] == static_cast<T>(-1))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+#endif
+
+// Returns the position of the first restart index at or after |i|, or |count|
+// if there is none. Blocks without a restart index are skipped 16 bytes at a
+// time, since restarts are rare compared to regular indices.
+template<typename T>
+uint32_t FindRestartIndex(const T *indexBuffer, uint32_t i, uint32_t count)
+{
+	static const T RestartIndex = static_cast<T>(-1);
+	constexpr uint32_t blockSize = 16 / sizeof(T);
+
+	while((i + blockSize <= count) && !HasRestartIndex(indexBuffer + i))
+	{
+		i += blockSize;
+	}
+
+	while((i < count) && (indexBuffer[i] != RestartIndex))
+	{
+		i++;
+	}
+
+	return i;
+}
+
 template<typename T>
 void ProcessPrimitiveRestart(T *indexBuffer,
                              VkPrimitiveTopology topology,
                              uint32_t count,
                              std::vector<std::pair<uint32_t, void *>> *indexBuffers)
 {
-	static const T RestartIndex = static_cast<T>(-1);
-	T *indexBufferStart = indexBuffer;
-	uint32_t vertexCount = 0;
-	for(uint32_t i = 0; i < count; i++)
+	for(uint32_t i = 0; i < count;)
 	{
-		if(indexBuffer[i] == RestartIndex)
+		// Record the segment up to the next restart index.
+		uint32_t end = FindRestartIndex(indexBuffer, i, count);
+		uint32_t vertexCount = end - i;
+		if(vertexCount > 0)
 		{
-			// Record previous segment
-			if(vertexCount > 0)
+			uint32_t primitiveCount = ComputePrimitiveCount(topology, vertexCount);
+			if(primitiveCount > 0)
 			{
-				uint32_t primitiveCount = ComputePrimitiveCount(topology, vertexCount);
-				if(primitiveCount > 0)
-				{
-					indexBuffers->push_back({ primitiveCount, indexBufferStart });
-				}
+				indexBuffers->push_back({ primitiveCount, indexBuffer + i });
 			}
-			vertexCount = 0;
 		}
-		else
-		{
-			if(vertexCount == 0)
-			{
-				indexBufferStart = indexBuffer + i;
-			}
-			vertexCount++;
-		}
-	}
 
-	// Record last segment
-	if(vertexCount > 0)
-	{
-		uint32_t primitiveCount = ComputePrimitiveCount(topology, vertexCount);
-		if(primitiveCount > 0)
-		{
-			indexBuffers->push_back({ primitiveCount, indexBufferStart });
-		}
+		i = end + 1;
 	}
 }
 
@@ -82,7 +82,7 @@ void PixelProcessor::setRoutineCacheSize(int cacheSize)
 	routineCache = std::make_unique<RoutineCacheType>(clamp(cacheSize, 1, 65536));
 }
 
-const PixelProcessor::State PixelProcessor::update(const vk::GraphicsState &pipelineState, const sw::SpirvShader *fragmentShader, const sw::SpirvShader *vertexShader, const vk::Attachments &attachments, bool occlusionEnabled) const
+const PixelProcessor::State PixelProcessor::update(const vk::GraphicsState &pipelineState, const sw::SpirvShader *fragmentShader, const sw::SpirvShader *vertexShader, const vk::Attachments &attachments, bool occlusionEnabled, bool statisticsEnabled) const
 {
 	State state;
 
@@ -124,6 +124,7 @@ const PixelProcessor::State PixelProcessor::update(const vk::GraphicsState &pipe
 	}
 
 	state.occlusionEnabled = occlusionEnabled;
+	state.statisticsEnabled = statisticsEnabled && (fragmentShader != nullptr);
 
 	bool fragmentContainsKill = (fragmentShader && fragmentShader->getModes().ContainsKill);
 	for(int i = 0; i < RENDERTARGETS; i++)
@@ -36,6 +36,7 @@ void QuadRasterizer::generate()
 {
 	constants = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData, constants));
 	occlusion = 0;
+	fragmentInvocations = 0;
 
 	Do
 	{
@@ -64,6 +65,13 @@ void QuadRasterizer::generate()
 		*Pointer<UInt>(data + OFFSET(DrawData, occlusion) + 4 * cluster) = clusterOcclusion;
 	}
 
+	if(state.statisticsEnabled)
+	{
+		UInt clusterInvocations = *Pointer<UInt>(data + OFFSET(DrawData, fragmentInvocations) + 4 * cluster);
+		clusterInvocations += fragmentInvocations;
+		*Pointer<UInt>(data + OFFSET(DrawData, fragmentInvocations) + 4 * cluster) = clusterInvocations;
+	}
+
 	Return();
 }
 
@@ -140,6 +148,11 @@ void QuadRasterizer::rasterize(Int &yMin, Int &yMax)
 
 		If(x0 < x1)
 		{
+			If(*Pointer<Int>(data + OFFSET(DrawData, hasClearTiles)) != 0)
+			{
+				Call(DrawCall::resolveClearTiles, data, y, x0, x1);
+			}
+
 			if(interpolateW())
 			{
 				Dw = *Pointer<Float4>(primitive + OFFSET(Primitive, w.C), 16) + yyyy * *Pointer<Float4>(primitive + OFFSET(Primitive, w.B), 16);
@@ -30,6 +30,7 @@
 #include "Vulkan/VkDescriptorSet.hpp"
 #include "Vulkan/VkDevice.hpp"
 #include "Vulkan/VkFence.hpp"
+#include "Vulkan/VkImage.hpp"
 #include "Vulkan/VkImageView.hpp"
 #include "Vulkan/VkPipelineLayout.hpp"
 #include "Vulkan/VkQueryPool.hpp"
@@ -38,6 +39,13 @@
 #include "marl/defer.h"
 #include "marl/trace.h"
 
+#if defined(__i386__) || defined(__x86_64__)
+#	include <xmmintrin.h>
+#	include <emmintrin.h>
+#elif defined(__aarch64__)
+#	include <arm_neon.h>
+#endif
+
 #undef max
 
 #ifndef NDEBUG
@@ -47,18 +55,332 @@ unsigned int maxPrimitives = 1 << 21;
 
 namespace sw {
 
+// Returns the number of vertices consumed by the input assembly stage for
+// primitiveCount primitives of the given topology.
+static uint64_t ComputeVertexCount(VkPrimitiveTopology topology, uint64_t primitiveCount)
+{
+	switch(topology)
+	{
+		case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+			return primitiveCount;
+		case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+			return primitiveCount * 2;
+		case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+			return primitiveCount + 1;
+		case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST:
+			return primitiveCount * 3;
+		case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP:
+		case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN:
+			return primitiveCount + 2;
+		default:
+			UNSUPPORTED("VkPrimitiveTopology %d", int(topology));
+	}
+
+	return 0;
+}
+
+struct LinearIndex
+{
+	unsigned int operator[](unsigned int i) { return i; }
+};
+
+// Four vertex indices, widened to 32-bit. The topologies handled below only
+// move indices around, so they're assembled four primitives at a time.
+#if defined(__i386__) || defined(__x86_64__)
+using Index4 = __m128i;
+
+inline Index4 load4(const uint16_t *indices, unsigned int i)
+{
+	return _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(indices + i)), _mm_setzero_si128());
+}
+
+inline Index4 load4(const uint32_t *indices, unsigned int i)
+{
+	return _mm_loadu_si128(reinterpret_cast<const __m128i *>(indices + i));
+}
+
+inline Index4 load4(LinearIndex, unsigned int i)
+{
+	return _mm_add_epi32(_mm_set1_epi32(i), _mm_setr_epi32(0, 1, 2, 3));
+}
+
+inline Index4 splat4(unsigned int index)
+{
+	return _mm_set1_epi32(index);
+}
+
+// Returns a mask of the lanes holding odd primitives, for a group starting at primitive |first|.
+inline Index4 oddLanes4(unsigned int first)
+{
+	return (first & 1) ? _mm_setr_epi32(-1, 0, -1, 0) : _mm_setr_epi32(0, -1, 0, -1);
+}
+
+inline Index4 select4(Index4 mask, Index4 a, Index4 b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// Returns the even and odd indices of eight consecutive indices.
+inline Index4 even4(Index4 lo, Index4 hi)
+{
+	return _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+inline Index4 odd4(Index4 lo, Index4 hi)
+{
+	return _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+inline void store4(unsigned int *out, Index4 index)
+{
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(out), index);
+}
+
+// Interleaves the vertex indices of four primitives into triples.
+inline void store4x3(unsigned int *out, Index4 v0, Index4 v1, Index4 v2)
+{
+	__m128 v01lo = _mm_castsi128_ps(_mm_unpacklo_epi32(v0, v1));  // v0.x v1.x v0.y v1.y
+	__m128 v01hi = _mm_castsi128_ps(_mm_unpackhi_epi32(v0, v1));  // v0.z v1.z v0.w v1.w
+	__m128 v12lo = _mm_castsi128_ps(_mm_unpacklo_epi32(v1, v2));  // v1.x v2.x v1.y v2.y
+	__m128 v12hi = _mm_castsi128_ps(_mm_unpackhi_epi32(v1, v2));  // v1.z v2.z v1.w v2.w
+	__m128 v20lo = _mm_castsi128_ps(_mm_unpacklo_epi32(v2, v0));  // v2.x v0.x v2.y v0.y
+	__m128 v20hi = _mm_castsi128_ps(_mm_unpackhi_epi32(v2, v0));  // v2.z v0.z v2.w v0.w
+
+	_mm_storeu_ps(reinterpret_cast<float *>(out + 0), _mm_shuffle_ps(v01lo, v20lo, _MM_SHUFFLE(3, 0, 1, 0)));
+	_mm_storeu_ps(reinterpret_cast<float *>(out + 4), _mm_shuffle_ps(v12lo, v01hi, _MM_SHUFFLE(1, 0, 3, 2)));
+	_mm_storeu_ps(reinterpret_cast<float *>(out + 8), _mm_shuffle_ps(v20hi, v12hi, _MM_SHUFFLE(3, 2, 3, 0)));
+}
+#elif defined(__aarch64__)
+using Index4 = uint32x4_t;
+
+inline Index4 load4(const uint16_t *indices, unsigned int i)
+{
+	return vmovl_u16(vld1_u16(indices + i));
+}
+
+inline Index4 load4(const uint32_t *indices, unsigned int i)
+{
+	return vld1q_u32(indices + i);
+}
+
+inline Index4 load4(LinearIndex, unsigned int i)
+{
+	static const uint32_t lanes[4] = { 0, 1, 2, 3 };
+	return vaddq_u32(vdupq_n_u32(i), vld1q_u32(lanes));
+}
+
+inline Index4 splat4(unsigned int index)
+{
+	return vdupq_n_u32(index);
+}
+
+// Returns a mask of the lanes holding odd primitives, for a group starting at primitive |first|.
+inline Index4 oddLanes4(unsigned int first)
+{
+	static const uint32_t masks[2][4] = { { 0, ~0u, 0, ~0u }, { ~0u, 0, ~0u, 0 } };
+	return vld1q_u32(masks[first & 1]);
+}
+
+inline Index4 select4(Index4 mask, Index4 a, Index4 b)
+{
+	return vbslq_u32(mask, a, b);
+}
+
+// Returns the even and odd indices of eight consecutive indices.
+inline Index4 even4(Index4 lo, Index4 hi)
+{
+	return vuzp1q_u32(lo, hi);
+}
+
+inline Index4 odd4(Index4 lo, Index4 hi)
+{
+	return vuzp2q_u32(lo, hi);
+}
+
+inline void store4(unsigned int *out, Index4 index)
+{
+	vst1q_u32(out, index);
+}
+
+// Interleaves the vertex indices of four primitives into triples.
+inline void store4x3(unsigned int *out, Index4 v0, Index4 v1, Index4 v2)
+{
+	vst3q_u32(out, uint32x4x3_t{ { v0, v1, v2 } });
+}
+#else
+struct Index4
+{
+	unsigned int lane[4];
+};
+
+template<typename T>
+inline Index4 load4(T indices, unsigned int i)
+{
+	return { { indices[i + 0], indices[i + 1], indices[i + 2], indices[i + 3] } };
+}
+
+inline Index4 splat4(unsigned int index)
+{
+	return { { index, index, index, index } };
+}
+
+// Returns a mask of the lanes holding odd primitives, for a group starting at primitive |first|.
+inline Index4 oddLanes4(unsigned int first)
+{
+	return (first & 1) ? Index4{ { ~0u, 0, ~0u, 0 } } : Index4{ { 0, ~0u, 0, ~0u } };
+}
+
+inline Index4 select4(Index4 mask, Index4 a, Index4 b)
+{
+	Index4 result;
+	for(int i = 0; i < 4; i++)
+	{
+		result.lane[i] = (mask.lane[i] & a.lane[i]) | (~mask.lane[i] & b.lane[i]);
+	}
+	return result;
+}
+
+// Returns the even and odd indices of eight consecutive indices.
+inline Index4 even4(Index4 lo, Index4 hi)
+{
+	return { { lo.lane[0], lo.lane[2], hi.lane[0], hi.lane[2] } };
+}
+
+inline Index4 odd4(Index4 lo, Index4 hi)
+{
+	return { { lo.lane[1], lo.lane[3], hi.lane[1], hi.lane[3] } };
+}
+
+inline void store4(unsigned int *out, Index4 index)
+{
+	for(int i = 0; i < 4; i++)
+	{
+		out[i] = index.lane[i];
+	}
+}
+
+// Interleaves the vertex indices of four primitives into triples.
+inline void store4x3(unsigned int *out, Index4 v0, Index4 v1, Index4 v2)
+{
+	for(int i = 0; i < 4; i++)
+	{
+		out[3 * i + 0] = v0.lane[i];
+		out[3 * i + 1] = v1.lane[i];
+		out[3 * i + 2] = v2.lane[i];
+	}
+}
+#endif
+
+// Assembles the vertex indices of the first multiple of four primitives, and
+// returns how many were assembled. The remainder is handled by setBatchIndices().
+template<typename T>
+inline unsigned int setBatchIndices4(unsigned int batch[128][3], VkPrimitiveTopology topology, bool provokeFirst, T indices, unsigned int start, unsigned int triangleCount)
+{
+	unsigned int count = triangleCount & ~3u;
+
+	switch(topology)
+	{
+		case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+		{
+			// Points are compacted to a single index each.
+			unsigned int *out = &batch[0][0];
+			for(unsigned int i = 0; i < count; i += 4)
+			{
+				store4(out + i, load4(indices, start + i));
+			}
+			break;
+		}
+		case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+			for(unsigned int i = 0; i < count; i += 4)
+			{
+				Index4 lo = load4(indices, 2 * (start + i));
+				Index4 hi = load4(indices, 2 * (start + i) + 4);
+				Index4 first = even4(lo, hi);
+				Index4 second = odd4(lo, hi);
+				store4x3(&batch[i][0], provokeFirst ? first : second, provokeFirst ? second : first, second);
+			}
+			break;
+		case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+			for(unsigned int i = 0; i < count; i += 4)
+			{
+				Index4 first = load4(indices, start + i);
+				Index4 second = load4(indices, start + i + 1);
+				store4x3(&batch[i][0], provokeFirst ? first : second, provokeFirst ? second : first, second);
+			}
+			break;
+		case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST:
+			if(!provokeFirst)
+			{
+				// Rotating each triple is left to setBatchIndices().
+				return 0;
+			}
+
+			// With the first vertex provoking, this is a straight copy.
+			for(unsigned int i = 0; i < 3 * count; i += 4)
+			{
+				store4(&batch[0][0] + i, load4(indices, 3 * start + i));
+			}
+			break;
+		case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP:
+		{
+			// Odd triangles swap their last two vertices to preserve the winding.
+			Index4 odd = oddLanes4(start);
+			for(unsigned int i = 0; i < count; i += 4)
+			{
+				Index4 v0 = load4(indices, start + i);
+				Index4 v1 = load4(indices, start + i + 1);
+				Index4 v2 = load4(indices, start + i + 2);
+				if(provokeFirst)
+				{
+					store4x3(&batch[i][0], v0, select4(odd, v2, v1), select4(odd, v1, v2));
+				}
+				else
+				{
+					store4x3(&batch[i][0], v2, select4(odd, v1, v0), select4(odd, v0, v1));
+				}
+			}
+			break;
+		}
+		case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN:
+		{
+			Index4 center = splat4(indices[0]);
+			for(unsigned int i = 0; i < count; i += 4)
+			{
+				Index4 v1 = load4(indices, start + i + 1);
+				Index4 v2 = load4(indices, start + i + 2);
+				if(provokeFirst)
+				{
+					store4x3(&batch[i][0], v1, v2, center);
+				}
+				else
+				{
+					store4x3(&batch[i][0], v2, center, v1);
+				}
+			}
+			break;
+		}
+		default:
+			return 0;
+	}
+
+	return count;
+}
+
 template<typename T>
 inline bool setBatchIndices(unsigned int batch[128][3], VkPrimitiveTopology topology, VkProvokingVertexModeEXT provokingVertexMode, T indices, unsigned int start, unsigned int triangleCount)
 {
 	bool provokeFirst = (provokingVertexMode == VK_PROVOKING_VERTEX_MODE_FIRST_VERTEX_EXT);
 
+	// Most primitives are assembled four at a time, which leaves at most three.
+	unsigned int first = setBatchIndices4(batch, topology, provokeFirst, indices, start, triangleCount);
+
 	switch(topology)
 	{
 		case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
 		{
-			auto index = start;
-			auto pointBatch = &(batch[0][0]);
-			for(unsigned int i = 0; i < triangleCount; i++)
+			auto index = start + first;
+			auto pointBatch = &(batch[0][0]) + first;
+			for(unsigned int i = first; i < triangleCount; i++)
 			{
 				*pointBatch++ = indices[index++];
 			}
@@ -73,8 +395,8 @@ inline bool setBatchIndices(unsigned int batch[128][3], VkPrimitiveTopology topo
 		}
 		case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
 		{
-			auto index = 2 * start;
-			for(unsigned int i = 0; i < triangleCount; i++)
+			auto index = 2 * (start + first);
+			for(unsigned int i = first; i < triangleCount; i++)
 			{
 				batch[i][0] = indices[index + (provokeFirst ? 0 : 1)];
 				batch[i][1] = indices[index + (provokeFirst ? 1 : 0)];
@@ -86,8 +408,8 @@ inline bool setBatchIndices(unsigned int batch[128][3], VkPrimitiveTopology topo
 		}
 		case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
 		{
-			auto index = start;
-			for(unsigned int i = 0; i < triangleCount; i++)
+			auto index = start + first;
+			for(unsigned int i = first; i < triangleCount; i++)
 			{
 				batch[i][0] = indices[index + (provokeFirst ? 0 : 1)];
 				batch[i][1] = indices[index + (provokeFirst ? 1 : 0)];
@@ -99,8 +421,8 @@ inline bool setBatchIndices(unsigned int batch[128][3], VkPrimitiveTopology topo
 		}
 		case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST:
 		{
-			auto index = 3 * start;
-			for(unsigned int i = 0; i < triangleCount; i++)
+			auto index = 3 * (start + first);
+			for(unsigned int i = first; i < triangleCount; i++)
 			{
 				batch[i][0] = indices[index + (provokeFirst ? 0 : 2)];
 				batch[i][1] = indices[index + (provokeFirst ? 1 : 0)];
@@ -112,8 +434,8 @@ inline bool setBatchIndices(unsigned int batch[128][3], VkPrimitiveTopology topo
 		}
 		case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP:
 		{
-			auto index = start;
-			for(unsigned int i = 0; i < triangleCount; i++)
+			auto index = start + first;
+			for(unsigned int i = first; i < triangleCount; i++)
 			{
 				batch[i][0] = indices[index + (provokeFirst ? 0 : 2)];
 				batch[i][1] = indices[index + ((start + i) & 1) + (provokeFirst ? 1 : 0)];
@@ -125,8 +447,8 @@ inline bool setBatchIndices(unsigned int batch[128][3], VkPrimitiveTopology topo
 		}
 		case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN:
 		{
-			auto index = start + 1;
-			for(unsigned int i = 0; i < triangleCount; i++)
+			auto index = start + first + 1;
+			for(unsigned int i = first; i < triangleCount; i++)
 			{
 				batch[i][provokeFirst ? 0 : 2] = indices[index + 0];
 				batch[i][provokeFirst ? 1 : 0] = indices[index + 1];
@@ -180,10 +502,16 @@ void Renderer::operator delete(void *mem)
 	vk::deallocate(mem, vk::DEVICE_MEMORY);
 }
 
-void Renderer::draw(const vk::GraphicsPipeline *pipeline, const vk::DynamicState &dynamicState, unsigned int count, int baseVertex,
-                    CountedEvent *events, int instanceID, int viewID, void *indexBuffer, const VkExtent3D &framebufferExtent,
+void Renderer::draw(const vk::GraphicsPipeline *pipeline, const vk::DynamicState &dynamicState, const DrawRange *ranges, unsigned int rangeCount,
+                    CountedEvent *events, int instanceID, int viewID, const VkExtent3D &framebufferExtent,
                     vk::Pipeline::PushConstantStorage const &pushConstants, bool update)
 {
+	unsigned int count = 0;
+	for(unsigned int i = 0; i < rangeCount; i++)
+	{
+		count += ranges[i].count;
+	}
+
 	if(count == 0) { return; }
 
 	auto id = nextDrawID++;
@@ -210,9 +538,12 @@ void Renderer::draw(const vk::GraphicsPipeline *pipeline, const vk::DynamicState
 
 		const vk::Attachments attachments = pipeline->getAttachments();
 
-		vertexState = vertexProcessor.update(pipelineState, vertexShader, inputs);
+		bool vertexStatistics = hasPipelineStatistic(VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT);
+		bool fragmentStatistics = hasPipelineStatistic(VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT);
+
+		vertexState = vertexProcessor.update(pipelineState, vertexShader, inputs, vertexStatistics);
 		setupState = setupProcessor.update(pipelineState, fragmentShader, vertexShader, attachments);
-		pixelState = pixelProcessor.update(pipelineState, fragmentShader, vertexShader, attachments, hasOcclusionQuery());
+		pixelState = pixelProcessor.update(pipelineState, fragmentShader, vertexShader, attachments, hasOcclusionQuery(), fragmentStatistics);
 
 		vertexRoutine = vertexProcessor.routine(vertexState, pipelineState.getPipelineLayout(), vertexShader, inputs.getDescriptorSets());
 		setupRoutine = setupProcessor.routine(setupState);
@@ -257,6 +588,10 @@ void Renderer::draw(const vk::GraphicsPipeline *pipeline, const vk::DynamicState
 	DrawData *data = draw->data;
 	draw->device = device;
 	draw->occlusionQuery = occlusionQuery;
+	draw->statisticsQuery = statisticsQuery;
+	draw->vertexInvocations = 0;
+	draw->clippingInvocations = 0;
+	draw->clippingPrimitives = 0;
 	draw->batchDataPool = &batchDataPool;
 	draw->numPrimitives = count;
 	draw->numPrimitivesPerBatch = numPrimitivesPerBatch;
@@ -268,6 +603,17 @@ void Renderer::draw(const vk::GraphicsPipeline *pipeline, const vk::DynamicState
 	draw->descriptorSetObjects = inputs.getDescriptorSetObjects();
 	draw->pipelineLayout = pipelineState.getPipelineLayout();
 
+	draw->ranges.clear();
+	for(unsigned int i = 0, firstPrimitive = 0; i < rangeCount; i++)
+	{
+		if(ranges[i].count > 0)
+		{
+			draw->ranges.push_back(ranges[i]);
+			draw->ranges.back().firstPrimitive = firstPrimitive;
+			firstPrimitive += ranges[i].count;
+		}
+	}
+
 	draw->vertexRoutine = vertexRoutine;
 	draw->setupRoutine = setupRoutine;
 	draw->pixelRoutine = pixelRoutine;
@@ -285,10 +631,8 @@ void Renderer::draw(const vk::GraphicsPipeline *pipeline, const vk::DynamicState
 		data->stride[i] = stream.vertexStride;
 	}
 
-	data->indices = indexBuffer;
 	data->viewID = viewID;
 	data->instanceID = instanceID;
-	data->baseVertex = baseVertex;
 
 	if(pixelState.stencilActive)
 	{
@@ -330,6 +674,14 @@ void Renderer::draw(const vk::GraphicsPipeline *pipeline, const vk::DynamicState
 		}
 	}
 
+	// The counters are summed on teardown whenever the statistics query has
+	// fragment shader invocations, even if the pixel routine doesn't count
+	// them (e.g. without a fragment shader), so always reset them.
+	for(int cluster = 0; cluster < MaxClusterCount; cluster++)
+	{
+		data->fragmentInvocations[cluster] = 0;
+	}
+
 	// Viewport
 	{
 		const VkViewport &viewport = pipelineState.getViewport();
@@ -378,33 +730,49 @@ void Renderer::draw(const vk::GraphicsPipeline *pipeline, const vk::DynamicState
 	{
 		const vk::Attachments attachments = pipeline->getAttachments();
 
+		data->hasClearTiles = 0;
+
 		for(int index = 0; index < RENDERTARGETS; index++)
 		{
 			draw->renderTarget[index] = attachments.renderTarget[index];
+			data->clearTiles[index] = nullptr;
 
 			if(draw->renderTarget[index])
 			{
+				data->clearTiles[index] = attachments.renderTarget[index]->getPendingClearTiles(VK_IMAGE_ASPECT_COLOR_BIT, data->viewID);
+
 				data->colorBuffer[index] = (unsigned int *)attachments.renderTarget[index]->getOffsetPointer({ 0, 0, 0 }, VK_IMAGE_ASPECT_COLOR_BIT, 0, data->viewID);
 				data->colorPitchB[index] = attachments.renderTarget[index]->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
-				data->colorSliceB[index] = attachments.renderTarget[index]->slicePitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
+				data->colorSamplePitchB[index] = attachments.renderTarget[index]->samplePitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
 			}
 		}
 
 		draw->depthBuffer = attachments.depthBuffer;
 		draw->stencilBuffer = attachments.stencilBuffer;
+		data->clearTiles[RENDERTARGETS + 0] = nullptr;
+		data->clearTiles[RENDERTARGETS + 1] = nullptr;
 
 		if(draw->depthBuffer)
 		{
+			data->clearTiles[RENDERTARGETS + 0] = attachments.depthBuffer->getPendingClearTiles(VK_IMAGE_ASPECT_DEPTH_BIT, data->viewID);
+
 			data->depthBuffer = (float *)attachments.depthBuffer->getOffsetPointer({ 0, 0, 0 }, VK_IMAGE_ASPECT_DEPTH_BIT, 0, data->viewID);
 			data->depthPitchB = attachments.depthBuffer->rowPitchBytes(VK_IMAGE_ASPECT_DEPTH_BIT, 0);
-			data->depthSliceB = attachments.depthBuffer->slicePitchBytes(VK_IMAGE_ASPECT_DEPTH_BIT, 0);
+			data->depthSamplePitchB = attachments.depthBuffer->samplePitchBytes(VK_IMAGE_ASPECT_DEPTH_BIT, 0);
 		}
 
 		if(draw->stencilBuffer)
 		{
+			data->clearTiles[RENDERTARGETS + 1] = attachments.stencilBuffer->getPendingClearTiles(VK_IMAGE_ASPECT_STENCIL_BIT, data->viewID);
+
 			data->stencilBuffer = (unsigned char *)attachments.stencilBuffer->getOffsetPointer({ 0, 0, 0 }, VK_IMAGE_ASPECT_STENCIL_BIT, 0, data->viewID);
 			data->stencilPitchB = attachments.stencilBuffer->rowPitchBytes(VK_IMAGE_ASPECT_STENCIL_BIT, 0);
-			data->stencilSliceB = attachments.stencilBuffer->slicePitchBytes(VK_IMAGE_ASPECT_STENCIL_BIT, 0);
+			data->stencilSamplePitchB = attachments.stencilBuffer->samplePitchBytes(VK_IMAGE_ASPECT_STENCIL_BIT, 0);
+		}
+
+		for(vk::ClearTiles *clearTiles : data->clearTiles)
+		{
+			data->hasClearTiles |= (clearTiles != nullptr);
 		}
 	}
 
@@ -437,6 +805,11 @@ void DrawCall::setup()
 		occlusionQuery->start();
 	}
 
+	if(statisticsQuery != nullptr)
+	{
+		statisticsQuery->start();
+	}
+
 	if(events)
 	{
 		events->add();
@@ -460,6 +833,28 @@ void DrawCall::teardown()
 		occlusionQuery->finish();
 	}
 
+	if(statisticsQuery != nullptr)
+	{
+		for(const auto &range : ranges)
+		{
+			statisticsQuery->add(VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT, ComputeVertexCount(topology, range.count));
+		}
+		statisticsQuery->add(VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT, numPrimitives);
+		statisticsQuery->add(VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT, vertexInvocations);
+		statisticsQuery->add(VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT, clippingInvocations);
+		statisticsQuery->add(VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT, clippingPrimitives);
+
+		if(statisticsQuery->hasPipelineStatistic(VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT))
+		{
+			for(int cluster = 0; cluster < MaxClusterCount; cluster++)
+			{
+				statisticsQuery->add(VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT, data->fragmentInvocations[cluster]);
+			}
+		}
+
+		statisticsQuery->finish();
+	}
+
 	vertexRoutine = {};
 	setupRoutine = {};
 	pixelRoutine = {};
@@ -534,20 +929,43 @@ void DrawCall::processVertices(DrawCall *draw, BatchData *batch)
 	unsigned int triangleIndices[MaxBatchSize + 1][3];  // One extra for SIMD width overrun. TODO: Adjust to dynamic batch size.
 	{
 		MARL_SCOPED_EVENT("processPrimitiveVertices");
-		processPrimitiveVertices(
-		    triangleIndices,
-		    draw->data->indices,
-		    draw->indexType,
-		    batch->firstPrimitive,
-		    batch->numPrimitives,
-		    draw->topology,
-		    draw->provokingVertexMode);
+
+		// Find the first range overlapping this batch.
+		auto range = std::upper_bound(draw->ranges.begin(), draw->ranges.end(), batch->firstPrimitive,
+		                              [](unsigned int primitive, const DrawRange &range) { return primitive < range.firstPrimitive; }) -
+		             1;
+
+		// Gather the vertex indices of each range the batch spans. Points are
+		// compacted to a single index per primitive.
+		bool points = (draw->topology == VK_PRIMITIVE_TOPOLOGY_POINT_LIST);
+		unsigned int primitive = batch->firstPrimitive;
+		unsigned int batchEnd = batch->firstPrimitive + batch->numPrimitives;
+		for(; primitive < batchEnd; ++range)
+		{
+			unsigned int offset = primitive - batch->firstPrimitive;
+			unsigned int start = primitive - range->firstPrimitive;
+			unsigned int count = std::min(range->count - start, batchEnd - primitive);
+			auto out = points ? reinterpret_cast<unsigned int(*)[3]>(&triangleIndices[0][0] + offset) : &triangleIndices[offset];
+
+			processPrimitiveVertices(
+			    out,
+			    range->indices,
+			    draw->indexType,
+			    start,
+			    count,
+			    range->baseVertex,
+			    draw->topology,
+			    draw->provokingVertexMode);
+
+			primitive += count;
+		}
 	}
 
 	auto &vertexTask = batch->vertexTask;
 	vertexTask.primitiveStart = batch->firstPrimitive;
 	// We're only using batch compaction for points, not lines
 	vertexTask.vertexCount = batch->numPrimitives * ((draw->topology == VK_PRIMITIVE_TOPOLOGY_POINT_LIST) ? 1 : 3);
+	vertexTask.vertexInvocations = 0;
 	if(vertexTask.vertexCache.drawCall != draw->id)
 	{
 		vertexTask.vertexCache.clear();
@@ -555,6 +973,11 @@ void DrawCall::processVertices(DrawCall *draw, BatchData *batch)
 	}
 
 	draw->vertexRoutine(&batch->triangles.front().v0, &triangleIndices[0][0], &vertexTask, draw->data);
+
+	if(draw->statisticsQuery != nullptr)
+	{
+		draw->vertexInvocations += vertexTask.vertexInvocations;
+	}
 }
 
 void DrawCall::processPrimitives(DrawCall *draw, BatchData *batch)
@@ -563,6 +986,14 @@ void DrawCall::processPrimitives(DrawCall *draw, BatchData *batch)
 	auto triangles = &batch->triangles[0];
 	auto primitives = &batch->primitives[0];
 	batch->numVisible = draw->setupPrimitives(triangles, primitives, draw, batch->numPrimitives);
+
+	if(draw->statisticsQuery != nullptr)
+	{
+		// Culling is performed as part of primitive setup, so culled primitives
+		// are not counted as clipper output.
+		draw->clippingInvocations += batch->numPrimitives;
+		draw->clippingPrimitives += batch->numVisible;
+	}
 }
 
 void DrawCall::processPixels(const marl::Loan<DrawCall> &draw, const marl::Loan<BatchData> &batch, const std::shared_ptr<marl::Finally> &finally)
@@ -591,6 +1022,22 @@ void DrawCall::processPixels(const marl::Loan<DrawCall> &draw, const marl::Loan<
 	}
 }
 
+void DrawCall::resolveClearTiles(DrawData *data, int y, int x0, int x1)
+{
+	// Called for the span of a row pair before any of its pixels are processed. Row pairs
+	// are rasterized by a single cluster, in draw order, so this is the first access to the
+	// tiles since the clear, unless another draw on the same cluster already resolved them.
+	VkRect2D span = { { x0, y }, { static_cast<uint32_t>(x1 - x0), vk::ClearTiles::Height } };
+
+	for(vk::ClearTiles *clearTiles : data->clearTiles)
+	{
+		if(clearTiles)
+		{
+			clearTiles->resolve(span);
+		}
+	}
+}
+
 void Renderer::synchronize()
 {
 	MARL_SCOPED_EVENT("synchronize");
@@ -606,16 +1053,12 @@ void DrawCall::processPrimitiveVertices(
     VkIndexType indexType,
     unsigned int start,
     unsigned int triangleCount,
+    int baseVertex,
     VkPrimitiveTopology topology,
     VkProvokingVertexModeEXT provokingVertexMode)
 {
 	if(!primitiveIndices)
 	{
-		struct LinearIndex
-		{
-			unsigned int operator[](unsigned int i) { return i; }
-		};
-
 		if(!setBatchIndices(triangleIndicesOut, topology, provokingVertexMode, LinearIndex(), start, triangleCount))
 		{
 			return;
@@ -652,6 +1095,18 @@ void DrawCall::processPrimitiveVertices(
 		triangleIndicesOut[triangleCount][1] = triangleIndicesOut[triangleCount - 1][2];
 		triangleIndicesOut[triangleCount][2] = triangleIndicesOut[triangleCount - 1][2];
 	}
+
+	// Fold the base vertex into the indices, including the SIMD width overrun,
+	// so that batches can span ranges with different base vertices.
+	if(baseVertex != 0)
+	{
+		unsigned int *index = &triangleIndicesOut[0][0];
+		unsigned int indexCount = (topology == VK_PRIMITIVE_TOPOLOGY_POINT_LIST) ? (triangleCount + 3) : (triangleCount + 1) * 3;
+		for(unsigned int i = 0; i < indexCount; i++)
+		{
+			index[i] += baseVertex;
+		}
+	}
 }
 
 int DrawCall::setupSolidTriangles(Triangle *triangles, Primitive *primitives, const DrawCall *drawCall, int count)
@@ -1202,20 +1657,43 @@ bool DrawCall::setupPoint(Primitive &primitive, Triangle &triangle, const DrawCa
 	return false;
 }
 
-void Renderer::addQuery(vk::Query *query)
+bool Renderer::hasPipelineStatistic(VkQueryPipelineStatisticFlagBits statistic) const
 {
-	ASSERT(query->getType() == VK_QUERY_TYPE_OCCLUSION);
-	ASSERT(!occlusionQuery);
+	return statisticsQuery && statisticsQuery->hasPipelineStatistic(statistic);
+}
 
-	occlusionQuery = query;
+void Renderer::addQuery(vk::Query *query)
+{
+	switch(query->getType())
+	{
+		case VK_QUERY_TYPE_OCCLUSION:
+			ASSERT(!occlusionQuery);
+			occlusionQuery = query;
+			break;
+		case VK_QUERY_TYPE_PIPELINE_STATISTICS:
+			ASSERT(!statisticsQuery);
+			statisticsQuery = query;
+			break;
+		default:
+			UNSUPPORTED("VkQueryType %d", int(query->getType()));
+	}
 }
 
 void Renderer::removeQuery(vk::Query *query)
 {
-	ASSERT(query->getType() == VK_QUERY_TYPE_OCCLUSION);
-	ASSERT(occlusionQuery == query);
-
-	occlusionQuery = nullptr;
+	switch(query->getType())
+	{
+		case VK_QUERY_TYPE_OCCLUSION:
+			ASSERT(occlusionQuery == query);
+			occlusionQuery = nullptr;
+			break;
+		case VK_QUERY_TYPE_PIPELINE_STATISTICS:
+			ASSERT(statisticsQuery == query);
+			statisticsQuery = nullptr;
+			break;
+		default:
+			UNSUPPORTED("VkQueryType %d", int(query->getType()));
+	}
 }
 
 }  // namespace sw
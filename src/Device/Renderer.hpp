@@ -31,9 +31,11 @@
 #include <list>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 namespace vk {
 
+class ClearTiles;
 class DescriptorSet;
 class Device;
 class Query;
@@ -56,6 +58,17 @@ static constexpr int MaxBatchCount = 16;
 static constexpr int MaxClusterCount = 16;
 static constexpr int MaxDrawCount = 16;
 
+// A run of primitives drawn by a DrawCall. A single DrawCall can span several
+// ranges, each with its own index buffer location and base vertex, so that
+// consecutive compatible indirect draw records share batches.
+struct DrawRange
+{
+	unsigned int count;           // Number of primitives
+	int baseVertex;               // Added to each vertex index
+	const void *indices;          // Index buffer, or nullptr for non-indexed draws
+	unsigned int firstPrimitive;  // Index of the range's first primitive within the DrawCall
+};
+
 using TriangleBatch = std::array<Triangle, MaxBatchSize>;
 using PrimitiveBatch = std::array<Primitive, MaxBatchSize>;
 
@@ -69,16 +82,14 @@ struct DrawData
 	const void *input[MAX_INTERFACE_COMPONENTS / 4];
 	unsigned int robustnessSize[MAX_INTERFACE_COMPONENTS / 4];
 	unsigned int stride[MAX_INTERFACE_COMPONENTS / 4];
-	const void *indices;
-
 	int instanceID;
-	int baseVertex;
 	float lineWidth;
 	int viewID;
 
 	PixelProcessor::Stencil stencil[2];  // clockwise, counterclockwise
 	PixelProcessor::Factor factor;
-	unsigned int occlusion[MaxClusterCount];  // Number of pixels passing depth test
+	unsigned int occlusion[MaxClusterCount];            // Number of pixels passing depth test
+	unsigned int fragmentInvocations[MaxClusterCount];  // Number of pixels shaded by the fragment shader
 
 	float4 WxF;
 	float4 HxF;
@@ -96,13 +107,18 @@ struct DrawData
 
 	unsigned int *colorBuffer[RENDERTARGETS];
 	int colorPitchB[RENDERTARGETS];
-	int colorSliceB[RENDERTARGETS];
+	int colorSamplePitchB[RENDERTARGETS];
 	float *depthBuffer;
 	int depthPitchB;
-	int depthSliceB;
+	int depthSamplePitchB;
 	unsigned char *stencilBuffer;
 	int stencilPitchB;
-	int stencilSliceB;
+	int stencilSamplePitchB;
+
+	// Color, depth and stencil attachments with pending clears, written out one tile at
+	// a time by the pixel routine before it draws to them. See DrawCall::resolveClearTiles().
+	vk::ClearTiles *clearTiles[RENDERTARGETS + 2];
+	int hasClearTiles;
 
 	int scissorX0;
 	int scissorX1;
@@ -143,6 +159,7 @@ struct DrawCall
 	static void processVertices(DrawCall *draw, BatchData *batch);
 	static void processPrimitives(DrawCall *draw, BatchData *batch);
 	static void processPixels(const marl::Loan<DrawCall> &draw, const marl::Loan<BatchData> &batch, const std::shared_ptr<marl::Finally> &finally);
+	static void resolveClearTiles(DrawData *data, int y, int x0, int x1);
 	void setup();
 	void teardown();
 
@@ -174,7 +191,16 @@ struct DrawCall
 	const vk::PipelineLayout *pipelineLayout;
 	sw::CountedEvent *events;
 
+	std::vector<DrawRange> ranges;
+
 	vk::Query *occlusionQuery;
+	vk::Query *statisticsQuery;
+
+	// Pipeline statistics accumulated by the batches of this draw call.
+	// Folded into the statisticsQuery on teardown.
+	std::atomic<uint64_t> vertexInvocations;
+	std::atomic<uint64_t> clippingInvocations;
+	std::atomic<uint64_t> clippingPrimitives;
 
 	DrawData *data;
 
@@ -184,6 +210,7 @@ struct DrawCall
 	    VkIndexType indexType,
 	    unsigned int start,
 	    unsigned int triangleCount,
+	    int baseVertex,
 	    VkPrimitiveTopology topology,
 	    VkProvokingVertexModeEXT provokingVertexMode);
 
@@ -208,9 +235,13 @@ public:
 	void operator delete(void *mem);
 
 	bool hasOcclusionQuery() const { return occlusionQuery != nullptr; }
+	bool hasPipelineStatistic(VkQueryPipelineStatisticFlagBits statistic) const;
+	vk::Query *getPipelineStatisticsQuery() const { return statisticsQuery; }
 
-	void draw(const vk::GraphicsPipeline *pipeline, const vk::DynamicState &dynamicState, unsigned int count, int baseVertex,
-	          CountedEvent *events, int instanceID, int viewID, void *indexBuffer, const VkExtent3D &framebufferExtent,
+	// draw() renders the primitives of all ranges with a single DrawCall.
+	// The firstPrimitive member of the ranges is ignored.
+	void draw(const vk::GraphicsPipeline *pipeline, const vk::DynamicState &dynamicState, const DrawRange *ranges, unsigned int rangeCount,
+	          CountedEvent *events, int instanceID, int viewID, const VkExtent3D &framebufferExtent,
 	          vk::Pipeline::PushConstantStorage const &pushConstants, bool update = true);
 
 	void addQuery(vk::Query *query);
@@ -225,6 +256,7 @@ private:
 	std::atomic<int> nextDrawID = { 0 };
 
 	vk::Query *occlusionQuery = nullptr;
+	vk::Query *statisticsQuery = nullptr;
 	marl::Ticket::Queue drawTickets;
 	marl::Ticket::Queue clusterQueues[MaxClusterCount];
 
@@ -92,6 +92,7 @@ struct Sampler
 {
 	VkImageViewType textureType;
 	vk::Format textureFormat;
+	vk::Format compressedFormat;  // Block format decoded by the sampler, or VK_FORMAT_UNDEFINED.
 	FilterType textureFilter;
 	AddressingMode addressingModeU;
 	AddressingMode addressingModeV;
@@ -104,6 +105,7 @@ struct Sampler
 	VkCompareOp compareOp;
 	VkBorderColor border;
 	bool unnormalizedCoordinates;
+	bool tiledLayout;  // Texels are stored in 4x4 tiles, see vk::Image::prepareForSampling()
 
 	VkSamplerYcbcrModelConversion ycbcrModel;
 	bool studioSwing;    // Narrow range
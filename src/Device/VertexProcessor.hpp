@@ -48,6 +48,7 @@ struct VertexTask
 {
 	unsigned int vertexCount;
 	unsigned int primitiveStart;
+	unsigned int vertexInvocations;  // Written by the routine when statistics are enabled
 	VertexCache vertexCache;
 };
 
@@ -81,6 +82,7 @@ public:
 		Input input[MAX_INTERFACE_COMPONENTS / 4];
 		bool robustBufferAccess : 1;
 		bool isPoint : 1;
+		bool statisticsEnabled : 1;
 	};
 
 	struct State : States
@@ -94,7 +96,7 @@ public:
 
 	VertexProcessor();
 
-	const State update(const vk::GraphicsState &pipelineState, const sw::SpirvShader *vertexShader, const vk::Inputs &inputs);
+	const State update(const vk::GraphicsState &pipelineState, const sw::SpirvShader *vertexShader, const vk::Inputs &inputs, bool statisticsEnabled);
 	RoutineType routine(const State &state, vk::PipelineLayout const *pipelineLayout,
 	                    SpirvShader const *vertexShader, const vk::DescriptorSet::Bindings &descriptorSets);
 
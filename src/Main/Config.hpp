@@ -17,7 +17,6 @@
 
 #include "Common/Types.hpp"
 
-#define PERF_HUD 0       // Display time spent on vertex, setup and pixel processing for each thread
 #define PERF_PROFILE 0   // Profile various pipeline stages and display the timing in SwiftConfig
 
 // Worker thread count when not set by SwiftConfig
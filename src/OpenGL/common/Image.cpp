@@ -1222,6 +1222,11 @@ namespace egl
 			return clientBuffer.lock(x, y, z);
 		}
 
+		void *lock(const sw::Box &region, sw::Lock lock) override
+		{
+			return this->lock(region.x0, region.y0, region.z0, lock);
+		}
+
 		void unlock() override
 		{
 			LOGLOCK("image=%p op=%s.ani", this, __FUNCTION__);
@@ -1661,7 +1666,8 @@ namespace egl
 		GLsizei inputHeight = (unpackParameters.imageHeight == 0) ? height : unpackParameters.imageHeight;
 		char *input = ((char*)pixels) + gl::ComputePackingOffset(format, type, inputWidth, inputHeight, unpackParameters);
 
-		void *buffer = lock(xoffset, yoffset, zoffset, sw::LOCK_WRITEONLY);
+		sw::Box region(xoffset, yoffset, zoffset, xoffset + width, yoffset + height, zoffset + depth);
+		void *buffer = lock(region, sw::LOCK_WRITEONLY);
 
 		if(buffer)
 		{
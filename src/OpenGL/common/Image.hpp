@@ -189,6 +189,12 @@ public:
 		return lockExternal(x, y, z, lock, sw::PUBLIC);
 	}
 
+	// Only the region gets converted to the internal format after writing to it.
+	virtual void *lock(const sw::Box &region, sw::Lock lock)
+	{
+		return lockExternal(region, lock, sw::PUBLIC);
+	}
+
 	unsigned int getPitch() const
 	{
 		return getExternalPitchB();
@@ -334,6 +340,11 @@ private:
 		return lockNativeBuffer(GRALLOC_USAGE_SW_READ_OFTEN | GRALLOC_USAGE_SW_WRITE_OFTEN);
 	}
 
+	void *lock(const sw::Box &region, sw::Lock lock) override
+	{
+		return this->lock(region.x0, region.y0, region.z0, lock);
+	}
+
 	void unlock() override
 	{
 		LOGLOCK("image=%p op=%s.ani", this, __FUNCTION__);
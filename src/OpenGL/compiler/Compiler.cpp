@@ -118,8 +118,12 @@ bool TCompiler::compile(const char* const shaderStrings[],
 		++firstSource;
 	}
 
+	// #extension directives only apply to the shader being compiled, so the
+	// default behavior must not be modified for subsequent compiles.
+	TExtensionBehavior shaderExtensionBehavior = extensionBehavior;
+
 	TIntermediate intermediate(infoSink);
-	TParseContext parseContext(symbolTable, extensionBehavior, intermediate,
+	TParseContext parseContext(symbolTable, shaderExtensionBehavior, intermediate,
 	                           shaderType, compileOptions, true,
 	                           sourcePath, infoSink);
 	SetGlobalParseContext(&parseContext);
@@ -112,7 +112,7 @@ private:
 	// Built-in symbol table for the given language, spec, and resources.
 	// It is preserved from compile-to-compile.
 	TSymbolTable symbolTable;
-	// Built-in extensions with default behavior.
+	// Built-in extensions with default behavior. Each compile works on a copy.
 	TExtensionBehavior extensionBehavior;
 
 	// Results of compilation.
@@ -120,7 +120,8 @@ private:
 	TInfoSink infoSink;  // Output sink.
 
 	// Memory allocator. Allocates and tracks memory required by the compiler.
-	// Deallocates all memory when compiler is destructed.
+	// Pages used by a compile are returned to its free list afterwards, and
+	// all memory is deallocated when the compiler is destructed.
 	TPoolAllocator allocator;
 };
 
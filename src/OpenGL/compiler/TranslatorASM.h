@@ -28,11 +28,15 @@ class TranslatorASM : public TCompiler
 public:
     TranslatorASM(glsl::Shader *shaderObject, GLenum type);
 
+	// Selects the shader object which receives the output of the next compile.
+	// This allows one translator, and its built-in symbol table, to be reused.
+	void setShaderObject(glsl::Shader *shader) { shaderObject = shader; }
+
 protected:
     virtual bool translate(TIntermNode* root);
 
 private:
-	glsl::Shader *const shaderObject;
+	glsl::Shader *shaderObject;
 };
 
 #endif  // COMPILER_TRANSLATORASM_H_
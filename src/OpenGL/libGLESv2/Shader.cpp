@@ -28,6 +28,8 @@ namespace es2
 {
 std::mutex Shader::mutex;
 bool Shader::compilerInitialized = false;
+TranslatorASM *Shader::vertexCompiler = nullptr;
+TranslatorASM *Shader::fragmentCompiler = nullptr;
 
 Shader::Shader(ResourceManager *manager, GLuint handle) : mHandle(handle), mResourceManager(manager)
 {
@@ -196,6 +198,23 @@ TranslatorASM *Shader::createCompiler(GLenum shaderType)
 	return assembler;
 }
 
+TranslatorASM *Shader::getCompiler(GLenum shaderType)
+{
+	TranslatorASM *&compiler = (shaderType == GL_VERTEX_SHADER) ? vertexCompiler : fragmentCompiler;
+
+	if(!compiler)
+	{
+		compiler = createCompiler(shaderType);
+	}
+
+	if(compiler)
+	{
+		compiler->setShaderObject(this);
+	}
+
+	return compiler;
+}
+
 void Shader::clear()
 {
 	infoLog.clear();
@@ -213,7 +232,7 @@ void Shader::compile()
 	clear();
 
 	createShader();
-	TranslatorASM *compiler = createCompiler(getType());
+	TranslatorASM *compiler = getCompiler(getType());
 
 	if(!compiler)
 	{
@@ -259,7 +278,7 @@ void Shader::compile()
 		TRACE("\n%s", infoLog.c_str());
 	}
 
-	delete compiler;
+	compiler->setShaderObject(nullptr);
 }
 
 bool Shader::isCompiled()
@@ -302,8 +321,16 @@ void Shader::releaseCompiler()
 	// Our version of glslang is not thread safe.
 	std::lock_guard<std::mutex> lock(mutex);
 
-	FreeCompilerGlobals();
-	compilerInitialized = false;
+	delete vertexCompiler;
+	vertexCompiler = nullptr;
+	delete fragmentCompiler;
+	fragmentCompiler = nullptr;
+
+	if(compilerInitialized)
+	{
+		FreeCompilerGlobals();
+		compilerInitialized = false;
+	}
 }
 
 // true if varying x has a higher priority in packing than y
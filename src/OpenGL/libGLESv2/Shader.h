@@ -73,6 +73,12 @@ protected:
 	static std::mutex mutex;
 	static bool compilerInitialized;
 
+	// Compilers are kept across compiles so that the built-in symbol table of
+	// each shader type is only constructed once, until releaseCompiler().
+	static TranslatorASM *vertexCompiler;
+	static TranslatorASM *fragmentCompiler;
+
+	TranslatorASM *getCompiler(GLenum shaderType);
 	TranslatorASM *createCompiler(GLenum shaderType);
 	void clear();
 
@@ -16,6 +16,8 @@
 
 #include "main.h"
 
+#include "Shader.h"
+
 #if !defined(_MSC_VER)
 #define CONSTRUCTOR __attribute__((constructor))
 #define DESTRUCTOR __attribute__((destructor))
@@ -46,6 +48,9 @@ DESTRUCTOR static void glDetachProcess()
 	TRACE("()");
 
 	glDetachThread();
+
+	// Free the compilers kept across glCompileShader calls.
+	es2::Shader::releaseCompiler();
 }
 
 #if defined(_WIN32)
@@ -237,6 +237,8 @@ void ComputeProgram::run(
 	data.pushConstants = pushConstants;
 	data.constants = &sw::Constants::Get();
 
+	vk::DescriptorSet::PrepareForSampling(descriptorSetObjects, pipelineLayout, device);
+
 	marl::WaitGroup wg;
 	const uint32_t batchCount = 16;
 
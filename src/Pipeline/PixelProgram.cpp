@@ -296,7 +296,7 @@ void PixelProgram::rasterOperation(Pointer<Byte> cBuffer[4], Int &x, Int sMask[4
 				{
 					if(state.multiSampleMask & (1 << q))
 					{
-						Pointer<Byte> buffer = cBuffer[index] + q * *Pointer<Int>(data + OFFSET(DrawData, colorSliceB[index]));
+						Pointer<Byte> buffer = cBuffer[index] + q * *Pointer<Int>(data + OFFSET(DrawData, colorSamplePitchB[index]));
 						Vector4s color;
 
 						color.x = convertFixed16(c[index].x, false);
@@ -342,7 +342,7 @@ void PixelProgram::rasterOperation(Pointer<Byte> cBuffer[4], Int &x, Int sMask[4
 				{
 					if(state.multiSampleMask & (1 << q))
 					{
-						Pointer<Byte> buffer = cBuffer[index] + q * *Pointer<Int>(data + OFFSET(DrawData, colorSliceB[index]));
+						Pointer<Byte> buffer = cBuffer[index] + q * *Pointer<Int>(data + OFFSET(DrawData, colorSamplePitchB[index]));
 						Vector4f color = c[index];
 
 						alphaBlend(index, buffer, color, x);
@@ -285,6 +285,17 @@ void PixelRoutine::quad(Pointer<Byte> cBuffer[RENDERTARGETS], Pointer<Byte> &zBu
 
 			if(spirvShader)
 			{
+				if(state.statisticsEnabled)
+				{
+					Int coverageMask = 0;
+					for(unsigned int q = sampleLoopInit; q < sampleLoopEnd; q++)
+					{
+						coverageMask |= cMask[q];
+					}
+
+					fragmentInvocations += *Pointer<UInt>(constants + OFFSET(Constants, occlusionCount) + 4 * coverageMask);
+				}
+
 				bool earlyFragTests = (spirvShader && spirvShader->getModes().EarlyFragmentTests);
 				applyShader(cMask, earlyFragTests ? sMask : cMask, earlyDepthTest ? zMask : cMask, sampleId);
 			}
@@ -353,7 +364,7 @@ void PixelRoutine::stencilTest(const Pointer<Byte> &sBuffer, int q, const Int &x
 
 	if(q > 0)
 	{
-		buffer += q * *Pointer<Int>(data + OFFSET(DrawData, stencilSliceB));
+		buffer += q * *Pointer<Int>(data + OFFSET(DrawData, stencilSamplePitchB));
 	}
 
 	Int pitch = *Pointer<Int>(data + OFFSET(DrawData, stencilPitchB));
@@ -442,7 +453,7 @@ Bool PixelRoutine::depthTest32F(const Pointer<Byte> &zBuffer, int q, const Int &
 
 	if(q > 0)
 	{
-		buffer += q * *Pointer<Int>(data + OFFSET(DrawData, depthSliceB));
+		buffer += q * *Pointer<Int>(data + OFFSET(DrawData, depthSamplePitchB));
 	}
 
 	Float4 zValue;
@@ -519,7 +530,7 @@ Bool PixelRoutine::depthTest16(const Pointer<Byte> &zBuffer, int q, const Int &x
 
 	if(q > 0)
 	{
-		buffer += q * *Pointer<Int>(data + OFFSET(DrawData, depthSliceB));
+		buffer += q * *Pointer<Int>(data + OFFSET(DrawData, depthSamplePitchB));
 	}
 
 	Short4 zValue;
@@ -638,7 +649,7 @@ void PixelRoutine::writeDepth32F(Pointer<Byte> &zBuffer, int q, const Int &x, co
 
 	if(q > 0)
 	{
-		buffer += q * *Pointer<Int>(data + OFFSET(DrawData, depthSliceB));
+		buffer += q * *Pointer<Int>(data + OFFSET(DrawData, depthSamplePitchB));
 	}
 
 	Float4 zValue;
@@ -670,7 +681,7 @@ void PixelRoutine::writeDepth16(Pointer<Byte> &zBuffer, int q, const Int &x, con
 
 	if(q > 0)
 	{
-		buffer += q * *Pointer<Int>(data + OFFSET(DrawData, depthSliceB));
+		buffer += q * *Pointer<Int>(data + OFFSET(DrawData, depthSamplePitchB));
 	}
 
 	Short4 zValue;
@@ -730,7 +741,7 @@ void PixelRoutine::writeStencil(Pointer<Byte> &sBuffer, int q, const Int &x, con
 
 	if(q > 0)
 	{
-		buffer += q * *Pointer<Int>(data + OFFSET(DrawData, stencilSliceB));
+		buffer += q * *Pointer<Int>(data + OFFSET(DrawData, stencilSamplePitchB));
 	}
 
 	Int pitch = *Pointer<Int>(data + OFFSET(DrawData, stencilPitchB));
@@ -21,6 +21,105 @@
 
 namespace sw {
 
+namespace {
+
+// Returns the offset of texel column x within a row of 4x4 texel tiles.
+Int4 tiledColumnOffset(const Int4 &x)
+{
+	return ((x & Int4(~3)) << 2) | (x & Int4(3));
+}
+
+// Returns the offset of texel row y, given the pitch of the linear rows which
+// each hold four rows of tiles. Negative coordinates remain negative.
+Int4 tiledRowOffset(const Int4 &y, const Int4 &pitchP)
+{
+	return (y & Int4(~3)) * pitchP + ((y & Int4(3)) << 2);
+}
+
+// Returns trunc(n / d) for the 3-bit BC palette divisors, exactly for |n| < 2^13.
+Int4 divideBC(const Int4 &n, const Int4 &d)
+{
+	Int4 sign = n >> 31;
+	Int4 a = (n ^ sign) - sign;
+	Int4 q3 = (a * Int4(21846)) >> 16;
+	Int4 q5 = (a * Int4(13108)) >> 16;
+	Int4 q7 = (a * Int4(9363)) >> 16;
+
+	Int4 q = (CmpEQ(d, Int4(3)) & q3) | (CmpEQ(d, Int4(5)) & q5) | (CmpEQ(d, Int4(7)) & q7) | (CmpEQ(d, Int4(2)) & (a >> 1));
+
+	return (q ^ sign) - sign;
+}
+
+// Interpolates between the endpoints e0 and e1 of a BC palette of d + 1 colors. Index 0
+// selects e0, index 1 selects e1, and index i > 1 the (i - 1)th intermediate color.
+Int4 interpolateBC(const Int4 &e0, const Int4 &e1, const Int4 &index, const Int4 &d)
+{
+	Int4 w = (index - Int4(1)) & ~CmpLT(index, Int4(2));
+	w |= CmpEQ(index, Int4(1)) & d;
+
+	return divideBC((d - w) * e0 + w * e1, d);
+}
+
+// Expands a 5 or 6-bit channel of a BC color endpoint to 8 bits.
+Int4 expandBC(const UInt4 &c, int shift, int bits)
+{
+	Int4 x = As<Int4>((c >> shift) & UInt4((1 << bits) - 1));
+
+	return (x << (8 - bits)) | (x >> (2 * bits - 8));
+}
+
+// Decodes the color block of BC1-BC3 into 8-bit channels. In three-color mode, BC1 with alpha
+// decodes index 3 as transparent black rather than opaque black.
+void decodeColorBC(Vector4i &c, const UInt4 &endpoints, const UInt4 &indices, const UInt4 &texel, bool hasAlphaChannel, bool hasSeparateAlpha)
+{
+	UInt4 c0 = endpoints & UInt4(0xFFFF);
+	UInt4 c1 = endpoints >> 16;
+
+	Int4 fourColors = Int4(hasSeparateAlpha ? -1 : 0) | CmpGT(As<Int4>(c0), As<Int4>(c1));
+	Int4 d = (fourColors & Int4(3)) | (~fourColors & Int4(2));
+
+	Int4 index = As<Int4>((indices >> (texel << 1)) & UInt4(3));
+	Int4 black = ~fourColors & CmpEQ(index, Int4(3));
+
+	c.x = interpolateBC(expandBC(c0, 11, 5), expandBC(c1, 11, 5), index, d) & ~black;
+	c.y = interpolateBC(expandBC(c0, 5, 6), expandBC(c1, 5, 6), index, d) & ~black;
+	c.z = interpolateBC(expandBC(c0, 0, 5), expandBC(c1, 0, 5), index, d) & ~black;
+	c.w = Int4(0xFF);
+
+	if(hasAlphaChannel)
+	{
+		c.w &= ~black;
+	}
+}
+
+// Decodes a single channel block of BC3-BC5, stored as two 32-bit words.
+Int4 decodeChannelBC(const UInt4 &lo, const UInt4 &hi, const UInt4 &texel, bool isSigned)
+{
+	Int4 e0 = isSigned ? (As<Int4>(lo) << 24) >> 24 : As<Int4>(lo & UInt4(0xFF));
+	Int4 e1 = isSigned ? (As<Int4>(lo) << 16) >> 24 : As<Int4>((lo >> 8) & UInt4(0xFF));
+
+	// The 3-bit indices start at bit 16, so texels 5 and 10 straddle the two words.
+	UInt4 bit = texel * UInt4(3) + UInt4(16);
+	UInt4 inLo = CmpLT(bit, UInt4(32));
+	UInt4 shiftLo = Min(bit, UInt4(31));
+	UInt4 fromLo = (lo >> shiftLo) | (hi << (UInt4(32) - shiftLo));
+	UInt4 fromHi = hi >> (Max(bit, UInt4(32)) - UInt4(32));
+	Int4 index = As<Int4>(((inLo & fromLo) | (~inLo & fromHi)) & UInt4(7));
+
+	Int4 eightValues = CmpGT(e0, e1);
+	Int4 d = (eightValues & Int4(7)) | (~eightValues & Int4(5));
+	Int4 c = interpolateBC(e0, e1, index, d);
+
+	// In six-value mode, indices 6 and 7 select the extremes of the range.
+	Int4 minimum = ~eightValues & CmpEQ(index, Int4(6));
+	Int4 maximum = ~eightValues & CmpEQ(index, Int4(7));
+	c = (c & ~(minimum | maximum)) | (minimum & Int4(isSigned ? -128 : 0)) | (maximum & Int4(isSigned ? 127 : 255));
+
+	return c;
+}
+
+}  // anonymous namespace
+
 SamplerCore::SamplerCore(Pointer<Byte> &constants, const Sampler &state)
     : constants(constants)
     , state(state)
@@ -128,7 +227,8 @@ Vector4f SamplerCore::sampleTexture(Pointer<Byte> &texture, Float4 uvwa[4], Floa
 	bool force32BitFiltering = state.highPrecisionFiltering && !isYcbcrFormat() && (state.textureFilter != FILTER_POINT);
 	bool use32BitFiltering = hasFloatTexture() || hasUnnormalizedIntegerTexture() || force32BitFiltering ||
 	                         state.isCube() || state.unnormalizedCoordinates || state.compareEnable ||
-	                         borderModeActive() || (function == Gather) || (function == Fetch);
+	                         borderModeActive() || (function == Gather) || (function == Fetch) ||
+	                         hasCompressedTexture();
 
 	if(use32BitFiltering)
 	{
@@ -987,8 +1087,17 @@ Vector4f SamplerCore::sampleFloat2D(Pointer<Byte> &texture, Float4 &u, Float4 &v
 	address(u, x0, x1, fu, mipmap, offset.x, filter, OFFSET(Mipmap, width), state.addressingModeU, function);
 	address(v, y0, y1, fv, mipmap, offset.y, filter, OFFSET(Mipmap, height), state.addressingModeV, function);
 
-	Int4 pitchP = *Pointer<Int4>(mipmap + OFFSET(Mipmap, pitchP), 16);
-	y0 *= pitchP;
+	// Compressed texels are addressed by their block and position within it instead.
+	Int4 pitchP = hasCompressedTexture() ? Int4(1) : *Pointer<Int4>(mipmap + OFFSET(Mipmap, pitchP), 16);
+	if(state.tiledLayout)
+	{
+		x0 = tiledColumnOffset(x0);
+		y0 = tiledRowOffset(y0, pitchP);
+	}
+	else
+	{
+		y0 *= pitchP;
+	}
 
 	Int4 z;
 	if(state.isCube() || state.isArrayed())
@@ -1018,7 +1127,15 @@ Vector4f SamplerCore::sampleFloat2D(Pointer<Byte> &texture, Float4 &u, Float4 &v
 	}
 	else
 	{
-		y1 *= pitchP;
+		if(state.tiledLayout)
+		{
+			x1 = tiledColumnOffset(x1);
+			y1 = tiledRowOffset(y1, pitchP);
+		}
+		else
+		{
+			y1 *= pitchP;
+		}
 
 		Vector4f c00 = sampleTexel(x0, y0, z, dRef, sample, mipmap, buffer, function);
 		Vector4f c10 = sampleTexel(x1, y0, z, dRef, sample, mipmap, buffer, function);
@@ -1413,12 +1530,20 @@ void SamplerCore::computeIndices(UInt index[4], Short4 uuuu, Short4 vvvv, Short4
 			vvvv = applyOffset(vvvv, offset.y, *Pointer<Int4>(mipmap + OFFSET(Mipmap, height)), state.addressingModeV);
 		}
 
-		Short4 uv0uv1 = As<Short4>(UnpackLow(uuuu, vvvv));
-		Short4 uv2uv3 = As<Short4>(UnpackHigh(uuuu, vvvv));
-		Int2 i01 = MulAdd(uv0uv1, *Pointer<Short4>(mipmap + OFFSET(Mipmap, onePitchP)));
-		Int2 i23 = MulAdd(uv2uv3, *Pointer<Short4>(mipmap + OFFSET(Mipmap, onePitchP)));
+		if(state.tiledLayout)
+		{
+			Int4 pitchP = *Pointer<Int4>(mipmap + OFFSET(Mipmap, pitchP), 16);
+			indices = As<UInt4>(tiledColumnOffset(Int4(As<UShort4>(uuuu))) + tiledRowOffset(Int4(As<UShort4>(vvvv)), pitchP));
+		}
+		else
+		{
+			Short4 uv0uv1 = As<Short4>(UnpackLow(uuuu, vvvv));
+			Short4 uv2uv3 = As<Short4>(UnpackHigh(uuuu, vvvv));
+			Int2 i01 = MulAdd(uv0uv1, *Pointer<Short4>(mipmap + OFFSET(Mipmap, onePitchP)));
+			Int2 i23 = MulAdd(uv2uv3, *Pointer<Short4>(mipmap + OFFSET(Mipmap, onePitchP)));
 
-		indices = UInt4(As<UInt2>(i01), As<UInt2>(i23));
+			indices = UInt4(As<UInt2>(i01), As<UInt2>(i23));
+		}
 	}
 
 	if(state.is3D())
@@ -1920,7 +2045,10 @@ Vector4f SamplerCore::sampleTexel(Int4 &uuuu, Int4 &vvvv, Int4 &wwww, Float4 &dR
 	}
 
 	UInt index[4];
-	computeIndices(index, uuuu, vvvv, wwww, sample, valid, mipmap, function);
+	if(!hasCompressedTexture())
+	{
+		computeIndices(index, uuuu, vvvv, wwww, sample, valid, mipmap, function);
+	}
 
 	Vector4f c;
 
@@ -2032,7 +2160,8 @@ Vector4f SamplerCore::sampleTexel(Int4 &uuuu, Int4 &vvvv, Int4 &wwww, Float4 &dR
 	{
 		ASSERT(!isYcbcrFormat());
 
-		Vector4s cs = sampleTexel(index, buffer);
+		Vector4s cs = hasCompressedTexture() ? sampleCompressedTexel(uuuu, vvvv, wwww, valid, mipmap, buffer)
+		                                     : sampleTexel(index, buffer);
 
 		bool isInteger = state.textureFormat.isUnnormalizedInteger();
 		int componentCount = textureComponentCount();
@@ -2103,6 +2232,97 @@ Vector4f SamplerCore::sampleTexel(Int4 &uuuu, Int4 &vvvv, Int4 &wwww, Float4 &dR
 	return c;
 }
 
+Vector4s SamplerCore::sampleCompressedTexel(Int4 &uuuu, Int4 &vvvv, Int4 &wwww, Int4 valid, const Pointer<Byte> &mipmap, Pointer<Byte> buffer)
+{
+	ASSERT(state.is2D());
+
+	const int blockBytes = state.compressedFormat.bytesPerBlock();
+
+	// Locate each texel's 4x4 block. The level's pitch is in bytes per row of blocks.
+	Int4 offsets = (uuuu >> 2) * Int4(blockBytes) + (vvvv >> 2) * *Pointer<Int4>(mipmap + OFFSET(Mipmap, pitchP), 16);
+
+	if(state.isArrayed())
+	{
+		offsets += wwww;
+	}
+
+	if(borderModeActive())
+	{
+		// Texels out of range are still decoded before being replaced
+		// with the border color, so decode the first block instead.
+		offsets &= valid;
+	}
+
+	UInt4 texel = As<UInt4>((uuuu & Int4(3)) | ((vvvv & Int4(3)) << 2));
+
+	UInt4 block[4];
+	for(int i = 0; i < 4; i++)
+	{
+		Pointer<Byte> address = buffer + Extract(offsets, i);
+
+		for(int j = 0; j < blockBytes / 4; j++)
+		{
+			block[j] = Insert(block[j], *Pointer<UInt>(address + 4 * j), i);
+		}
+	}
+
+	Vector4i c;
+
+	switch(state.compressedFormat)
+	{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			decodeColorBC(c, block[0], block[1], texel, false, false);
+			break;
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			decodeColorBC(c, block[0], block[1], texel, true, false);
+			break;
+		case VK_FORMAT_BC2_UNORM_BLOCK:
+		case VK_FORMAT_BC2_SRGB_BLOCK:
+		{
+			decodeColorBC(c, block[2], block[3], texel, false, true);
+
+			// Explicit 4-bit alpha, eight texels per word.
+			UInt4 inLo = CmpLT(texel, UInt4(8));
+			UInt4 alpha = ((inLo & block[0]) | (~inLo & block[1])) >> ((texel & UInt4(7)) << 2);
+			c.w = As<Int4>(alpha & UInt4(0xF)) * Int4(0x11);
+		}
+		break;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			decodeColorBC(c, block[2], block[3], texel, false, true);
+			c.w = decodeChannelBC(block[0], block[1], texel, false);
+			break;
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC4_SNORM_BLOCK:
+			c.x = decodeChannelBC(block[0], block[1], texel, state.compressedFormat == VK_FORMAT_BC4_SNORM_BLOCK);
+			break;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC5_SNORM_BLOCK:
+			c.x = decodeChannelBC(block[0], block[1], texel, state.compressedFormat == VK_FORMAT_BC5_SNORM_BLOCK);
+			c.y = decodeChannelBC(block[2], block[3], texel, state.compressedFormat == VK_FORMAT_BC5_SNORM_BLOCK);
+			break;
+		default:
+			UNSUPPORTED("Format %d", VkFormat(state.compressedFormat));
+	}
+
+	// Produce the texels as sampleTexel() reads them from the decompressed format,
+	// with 8-bit values in the upper byte.
+	Vector4s cs;
+	for(int i = 0; i < textureComponentCount(); i++)
+	{
+		cs[i] = Short4(c[i] << 8);
+
+		if(state.textureFormat.isSRGBformat() && isRGBComponent(i))
+		{
+			sRGBtoLinearFF00(cs[i]);
+		}
+	}
+
+	return cs;
+}
+
 Vector4f SamplerCore::replaceBorderTexel(const Vector4f &c, Int4 valid)
 {
 	Int4 borderRGB;
@@ -2575,6 +2795,11 @@ bool SamplerCore::isRGBComponent(int component) const
 	return state.textureFormat.isRGBComponent(component);
 }
 
+bool SamplerCore::hasCompressedTexture() const
+{
+	return state.compressedFormat != VK_FORMAT_UNDEFINED;
+}
+
 bool SamplerCore::borderModeActive() const
 {
 	return state.addressingModeU == ADDRESSING_BORDER ||
@@ -84,6 +84,7 @@ private:
 	Vector4s sampleTexel(Short4 &u, Short4 &v, Short4 &w, const Short4 &cubeArrayLayer, Vector4i &offset, const Int4 &sample, Pointer<Byte> &mipmap, Pointer<Byte> buffer, SamplerFunction function);
 	Vector4s sampleTexel(UInt index[4], Pointer<Byte> buffer);
 	Vector4f sampleTexel(Int4 &u, Int4 &v, Int4 &w, Float4 &dRef, const Int4 &sample, Pointer<Byte> &mipmap, Pointer<Byte> buffer, SamplerFunction function);
+	Vector4s sampleCompressedTexel(Int4 &u, Int4 &v, Int4 &w, Int4 valid, const Pointer<Byte> &mipmap, Pointer<Byte> buffer);
 	Vector4f replaceBorderTexel(const Vector4f &c, Int4 valid);
 	void selectMipmap(const Pointer<Byte> &texture, Pointer<Byte> &mipmap, Pointer<Byte> &buffer, const Float &lod, bool secondLOD);
 	Short4 address(const Float4 &uvw, AddressingMode addressingMode, Pointer<Byte> &mipmap);
@@ -106,6 +107,7 @@ private:
 	bool has32bitIntegerTextureComponents() const;
 	bool isYcbcrFormat() const;
 	bool isRGBComponent(int component) const;
+	bool hasCompressedTexture() const;
 	bool borderModeActive() const;
 	VkComponentSwizzle gatherSwizzle() const;
 
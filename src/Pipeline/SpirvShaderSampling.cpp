@@ -48,12 +48,22 @@ SpirvShader::ImageSampler *SpirvShader::getImageSampler(uint32_t inst, vk::Sampl
 		samplerState.textureType = type;
 		samplerState.textureFormat = imageDescriptor->format;
 
+		// Compressed views are only sampled without a decompressed image copy if the
+		// sampler decodes their blocks, which then produce texels of the decompressed format.
+		if(samplerState.textureFormat.isCompressed())
+		{
+			ASSERT(samplerState.textureFormat.isSampledCompressed());
+			samplerState.compressedFormat = samplerState.textureFormat;
+			samplerState.textureFormat = samplerState.textureFormat.getDecompressedFormat();
+		}
+
 		samplerState.addressingModeU = convertAddressingMode(0, sampler, type);
 		samplerState.addressingModeV = convertAddressingMode(1, sampler, type);
 		samplerState.addressingModeW = convertAddressingMode(2, sampler, type);
 
 		samplerState.mipmapFilter = convertMipmapMode(sampler);
 		samplerState.swizzle = imageDescriptor->swizzle;
+		samplerState.tiledLayout = imageDescriptor->tiledLayout;
 		samplerState.gatherComponent = instruction.gatherComponent;
 
 		if(sampler)
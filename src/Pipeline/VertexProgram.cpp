@@ -67,8 +67,8 @@ VertexProgram::~VertexProgram()
 
 void VertexProgram::program(Pointer<UInt> &batch, UInt &vertexCount)
 {
-	routine.vertexIndex = *Pointer<SIMD::Int>(As<Pointer<SIMD::Int>>(batch)) +
-	                      SIMD::Int(*Pointer<Int>(data + OFFSET(DrawData, baseVertex)));
+	// The batch indices already include the base vertex.
+	routine.vertexIndex = *Pointer<SIMD::Int>(As<Pointer<SIMD::Int>>(batch));
 
 	auto it = spirvShader->inputBuiltins.find(spv::BuiltInVertexIndex);
 	if(it != spirvShader->inputBuiltins.end())
@@ -23,6 +23,24 @@
 
 namespace sw {
 
+namespace {
+
+// Loads 32 bits at the given byte offset of four vertices, one vertex per lane. Formats
+// which pack their components into 32-bit words are then unpacked for all four vertices
+// at once, instead of converting each vertex separately and transposing the results.
+Int4 Gather32(const Pointer<Byte> (&source)[4], int offset)
+{
+	Int4 packed;
+	packed = Insert(packed, *Pointer<Int>(source[0] + offset), 0);
+	packed = Insert(packed, *Pointer<Int>(source[1] + offset), 1);
+	packed = Insert(packed, *Pointer<Int>(source[2] + offset), 2);
+	packed = Insert(packed, *Pointer<Int>(source[3] + offset), 3);
+
+	return packed;
+}
+
+}  // anonymous namespace
+
 VertexRoutine::VertexRoutine(
     const VertexProcessor::State &state,
     vk::PipelineLayout const *pipelineLayout,
@@ -65,6 +83,12 @@ void VertexRoutine::generate()
 			computeCullMask();
 
 			writeCache(vertexCache, tagCache, batch);
+
+			if(state.statisticsEnabled)
+			{
+				Pointer<UInt> invocations = Pointer<UInt>(task + OFFSET(VertexTask, vertexInvocations));
+				*invocations += Min(vertexCount, UInt(SIMD::Width));
+			}
 		}
 
 		Pointer<Byte> cacheEntry = vertexCache + cacheIndex * UInt((int)sizeof(Vertex));
@@ -95,14 +119,13 @@ void VertexRoutine::readInput(Pointer<UInt> &batch)
 		{
 			Pointer<Byte> input = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData, input) + sizeof(void *) * (i / 4));
 			UInt stride = *Pointer<UInt>(data + OFFSET(DrawData, stride) + sizeof(uint32_t) * (i / 4));
-			Int baseVertex = *Pointer<Int>(data + OFFSET(DrawData, baseVertex));
 			UInt robustnessSize(0);
 			if(state.robustBufferAccess)
 			{
 				robustnessSize = *Pointer<UInt>(data + OFFSET(DrawData, robustnessSize) + sizeof(uint32_t) * (i / 4));
 			}
 
-			auto value = readStream(input, stride, state.input[i / 4], batch, state.robustBufferAccess, robustnessSize, baseVertex);
+			auto value = readStream(input, stride, state.input[i / 4], batch, state.robustBufferAccess, robustnessSize);
 			routine.inputs[i + 0] = value.x;
 			routine.inputs[i + 1] = value.y;
 			routine.inputs[i + 2] = value.z;
@@ -165,15 +188,16 @@ void VertexRoutine::computeCullMask()
 }
 
 Vector4f VertexRoutine::readStream(Pointer<Byte> &buffer, UInt &stride, const Stream &stream, Pointer<UInt> &batch,
-                                   bool robustBufferAccess, UInt &robustnessSize, Int baseVertex)
+                                   bool robustBufferAccess, UInt &robustnessSize)
 {
 	Vector4f v;
-	// Because of the following rule in the Vulkan spec, we do not care if a very large negative
-	// baseVertex would overflow all the way back into a valid region of the index buffer:
+	// The batch indices include the base vertex. Because of the following rule in the Vulkan spec,
+	// we do not care if a very large negative baseVertex would overflow all the way back into a
+	// valid region of the index buffer:
 	// "Out-of-bounds buffer loads will return any of the following values :
 	//  - Values from anywhere within the memory range(s) bound to the buffer (possibly including
 	//    bytes of memory past the end of the buffer, up to the end of the bound range)."
-	UInt4 offsets = (*Pointer<UInt4>(As<Pointer<UInt4>>(batch)) + As<UInt4>(Int4(baseVertex))) * UInt4(stride);
+	UInt4 offsets = *Pointer<UInt4>(As<Pointer<UInt4>>(batch)) * UInt4(stride);
 
 	Pointer<Byte> source0 = buffer + offsets.x;
 	Pointer<Byte> source1 = buffer + offsets.y;
@@ -194,6 +218,8 @@ Vector4f VertexRoutine::readStream(Pointer<Byte> &buffer, UInt &stride, const St
 		source3 = IfThenElse(limits.w <= robustnessSize, source3, zeroSource);
 	}
 
+	const Pointer<Byte> sources[4] = { source0, source1, source2, source3 };
+
 	int componentCount = format.componentCount();
 	bool normalized = !format.isUnnormalizedInteger();
 	bool isNativeFloatAttrib = (stream.attribType == SpirvShader::ATTRIBTYPE_FLOAT) || normalized;
@@ -238,65 +264,73 @@ Vector4f VertexRoutine::readStream(Pointer<Byte> &buffer, UInt &stride, const St
 		case VK_FORMAT_R8G8_UNORM:
 		case VK_FORMAT_R8G8B8A8_UNORM:
 		case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
-			v.x = Float4(*Pointer<Byte4>(source0));
-			v.y = Float4(*Pointer<Byte4>(source1));
-			v.z = Float4(*Pointer<Byte4>(source2));
-			v.w = Float4(*Pointer<Byte4>(source3));
-
-			transpose4xN(v.x, v.y, v.z, v.w, componentCount);
+		{
+			Int4 src = Gather32(sources, 0);
 
-			if(componentCount >= 1) v.x *= *Pointer<Float4>(constants + OFFSET(Constants, unscaleByte));
-			if(componentCount >= 2) v.y *= *Pointer<Float4>(constants + OFFSET(Constants, unscaleByte));
-			if(componentCount >= 3) v.z *= *Pointer<Float4>(constants + OFFSET(Constants, unscaleByte));
-			if(componentCount >= 4) v.w *= *Pointer<Float4>(constants + OFFSET(Constants, unscaleByte));
-			break;
+			if(componentCount >= 1) v.x = Float4(src & Int4(0xFF)) * *Pointer<Float4>(constants + OFFSET(Constants, unscaleByte));
+			if(componentCount >= 2) v.y = Float4((src >> 8) & Int4(0xFF)) * *Pointer<Float4>(constants + OFFSET(Constants, unscaleByte));
+			if(componentCount >= 3) v.z = Float4((src >> 16) & Int4(0xFF)) * *Pointer<Float4>(constants + OFFSET(Constants, unscaleByte));
+			if(componentCount >= 4) v.w = Float4((src >> 24) & Int4(0xFF)) * *Pointer<Float4>(constants + OFFSET(Constants, unscaleByte));
+		}
+		break;
 		case VK_FORMAT_R8_UINT:
 		case VK_FORMAT_R8G8_UINT:
 		case VK_FORMAT_R8G8B8A8_UINT:
 		case VK_FORMAT_A8B8G8R8_UINT_PACK32:
-			v.x = As<Float4>(Int4(*Pointer<Byte4>(source0)));
-			v.y = As<Float4>(Int4(*Pointer<Byte4>(source1)));
-			v.z = As<Float4>(Int4(*Pointer<Byte4>(source2)));
-			v.w = As<Float4>(Int4(*Pointer<Byte4>(source3)));
+		{
+			Int4 src = Gather32(sources, 0);
 
-			transpose4xN(v.x, v.y, v.z, v.w, componentCount);
-			break;
+			v.x = As<Float4>(src & Int4(0xFF));
+			v.y = As<Float4>((src >> 8) & Int4(0xFF));
+			v.z = As<Float4>((src >> 16) & Int4(0xFF));
+			v.w = As<Float4>((src >> 24) & Int4(0xFF));
+		}
+		break;
 		case VK_FORMAT_R8_SNORM:
 		case VK_FORMAT_R8G8_SNORM:
 		case VK_FORMAT_R8G8B8A8_SNORM:
 		case VK_FORMAT_A8B8G8R8_SNORM_PACK32:
-			v.x = Float4(*Pointer<SByte4>(source0));
-			v.y = Float4(*Pointer<SByte4>(source1));
-			v.z = Float4(*Pointer<SByte4>(source2));
-			v.w = Float4(*Pointer<SByte4>(source3));
-
-			transpose4xN(v.x, v.y, v.z, v.w, componentCount);
+		{
+			Int4 src = Gather32(sources, 0);
 
-			if(componentCount >= 1) v.x = Max(v.x * *Pointer<Float4>(constants + OFFSET(Constants, unscaleSByte)), Float4(-1.0f));
-			if(componentCount >= 2) v.y = Max(v.y * *Pointer<Float4>(constants + OFFSET(Constants, unscaleSByte)), Float4(-1.0f));
-			if(componentCount >= 3) v.z = Max(v.z * *Pointer<Float4>(constants + OFFSET(Constants, unscaleSByte)), Float4(-1.0f));
-			if(componentCount >= 4) v.w = Max(v.w * *Pointer<Float4>(constants + OFFSET(Constants, unscaleSByte)), Float4(-1.0f));
-			break;
+			if(componentCount >= 1) v.x = Max(Float4((src << 24) >> 24) * *Pointer<Float4>(constants + OFFSET(Constants, unscaleSByte)), Float4(-1.0f));
+			if(componentCount >= 2) v.y = Max(Float4((src << 16) >> 24) * *Pointer<Float4>(constants + OFFSET(Constants, unscaleSByte)), Float4(-1.0f));
+			if(componentCount >= 3) v.z = Max(Float4((src << 8) >> 24) * *Pointer<Float4>(constants + OFFSET(Constants, unscaleSByte)), Float4(-1.0f));
+			if(componentCount >= 4) v.w = Max(Float4(src >> 24) * *Pointer<Float4>(constants + OFFSET(Constants, unscaleSByte)), Float4(-1.0f));
+		}
+		break;
 		case VK_FORMAT_R8_SINT:
 		case VK_FORMAT_R8G8_SINT:
 		case VK_FORMAT_R8G8B8A8_SINT:
 		case VK_FORMAT_A8B8G8R8_SINT_PACK32:
-			v.x = As<Float4>(Int4(*Pointer<SByte4>(source0)));
-			v.y = As<Float4>(Int4(*Pointer<SByte4>(source1)));
-			v.z = As<Float4>(Int4(*Pointer<SByte4>(source2)));
-			v.w = As<Float4>(Int4(*Pointer<SByte4>(source3)));
+		{
+			Int4 src = Gather32(sources, 0);
 
-			transpose4xN(v.x, v.y, v.z, v.w, componentCount);
-			break;
+			v.x = As<Float4>((src << 24) >> 24);
+			v.y = As<Float4>((src << 16) >> 24);
+			v.z = As<Float4>((src << 8) >> 24);
+			v.w = As<Float4>(src >> 24);
+		}
+		break;
 		case VK_FORMAT_R16_SNORM:
 		case VK_FORMAT_R16G16_SNORM:
 		case VK_FORMAT_R16G16B16A16_SNORM:
-			v.x = Float4(*Pointer<Short4>(source0));
-			v.y = Float4(*Pointer<Short4>(source1));
-			v.z = Float4(*Pointer<Short4>(source2));
-			v.w = Float4(*Pointer<Short4>(source3));
+			if(componentCount <= 2)
+			{
+				Int4 src = Gather32(sources, 0);
 
-			transpose4xN(v.x, v.y, v.z, v.w, componentCount);
+				v.x = Float4((src << 16) >> 16);
+				v.y = Float4(src >> 16);
+			}
+			else
+			{
+				v.x = Float4(*Pointer<Short4>(source0));
+				v.y = Float4(*Pointer<Short4>(source1));
+				v.z = Float4(*Pointer<Short4>(source2));
+				v.w = Float4(*Pointer<Short4>(source3));
+
+				transpose4xN(v.x, v.y, v.z, v.w, componentCount);
+			}
 
 			if(componentCount >= 1) v.x = Max(v.x * *Pointer<Float4>(constants + OFFSET(Constants, unscaleShort)), Float4(-1.0f));
 			if(componentCount >= 2) v.y = Max(v.y * *Pointer<Float4>(constants + OFFSET(Constants, unscaleShort)), Float4(-1.0f));
@@ -306,22 +340,42 @@ Vector4f VertexRoutine::readStream(Pointer<Byte> &buffer, UInt &stride, const St
 		case VK_FORMAT_R16_SINT:
 		case VK_FORMAT_R16G16_SINT:
 		case VK_FORMAT_R16G16B16A16_SINT:
-			v.x = As<Float4>(Int4(*Pointer<Short4>(source0)));
-			v.y = As<Float4>(Int4(*Pointer<Short4>(source1)));
-			v.z = As<Float4>(Int4(*Pointer<Short4>(source2)));
-			v.w = As<Float4>(Int4(*Pointer<Short4>(source3)));
+			if(componentCount <= 2)
+			{
+				Int4 src = Gather32(sources, 0);
 
-			transpose4xN(v.x, v.y, v.z, v.w, componentCount);
+				v.x = As<Float4>((src << 16) >> 16);
+				v.y = As<Float4>(src >> 16);
+			}
+			else
+			{
+				v.x = As<Float4>(Int4(*Pointer<Short4>(source0)));
+				v.y = As<Float4>(Int4(*Pointer<Short4>(source1)));
+				v.z = As<Float4>(Int4(*Pointer<Short4>(source2)));
+				v.w = As<Float4>(Int4(*Pointer<Short4>(source3)));
+
+				transpose4xN(v.x, v.y, v.z, v.w, componentCount);
+			}
 			break;
 		case VK_FORMAT_R16_UNORM:
 		case VK_FORMAT_R16G16_UNORM:
 		case VK_FORMAT_R16G16B16A16_UNORM:
-			v.x = Float4(*Pointer<UShort4>(source0));
-			v.y = Float4(*Pointer<UShort4>(source1));
-			v.z = Float4(*Pointer<UShort4>(source2));
-			v.w = Float4(*Pointer<UShort4>(source3));
+			if(componentCount <= 2)
+			{
+				Int4 src = Gather32(sources, 0);
 
-			transpose4xN(v.x, v.y, v.z, v.w, componentCount);
+				v.x = Float4(src & Int4(0xFFFF));
+				v.y = Float4((src >> 16) & Int4(0xFFFF));
+			}
+			else
+			{
+				v.x = Float4(*Pointer<UShort4>(source0));
+				v.y = Float4(*Pointer<UShort4>(source1));
+				v.z = Float4(*Pointer<UShort4>(source2));
+				v.w = Float4(*Pointer<UShort4>(source3));
+
+				transpose4xN(v.x, v.y, v.z, v.w, componentCount);
+			}
 
 			if(componentCount >= 1) v.x *= *Pointer<Float4>(constants + OFFSET(Constants, unscaleUShort));
 			if(componentCount >= 2) v.y *= *Pointer<Float4>(constants + OFFSET(Constants, unscaleUShort));
@@ -331,12 +385,22 @@ Vector4f VertexRoutine::readStream(Pointer<Byte> &buffer, UInt &stride, const St
 		case VK_FORMAT_R16_UINT:
 		case VK_FORMAT_R16G16_UINT:
 		case VK_FORMAT_R16G16B16A16_UINT:
-			v.x = As<Float4>(Int4(*Pointer<UShort4>(source0)));
-			v.y = As<Float4>(Int4(*Pointer<UShort4>(source1)));
-			v.z = As<Float4>(Int4(*Pointer<UShort4>(source2)));
-			v.w = As<Float4>(Int4(*Pointer<UShort4>(source3)));
+			if(componentCount <= 2)
+			{
+				Int4 src = Gather32(sources, 0);
 
-			transpose4xN(v.x, v.y, v.z, v.w, componentCount);
+				v.x = As<Float4>(src & Int4(0xFFFF));
+				v.y = As<Float4>((src >> 16) & Int4(0xFFFF));
+			}
+			else
+			{
+				v.x = As<Float4>(Int4(*Pointer<UShort4>(source0)));
+				v.y = As<Float4>(Int4(*Pointer<UShort4>(source1)));
+				v.z = As<Float4>(Int4(*Pointer<UShort4>(source2)));
+				v.w = As<Float4>(Int4(*Pointer<UShort4>(source3)));
+
+				transpose4xN(v.x, v.y, v.z, v.w, componentCount);
+			}
 			break;
 		case VK_FORMAT_R32_SINT:
 		case VK_FORMAT_R32G32_SINT:
@@ -422,11 +486,7 @@ Vector4f VertexRoutine::readStream(Pointer<Byte> &buffer, UInt &stride, const St
 			// [[fallthrough]]
 		case VK_FORMAT_A2B10G10R10_SNORM_PACK32:
 		{
-			Int4 src;
-			src = Insert(src, *Pointer<Int>(source0), 0);
-			src = Insert(src, *Pointer<Int>(source1), 1);
-			src = Insert(src, *Pointer<Int>(source2), 2);
-			src = Insert(src, *Pointer<Int>(source3), 3);
+			Int4 src = Gather32(sources, 0);
 			v.x = Float4((src << 22) >> 22);
 			v.y = Float4((src << 12) >> 22);
 			v.z = Float4((src << 02) >> 22);
@@ -443,11 +503,7 @@ Vector4f VertexRoutine::readStream(Pointer<Byte> &buffer, UInt &stride, const St
 			// [[fallthrough]]
 		case VK_FORMAT_A2B10G10R10_SINT_PACK32:
 		{
-			Int4 src;
-			src = Insert(src, *Pointer<Int>(source0), 0);
-			src = Insert(src, *Pointer<Int>(source1), 1);
-			src = Insert(src, *Pointer<Int>(source2), 2);
-			src = Insert(src, *Pointer<Int>(source3), 3);
+			Int4 src = Gather32(sources, 0);
 			v.x = As<Float4>((src << 22) >> 22);
 			v.y = As<Float4>((src << 12) >> 22);
 			v.z = As<Float4>((src << 02) >> 22);
@@ -459,11 +515,7 @@ Vector4f VertexRoutine::readStream(Pointer<Byte> &buffer, UInt &stride, const St
 			// [[fallthrough]]
 		case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
 		{
-			Int4 src;
-			src = Insert(src, *Pointer<Int>(source0), 0);
-			src = Insert(src, *Pointer<Int>(source1), 1);
-			src = Insert(src, *Pointer<Int>(source2), 2);
-			src = Insert(src, *Pointer<Int>(source3), 3);
+			Int4 src = Gather32(sources, 0);
 
 			v.x = Float4(src & Int4(0x3FF));
 			v.y = Float4((src >> 10) & Int4(0x3FF));
@@ -481,11 +533,7 @@ Vector4f VertexRoutine::readStream(Pointer<Byte> &buffer, UInt &stride, const St
 			// [[fallthrough]]
 		case VK_FORMAT_A2B10G10R10_UINT_PACK32:
 		{
-			Int4 src;
-			src = Insert(src, *Pointer<Int>(source0), 0);
-			src = Insert(src, *Pointer<Int>(source1), 1);
-			src = Insert(src, *Pointer<Int>(source2), 2);
-			src = Insert(src, *Pointer<Int>(source3), 3);
+			Int4 src = Gather32(sources, 0);
 
 			v.x = As<Float4>(src & Int4(0x3FF));
 			v.y = As<Float4>((src >> 10) & Int4(0x3FF));
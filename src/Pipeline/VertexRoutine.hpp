@@ -71,7 +71,7 @@ private:
 	typedef VertexProcessor::State::Input Stream;
 
 	Vector4f readStream(Pointer<Byte> &buffer, UInt &stride, const Stream &stream, Pointer<UInt> &batch,
-	                    bool robustBufferAccess, UInt &robustnessSize, Int baseVertex);
+	                    bool robustBufferAccess, UInt &robustnessSize);
 	void readInput(Pointer<UInt> &batch);
 	void computeClipFlags();
 	void computeCullMask();
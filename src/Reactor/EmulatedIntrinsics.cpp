@@ -151,6 +151,30 @@ void Scatter(RValue<Pointer<Int>> base, RValue<Int4> val, RValue<Int4> offsets,
 	scatter<Int4>(base, val, offsets, mask, alignment);
 }
 
+RValue<Float4> MaskedLoad(RValue<Pointer<Float4>> base, RValue<Int4> mask, unsigned int alignment, bool zeroMaskedLanes /* = false */)
+{
+	Float4 result{};
+	gather<Float4, Float>(result, Pointer<Float>(base), Int4(0, 4, 8, 12), mask, std::min(alignment, 4u), zeroMaskedLanes);
+	return result;
+}
+
+RValue<Int4> MaskedLoad(RValue<Pointer<Int4>> base, RValue<Int4> mask, unsigned int alignment, bool zeroMaskedLanes /* = false */)
+{
+	Int4 result{};
+	gather<Int4, Int>(result, Pointer<Int>(base), Int4(0, 4, 8, 12), mask, std::min(alignment, 4u), zeroMaskedLanes);
+	return result;
+}
+
+void MaskedStore(RValue<Pointer<Float4>> base, RValue<Float4> val, RValue<Int4> mask, unsigned int alignment)
+{
+	scatter<Float4, Float>(Pointer<Float>(base), val, Int4(0, 4, 8, 12), mask, std::min(alignment, 4u));
+}
+
+void MaskedStore(RValue<Pointer<Int4>> base, RValue<Int4> val, RValue<Int4> mask, unsigned int alignment)
+{
+	scatter<Int4, Int>(Pointer<Int>(base), val, Int4(0, 4, 8, 12), mask, std::min(alignment, 4u));
+}
+
 RValue<Float> Exp2(RValue<Float> x)
 {
 	return Call(exp2f, x);
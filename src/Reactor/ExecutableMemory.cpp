@@ -39,6 +39,13 @@
 
 #include <memory.h>
 
+#if defined(__linux__)
+#	include <algorithm>
+#	include <atomic>
+#	include <bitset>
+#	include <mutex>
+#endif
+
 #undef allocate
 #undef deallocate
 
@@ -135,33 +142,35 @@ int permissionsToMmapProt(int permissions)
 }
 #endif  // !defined(_WIN32) && !defined(__Fuchsia__)
 
-#if defined(__linux__) && defined(REACTOR_ANONYMOUS_MMAP_NAME)
-#	if !defined(__ANDROID__)
+#if defined(__linux__) && !defined(__ANDROID__)
 // Create a file descriptor for anonymous memory with the given
 // name. Returns -1 on failure.
 // TODO: remove once libc wrapper exists.
 static int memfd_create(const char *name, unsigned int flags)
 {
-#		if __aarch64__
-#			define __NR_memfd_create 279
-#		elif __arm__
-#			define __NR_memfd_create 279
-#		elif __powerpc64__
-#			define __NR_memfd_create 360
-#		elif __i386__
-#			define __NR_memfd_create 356
-#		elif __x86_64__
-#			define __NR_memfd_create 319
-#		endif /* __NR_memfd_create__ */
-#		ifdef __NR_memfd_create
+#	if __aarch64__
+#		define __NR_memfd_create 279
+#	elif __arm__
+#		define __NR_memfd_create 279
+#	elif __powerpc64__
+#		define __NR_memfd_create 360
+#	elif __i386__
+#		define __NR_memfd_create 356
+#	elif __x86_64__
+#		define __NR_memfd_create 319
+#	endif /* __NR_memfd_create__ */
+#	ifdef __NR_memfd_create
 	// In the event of no system call this returns -1 with errno set
 	// as ENOSYS.
 	return syscall(__NR_memfd_create, name, flags);
-#		else
+#	else
 	return -1;
-#		endif
+#	endif
 }
+#endif  // defined(__linux__) && !defined(__ANDROID__)
 
+#if defined(__linux__) && defined(REACTOR_ANONYMOUS_MMAP_NAME)
+#	if !defined(__ANDROID__)
 // Returns a file descriptor for use with an anonymous mmap, if
 // memfd_create fails, -1 is returned. Note, the mappings should be
 // MAP_PRIVATE so that underlying pages aren't shared.
@@ -190,6 +199,66 @@ void ensureAnonFileSize(int anonFd, size_t length)
 }
 #endif  // defined(__linux__) && defined(REACTOR_ANONYMOUS_MMAP_NAME)
 
+#if defined(__linux__)
+// Maps |length| bytes of private anonymous memory with the given protection.
+// Returns nullptr on failure.
+void *mapAnonymous(size_t length, int prot)
+{
+	int flags = MAP_PRIVATE;
+	int anonFd = -1;
+
+#	if defined(REACTOR_ANONYMOUS_MMAP_NAME)
+	// Try to name the memory region for the executable code,
+	// to aid profilers.
+	anonFd = anonymousFd();
+	if(anonFd != -1)
+	{
+		ensureAnonFileSize(anonFd, length);
+	}
+#	endif
+
+	if(anonFd == -1)
+	{
+		flags |= MAP_ANONYMOUS;
+	}
+
+	void *mapping = mmap(nullptr, length, prot, flags, anonFd, 0);
+
+	if(mapping == MAP_FAILED)
+	{
+		return nullptr;
+	}
+
+#	if defined(__ANDROID__) && defined(REACTOR_ANONYMOUS_MMAP_NAME)
+	// On Android, prefer to use a non-standard prctl called
+	// PR_SET_VMA_ANON_NAME to set the name of a private anonymous
+	// mapping, as Android restricts EXECUTE permission on
+	// CoW/shared anonymous mappings with sepolicy neverallows.
+	prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, mapping, length,
+	      MACRO_STRINGIFY(REACTOR_ANONYMOUS_MMAP_NAME));
+#	endif  // __ANDROID__
+
+	return mapping;
+}
+
+// Returns a file descriptor for the shared memory which Packed code arenas
+// map twice. Returns -1 if shared executable mappings are unavailable.
+int createCodeMemoryFd()
+{
+#	if defined(__ANDROID__)
+	// Android restricts EXECUTE permission on shared anonymous mappings.
+	return -1;
+#	else
+#		if defined(REACTOR_ANONYMOUS_MMAP_NAME)
+	const char *name = MACRO_STRINGIFY(REACTOR_ANONYMOUS_MMAP_NAME);
+#		else
+	const char *name = "reactor_jit";
+#		endif
+	return memfd_create(name, 1 /* MFD_CLOEXEC */);
+#	endif
+}
+#endif  // defined(__linux__)
+
 #if defined(__Fuchsia__)
 zx_vm_option_t permissionsToZxVmOptions(int permissions)
 {
@@ -212,6 +281,379 @@ zx_vm_option_t permissionsToZxVmOptions(int permissions)
 
 }  // anonymous namespace
 
+#if defined(__linux__)
+struct CodeArena::Slab
+{
+	static constexpr size_t MaxUnitCount = 4096;
+	static constexpr size_t WordBits = 64;
+
+	Slab(uint8_t *base, uint8_t *writable)
+	    : base(base)
+	    , writable(writable)
+	{}
+
+	// First-fit search for |units| consecutive free units, starting at a
+	// multiple of |alignmentUnits|. Returns the index of the first unit, or
+	// |unitCount| if there is no such run.
+	size_t allocate(size_t units, size_t alignmentUnits, size_t unitCount)
+	{
+		size_t run = 0;
+		for(size_t i = 0; i < unitCount; i++)
+		{
+			if(run == 0 && (i % alignmentUnits) != 0)
+			{
+				continue;
+			}
+
+			run = used[i] ? 0 : run + 1;
+
+			if(run == units)
+			{
+				size_t first = i + 1 - units;
+				for(size_t j = first; j <= i; j++)
+				{
+					used[j] = true;
+				}
+
+				return first;
+			}
+		}
+
+		return unitCount;
+	}
+
+	// Marks units as released. Doesn't require the arena lock.
+	void release(size_t first, size_t units)
+	{
+		ASSERT(first + units <= MaxUnitCount);
+
+		for(size_t i = first; i < first + units;)
+		{
+			size_t bit = i % WordBits;
+			size_t bits = std::min(WordBits - bit, first + units - i);
+			uint64_t mask = (bits == WordBits) ? ~uint64_t(0) : (((uint64_t(1) << bits) - 1) << bit);
+
+			released[i / WordBits].fetch_or(mask, std::memory_order_release);
+			i += bits;
+		}
+	}
+
+	// Marks released units as free again, and calls |reset| for each
+	// contiguous run of them. Returns the number of units reclaimed.
+	template<typename F>
+	size_t reclaim(size_t unitCount, F reset)
+	{
+		std::bitset<MaxUnitCount> pending;
+		for(size_t w = 0; w < unitCount / WordBits; w++)
+		{
+			uint64_t bits = released[w].exchange(0, std::memory_order_acquire);
+			for(size_t bit = 0; bits != 0; bit++, bits >>= 1)
+			{
+				pending[w * WordBits + bit] = (bits & 1) != 0;
+			}
+		}
+
+		size_t reclaimed = 0;
+		for(size_t first = 0; first < unitCount;)
+		{
+			if(!pending[first])
+			{
+				first++;
+				continue;
+			}
+
+			size_t end = first;
+			while(end < unitCount && pending[end])
+			{
+				used[end] = false;
+				end++;
+			}
+
+			reset(first, end);
+
+			reclaimed += end - first;
+			first = end;
+		}
+
+		return reclaimed;
+	}
+
+	uint8_t *const base;      // Where the code runs from
+	uint8_t *const writable;  // Where the code is written to
+	std::bitset<MaxUnitCount> used;  // Guarded by the arena mutex
+	std::atomic<uint64_t> released[MaxUnitCount / WordBits] = {};
+};
+
+CodeArena::CodeArena(Kind kind)
+    : kind(kind)
+    , unitSize((kind == Pages) ? memoryPageSize() : 64)
+    , unitCount((kind == Pages) ? 256 : Slab::MaxUnitCount)
+    , ownerProcess(getpid())
+{
+	if(kind == Packed)
+	{
+		fd = createCodeMemoryFd();
+	}
+}
+
+CodeArena::~CodeArena()
+{
+	size_t count = slabCount.load(std::memory_order_relaxed);
+	for(size_t i = 0; i < count; i++)
+	{
+		munmap(slabs[i]->base, unitCount * unitSize);
+		if(slabs[i]->writable != slabs[i]->base)
+		{
+			munmap(slabs[i]->writable, unitCount * unitSize);
+		}
+
+		delete slabs[i];
+	}
+
+	if(fd != -1)
+	{
+		close(fd);
+	}
+}
+
+void *CodeArena::allocate(size_t bytes, size_t alignment, void **writable)
+{
+	ASSERT((alignment & (alignment - 1)) == 0);  // Power of 2 alignment.
+
+	size_t units = (bytes + unitSize - 1) / unitSize;
+	size_t alignmentUnits = std::max(alignment / unitSize, size_t(1));
+
+	if(units == 0 || units > unitCount || alignmentUnits > unitCount || forked())
+	{
+		return nullptr;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+
+	uint8_t *memory = allocateLocked(units, alignmentUnits);
+
+	if(!memory && releasedUnits.load(std::memory_order_relaxed) > 0)
+	{
+		reclaimLocked();
+		memory = allocateLocked(units, alignmentUnits);
+	}
+
+	if(!memory)
+	{
+		size_t index = slabCount.load(std::memory_order_relaxed);
+		if(index == MaxSlabCount)
+		{
+			return nullptr;
+		}
+
+		Slab *slab = mapSlab();
+		if(!slab)
+		{
+			return nullptr;
+		}
+
+		slabs[index] = slab;
+		slabCount.store(index + 1, std::memory_order_release);
+		memory = allocateLocked(units, alignmentUnits);
+		ASSERT(memory);
+	}
+
+	usedUnits += units;
+
+	size_t count = slabCount.load(std::memory_order_relaxed);
+	for(size_t i = 0; i < count; i++)
+	{
+		if(memory >= slabs[i]->base && memory < slabs[i]->base + unitCount * unitSize)
+		{
+			*writable = slabs[i]->writable + (memory - slabs[i]->base);
+			break;
+		}
+	}
+
+	return memory;
+}
+
+bool CodeArena::deallocate(void *memory, size_t bytes)
+{
+	uint8_t *begin = static_cast<uint8_t *>(memory);
+	size_t units = (bytes + unitSize - 1) / unitSize;
+
+	// Slabs are never removed, so they can be looked up without the lock.
+	size_t count = slabCount.load(std::memory_order_acquire);
+	for(size_t i = 0; i < count; i++)
+	{
+		Slab *slab = slabs[i];
+		if(begin < slab->base || begin >= slab->base + unitCount * unitSize)
+		{
+			continue;
+		}
+
+		if(forked())
+		{
+			// The parent process may still reuse this memory, through the
+			// same shared pages. Leak it instead.
+			return true;
+		}
+
+		// Count the units before publishing them, so that a concurrent
+		// reclaim never subtracts more units than have been added.
+		size_t pending = releasedUnits.fetch_add(units, std::memory_order_relaxed) + units;
+		slab->release((begin - slab->base) / unitSize, units);
+
+		if(pending >= unitCount / 4)
+		{
+			// Let whichever thread already holds the lock reclaim the units later.
+			std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+			if(lock.owns_lock())
+			{
+				reclaimLocked();
+			}
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+CodeArena::Stats CodeArena::stats()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	Stats stats;
+	stats.slabCount = slabCount.load(std::memory_order_relaxed);
+	stats.slabBytes = unitCount * unitSize;
+	stats.usedBytes = usedUnits * unitSize;
+	stats.releasedBytes = releasedUnits.load(std::memory_order_relaxed) * unitSize;
+
+	return stats;
+}
+
+CodeArena::Slab *CodeArena::mapSlab()
+{
+	size_t length = unitCount * unitSize;
+
+	if(kind == Pages)
+	{
+		void *base = mapAnonymous(length, PROT_READ | PROT_WRITE);
+		return base ? new Slab(static_cast<uint8_t *>(base), static_cast<uint8_t *>(base)) : nullptr;
+	}
+
+	if(fd == -1)
+	{
+		return nullptr;
+	}
+
+	off_t offset = slabCount.load(std::memory_order_relaxed) * length;
+	if(ftruncate(fd, offset + length) != 0)
+	{
+		return nullptr;
+	}
+
+	void *base = mmap(nullptr, length, PROT_READ | PROT_EXEC, MAP_SHARED, fd, offset);
+	if(base == MAP_FAILED)
+	{
+		return nullptr;
+	}
+
+	void *writable = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
+	if(writable == MAP_FAILED)
+	{
+		munmap(base, length);
+		return nullptr;
+	}
+
+	return new Slab(static_cast<uint8_t *>(base), static_cast<uint8_t *>(writable));
+}
+
+uint8_t *CodeArena::allocateLocked(size_t units, size_t alignmentUnits)
+{
+	size_t count = slabCount.load(std::memory_order_relaxed);
+	for(size_t i = 0; i < count; i++)
+	{
+		size_t first = slabs[i]->allocate(units, alignmentUnits, unitCount);
+		if(first != unitCount)
+		{
+			return slabs[i]->base + first * unitSize;
+		}
+	}
+
+	return nullptr;
+}
+
+void CodeArena::reclaimLocked()
+{
+	size_t pageSize = memoryPageSize();
+
+	size_t count = slabCount.load(std::memory_order_relaxed);
+	for(size_t i = 0; i < count; i++)
+	{
+		Slab *slab = slabs[i];
+
+		size_t reclaimed = slab->reclaim(unitCount, [&](size_t first, size_t end) {
+			size_t begin = first * unitSize;
+			size_t length = (end - first) * unitSize;
+
+			if(kind == Pages)
+			{
+				// Drops execute permission, and the stale code.
+				[[maybe_unused]] int result = mprotect(slab->base + begin, length, PROT_READ | PROT_WRITE);
+				ASSERT(result == 0);
+				madvise(slab->base + begin, length, MADV_DONTNEED);
+				return;
+			}
+
+			// Discard the pages which are now entirely free, and zero the
+			// released parts of the others.
+			for(size_t page = begin & ~(pageSize - 1); page < begin + length; page += pageSize)
+			{
+				size_t pageUnits = pageSize / unitSize;
+				size_t firstUnit = page / unitSize;
+				bool unused = true;
+				for(size_t u = firstUnit; u < firstUnit + pageUnits; u++)
+				{
+					unused = unused && !slab->used[u];
+				}
+
+				if(unused)
+				{
+					madvise(slab->writable + page, pageSize, MADV_REMOVE);
+				}
+				else
+				{
+					size_t from = std::max(page, begin);
+					size_t to = std::min(page + pageSize, begin + length);
+					memset(slab->writable + from, 0, to - from);
+				}
+			}
+		});
+
+		usedUnits -= reclaimed;
+		releasedUnits.fetch_sub(reclaimed, std::memory_order_relaxed);
+	}
+}
+
+bool CodeArena::forked() const
+{
+	// Packed slabs are shared with child processes, which must not write to
+	// them.
+	return (kind == Packed) && (getpid() != ownerProcess);
+}
+
+namespace {
+
+CodeArena &codeArena(CodeArena::Kind kind)
+{
+	// Intentionally leaked: routines may outlive static destructors.
+	static CodeArena *pages = new CodeArena(CodeArena::Pages);
+	static CodeArena *packed = new CodeArena(CodeArena::Packed);
+
+	return (kind == CodeArena::Pages) ? *pages : *packed;
+}
+
+}  // anonymous namespace
+#endif  // defined(__linux__)
+
 size_t memoryPageSize()
 {
 	static int pageSize = [] {
@@ -267,39 +709,26 @@ void *allocateMemoryPages(size_t bytes, int permissions, bool need_exec)
 	size_t length = roundUp(bytes, pageSize);
 	void *mapping = nullptr;
 
-#if defined(__linux__) && defined(REACTOR_ANONYMOUS_MMAP_NAME)
-	int flags = MAP_PRIVATE;
-
-	// Try to name the memory region for the executable code,
-	// to aid profilers.
-	int anonFd = anonymousFd();
-	if(anonFd == -1)
+#if defined(__linux__)
+	if(need_exec)
 	{
-		flags |= MAP_ANONYMOUS;
-	}
-	else
-	{
-		ensureAnonFileSize(anonFd, length);
-	}
-
-	mapping = mmap(
-	    nullptr, length, permissionsToMmapProt(permissions), flags, anonFd, 0);
+		void *writable = nullptr;
+		mapping = codeArena(CodeArena::Pages).allocate(length, pageSize, &writable);
+		if(mapping)
+		{
+			// Free pages in the arena are read+write.
+			if(permissions != (PERMISSION_READ | PERMISSION_WRITE))
+			{
+				protectMemoryPages(mapping, length, permissions);
+			}
 
-	if(mapping == MAP_FAILED)
-	{
-		mapping = nullptr;
-	}
-#	if defined(__ANDROID__)
-	else
-	{
-		// On Android, prefer to use a non-standard prctl called
-		// PR_SET_VMA_ANON_NAME to set the name of a private anonymous
-		// mapping, as Android restricts EXECUTE permission on
-		// CoW/shared anonymous mappings with sepolicy neverallows.
-		prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, mapping, length,
-		      MACRO_STRINGIFY(REACTOR_ANONYMOUS_MMAP_NAME));
+			return mapping;
+		}
 	}
-#	endif  // __ANDROID__
+#endif
+
+#if defined(__linux__) && defined(REACTOR_ANONYMOUS_MMAP_NAME)
+	mapping = mapAnonymous(length, permissionsToMmapProt(permissions));
 #elif defined(__Fuchsia__)
 	zx_handle_t vmo;
 	if(zx_vmo_create(length, 0, &vmo) != ZX_OK)
@@ -381,6 +810,13 @@ void protectMemoryPages(void *memory, size_t bytes, int permissions)
 
 void deallocateMemoryPages(void *memory, size_t bytes)
 {
+#if defined(__linux__)
+	if(codeArena(CodeArena::Pages).deallocate(memory, roundUp(bytes, memoryPageSize())))
+	{
+		return;
+	}
+#endif
+
 #if defined(_WIN32)
 	unsigned long oldProtection;
 	BOOL result =
@@ -405,4 +841,23 @@ void deallocateMemoryPages(void *memory, size_t bytes)
 #endif
 }
 
+void *allocateCodeMemory(size_t bytes, size_t alignment, void **writable)
+{
+#if defined(__linux__)
+	return codeArena(CodeArena::Packed).allocate(bytes, alignment, writable);
+#else
+	return nullptr;
+#endif
+}
+
+void deallocateCodeMemory(void *memory, size_t bytes)
+{
+#if defined(__linux__)
+	[[maybe_unused]] bool released = codeArena(CodeArena::Packed).deallocate(memory, bytes);
+	ASSERT(released);
+#else
+	UNREACHABLE("memory was not allocated with allocateCodeMemory()");
+#endif
+}
+
 }  // namespace rr
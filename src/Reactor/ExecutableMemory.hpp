@@ -19,6 +19,11 @@
 #include <cstdint>
 #include <cstring>
 
+#if defined(__linux__)
+#	include <atomic>
+#	include <mutex>
+#endif
+
 namespace rr {
 
 size_t memoryPageSize();
@@ -40,6 +45,86 @@ void protectMemoryPages(void *memory, size_t bytes, int permissions);
 // Releases memory allocated with allocateMemoryPages().
 void deallocateMemoryPages(void *memory, size_t bytes);
 
+// Allocates executable memory for code which is written once and then never
+// modified. Unlike allocateMemoryPages(), allocations share pages with each
+// other. The code must be written through |*writable|, a read+write view of
+// the same memory, and runs from the returned address. Returns nullptr if this
+// isn't supported, in which case allocateMemoryPages() can be used instead.
+void *allocateCodeMemory(size_t bytes, size_t alignment, void **writable);
+
+// Releases memory allocated with allocateCodeMemory().
+void deallocateCodeMemory(void *memory, size_t bytes);
+
+#if defined(__linux__)
+// CodeArena serves executable allocations from a few large shared mappings
+// (slabs), instead of creating a mapping per routine.
+//
+// A Pages arena hands out whole pages, whose permissions are set by the caller.
+// Free pages are kept read+write, and released pages are made read+write again
+// and have their backing store discarded.
+//
+// A Packed arena hands out 64 byte blocks, so that many small routines fit in
+// one page. Its slabs are mapped twice from a memfd: code is written through a
+// read+write view and runs from a read+execute view, so pages which routines
+// are running from never change their permissions. Released blocks are zeroed.
+//
+// Releases are recorded without taking the arena lock, and returned to their
+// slab in batches.
+class CodeArena
+{
+public:
+	enum Kind
+	{
+		Pages,
+		Packed,
+	};
+
+	explicit CodeArena(Kind kind);
+	~CodeArena();
+
+	// Returns nullptr if the request can't be served from the arena. The
+	// memory can be written through |*writable|, which differs from the
+	// returned address for Packed arenas.
+	void *allocate(size_t bytes, size_t alignment, void **writable);
+
+	// Returns false if |memory| was not allocated from the arena.
+	bool deallocate(void *memory, size_t bytes);
+
+	struct Stats
+	{
+		size_t slabCount = 0;
+		size_t slabBytes = 0;      // Size of each slab
+		size_t usedBytes = 0;      // Allocated and not yet returned to a slab
+		size_t releasedBytes = 0;  // Released and not yet returned to a slab
+	};
+
+	Stats stats();
+
+private:
+	struct Slab;
+
+	Slab *mapSlab();
+	uint8_t *allocateLocked(size_t units, size_t alignmentUnits);
+	void reclaimLocked();
+	bool forked() const;
+
+	const Kind kind;
+	const size_t unitSize;
+	const size_t unitCount;
+
+	static constexpr size_t MaxSlabCount = 1024;
+
+	std::mutex mutex;
+	Slab *slabs[MaxSlabCount] = {};
+	std::atomic<size_t> slabCount = { 0 };
+	size_t usedUnits = 0;  // Guarded by the mutex
+	std::atomic<size_t> releasedUnits = { 0 };
+
+	int fd = -1;  // Backs the views of Packed slabs
+	const int ownerProcess;
+};
+#endif  // defined(__linux__)
+
 template<typename P>
 P unaligned_read(P *address)
 {
@@ -481,7 +481,7 @@ inline const SectionHeader *elfSection(const ElfHeader *elfHeader, int index)
 	return &sectionHeader(elfHeader)[index];
 }
 
-static void *relocateSymbol(const ElfHeader *elfHeader, const Elf32_Rel &relocation, const SectionHeader &relocationTable)
+static void *relocateSymbol(const ElfHeader *elfHeader, intptr_t loadAddress, const Elf32_Rel &relocation, const SectionHeader &relocationTable)
 {
 	const SectionHeader *target = elfSection(elfHeader, relocationTable.sh_info);
 
@@ -508,7 +508,7 @@ static void *relocateSymbol(const ElfHeader *elfHeader, const Elf32_Rel &relocat
 		if(section != SHN_UNDEF && section < SHN_LORESERVE)
 		{
 			const SectionHeader *target = elfSection(elfHeader, symbol.st_shndx);
-			symbolValue = reinterpret_cast<void *>((intptr_t)elfHeader + symbol.st_value + target->sh_offset);
+			symbolValue = reinterpret_cast<void *>(loadAddress + symbol.st_value + target->sh_offset);
 		}
 		else
 		{
@@ -518,6 +518,7 @@ static void *relocateSymbol(const ElfHeader *elfHeader, const Elf32_Rel &relocat
 
 	intptr_t address = (intptr_t)elfHeader + target->sh_offset;
 	unaligned_ptr<int32_t> patchSite = (int32_t *)(address + relocation.r_offset);
+	intptr_t patchAddress = loadAddress + target->sh_offset + relocation.r_offset;
 
 	if(CPUID::ARM)
 	{
@@ -555,7 +556,7 @@ static void *relocateSymbol(const ElfHeader *elfHeader, const Elf32_Rel &relocat
 				*patchSite = (int32_t)((intptr_t)symbolValue + *patchSite);
 				break;
 			case R_386_PC32:
-				*patchSite = (int32_t)((intptr_t)symbolValue + *patchSite - (intptr_t)patchSite);
+				*patchSite = (int32_t)((intptr_t)symbolValue + *patchSite - patchAddress);
 				break;
 			default:
 				ASSERT(false && "Unsupported relocation type");
@@ -566,7 +567,7 @@ static void *relocateSymbol(const ElfHeader *elfHeader, const Elf32_Rel &relocat
 	return symbolValue;
 }
 
-static void *relocateSymbol(const ElfHeader *elfHeader, const Elf64_Rela &relocation, const SectionHeader &relocationTable)
+static void *relocateSymbol(const ElfHeader *elfHeader, intptr_t loadAddress, const Elf64_Rela &relocation, const SectionHeader &relocationTable)
 {
 	const SectionHeader *target = elfSection(elfHeader, relocationTable.sh_info);
 
@@ -593,7 +594,7 @@ static void *relocateSymbol(const ElfHeader *elfHeader, const Elf64_Rela &reloca
 		if(section != SHN_UNDEF && section < SHN_LORESERVE)
 		{
 			const SectionHeader *target = elfSection(elfHeader, symbol.st_shndx);
-			symbolValue = reinterpret_cast<void *>((intptr_t)elfHeader + symbol.st_value + target->sh_offset);
+			symbolValue = reinterpret_cast<void *>(loadAddress + symbol.st_value + target->sh_offset);
 		}
 		else
 		{
@@ -604,6 +605,7 @@ static void *relocateSymbol(const ElfHeader *elfHeader, const Elf64_Rela &reloca
 	intptr_t address = (intptr_t)elfHeader + target->sh_offset;
 	unaligned_ptr<int32_t> patchSite32 = (int32_t *)(address + relocation.r_offset);
 	unaligned_ptr<int64_t> patchSite64 = (int64_t *)(address + relocation.r_offset);
+	intptr_t patchAddress = loadAddress + target->sh_offset + relocation.r_offset;
 
 	switch(relocation.getType())
 	{
@@ -614,7 +616,7 @@ static void *relocateSymbol(const ElfHeader *elfHeader, const Elf64_Rela &reloca
 			*patchSite64 = (int64_t)((intptr_t)symbolValue + *patchSite64 + relocation.r_addend);
 			break;
 		case R_X86_64_PC32:
-			*patchSite32 = (int32_t)((intptr_t)symbolValue + *patchSite32 - (intptr_t)patchSite32 + relocation.r_addend);
+			*patchSite32 = (int32_t)((intptr_t)symbolValue + *patchSite32 - patchAddress + relocation.r_addend);
 			break;
 		case R_X86_64_32S:
 			*patchSite32 = (int32_t)((intptr_t)symbolValue + *patchSite32 + relocation.r_addend);
@@ -633,7 +635,9 @@ struct EntryPoint
 	size_t codeSize = 0;
 };
 
-std::vector<EntryPoint> loadImage(uint8_t *const elfImage, const std::vector<const char *> &functionNames)
+// Relocates the image in place for running at |loadAddress|, which is where
+// its first byte will be copied to, and returns the entry points there.
+std::vector<EntryPoint> loadImage(uint8_t *const elfImage, intptr_t loadAddress, const std::vector<const char *> &functionNames)
 {
 	ASSERT(functionNames.size() > 0);
 	std::vector<EntryPoint> entryPoints(functionNames.size());
@@ -687,7 +691,7 @@ std::vector<EntryPoint> loadImage(uint8_t *const elfImage, const std::vector<con
 				};
 
 				size_t index = findSectionNameEntryIndex();
-				entryPoints[index].entry = elfImage + sectionHeader[i].sh_offset;
+				entryPoints[index].entry = reinterpret_cast<const void *>(loadAddress + sectionHeader[i].sh_offset);
 				entryPoints[index].codeSize = sectionHeader[i].sh_size;
 			}
 		}
@@ -698,7 +702,7 @@ std::vector<EntryPoint> loadImage(uint8_t *const elfImage, const std::vector<con
 			for(Elf32_Word index = 0; index < sectionHeader[i].sh_size / sectionHeader[i].sh_entsize; index++)
 			{
 				const Elf32_Rel &relocation = ((const Elf32_Rel *)(elfImage + sectionHeader[i].sh_offset))[index];
-				relocateSymbol(elfHeader, relocation, sectionHeader[i]);
+				relocateSymbol(elfHeader, loadAddress, relocation, sectionHeader[i]);
 			}
 		}
 		else if(sectionHeader[i].sh_type == SHT_RELA)
@@ -708,7 +712,7 @@ std::vector<EntryPoint> loadImage(uint8_t *const elfImage, const std::vector<con
 			for(Elf32_Word index = 0; index < sectionHeader[i].sh_size / sectionHeader[i].sh_entsize; index++)
 			{
 				const Elf64_Rela &relocation = ((const Elf64_Rela *)(elfImage + sectionHeader[i].sh_offset))[index];
-				relocateSymbol(elfHeader, relocation, sectionHeader[i]);
+				relocateSymbol(elfHeader, loadAddress, relocation, sectionHeader[i]);
 			}
 		}
 	}
@@ -716,29 +720,6 @@ std::vector<EntryPoint> loadImage(uint8_t *const elfImage, const std::vector<con
 	return entryPoints;
 }
 
-template<typename T>
-struct ExecutableAllocator
-{
-	ExecutableAllocator() {}
-	template<class U>
-	ExecutableAllocator(const ExecutableAllocator<U> &other)
-	{}
-
-	using value_type = T;
-	using size_type = std::size_t;
-
-	T *allocate(size_type n)
-	{
-		return (T *)allocateMemoryPages(
-		    sizeof(T) * n, PERMISSION_READ | PERMISSION_WRITE, true);
-	}
-
-	void deallocate(T *p, size_type n)
-	{
-		deallocateMemoryPages(p, sizeof(T) * n);
-	}
-};
-
 class ELFMemoryStreamer : public Ice::ELFStreamer, public Routine
 {
 	ELFMemoryStreamer(const ELFMemoryStreamer &) = delete;
@@ -754,6 +735,14 @@ public:
 
 	~ELFMemoryStreamer() override
 	{
+		if(packed)
+		{
+			deallocateCodeMemory(code, codeSize);
+		}
+		else if(code)
+		{
+			deallocateMemoryPages(code, codeSize);
+		}
 	}
 
 	void write8(uint8_t Value) override
@@ -786,7 +775,38 @@ public:
 
 	std::vector<EntryPoint> loadImageAndGetEntryPoints(const std::vector<const char *> &functionNames)
 	{
-		auto entryPoints = loadImage(&buffer[0], functionNames);
+		// Only the sections which are loaded at run time are copied to
+		// executable memory. Small routines then share pages with others.
+		const ElfHeader *elfHeader = reinterpret_cast<const ElfHeader *>(&buffer[0]);
+		size_t begin = buffer.size();
+		size_t end = 0;
+		size_t alignment = 1;
+		for(int i = 0; i < elfHeader->e_shnum; i++)
+		{
+			const SectionHeader *section = elfSection(elfHeader, i);
+			if(section->sh_flags & SHF_ALLOC)
+			{
+				begin = std::min<size_t>(begin, section->sh_offset);
+				end = std::max<size_t>(end, section->sh_offset + section->sh_size);
+				alignment = std::max<size_t>(alignment, section->sh_addralign);
+			}
+		}
+		begin &= ~(alignment - 1);  // Keep the sections aligned.
+		ASSERT(begin < end && end <= buffer.size());
+
+		codeSize = end - begin;
+		void *writable = nullptr;
+		code = static_cast<uint8_t *>(allocateCodeMemory(codeSize, alignment, &writable));
+		packed = (code != nullptr);
+
+		if(!packed)
+		{
+			code = static_cast<uint8_t *>(allocateMemoryPages(codeSize, PERMISSION_READ | PERMISSION_WRITE, true));
+			writable = code;
+		}
+
+		auto entryPoints = loadImage(&buffer[0], reinterpret_cast<intptr_t>(code) - begin, functionNames);
+		memcpy(writable, &buffer[begin], codeSize);
 
 #if defined(_WIN32)
 		FlushInstructionCache(GetCurrentProcess(), NULL, 0);
@@ -804,7 +824,13 @@ public:
 	{
 		position = std::numeric_limits<std::size_t>::max();  // Can't stream more data after this
 
-		protectMemoryPages(&buffer[0], buffer.size(), PERMISSION_READ | PERMISSION_EXECUTE);
+		if(!packed)
+		{
+			protectMemoryPages(code, codeSize, PERMISSION_READ | PERMISSION_EXECUTE);
+		}
+
+		// The code has been copied out of the image.
+		std::vector<uint8_t>().swap(buffer);
 	}
 
 	void setEntry(int index, const void *func)
@@ -865,8 +891,11 @@ private:
 	};
 
 	std::array<const void *, Nucleus::CoroutineEntryCount> funcs = {};
-	std::vector<uint8_t, ExecutableAllocator<uint8_t>> buffer;
+	std::vector<uint8_t> buffer;
 	std::size_t position;
+	uint8_t *code = nullptr;
+	std::size_t codeSize = 0;
+	bool packed = false;  // |code| is from allocateCodeMemory()
 	std::vector<Constant> constantsPool;
 };
 
@@ -4281,13 +4310,36 @@ void Nucleus::createFence(std::memory_order memoryOrder)
 Value *Nucleus::createMaskedLoad(Value *ptr, Type *elTy, Value *mask, unsigned int alignment, bool zeroMaskedLanes)
 {
 	RR_DEBUG_INFO_UPDATE_LOC();
-	UNIMPLEMENTED_NO_BUG("Subzero createMaskedLoad()");
-	return nullptr;
+	ASSERT(mask->getType() == Ice::IceType_v4i32);
+
+	switch(T(elTy))
+	{
+	case Ice::IceType_f32:
+		return emulated::MaskedLoad(RValue<Pointer<Float4>>(ptr), RValue<Int4>(mask), alignment, zeroMaskedLanes).value();
+	case Ice::IceType_i32:
+		return emulated::MaskedLoad(RValue<Pointer<Int4>>(ptr), RValue<Int4>(mask), alignment, zeroMaskedLanes).value();
+	default:
+		UNIMPLEMENTED_NO_BUG("Subzero createMaskedLoad() element type %d", int(T(elTy)));
+		return nullptr;
+	}
 }
+
 void Nucleus::createMaskedStore(Value *ptr, Value *val, Value *mask, unsigned int alignment)
 {
 	RR_DEBUG_INFO_UPDATE_LOC();
-	UNIMPLEMENTED_NO_BUG("Subzero createMaskedStore()");
+	ASSERT(mask->getType() == Ice::IceType_v4i32);
+
+	switch(val->getType())
+	{
+	case Ice::IceType_v4f32:
+		emulated::MaskedStore(RValue<Pointer<Float4>>(ptr), RValue<Float4>(val), RValue<Int4>(mask), alignment);
+		break;
+	case Ice::IceType_v4i32:
+		emulated::MaskedStore(RValue<Pointer<Int4>>(ptr), RValue<Int4>(val), RValue<Int4>(mask), alignment);
+		break;
+	default:
+		UNIMPLEMENTED_NO_BUG("Subzero createMaskedStore() value type %d", int(val->getType()));
+	}
 }
 
 RValue<Float4> Gather(RValue<Pointer<Float>> base, RValue<Int4> offsets, RValue<Int4> mask, unsigned int alignment, bool zeroMaskedLanes /* = false */)
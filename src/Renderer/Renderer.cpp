@@ -22,15 +22,15 @@
 #include "Main/SwiftConfig.hpp"
 #include "Reactor/Reactor.hpp"
 #include "Shader/Constants.hpp"
-#include "Common/MutexLock.hpp"
 #include "Common/CPUID.hpp"
 #include "Common/Memory.hpp"
 #include "Common/Resource.hpp"
 #include "Common/Half.hpp"
 #include "Common/Math.hpp"
-#include "Common/Timer.hpp"
 #include "Common/Debug.hpp"
 
+#include "marl/mutex.h"
+
 #undef max
 
 bool disableServer = true;
@@ -63,7 +63,6 @@ namespace sw
 
 	static const int batchSize = 128;
 	AtomicInt threadCount(1);
-	AtomicInt Renderer::unitCount(1);
 	AtomicInt Renderer::clusterCount(1);
 
 	TranscendentalPrecision logPrecision = ACCURATE;
@@ -90,11 +89,51 @@ namespace sw
 		}
 	}
 
-	struct Parameters
+	// Returns the scheduler shared by all renderers, creating it on first use
+	// or when the requested number of threads has changed.
+	static std::shared_ptr<marl::Scheduler> getOrCreateScheduler(int threadCount)
 	{
-		Renderer *renderer;
-		int threadIndex;
-	};
+		struct Scheduler
+		{
+			marl::mutex mutex;
+			std::weak_ptr<marl::Scheduler> weakptr;
+			int workerThreadCount = -1;
+		};
+
+		static Scheduler scheduler;
+
+		// A single thread renders on the application thread in debug builds, which
+		// a scheduler without worker threads provides by running tasks while the
+		// drawing thread is blocked or unbinds.
+		int workerThreadCount = threadCount;
+		#ifndef NDEBUG
+			if(threadCount == 1)
+			{
+				workerThreadCount = 0;
+			}
+		#endif
+
+		marl::lock lock(scheduler.mutex);
+		auto sptr = scheduler.weakptr.lock();
+		if(!sptr || scheduler.workerThreadCount != workerThreadCount)
+		{
+			bool flushDenormals = (logPrecision < IEEE);
+
+			marl::Scheduler::Config cfg;
+			cfg.setWorkerThreadCount(workerThreadCount);
+			cfg.setWorkerThreadInitializer([flushDenormals](int) {
+				if(flushDenormals)
+				{
+					CPUID::setFlushToZero(true);
+					CPUID::setDenormalsAreZero(true);
+				}
+			});
+			sptr = std::make_shared<marl::Scheduler>(cfg);
+			scheduler.weakptr = sptr;
+			scheduler.workerThreadCount = workerThreadCount;
+		}
+		return sptr;
+	}
 
 	Query::Query(Type type) : building(false), data(0), type(type), reference(1)
 	{
@@ -155,48 +194,13 @@ namespace sw
 		updateProjectionMatrix = true;
 		updateClipPlanes = true;
 
-		#if PERF_HUD
-			resetTimers();
-		#endif
-
-		for(int i = 0; i < 16; i++)
-		{
-			vertexTask[i] = 0;
-
-			worker[i] = 0;
-			resume[i] = 0;
-			suspend[i] = 0;
-		}
-
-		threadsAwake = 0;
 		resumeApp = new Event();
 
-		currentDraw = 0;
 		nextDraw = 0;
 
-		qHead = 0;
-		qSize = 0;
-
-		for(int i = 0; i < 16; i++)
-		{
-			triangleBatch[i] = 0;
-			primitiveBatch[i] = 0;
-		}
-
 		for(int draw = 0; draw < DRAW_COUNT; draw++)
 		{
 			drawCall[draw] = new DrawCall();
-			drawList[draw] = drawCall[draw];
-		}
-
-		for(int unit = 0; unit < 16; unit++)
-		{
-			primitiveProgress[unit].init();
-		}
-
-		for(int cluster = 0; cluster < 16; cluster++)
-		{
-			pixelProgress[cluster].init();
 		}
 
 		clipFlags = 0;
@@ -211,7 +215,7 @@ namespace sw
 	{
 		sync->lock(EXCLUSIVE);
 		sync->destruct();
-		terminateThreads();
+		terminateScheduler();
 		sync->unlock();
 
 		delete clipper;
@@ -288,7 +292,7 @@ namespace sw
 
 			int batch = batchSize / ms;
 
-			int (Renderer::*setupPrimitives)(int batch, int count);
+			int (Renderer::*setupPrimitives)(Triangle *triangle, Primitive *primitive, const DrawCall &draw, int count);
 
 			if(context->isDrawTriangle())
 			{
@@ -328,8 +332,6 @@ namespace sw
 					if(drawCall[i]->references == -1)
 					{
 						draw = drawCall[i];
-						drawList[nextDraw & DRAW_COUNT_BITS] = draw;
-
 						break;
 					}
 				}
@@ -685,36 +687,11 @@ namespace sw
 				data->scissorY1 = scissor.y1;
 			}
 
-			draw->primitive = 0;
+			draw->id = nextDraw++;
 			draw->count = count;
+			draw->references = 1;
 
-			draw->references = (count + batch - 1) / batch;
-
-			schedulerMutex.lock();
-			++nextDraw; // Atomic
-			schedulerMutex.unlock();
-
-			#ifndef NDEBUG
-			if(threadCount == 1)   // Use main thread for draw execution
-			{
-				threadsAwake = 1;
-				task[0].type = Task::RESUME;
-
-				taskLoop(0);
-			}
-			else
-			#endif
-			{
-				if(!threadsAwake)
-				{
-					suspend[0]->wait();
-
-					threadsAwake = 1;
-					task[0].type = Task::RESUME;
-
-					resume[0]->signal();
-				}
-			}
+			scheduleDraw(draw);
 		}
 
 		// TODO(sugoi): This is a temporary brute-force workaround to ensure IOSurface synchronization.
@@ -739,237 +716,92 @@ namespace sw
 		blitter->blit3D(source, dest);
 	}
 
-	void Renderer::threadFunction(void *parameters)
+	void Renderer::scheduleDraw(DrawCall *draw)
 	{
-		Renderer *renderer = static_cast<Parameters*>(parameters)->renderer;
-		int threadIndex = static_cast<Parameters*>(parameters)->threadIndex;
-
-		if(logPrecision < IEEE)
+		// Reuse a scheduler already bound to this thread, if any, so that work
+		// submitted by the application or other APIs shares the same workers.
+		bool bindScheduler = (marl::Scheduler::get() == nullptr);
+		if(bindScheduler)
 		{
-			CPUID::setFlushToZero(true);
-			CPUID::setDenormalsAreZero(true);
+			scheduler->bind();
 		}
 
-		renderer->threadLoop(threadIndex);
-	}
+		const unsigned int count = draw->count;
+		const unsigned int batch = draw->batchSize;
+		const int clusters = clusterCount;
 
-	void Renderer::threadLoop(int threadIndex)
-	{
-		while(!exitThreads)
-		{
-			taskLoop(threadIndex);
+		auto finally = marl::make_shared_finally([this, draw] {
+			finishRendering(*draw);
+		});
 
-			suspend[threadIndex]->signal();
-			resume[threadIndex]->wait();
-		}
-	}
-
-	void Renderer::taskLoop(int threadIndex)
-	{
-		while(task[threadIndex].type != Task::SUSPEND)
+		for(unsigned int firstPrimitive = 0; firstPrimitive < count; firstPrimitive += batch)
 		{
-			scheduleTask(threadIndex);
-			executeTask(threadIndex);
-		}
-	}
+			auto batchData = batchDataPool.borrow();
+			batchData->firstPrimitive = firstPrimitive;
+			batchData->numPrimitives = min(firstPrimitive + batch, count) - firstPrimitive;
+			batchData->numVisible = 0;
 
-	void Renderer::findAvailableTasks()
-	{
-		// Find pixel tasks
-		for(int cluster = 0; cluster < clusterCount; cluster++)
-		{
-			if(!pixelProgress[cluster].executing)
+			// Tickets are taken in submission order, so each cluster processes
+			// the batches of consecutive draws in the order they were issued.
+			for(int cluster = 0; cluster < clusters; cluster++)
 			{
-				for(int unit = 0; unit < unitCount; unit++)
-				{
-					if(primitiveProgress[unit].references > 0)   // Contains processed primitives
-					{
-						if(pixelProgress[cluster].drawCall == primitiveProgress[unit].drawCall)
-						{
-							if(pixelProgress[cluster].processedPrimitives == primitiveProgress[unit].firstPrimitive)   // Previous primitives have been rendered
-							{
-								Task &task = taskQueue[qHead];
-								task.type = Task::PIXELS;
-								task.primitiveUnit = unit;
-								task.pixelCluster = cluster;
+				batchData->clusterTickets[cluster] = std::move(clusterQueues[cluster].take());
+			}
 
-								pixelProgress[cluster].executing = true;
+			marl::schedule([this, draw, batchData, finally, clusters] {
+				processPrimitiveVertices(*draw, *batchData.get());
 
-								// Commit to the task queue
-								qHead = (qHead + 1) & TASK_COUNT_BITS;
-								qSize++;
+				if(!draw->setupState.rasterizerDiscard)
+				{
+					batchData->numVisible = (this->*draw->setupPrimitives)(batchData->triangles, batchData->primitives, *draw, batchData->numPrimitives);
 
-								break;
-							}
-						}
+					if(batchData->numVisible > 0)
+					{
+						processPixels(draw, batchData, finally, clusters);
+						return;
 					}
 				}
-			}
-		}
 
-		// Find primitive tasks
-		if(currentDraw == nextDraw)
-		{
-			return;   // No more primitives to process
-		}
-
-		for(int unit = 0; unit < unitCount; unit++)
-		{
-			DrawCall *draw = drawList[currentDraw & DRAW_COUNT_BITS];
-
-			int primitive = draw->primitive;
-			int count = draw->count;
-
-			if(primitive >= count)
-			{
-				++currentDraw; // Atomic
-
-				if(currentDraw == nextDraw)
+				for(int cluster = 0; cluster < clusters; cluster++)
 				{
-					return;   // No more primitives to process
+					batchData->clusterTickets[cluster].done();
 				}
-
-				draw = drawList[currentDraw & DRAW_COUNT_BITS];
-			}
-
-			if(!primitiveProgress[unit].references)   // Task not already being executed and not still in use by a pixel unit
-			{
-				primitive = draw->primitive;
-				count = draw->count;
-				int batch = draw->batchSize;
-
-				primitiveProgress[unit].drawCall = currentDraw;
-				primitiveProgress[unit].firstPrimitive = primitive;
-				primitiveProgress[unit].primitiveCount = count - primitive >= batch ? batch : count - primitive;
-
-				draw->primitive += batch;
-
-				Task &task = taskQueue[qHead];
-				task.type = Task::PRIMITIVES;
-				task.primitiveUnit = unit;
-
-				primitiveProgress[unit].references = -1;
-
-				// Commit to the task queue
-				qHead = (qHead + 1) & TASK_COUNT_BITS;
-				qSize++;
-			}
-		}
-	}
-
-	void Renderer::scheduleTask(int threadIndex)
-	{
-		schedulerMutex.lock();
-
-		int curThreadsAwake = threadsAwake;
-
-		if((int)qSize < threadCount - curThreadsAwake + 1)
-		{
-			findAvailableTasks();
+			});
 		}
 
-		if(qSize != 0)
-		{
-			task[threadIndex] = taskQueue[(qHead - qSize) & TASK_COUNT_BITS];
-			qSize--;
-
-			if(curThreadsAwake != threadCount)
-			{
-				int wakeup = qSize - curThreadsAwake + 1;
-
-				for(int i = 0; i < threadCount && wakeup > 0; i++)
-				{
-					if(task[i].type == Task::SUSPEND)
-					{
-						suspend[i]->wait();
-						task[i].type = Task::RESUME;
-						resume[i]->signal();
-
-						++threadsAwake; // Atomic
-						wakeup--;
-					}
-				}
-			}
-		}
-		else
+		if(bindScheduler)
 		{
-			task[threadIndex].type = Task::SUSPEND;
-
-			--threadsAwake; // Atomic
+			marl::Scheduler::unbind();
 		}
-
-		schedulerMutex.unlock();
 	}
 
-	void Renderer::executeTask(int threadIndex)
+	void Renderer::processPixels(DrawCall *draw, const marl::Loan<BatchData> &batch, const std::shared_ptr<marl::Finally> &finally, int clusters)
 	{
-		#if PERF_HUD
-			int64_t startTick = Timer::ticks();
-		#endif
-
-		switch(task[threadIndex].type)
+		struct Data
 		{
-		case Task::PRIMITIVES:
+			Data(DrawCall *draw, const marl::Loan<BatchData> &batch, const std::shared_ptr<marl::Finally> &finally)
+			    : draw(draw), batch(batch), finally(finally)
 			{
-				int unit = task[threadIndex].primitiveUnit;
-
-				int input = primitiveProgress[unit].firstPrimitive;
-				int count = primitiveProgress[unit].primitiveCount;
-				DrawCall *draw = drawList[primitiveProgress[unit].drawCall & DRAW_COUNT_BITS];
-				int (Renderer::*setupPrimitives)(int batch, int count) = draw->setupPrimitives;
-
-				processPrimitiveVertices(unit, input, count, draw->count, threadIndex);
-
-				#if PERF_HUD
-					int64_t time = Timer::ticks();
-					vertexTime[threadIndex] += time - startTick;
-					startTick = time;
-				#endif
-
-				int visible = 0;
-
-				if(!draw->setupState.rasterizerDiscard)
-				{
-					visible = (this->*setupPrimitives)(unit, count);
-				}
-
-				primitiveProgress[unit].visible = visible;
-				primitiveProgress[unit].references = clusterCount;
-
-				#if PERF_HUD
-					setupTime[threadIndex] += Timer::ticks() - startTick;
-				#endif
 			}
-			break;
-		case Task::PIXELS:
-			{
-				int unit = task[threadIndex].primitiveUnit;
-				int visible = primitiveProgress[unit].visible;
 
-				if(visible > 0)
-				{
-					int cluster = task[threadIndex].pixelCluster;
-					Primitive *primitive = primitiveBatch[unit];
-					DrawCall *draw = drawList[pixelProgress[cluster].drawCall & DRAW_COUNT_BITS];
-					DrawData *data = draw->data;
-					PixelProcessor::RoutinePointer pixelRoutine = draw->pixelPointer;
+			DrawCall *draw;
+			marl::Loan<BatchData> batch;
+			std::shared_ptr<marl::Finally> finally;
+		};
 
-					pixelRoutine(primitive, visible, cluster, data);
-				}
+		auto data = std::make_shared<Data>(draw, batch, finally);
 
-				finishRendering(task[threadIndex]);
+		for(int cluster = 0; cluster < clusters; cluster++)
+		{
+			batch->clusterTickets[cluster].onCall([data, cluster] {
+				DrawCall *draw = data->draw;
+				BatchData *batch = data->batch.get();
+				PixelProcessor::RoutinePointer pixelRoutine = draw->pixelPointer;
 
-				#if PERF_HUD
-					pixelTime[threadIndex] += Timer::ticks() - startTick;
-				#endif
-			}
-			break;
-		case Task::RESUME:
-			break;
-		case Task::SUSPEND:
-			break;
-		default:
-			ASSERT(false);
+				pixelRoutine(batch->primitives, batch->numVisible, cluster, draw->data);
+
+				batch->clusterTickets[cluster].done();
+			});
 		}
 	}
 
@@ -979,162 +811,137 @@ namespace sw
 		sync->unlock();
 	}
 
-	void Renderer::finishRendering(Task &pixelTask)
+	void Renderer::finishRendering(DrawCall &draw)
 	{
-		int unit = pixelTask.primitiveUnit;
-		int cluster = pixelTask.pixelCluster;
-
-		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall & DRAW_COUNT_BITS];
 		DrawData &data = *draw.data;
-		int primitive = primitiveProgress[unit].firstPrimitive;
-		int count = primitiveProgress[unit].primitiveCount;
-		int processedPrimitives = primitive + count;
-
-		pixelProgress[cluster].processedPrimitives = processedPrimitives;
-
-		if(pixelProgress[cluster].processedPrimitives >= draw.count)
-		{
-			++pixelProgress[cluster].drawCall; // Atomic
-			pixelProgress[cluster].processedPrimitives = 0;
-		}
-
-		int ref = primitiveProgress[unit].references--; // Atomic
 
-		if(ref == 0)
-		{
-			ref = draw.references--; // Atomic
-
-			if(ref == 0)
+		#if PERF_PROFILE
+			for(int cluster = 0; cluster < clusterCount; cluster++)
 			{
-				#if PERF_PROFILE
-					for(int cluster = 0; cluster < clusterCount; cluster++)
-					{
-						for(int i = 0; i < PERF_TIMERS; i++)
-						{
-							profiler.cycles[i] += data.cycles[i][cluster];
-						}
-					}
-				#endif
-
-				if(draw.queries)
+				for(int i = 0; i < PERF_TIMERS; i++)
 				{
-					for(auto &query : *(draw.queries))
-					{
-						switch(query->type)
-						{
-						case Query::FRAGMENTS_PASSED:
-							for(int cluster = 0; cluster < clusterCount; cluster++)
-							{
-								query->data += data.occlusion[cluster];
-							}
-							break;
-						case Query::TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN:
-							query->data += processedPrimitives;
-							break;
-						default:
-							break;
-						}
-
-						query->release();
-					}
-
-					delete draw.queries;
-					draw.queries = 0;
+					profiler.cycles[i] += data.cycles[i][cluster];
 				}
+			}
+		#endif
 
-				for(int i = 0; i < RENDERTARGETS; i++)
+		if(draw.queries)
+		{
+			for(auto &query : *(draw.queries))
+			{
+				switch(query->type)
 				{
-					if(draw.renderTarget[i])
+				case Query::FRAGMENTS_PASSED:
+					for(int cluster = 0; cluster < clusterCount; cluster++)
 					{
-						draw.renderTarget[i]->unlockInternal();
+						query->data += data.occlusion[cluster];
 					}
+					break;
+				case Query::TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN:
+					query->data += draw.count;
+					break;
+				default:
+					break;
 				}
 
-				if(draw.depthBuffer)
-				{
-					draw.depthBuffer->unlockInternal();
-				}
+				query->release();
+			}
 
-				if(draw.stencilBuffer)
-				{
-					draw.stencilBuffer->unlockStencil();
-				}
+			delete draw.queries;
+			draw.queries = 0;
+		}
 
-				for(int i = 0; i < TOTAL_IMAGE_UNITS; i++)
-				{
-					if(draw.texture[i])
-					{
-						draw.texture[i]->unlock();
-					}
-				}
+		for(int i = 0; i < RENDERTARGETS; i++)
+		{
+			if(draw.renderTarget[i])
+			{
+				draw.renderTarget[i]->unlockInternal();
+			}
+		}
 
-				for(int i = 0; i < MAX_VERTEX_INPUTS; i++)
-				{
-					if(draw.vertexStream[i])
-					{
-						draw.vertexStream[i]->unlock();
-					}
-				}
+		if(draw.depthBuffer)
+		{
+			draw.depthBuffer->unlockInternal();
+		}
 
-				if(draw.indexBuffer)
-				{
-					draw.indexBuffer->unlock();
-				}
+		if(draw.stencilBuffer)
+		{
+			draw.stencilBuffer->unlockStencil();
+		}
 
-				for(int i = 0; i < MAX_UNIFORM_BUFFER_BINDINGS; i++)
-				{
-					if(draw.pUniformBuffers[i])
-					{
-						draw.pUniformBuffers[i]->unlock();
-					}
-					if(draw.vUniformBuffers[i])
-					{
-						draw.vUniformBuffers[i]->unlock();
-					}
-				}
+		for(int i = 0; i < TOTAL_IMAGE_UNITS; i++)
+		{
+			if(draw.texture[i])
+			{
+				draw.texture[i]->unlock();
+			}
+		}
 
-				for(int i = 0; i < MAX_TRANSFORM_FEEDBACK_INTERLEAVED_COMPONENTS; i++)
-				{
-					if(draw.transformFeedbackBuffers[i])
-					{
-						draw.transformFeedbackBuffers[i]->unlock();
-					}
-				}
+		for(int i = 0; i < MAX_VERTEX_INPUTS; i++)
+		{
+			if(draw.vertexStream[i])
+			{
+				draw.vertexStream[i]->unlock();
+			}
+		}
 
-				draw.vertexRoutine.reset();
-				draw.setupRoutine.reset();
-				draw.pixelRoutine.reset();
+		if(draw.indexBuffer)
+		{
+			draw.indexBuffer->unlock();
+		}
 
-				sync->unlock();
+		for(int i = 0; i < MAX_UNIFORM_BUFFER_BINDINGS; i++)
+		{
+			if(draw.pUniformBuffers[i])
+			{
+				draw.pUniformBuffers[i]->unlock();
+			}
+			if(draw.vUniformBuffers[i])
+			{
+				draw.vUniformBuffers[i]->unlock();
+			}
+		}
 
-				draw.references = -1;
-				resumeApp->signal();
+		for(int i = 0; i < MAX_TRANSFORM_FEEDBACK_INTERLEAVED_COMPONENTS; i++)
+		{
+			if(draw.transformFeedbackBuffers[i])
+			{
+				draw.transformFeedbackBuffers[i]->unlock();
 			}
 		}
 
-		pixelProgress[cluster].executing = false;
+		draw.vertexRoutine.reset();
+		draw.setupRoutine.reset();
+		draw.pixelRoutine.reset();
+
+		draw.references = -1;
+		resumeApp->signal();
+
+		// Last, as releasing the renderer lock allows it to be destroyed.
+		sync->unlock();
 	}
 
-	void Renderer::processPrimitiveVertices(int unit, unsigned int start, unsigned int triangleCount, unsigned int loop, int thread)
+	void Renderer::processPrimitiveVertices(const DrawCall &draw, BatchData &batchData)
 	{
-		Triangle *triangle = triangleBatch[unit];
-		int primitiveDrawCall = primitiveProgress[unit].drawCall;
-		DrawCall *draw = drawList[primitiveDrawCall & DRAW_COUNT_BITS];
-		DrawData *data = draw->data;
-		VertexTask *task = vertexTask[thread];
+		unsigned int start = batchData.firstPrimitive;
+		unsigned int triangleCount = batchData.numPrimitives;
+		unsigned int loop = draw.count;
+		Triangle *triangle = batchData.triangles;
+		DrawData *data = draw.data;
+		VertexTask *task = &batchData.vertexTask;
 
 		const void *indices = data->indices;
-		VertexProcessor::RoutinePointer vertexRoutine = draw->vertexPointer;
+		VertexProcessor::RoutinePointer vertexRoutine = draw.vertexPointer;
 
-		if(task->vertexCache.drawCall != primitiveDrawCall)
+		if(task->vertexCache.drawCall != draw.id)
 		{
 			task->vertexCache.clear();
-			task->vertexCache.drawCall = primitiveDrawCall;
+			task->vertexCache.drawCall = draw.id;
 		}
 
 		unsigned int batch[128][3];   // FIXME: Adjust to dynamic batch size
 
-		switch(draw->drawType)
+		switch(draw.drawType)
 		{
 		case DRAW_POINTLIST:
 			{
@@ -1562,13 +1369,9 @@ namespace sw
 		vertexRoutine(&triangle->v0, (unsigned int*)&batch, task, data);
 	}
 
-	int Renderer::setupSolidTriangles(int unit, int count)
+	int Renderer::setupSolidTriangles(Triangle *triangle, Primitive *primitive, const DrawCall &draw, int count)
 	{
-		Triangle *triangle = triangleBatch[unit];
-		Primitive *primitive = primitiveBatch[unit];
-
-		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall & DRAW_COUNT_BITS];
-		SetupProcessor::State &state = draw.setupState;
+		const SetupProcessor::State &state = draw.setupState;
 		const SetupProcessor::RoutinePointer &setupRoutine = draw.setupPointer;
 
 		int ms = state.multiSample;
@@ -1607,14 +1410,11 @@ namespace sw
 		return visible;
 	}
 
-	int Renderer::setupWireframeTriangle(int unit, int count)
+	int Renderer::setupWireframeTriangle(Triangle *triangle, Primitive *primitive, const DrawCall &draw, int count)
 	{
-		Triangle *triangle = triangleBatch[unit];
-		Primitive *primitive = primitiveBatch[unit];
 		int visible = 0;
 
-		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall & DRAW_COUNT_BITS];
-		SetupProcessor::State &state = draw.setupState;
+		const SetupProcessor::State &state = draw.setupState;
 
 		const Vertex &v0 = triangle[0].v0;
 		const Vertex &v1 = triangle[0].v1;
@@ -1664,14 +1464,11 @@ namespace sw
 		return visible;
 	}
 
-	int Renderer::setupVertexTriangle(int unit, int count)
+	int Renderer::setupVertexTriangle(Triangle *triangle, Primitive *primitive, const DrawCall &draw, int count)
 	{
-		Triangle *triangle = triangleBatch[unit];
-		Primitive *primitive = primitiveBatch[unit];
 		int visible = 0;
 
-		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall & DRAW_COUNT_BITS];
-		SetupProcessor::State &state = draw.setupState;
+		const SetupProcessor::State &state = draw.setupState;
 
 		const Vertex &v0 = triangle[0].v0;
 		const Vertex &v1 = triangle[0].v1;
@@ -1708,14 +1505,11 @@ namespace sw
 		return visible;
 	}
 
-	int Renderer::setupLines(int unit, int count)
+	int Renderer::setupLines(Triangle *triangle, Primitive *primitive, const DrawCall &draw, int count)
 	{
-		Triangle *triangle = triangleBatch[unit];
-		Primitive *primitive = primitiveBatch[unit];
 		int visible = 0;
 
-		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall & DRAW_COUNT_BITS];
-		SetupProcessor::State &state = draw.setupState;
+		const SetupProcessor::State &state = draw.setupState;
 
 		int ms = state.multiSample;
 
@@ -1733,14 +1527,11 @@ namespace sw
 		return visible;
 	}
 
-	int Renderer::setupPoints(int unit, int count)
+	int Renderer::setupPoints(Triangle *triangle, Primitive *primitive, const DrawCall &draw, int count)
 	{
-		Triangle *triangle = triangleBatch[unit];
-		Primitive *primitive = primitiveBatch[unit];
 		int visible = 0;
 
-		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall & DRAW_COUNT_BITS];
-		SetupProcessor::State &state = draw.setupState;
+		const SetupProcessor::State &state = draw.setupState;
 
 		int ms = state.multiSample;
 
@@ -2129,74 +1920,15 @@ namespace sw
 		return false;
 	}
 
-	void Renderer::initializeThreads()
+	void Renderer::initializeScheduler()
 	{
-		unitCount = ceilPow2(threadCount);
-		clusterCount = ceilPow2(threadCount);
-
-		for(int i = 0; i < unitCount; i++)
-		{
-			triangleBatch[i] = (Triangle*)allocate(batchSize * sizeof(Triangle));
-			primitiveBatch[i] = (Primitive*)allocate(batchSize * sizeof(Primitive));
-		}
-
-		for(int i = 0; i < threadCount; i++)
-		{
-			vertexTask[i] = (VertexTask*)allocate(sizeof(VertexTask));
-			vertexTask[i]->vertexCache.drawCall = -1;
-
-			task[i].type = Task::SUSPEND;
-
-			resume[i] = new Event();
-			suspend[i] = new Event();
-
-			Parameters parameters;
-			parameters.threadIndex = i;
-			parameters.renderer = this;
-
-			exitThreads = false;
-			worker[i] = new Thread(threadFunction, &parameters);
-
-			suspend[i]->wait();
-			suspend[i]->signal();
-		}
+		scheduler = getOrCreateScheduler(threadCount);
+		clusterCount = min(ceilPow2(threadCount), static_cast<int>(MAX_CLUSTER_COUNT));
 	}
 
-	void Renderer::terminateThreads()
+	void Renderer::terminateScheduler()
 	{
-		while(threadsAwake != 0)
-		{
-			Thread::sleep(1);
-		}
-
-		for(int thread = 0; thread < threadCount; thread++)
-		{
-			if(worker[thread])
-			{
-				exitThreads = true;
-				resume[thread]->signal();
-				worker[thread]->join();
-
-				delete worker[thread];
-				worker[thread] = 0;
-				delete resume[thread];
-				resume[thread] = 0;
-				delete suspend[thread];
-				suspend[thread] = 0;
-			}
-
-			deallocate(vertexTask[thread]);
-			vertexTask[thread] = 0;
-		}
-
-		for(int i = 0; i < 16; i++)
-		{
-			deallocate(triangleBatch[i]);
-			triangleBatch[i] = 0;
-
-			deallocate(primitiveBatch[i]);
-			primitiveBatch[i] = 0;
-		}
+		scheduler.reset();
 	}
 
 	void Renderer::loadConstants(const VertexShader *vertexShader)
@@ -2794,38 +2526,6 @@ namespace sw
 		queries.remove(query);
 	}
 
-	#if PERF_HUD
-		int Renderer::getThreadCount()
-		{
-			return threadCount;
-		}
-
-		int64_t Renderer::getVertexTime(int thread)
-		{
-			return vertexTime[thread];
-		}
-
-		int64_t Renderer::getSetupTime(int thread)
-		{
-			return setupTime[thread];
-		}
-
-		int64_t Renderer::getPixelTime(int thread)
-		{
-			return pixelTime[thread];
-		}
-
-		void Renderer::resetTimers()
-		{
-			for(int thread = 0; thread < threadCount; thread++)
-			{
-				vertexTime[thread] = 0;
-				setupTime[thread] = 0;
-				pixelTime[thread] = 0;
-			}
-		}
-	#endif
-
 	void Renderer::setViewport(const Viewport &viewport)
 	{
 		this->viewport = viewport;
@@ -2858,7 +2558,11 @@ namespace sw
 
 		if(newConfiguration || initialUpdate)
 		{
-			terminateThreads();
+			if(scheduler)
+			{
+				synchronize();   // Drain pending draws before changing the thread count
+				terminateScheduler();
+			}
 
 			SwiftConfig::Configuration configuration = {};
 			swiftConfig->getConfiguration(configuration);
@@ -2968,9 +2672,9 @@ namespace sw
 		#endif
 		}
 
-		if(!initialUpdate && !worker[0])
+		if(!initialUpdate && !scheduler)
 		{
-			initializeThreads();
+			initializeScheduler();
 		}
 	}
 }
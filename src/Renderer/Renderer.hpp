@@ -22,9 +22,16 @@
 #include "Blitter.hpp"
 #include "Common/MutexLock.hpp"
 #include "Common/Thread.hpp"
+#include "Primitive.hpp"
 #include "Main/Config.hpp"
 
+#include "marl/finally.h"
+#include "marl/pool.h"
+#include "marl/scheduler.h"
+#include "marl/ticket.h"
+
 #include <list>
+#include <memory>
 
 namespace sw
 {
@@ -222,52 +229,32 @@ namespace sw
 
 	class Renderer : public VertexProcessor, public PixelProcessor, public SetupProcessor
 	{
-		struct Task
+		enum
 		{
-			enum Type
-			{
-				PRIMITIVES,
-				PIXELS,
-
-				RESUME,
-				SUSPEND
-			};
-
-			AtomicInt type;
-			AtomicInt primitiveUnit;
-			AtomicInt pixelCluster;
+			MAX_BATCH_SIZE = 128,    // Maximum number of primitives processed by a single task
+			MAX_BATCH_COUNT = 16,    // Number of batches in flight
+			MAX_CLUSTER_COUNT = 16,  // Maximum number of pixel clusters, limited by DrawData::occlusion
 		};
 
-		struct PrimitiveProgress
+		// Storage for a batch of primitives as it flows through the vertex, setup
+		// and pixel stages. Batches are pooled rather than tied to a thread, so
+		// any scheduler worker can pick up any stage.
+		struct BatchData
 		{
-			void init()
-			{
-				drawCall = 0;
-				firstPrimitive = 0;
-				primitiveCount = 0;
-				visible = 0;
-				references = 0;
-			}
+			using Pool = marl::BoundedPool<BatchData, MAX_BATCH_COUNT, marl::PoolPolicy::Preserve>;
 
-			AtomicInt drawCall;
-			AtomicInt firstPrimitive;
-			AtomicInt primitiveCount;
-			AtomicInt visible;
-			AtomicInt references;
-		};
-
-		struct PixelProgress
-		{
-			void init()
+			BatchData()
 			{
-				drawCall = 0;
-				processedPrimitives = 0;
-				executing = false;
+				vertexTask.vertexCache.drawCall = -1;
 			}
 
-			AtomicInt drawCall;
-			AtomicInt processedPrimitives;
-			AtomicInt executing;
+			Triangle triangles[MAX_BATCH_SIZE];
+			Primitive primitives[MAX_BATCH_SIZE];
+			VertexTask vertexTask;
+			unsigned int firstPrimitive;
+			unsigned int numPrimitives;
+			int numVisible;
+			marl::Ticket clusterTickets[MAX_CLUSTER_COUNT];
 		};
 
 	public:
@@ -352,33 +339,20 @@ namespace sw
 
 		void synchronize();
 
-		#if PERF_HUD
-			// Performance timers
-			int getThreadCount();
-			int64_t getVertexTime(int thread);
-			int64_t getSetupTime(int thread);
-			int64_t getPixelTime(int thread);
-			void resetTimers();
-		#endif
-
 		static int getClusterCount() { return clusterCount; }
 
 	private:
-		static void threadFunction(void *parameters);
-		void threadLoop(int threadIndex);
-		void taskLoop(int threadIndex);
-		void findAvailableTasks();
-		void scheduleTask(int threadIndex);
-		void executeTask(int threadIndex);
-		void finishRendering(Task &pixelTask);
-
-		void processPrimitiveVertices(int unit, unsigned int start, unsigned int count, unsigned int loop, int thread);
-
-		int setupSolidTriangles(int batch, int count);
-		int setupWireframeTriangle(int batch, int count);
-		int setupVertexTriangle(int batch, int count);
-		int setupLines(int batch, int count);
-		int setupPoints(int batch, int count);
+		void scheduleDraw(DrawCall *draw);
+		void processPixels(DrawCall *draw, const marl::Loan<BatchData> &batch, const std::shared_ptr<marl::Finally> &finally, int clusters);
+		void finishRendering(DrawCall &draw);
+
+		void processPrimitiveVertices(const DrawCall &draw, BatchData &batch);
+
+		int setupSolidTriangles(Triangle *triangle, Primitive *primitive, const DrawCall &draw, int count);
+		int setupWireframeTriangle(Triangle *triangle, Primitive *primitive, const DrawCall &draw, int count);
+		int setupVertexTriangle(Triangle *triangle, Primitive *primitive, const DrawCall &draw, int count);
+		int setupLines(Triangle *triangle, Primitive *primitive, const DrawCall &draw, int count);
+		int setupPoints(Triangle *triangle, Primitive *primitive, const DrawCall &draw, int count);
 
 		bool setupLine(Primitive &primitive, Triangle &triangle, const DrawCall &draw);
 		bool setupPoint(Primitive &primitive, Triangle &triangle, const DrawCall &draw);
@@ -386,8 +360,8 @@ namespace sw
 		bool isReadWriteTexture(int sampler);
 		void updateClipper();
 		void updateConfiguration(bool initialUpdate = false);
-		void initializeThreads();
-		void terminateThreads();
+		void initializeScheduler();
+		void terminateScheduler();
 
 		void loadConstants(const VertexShader *vertexShader);
 		void loadConstants(const PixelShader *pixelShader);
@@ -399,56 +373,25 @@ namespace sw
 		Rect scissor;
 		int clipFlags;
 
-		Triangle *triangleBatch[16];
-		Primitive *primitiveBatch[16];
-
 		// User-defined clipping planes
 		Plane userPlane[MAX_CLIP_PLANES];
 		Plane clipPlane[MAX_CLIP_PLANES];   // Tranformed to clip space
 		bool updateClipPlanes;
 
-		AtomicInt exitThreads;
-		AtomicInt threadsAwake;
-		Thread *worker[16];
-		Event *resume[16];         // Events for resuming threads
-		Event *suspend[16];        // Events for suspending threads
-		Event *resumeApp;          // Event for resuming the application thread
-
-		PrimitiveProgress primitiveProgress[16];
-		PixelProgress pixelProgress[16];
-		Task task[16];   // Current tasks for threads
+		Event *resumeApp;   // Event for resuming the application thread
 
 		enum {
-			DRAW_COUNT = 16,   // Number of draw calls buffered (must be power of 2)
-			DRAW_COUNT_BITS = DRAW_COUNT - 1,
+			DRAW_COUNT = 16,   // Number of draw calls buffered
 		};
 		DrawCall *drawCall[DRAW_COUNT];
-		DrawCall *drawList[DRAW_COUNT];
+		int nextDraw;
 
-		AtomicInt currentDraw;
-		AtomicInt nextDraw;
+		std::shared_ptr<marl::Scheduler> scheduler;
+		BatchData::Pool batchDataPool;
+		marl::Ticket::Queue clusterQueues[MAX_CLUSTER_COUNT];
 
-		enum {
-			TASK_COUNT = 32,   // Size of the task queue (must be power of 2)
-			TASK_COUNT_BITS = TASK_COUNT - 1,
-		};
-		Task taskQueue[TASK_COUNT];
-		AtomicInt qHead;
-		AtomicInt qSize;
-
-		static AtomicInt unitCount;
 		static AtomicInt clusterCount;
 
-		MutexLock schedulerMutex;
-
-		#if PERF_HUD
-			int64_t vertexTime[16];
-			int64_t setupTime[16];
-			int64_t pixelTime[16];
-		#endif
-
-		VertexTask *vertexTask[16];
-
 		SwiftConfig *swiftConfig;
 
 		std::list<Query*> queries;
@@ -480,7 +423,7 @@ namespace sw
 		SetupProcessor::RoutinePointer setupPointer;
 		PixelProcessor::RoutinePointer pixelPointer;
 
-		int (Renderer::*setupPrimitives)(int batch, int count);
+		int (Renderer::*setupPrimitives)(Triangle *triangle, Primitive *primitive, const DrawCall &draw, int count);
 		SetupProcessor::State setupState;
 
 		Resource *vertexStream[MAX_VERTEX_INPUTS];
@@ -505,9 +448,9 @@ namespace sw
 
 		AtomicInt clipFlags;
 
-		AtomicInt primitive;    // Current primitive to enter pipeline
+		int id;                 // Sequence number, identifying the draw in vertex caches
 		AtomicInt count;        // Number of primitives to render
-		AtomicInt references;   // Remaining references to this draw call, 0 when done drawing, -1 when resources unlocked and slot is free
+		AtomicInt references;   // 1 while drawing, -1 when resources unlocked and slot is free
 
 		DrawData *data;
 	};
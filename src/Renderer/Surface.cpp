@@ -1125,6 +1125,12 @@ namespace sw
 	}
 
 	void *Surface::Buffer::lockRect(int x, int y, int z, Lock lock)
+	{
+		// Without knowing the extent of the access, any texel may get written.
+		return lockRect(x, y, z, lock, Box(0, 0, 0, width, height, depth));
+	}
+
+	void *Surface::Buffer::lockRect(int x, int y, int z, Lock lock, const Box &written)
 	{
 		this->lock = lock;
 
@@ -1137,7 +1143,7 @@ namespace sw
 		case LOCK_WRITEONLY:
 		case LOCK_READWRITE:
 		case LOCK_DISCARD:
-			dirty = true;
+			markDirty(written);
 			break;
 		default:
 			ASSERT(false);
@@ -1182,6 +1188,19 @@ namespace sw
 		lock = LOCK_UNLOCKED;
 	}
 
+	void Surface::Buffer::markDirty(const Box &written)
+	{
+		if(dirty)
+		{
+			dirtyBox.merge(written);
+		}
+		else
+		{
+			dirtyBox = written;
+			dirty = true;
+		}
+	}
+
 	class SurfaceImplementation : public Surface
 	{
 	public:
@@ -1233,6 +1252,7 @@ namespace sw
 		external.border = 0;
 		external.lock = LOCK_UNLOCKED;
 		external.dirty = true;
+		external.dirtyBox = Box(0, 0, 0, width, height, depth);
 
 		internal.buffer = nullptr;
 		internal.width = width;
@@ -1354,9 +1374,21 @@ namespace sw
 	}
 
 	void *Surface::lockExternal(int x, int y, int z, Lock lock, Accessor client)
+	{
+		return lockExternal(x, y, z, Box(0, 0, 0, external.width, external.height, external.depth), lock, client);
+	}
+
+	void *Surface::lockExternal(const Box &region, Lock lock, Accessor client)
+	{
+		return lockExternal(region.x0, region.y0, region.z0, region, lock, client);
+	}
+
+	void *Surface::lockExternal(int x, int y, int z, const Box &written, Lock lock, Accessor client)
 	{
 		resource->lock(client);
 
+		siblingMutex.lock();
+
 		if(!external.buffer)
 		{
 			if(internal.buffer && identicalBuffers())
@@ -1392,7 +1424,13 @@ namespace sw
 			ASSERT(false);
 		}
 
-		return external.lockRect(x, y, z, lock);
+		// Discarding skips the update from the internal buffer, so afterwards
+		// none of the external contents are known to match it.
+		void *data = (lock == LOCK_DISCARD) ? external.lockRect(x, y, z, lock) : external.lockRect(x, y, z, lock, written);
+
+		siblingMutex.unlock();
+
+		return data;
 	}
 
 	void Surface::unlockExternal()
@@ -1409,6 +1447,8 @@ namespace sw
 			resource->lock(client);
 		}
 
+		siblingMutex.lock();
+
 		if(!internal.buffer)
 		{
 			if(external.buffer && identicalBuffers())
@@ -1435,8 +1475,10 @@ namespace sw
 					case FORMAT_A1R5G5B5:
 					case FORMAT_A2R10G10B10:
 					case FORMAT_A2B10G10R10:
+						siblingMutex.unlock();
 						lockExternal(0, 0, 0, LOCK_READWRITE, client);
 						unlockExternal();
+						siblingMutex.lock();
 						break;
 					default:
 						// Difference passes WHQL
@@ -1446,7 +1488,13 @@ namespace sw
 			}
 		}
 
-		if(external.dirty || (isPalette(external.format) && paletteUsed != Surface::paletteID))
+		if(isPalette(external.format) && paletteUsed != Surface::paletteID)
+		{
+			// All texels need converting with the new palette.
+			external.markDirty(Box(0, 0, 0, external.width, external.height, external.depth));
+		}
+
+		if(external.dirty)
 		{
 			if(lock != LOCK_DISCARD)
 			{
@@ -1476,7 +1524,11 @@ namespace sw
 			resolve();
 		}
 
-		return internal.lockRect(x, y, z, lock);
+		void *data = internal.lockRect(x, y, z, lock);
+
+		siblingMutex.unlock();
+
+		return data;
 	}
 
 	void Surface::unlockInternal()
@@ -1774,19 +1826,32 @@ namespace sw
 			case FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2: decodeETC2(destination, source, 1, true);  break; // FIXME: Check destination format
 			case FORMAT_RGBA8_ETC2_EAC:                 decodeETC2(destination, source, 8, false); break; // FIXME: Check destination format
 			case FORMAT_SRGB8_ALPHA8_ETC2_EAC:          decodeETC2(destination, source, 8, true);  break; // FIXME: Check destination format
-			default:				genericUpdate(destination, source);		break;
+			default:				genericUpdate(destination, source, source.dirtyBox);	break;
 			}
 		}
 	}
 
-	void Surface::genericUpdate(Buffer &destination, Buffer &source)
+	void Surface::genericUpdate(Buffer &destination, Buffer &source, const Box &region)
 	{
-		unsigned char *sourceSlice = (unsigned char*)source.lockRect(0, 0, 0, sw::LOCK_READONLY);
-		unsigned char *destinationSlice = (unsigned char*)destination.lockRect(0, 0, 0, sw::LOCK_UPDATE);
+		// Only the region which differs between the buffers gets converted.
+		int x0 = max(region.x0, 0);
+		int y0 = max(region.y0, 0);
+		int z0 = max(region.z0, 0);
+		int x1 = min(region.x1, destination.width, source.width);
+		int y1 = min(region.y1, destination.height, source.height);
+		int z1 = min(region.z1, destination.depth, source.depth);
+
+		if(x0 >= x1 || y0 >= y1 || z0 >= z1)
+		{
+			return;
+		}
 
-		int depth = min(destination.depth, source.depth);
-		int height = min(destination.height, source.height);
-		int width = min(destination.width, source.width);
+		unsigned char *sourceSlice = (unsigned char*)source.lockRect(x0, y0, 0, sw::LOCK_READONLY) + z0 * source.sliceB;
+		unsigned char *destinationSlice = (unsigned char*)destination.lockRect(x0, y0, 0, sw::LOCK_UPDATE) + z0 * destination.sliceB;
+
+		int depth = z1 - z0;
+		int height = y1 - y0;
+		int width = x1 - x0;
 		int rowBytes = width * source.bytes;
 
 		for(int z = 0; z < depth; z++)
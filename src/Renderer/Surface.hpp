@@ -60,6 +60,29 @@ namespace sw
 	typedef SliceRectT<int> SliceRect;
 	typedef SliceRectT<float> SliceRectF;
 
+	struct Box
+	{
+		Box() {}
+		Box(int x0i, int y0i, int z0i, int x1i, int y1i, int z1i) : x0(x0i), y0(y0i), z0(z0i), x1(x1i), y1(y1i), z1(z1i) {}
+
+		void merge(const Box &box)
+		{
+			x0 = min(x0, box.x0);
+			y0 = min(y0, box.y0);
+			z0 = min(z0, box.z0);
+			x1 = max(x1, box.x1);
+			y1 = max(y1, box.y1);
+			z1 = max(z1, box.z1);
+		}
+
+		int x0;   // Inclusive
+		int y0;   // Inclusive
+		int z0;   // Inclusive
+		int x1;   // Exclusive
+		int y1;   // Exclusive
+		int z1;   // Exclusive
+	};
+
 	enum Format ENUM_UNDERLYING_TYPE_UNSIGNED_INT
 	{
 		FORMAT_NULL,
@@ -227,8 +250,11 @@ namespace sw
 			Color<float> sample(float x, float y, int layer) const;
 
 			void *lockRect(int x, int y, int z, Lock lock);
+			void *lockRect(int x, int y, int z, Lock lock, const Box &written);
 			void unlockRect();
 
+			void markDirty(const Box &written);
+
 			void *buffer;
 			int width;
 			int height;
@@ -245,7 +271,8 @@ namespace sw
 			Format format;
 			AtomicInt lock;
 
-			bool dirty;   // Sibling internal/external buffer doesn't match.
+			bool dirty;      // Sibling internal/external buffer doesn't match.
+			Box dirtyBox;    // Region which doesn't match the sibling buffer, if dirty.
 		};
 
 	protected:
@@ -271,6 +298,7 @@ namespace sw
 		inline int getSliceP(bool internal = false) const;
 
 		void *lockExternal(int x, int y, int z, Lock lock, Accessor client);
+		void *lockExternal(const Box &region, Lock lock, Accessor client);   // Only the region gets converted to the internal format
 		void unlockExternal();
 		inline Format getExternalFormat() const;
 		inline int getExternalPitchB() const;
@@ -453,7 +481,7 @@ namespace sw
 		static void decodeETC2(Buffer &internal, Buffer &external, int nbAlphaBits, bool isSRGB);
 
 		static void update(Buffer &destination, Buffer &source);
-		static void genericUpdate(Buffer &destination, Buffer &source);
+		static void genericUpdate(Buffer &destination, Buffer &source, const Box &region);
 		static void *allocateBuffer(int width, int height, int depth, int border, int samples, Format format);
 		static void memfill4(void *buffer, int pattern, int bytes);
 
@@ -462,6 +490,8 @@ namespace sw
 
 		void resolve();
 
+		void *lockExternal(int x, int y, int z, const Box &written, Lock lock, Accessor client);
+
 		Buffer external;
 		Buffer internal;
 		Buffer stencil;
@@ -469,6 +499,10 @@ namespace sw
 		const bool lockable;
 		const bool renderTarget;
 
+		// Serializes updating one buffer from its sibling. The resource lock can be
+		// shared by readers, which must not convert the same buffer concurrently.
+		MutexLock siblingMutex;
+
 		bool dirtyContents;   // Sibling surfaces need updating (mipmaps / cube borders).
 		unsigned int paletteUsed;
 
@@ -14,6 +14,9 @@
 
 #include "Math.hpp"
 
+#include <algorithm>
+#include <cstring>
+
 namespace sw {
 
 inline uint64_t FNV_1a(uint64_t hash, unsigned char data)
@@ -33,6 +36,110 @@ uint64_t FNV_1a(const unsigned char *data, int size)
 	return hash;
 }
 
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t fmix64(uint64_t k)
+{
+	k ^= k >> 33;
+	k *= 0xFF51AFD7ED558CCDull;
+	k ^= k >> 33;
+	k *= 0xC4CEB9FE1A85EC53ull;
+	k ^= k >> 33;
+
+	return k;
+}
+
+Hash128 Murmur3_128(const void *data, size_t size, const Hash128 &seed)
+{
+	const uint8_t *bytes = static_cast<const uint8_t *>(data);
+	const size_t blocks = size / 16;
+
+	uint64_t h1 = seed.lo;
+	uint64_t h2 = seed.hi;
+
+	const uint64_t c1 = 0x87C37B91114253D5ull;
+	const uint64_t c2 = 0x4CF5AD432745937Full;
+
+	for(size_t i = 0; i < blocks; i++)
+	{
+		uint64_t k1;
+		uint64_t k2;
+		memcpy(&k1, bytes + i * 16, sizeof(k1));
+		memcpy(&k2, bytes + i * 16 + 8, sizeof(k2));
+
+		k1 *= c1;
+		k1 = rotl64(k1, 31);
+		k1 *= c2;
+		h1 ^= k1;
+
+		h1 = rotl64(h1, 27);
+		h1 += h2;
+		h1 = h1 * 5 + 0x52DCE729;
+
+		k2 *= c2;
+		k2 = rotl64(k2, 33);
+		k2 *= c1;
+		h2 ^= k2;
+
+		h2 = rotl64(h2, 31);
+		h2 += h1;
+		h2 = h2 * 5 + 0x38495AB5;
+	}
+
+	const uint8_t *tail = bytes + blocks * 16;
+	const size_t remainder = size & 15;
+
+	uint64_t k1 = 0;
+	uint64_t k2 = 0;
+
+	for(size_t i = remainder; i > 8; i--)
+	{
+		k2 ^= uint64_t(tail[i - 1]) << ((i - 9) * 8);
+	}
+
+	if(remainder > 8)
+	{
+		k2 *= c2;
+		k2 = rotl64(k2, 33);
+		k2 *= c1;
+		h2 ^= k2;
+	}
+
+	for(size_t i = std::min<size_t>(remainder, 8); i > 0; i--)
+	{
+		k1 ^= uint64_t(tail[i - 1]) << ((i - 1) * 8);
+	}
+
+	if(remainder > 0)
+	{
+		k1 *= c1;
+		k1 = rotl64(k1, 31);
+		k1 *= c2;
+		h1 ^= k1;
+	}
+
+	h1 ^= size;
+	h2 ^= size;
+
+	h1 += h2;
+	h2 += h1;
+
+	h1 = fmix64(h1);
+	h2 = fmix64(h2);
+
+	h1 += h2;
+	h2 += h1;
+
+	Hash128 hash;
+	hash.lo = h1;
+	hash.hi = h2;
+
+	return hash;
+}
+
 unsigned char sRGB8toLinear8(unsigned char value)
 {
 	static unsigned char sRGBtoLinearTable[256] = { 255 };
@@ -19,6 +19,7 @@
 #include "Types.hpp"
 
 #include <cmath>
+#include <cstddef>
 #if defined(_MSC_VER)
 #	include <intrin.h>
 #endif
@@ -351,6 +352,28 @@ unsigned char sRGB8toLinear8(unsigned char value);
 
 uint64_t FNV_1a(const unsigned char *data, int size);  // Fowler-Noll-Vo hash function
 
+// 128-bit content hash of large blobs of data. It makes mismatching cache keys
+// cheap to reject, but distinct data can collide, so a hash match must still be
+// confirmed by comparing the data.
+struct Hash128
+{
+	uint64_t lo = 0;
+	uint64_t hi = 0;
+
+	bool operator==(const Hash128 &other) const { return lo == other.lo && hi == other.hi; }
+	bool operator!=(const Hash128 &other) const { return !(*this == other); }
+
+	struct Hash
+	{
+		// The bits are already well mixed, so any half of the hash will do.
+		std::size_t operator()(const Hash128 &hash) const noexcept { return static_cast<std::size_t>(hash.lo); }
+	};
+};
+
+// MurmurHash3 (x64, 128-bit variant). Passing the result of a previous call
+// as the seed chains the hashes of several non-contiguous blocks.
+Hash128 Murmur3_128(const void *data, size_t size, const Hash128 &seed = {});
+
 // Round up to the next multiple of alignment
 template<typename T>
 inline T align(T value, unsigned int alignment)
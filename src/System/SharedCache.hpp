@@ -0,0 +1,66 @@
+// Copyright 2021 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_SharedCache_hpp
+#define sw_SharedCache_hpp
+
+#include "LRUCache.hpp"
+
+#include "marl/mutex.h"
+#include "marl/tsa.h"
+
+#include <memory>
+
+namespace sw {
+
+// SharedCache is a thread-safe LRU cache of shared objects, meant to be used
+// as a process-wide cache. It outlives any Vulkan object, so it must only hold
+// data that does not reference one.
+// Keys are compared with KEY::operator==, so a hash collision can never return
+// the data of another key.
+template<typename KEY, typename DATA, typename HASH = std::hash<KEY>>
+class SharedCache
+{
+public:
+	SharedCache(size_t capacity)
+	    : cache(capacity)
+	{}
+
+	// getOrCreate() returns the cached data for key, or calls create() and
+	// caches its result. create() is called without the lock held, and the
+	// first result to be added wins.
+	template<typename Function>
+	std::shared_ptr<DATA> getOrCreate(const KEY &key, Function &&create)
+	{
+		{
+			marl::lock lock(mutex);
+			if(auto data = cache.lookup(key)) { return data; }
+		}
+
+		std::shared_ptr<DATA> created = create();
+
+		marl::lock lock(mutex);
+		if(auto data = cache.lookup(key)) { return data; }
+		cache.add(key, created);
+		return created;
+	}
+
+private:
+	marl::mutex mutex;
+	LRUCache<KEY, std::shared_ptr<DATA>, HASH> cache GUARDED_BY(mutex);
+};
+
+}  // namespace sw
+
+#endif  // sw_SharedCache_hpp
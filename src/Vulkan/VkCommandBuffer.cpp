@@ -62,7 +62,9 @@ public:
 	{
 		executionState.renderPass = renderPass;
 		executionState.renderPassFramebuffer = framebuffer;
+		executionState.renderArea = renderArea;
 		executionState.subpassIndex = 0;
+		framebuffer->discardOnLoad(executionState.renderPass, renderArea);
 		framebuffer->clear(executionState.renderPass, clearValueCount, clearValues, renderArea);
 	}
 
@@ -110,6 +112,9 @@ public:
 		//               for a Draw command or after the last command of the current subpass
 		//               which modifies pixels.
 		executionState.renderPassFramebuffer->resolve(executionState.renderPass, executionState.subpassIndex);
+
+		executionState.renderPassFramebuffer->discardOnStore(executionState.renderPass, executionState.renderArea);
+
 		executionState.renderPass = nullptr;
 		executionState.renderPassFramebuffer = nullptr;
 	}
@@ -180,7 +185,8 @@ public:
 		              pipelineState.descriptorSetObjects,
 		              pipelineState.descriptorSets,
 		              pipelineState.descriptorDynamicOffsets,
-		              executionState.pushConstants);
+		              executionState.pushConstants,
+		              executionState.renderer->getPipelineStatisticsQuery());
 	}
 
 	std::string description() override { return "vkCmdDispatch()"; }
@@ -214,7 +220,8 @@ public:
 		              pipelineState.descriptorSetObjects,
 		              pipelineState.descriptorSets,
 		              pipelineState.descriptorDynamicOffsets,
-		              executionState.pushConstants);
+		              executionState.pushConstants,
+		              executionState.renderer->getPipelineStatisticsQuery());
 	}
 
 	std::string description() override { return "vkCmdDispatchIndirect()"; }
@@ -466,8 +473,27 @@ private:
 class CmdDrawBase : public vk::CommandBuffer::Command
 {
 public:
+	// Draw parameters, as found in VkDrawIndirectCommand and VkDrawIndexedIndirectCommand.
+	struct Record
+	{
+		uint32_t count;
+		uint32_t instanceCount;
+		uint32_t first;
+		int32_t vertexOffset;
+		uint32_t firstInstance;
+	};
+
 	void draw(vk::CommandBuffer::ExecutionState &executionState, bool indexed,
 	          uint32_t count, uint32_t instanceCount, uint32_t first, int32_t vertexOffset, uint32_t firstInstance)
+	{
+		const Record record = { count, instanceCount, first, vertexOffset, firstInstance };
+		draw(executionState, indexed, &record, 1);
+	}
+
+	// Draws all records. Consecutive single-instance records with the same
+	// first instance are packed into a single DrawCall, so that they share
+	// the routine state and batches.
+	void draw(vk::CommandBuffer::ExecutionState &executionState, bool indexed, const Record *records, uint32_t recordCount)
 	{
 		auto const &pipelineState = executionState.pipelineState[VK_PIPELINE_BIND_POINT_GRAPHICS];
 
@@ -481,33 +507,60 @@ public:
 		                            pipelineState.descriptorSets,
 		                            pipelineState.descriptorDynamicOffsets);
 		inputs.setVertexInputBinding(executionState.vertexInputBindings);
-		inputs.bindVertexInputs(firstInstance);
 
 		vk::IndexBuffer &indexBuffer = pipeline->getIndexBuffer();
 		indexBuffer.setIndexBufferBinding(executionState.indexBufferBinding, executionState.indexType);
 
 		std::vector<std::pair<uint32_t, void *>> indexBuffers;
-		pipeline->getIndexBuffers(count, first, indexed, &indexBuffers);
+		std::vector<sw::DrawRange> ranges;
 
-		for(uint32_t instance = firstInstance; instance != firstInstance + instanceCount; instance++)
+		for(uint32_t i = 0; i < recordCount;)
 		{
-			// FIXME: reconsider instances/views nesting.
-			auto viewMask = executionState.renderPass->getViewMask(executionState.subpassIndex);
-			while(viewMask)
+			uint32_t firstInstance = records[i].firstInstance;
+			uint32_t instanceCount = records[i].instanceCount;
+
+			ranges.clear();
+			do
 			{
-				int viewID = sw::log2i(viewMask);
-				viewMask &= ~(1 << viewID);
+				const Record &record = records[i++];
+				if(record.instanceCount == 0)
+				{
+					continue;
+				}
 
+				indexBuffers.clear();
+				pipeline->getIndexBuffers(record.count, record.first, indexed, &indexBuffers);
 				for(auto indexBuffer : indexBuffers)
 				{
-					executionState.renderer->draw(pipeline, executionState.dynamicState, indexBuffer.first, vertexOffset,
-					                              executionState.events, instance, viewID, indexBuffer.second,
+					ranges.push_back({ indexBuffer.first, record.vertexOffset, indexBuffer.second, 0 });
+				}
+			} while((instanceCount <= 1) && (i < recordCount) &&
+			        (records[i].instanceCount == 0 || (records[i].instanceCount == 1 && records[i].firstInstance == firstInstance)));
+
+			if(ranges.empty())
+			{
+				continue;
+			}
+
+			inputs.bindVertexInputs(firstInstance);
+
+			for(uint32_t instance = firstInstance; instance != firstInstance + std::max(instanceCount, 1u); instance++)
+			{
+				// FIXME: reconsider instances/views nesting.
+				auto viewMask = executionState.renderPass->getViewMask(executionState.subpassIndex);
+				while(viewMask)
+				{
+					int viewID = sw::log2i(viewMask);
+					viewMask &= ~(1 << viewID);
+
+					executionState.renderer->draw(pipeline, executionState.dynamicState, ranges.data(), static_cast<unsigned int>(ranges.size()),
+					                              executionState.events, instance, viewID,
 					                              executionState.renderPassFramebuffer->getExtent(),
 					                              executionState.pushConstants);
 				}
-			}
 
-			inputs.advanceInstanceAttributes();
+				inputs.advanceInstanceAttributes();
+			}
 		}
 	}
 };
@@ -567,9 +620,13 @@ private:
 class CmdDrawIndirect : public CmdDrawBase
 {
 public:
-	CmdDrawIndirect(vk::Buffer *buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
+	// countBuffer is optional. When present, the number of draws is the
+	// lesser of its value and drawCount (VK_KHR_draw_indirect_count).
+	CmdDrawIndirect(vk::Buffer *buffer, VkDeviceSize offset, vk::Buffer *countBuffer, VkDeviceSize countBufferOffset, uint32_t drawCount, uint32_t stride)
 	    : buffer(buffer)
 	    , offset(offset)
+	    , countBuffer(countBuffer)
+	    , countBufferOffset(countBufferOffset)
 	    , drawCount(drawCount)
 	    , stride(stride)
 	{
@@ -577,18 +634,29 @@ public:
 
 	void play(vk::CommandBuffer::ExecutionState &executionState) override
 	{
-		for(auto drawId = 0u; drawId < drawCount; drawId++)
+		uint32_t count = drawCount;
+		if(countBuffer)
+		{
+			count = std::min(*static_cast<const uint32_t *>(countBuffer->getOffsetPointer(countBufferOffset)), drawCount);
+		}
+
+		std::vector<Record> records(count);
+		for(auto drawId = 0u; drawId < count; drawId++)
 		{
 			auto cmd = reinterpret_cast<VkDrawIndirectCommand const *>(buffer->getOffsetPointer(offset + drawId * stride));
-			draw(executionState, false, cmd->vertexCount, cmd->instanceCount, 0, cmd->firstVertex, cmd->firstInstance);
+			records[drawId] = { cmd->vertexCount, cmd->instanceCount, 0, static_cast<int32_t>(cmd->firstVertex), cmd->firstInstance };
 		}
+
+		draw(executionState, false, records.data(), count);
 	}
 
-	std::string description() override { return "vkCmdDrawIndirect()"; }
+	std::string description() override { return countBuffer ? "vkCmdDrawIndirectCount()" : "vkCmdDrawIndirect()"; }
 
 private:
 	const vk::Buffer *buffer;
 	VkDeviceSize offset;
+	const vk::Buffer *countBuffer;
+	VkDeviceSize countBufferOffset;
 	uint32_t drawCount;
 	uint32_t stride;
 };
@@ -596,9 +664,13 @@ private:
 class CmdDrawIndexedIndirect : public CmdDrawBase
 {
 public:
-	CmdDrawIndexedIndirect(vk::Buffer *buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
+	// countBuffer is optional. When present, the number of draws is the
+	// lesser of its value and drawCount (VK_KHR_draw_indirect_count).
+	CmdDrawIndexedIndirect(vk::Buffer *buffer, VkDeviceSize offset, vk::Buffer *countBuffer, VkDeviceSize countBufferOffset, uint32_t drawCount, uint32_t stride)
 	    : buffer(buffer)
 	    , offset(offset)
+	    , countBuffer(countBuffer)
+	    , countBufferOffset(countBufferOffset)
 	    , drawCount(drawCount)
 	    , stride(stride)
 	{
@@ -606,18 +678,29 @@ public:
 
 	void play(vk::CommandBuffer::ExecutionState &executionState) override
 	{
-		for(auto drawId = 0u; drawId < drawCount; drawId++)
+		uint32_t count = drawCount;
+		if(countBuffer)
+		{
+			count = std::min(*static_cast<const uint32_t *>(countBuffer->getOffsetPointer(countBufferOffset)), drawCount);
+		}
+
+		std::vector<Record> records(count);
+		for(auto drawId = 0u; drawId < count; drawId++)
 		{
 			auto cmd = reinterpret_cast<VkDrawIndexedIndirectCommand const *>(buffer->getOffsetPointer(offset + drawId * stride));
-			draw(executionState, true, cmd->indexCount, cmd->instanceCount, cmd->firstIndex, cmd->vertexOffset, cmd->firstInstance);
+			records[drawId] = { cmd->indexCount, cmd->instanceCount, cmd->firstIndex, cmd->vertexOffset, cmd->firstInstance };
 		}
+
+		draw(executionState, true, records.data(), count);
 	}
 
-	std::string description() override { return "vkCmdDrawIndexedIndirect()"; }
+	std::string description() override { return countBuffer ? "vkCmdDrawIndexedIndirectCount()" : "vkCmdDrawIndexedIndirect()"; }
 
 private:
 	const vk::Buffer *buffer;
 	VkDeviceSize offset;
+	const vk::Buffer *countBuffer;
+	VkDeviceSize countBufferOffset;
 	uint32_t drawCount;
 	uint32_t stride;
 };
@@ -1657,12 +1740,22 @@ void CommandBuffer::drawIndexed(uint32_t indexCount, uint32_t instanceCount, uin
 
 void CommandBuffer::drawIndirect(Buffer *buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
 {
-	addCommand<::CmdDrawIndirect>(buffer, offset, drawCount, stride);
+	addCommand<::CmdDrawIndirect>(buffer, offset, nullptr, 0, drawCount, stride);
 }
 
 void CommandBuffer::drawIndexedIndirect(Buffer *buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
 {
-	addCommand<::CmdDrawIndexedIndirect>(buffer, offset, drawCount, stride);
+	addCommand<::CmdDrawIndexedIndirect>(buffer, offset, nullptr, 0, drawCount, stride);
+}
+
+void CommandBuffer::drawIndirectCount(Buffer *buffer, VkDeviceSize offset, Buffer *countBuffer, VkDeviceSize countBufferOffset, uint32_t maxDrawCount, uint32_t stride)
+{
+	addCommand<::CmdDrawIndirect>(buffer, offset, countBuffer, countBufferOffset, maxDrawCount, stride);
+}
+
+void CommandBuffer::drawIndexedIndirectCount(Buffer *buffer, VkDeviceSize offset, Buffer *countBuffer, VkDeviceSize countBufferOffset, uint32_t maxDrawCount, uint32_t stride)
+{
+	addCommand<::CmdDrawIndexedIndirect>(buffer, offset, countBuffer, countBufferOffset, maxDrawCount, stride);
 }
 
 void CommandBuffer::beginDebugUtilsLabel(const VkDebugUtilsLabelEXT *pLabelInfo)
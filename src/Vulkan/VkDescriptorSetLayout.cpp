@@ -291,6 +291,7 @@ void DescriptorSetLayout::WriteDescriptorSet(Device *device, DescriptorSet *dstS
 			sampledImage[i].imageViewId = bufferView->id;
 			constexpr VkComponentMapping identityMapping = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
 			sampledImage[i].swizzle = ResolveComponentMapping(identityMapping, bufferView->getFormat());
+			sampledImage[i].tiledLayout = false;
 			sampledImage[i].format = bufferView->getFormat();
 
 			auto numElements = bufferView->getElementCount();
@@ -350,6 +351,7 @@ void DescriptorSetLayout::WriteDescriptorSet(Device *device, DescriptorSet *dstS
 			sampledImage[i].sampleCount = imageView->getSampleCount();
 			sampledImage[i].type = imageView->getType();
 			sampledImage[i].swizzle = imageView->getComponentMapping();
+			sampledImage[i].tiledLayout = imageView->id.tiled;
 			sampledImage[i].format = format;
 			sampledImage[i].device = device;
 			sampledImage[i].memoryOwner = imageView;
@@ -417,10 +419,11 @@ void DescriptorSetLayout::WriteDescriptorSet(Device *device, DescriptorSet *dstS
 					int height = extent.height;
 					int layerCount = imageView->getSubresourceRange().layerCount;
 					int depth = imageView->getDepthOrLayerCount(level);
-					int bytes = format.bytes();
+					// Directly sampled compressed levels are addressed in bytes, by row of blocks.
+					int bytes = format.isCompressed() ? 1 : format.bytes();
 					int pitchP = imageView->rowPitchBytes(aspect, level, ImageView::SAMPLING) / bytes;
 					int sliceP = (layerCount > 1 ? imageView->layerPitchBytes(aspect, ImageView::SAMPLING) : imageView->slicePitchBytes(aspect, level, ImageView::SAMPLING)) / bytes;
-					int samplePitchP = imageView->getMipLevelSize(aspect, level, ImageView::SAMPLING) / bytes;
+					int samplePitchP = imageView->samplePitchBytes(aspect, level, ImageView::SAMPLING) / bytes;
 					int sampleMax = imageView->getSampleCount() - 1;
 
 					WriteTextureLevelInfo(texture, mipmapLevel, width, height, depth, pitchP, sliceP, samplePitchP, sampleMax);
@@ -444,7 +447,7 @@ void DescriptorSetLayout::WriteDescriptorSet(Device *device, DescriptorSet *dstS
 			storageImage[i].height = extent.height;
 			storageImage[i].depth = imageView->getDepthOrLayerCount(0);
 			storageImage[i].rowPitchBytes = imageView->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
-			storageImage[i].samplePitchBytes = imageView->slicePitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
+			storageImage[i].samplePitchBytes = imageView->samplePitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
 			storageImage[i].slicePitchBytes = layerCount > 1
 			                                      ? imageView->layerPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT)
 			                                      : imageView->slicePitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
@@ -456,7 +459,7 @@ void DescriptorSetLayout::WriteDescriptorSet(Device *device, DescriptorSet *dstS
 			{
 				storageImage[i].stencilPtr = imageView->getOffsetPointer({ 0, 0, 0 }, VK_IMAGE_ASPECT_STENCIL_BIT, 0, 0);
 				storageImage[i].stencilRowPitchBytes = imageView->rowPitchBytes(VK_IMAGE_ASPECT_STENCIL_BIT, 0);
-				storageImage[i].stencilSamplePitchBytes = imageView->slicePitchBytes(VK_IMAGE_ASPECT_STENCIL_BIT, 0);
+				storageImage[i].stencilSamplePitchBytes = imageView->samplePitchBytes(VK_IMAGE_ASPECT_STENCIL_BIT, 0);
 				storageImage[i].stencilSlicePitchBytes = (imageView->getSubresourceRange().layerCount > 1)
 				                                             ? imageView->layerPitchBytes(VK_IMAGE_ASPECT_STENCIL_BIT)
 				                                             : imageView->slicePitchBytes(VK_IMAGE_ASPECT_STENCIL_BIT, 0);
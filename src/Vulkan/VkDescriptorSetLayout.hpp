@@ -43,6 +43,7 @@ struct alignas(16) SampledImageDescriptor
 	VkImageViewType type;
 	VkFormat format;
 	VkComponentMapping swizzle;
+	bool tiledLayout;  // Texels are stored in 4x4 tiles
 	alignas(16) sw::Texture texture;
 	int width;  // Of base mip-level.
 	int height;
@@ -281,56 +281,22 @@ VkResult Device::waitForSemaphores(const VkSemaphoreWaitInfo *pWaitInfo, uint64_
 	bool infiniteTimeout = false;
 	const time_point end_ns = getEndTimePoint(timeout, infiniteTimeout);
 
-	if(pWaitInfo->flags & VK_SEMAPHORE_WAIT_ANY_BIT)
-	{
-		TimelineSemaphore any = TimelineSemaphore();
-
-		for(uint32_t i = 0; i < pWaitInfo->semaphoreCount; i++)
-		{
-			TimelineSemaphore *semaphore = DynamicCast<TimelineSemaphore>(pWaitInfo->pSemaphores[i]);
-			uint64_t waitValue = pWaitInfo->pValues[i];
-
-			if(semaphore->getCounterValue() == waitValue)
-			{
-				return VK_SUCCESS;
-			}
-
-			semaphore->addDependent(any, waitValue);
-		}
-
-		if(infiniteTimeout)
-		{
-			any.wait(1ull);
-			return VK_SUCCESS;
-		}
-		else
-		{
-			if(any.wait(1, end_ns) == VK_SUCCESS)
-			{
-				return VK_SUCCESS;
-			}
-		}
+	ASSERT((pWaitInfo->flags & ~VK_SEMAPHORE_WAIT_ANY_BIT) == 0);
+	bool waitAny = (pWaitInfo->flags & VK_SEMAPHORE_WAIT_ANY_BIT) != 0;
 
-		return VK_TIMEOUT;
+	marl::containers::vector<TimelineSemaphore *, 8> semaphores;
+	for(uint32_t i = 0; i < pWaitInfo->semaphoreCount; i++)
+	{
+		semaphores.push_back(DynamicCast<TimelineSemaphore>(pWaitInfo->pSemaphores[i]));
 	}
-	else
+
+	if(infiniteTimeout)
 	{
-		ASSERT(pWaitInfo->flags == 0);
-		for(uint32_t i = 0; i < pWaitInfo->semaphoreCount; i++)
-		{
-			TimelineSemaphore *semaphore = DynamicCast<TimelineSemaphore>(pWaitInfo->pSemaphores[i]);
-			uint64_t value = pWaitInfo->pValues[i];
-			if(infiniteTimeout)
-			{
-				semaphore->wait(value);
-			}
-			else if(semaphore->wait(pWaitInfo->pValues[i], end_ns) != VK_SUCCESS)
-			{
-				return VK_TIMEOUT;
-			}
-		}
+		TimelineSemaphore::Wait(pWaitInfo->semaphoreCount, semaphores.begin(), pWaitInfo->pValues, waitAny);
 		return VK_SUCCESS;
 	}
+
+	return TimelineSemaphore::Wait(pWaitInfo->semaphoreCount, semaphores.begin(), pWaitInfo->pValues, waitAny, end_ns);
 }
 
 VkResult Device::waitIdle()
@@ -68,6 +68,7 @@ public:
 	void getRequirements(VkMemoryDedicatedRequirements *requirements) const;
 	const VkPhysicalDeviceFeatures &getEnabledFeatures() const { return enabledFeatures; }
 	sw::Blitter *getBlitter() const { return blitter.get(); }
+	marl::Scheduler *getScheduler() const { return scheduler.get(); }
 
 	void registerImageView(ImageView *imageView);
 	void unregisterImageView(ImageView *imageView);
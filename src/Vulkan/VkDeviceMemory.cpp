@@ -192,6 +192,7 @@ struct OpaqueFdAllocateInfo
 	bool importFd = false;
 	bool exportFd = false;
 	int fd = -1;
+	VkExternalMemoryHandleTypeFlagBits handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
 
 	OpaqueFdAllocateInfo() = default;
 
@@ -207,12 +208,19 @@ struct OpaqueFdAllocateInfo
 				{
 					const auto *importInfo = reinterpret_cast<const VkImportMemoryFdInfoKHR *>(createInfo);
 
-					if(importInfo->handleType != VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT)
+					switch(importInfo->handleType)
 					{
-						UNSUPPORTED("VkImportMemoryFdInfoKHR::handleType %d", int(importInfo->handleType));
+						case VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT:
+#	if SWIFTSHADER_EXTERNAL_MEMORY_DMA_BUF
+						case VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT:
+#	endif
+							break;
+						default:
+							UNSUPPORTED("VkImportMemoryFdInfoKHR::handleType %d", int(importInfo->handleType));
 					}
 					importFd = true;
 					fd = importInfo->fd;
+					handleType = importInfo->handleType;
 				}
 				break;
 				case VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO:
@@ -231,6 +239,9 @@ struct OpaqueFdAllocateInfo
 					// "If the pNext chain includes a VkMemoryDedicatedAllocateInfo structure, then that structure
 					//  includes a handle of the sole buffer or image resource that the memory *can* be bound to."
 					break;
+				case VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT:
+					// Handled by ExternalMemoryHost.
+					break;
 				default:
 					WARN("VkMemoryAllocateInfo->pNext sType = %s", vk::Stringify(createInfo->sType).c_str());
 			}
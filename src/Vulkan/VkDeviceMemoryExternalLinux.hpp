@@ -18,6 +18,7 @@
 #include <errno.h>
 #include <string.h>
 #include <sys/mman.h>
+#include <unistd.h>
 
 class OpaqueFdExternalMemory : public vk::DeviceMemory::ExternalBase
 {
@@ -44,6 +45,17 @@ public:
 	{
 		if(allocateInfo.importFd)
 		{
+			// Any mappable file descriptor can be imported, be it a memfd region
+			// or a dma-buf exported by another driver. Mapping past the end of it
+			// would fault on first access, so reject regions that are too small
+			// before taking ownership of the descriptor.
+			off_t regionSize = ::lseek(allocateInfo.fd, 0, SEEK_END);
+			if(regionSize < 0 || static_cast<size_t>(regionSize) < size)
+			{
+				TRACE("Imported fd %d is too small (%lld < %lld bytes)", allocateInfo.fd, (long long)regionSize, (long long)size);
+				return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+			}
+
 			memfd.importFd(allocateInfo.fd);
 			if(!memfd.isValid())
 			{
@@ -78,7 +90,8 @@ public:
 
 	VkExternalMemoryHandleTypeFlagBits getFlagBit() const override
 	{
-		return typeFlagBit;
+		// Imported dma-bufs are handled by this class too.
+		return allocateInfo.handleType;
 	}
 
 	VkResult exportFd(int *pFd) const override
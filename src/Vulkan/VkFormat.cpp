@@ -529,6 +529,30 @@ bool Format::isCompressed() const
 	}
 }
 
+// Returns true if the sampler decodes blocks of this format directly, so images
+// don't need a decompressed copy for sampling.
+bool Format::isSampledCompressed() const
+{
+	switch(format)
+	{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC2_UNORM_BLOCK:
+		case VK_FORMAT_BC2_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC4_SNORM_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC5_SNORM_BLOCK:
+			return true;
+		default:
+			return false;
+	}
+}
+
 VkFormat Format::getDecompressedFormat() const
 {
 	// Note: our ETC2 decoder decompresses the 64 bit RGB compressed texel data to B8G8R8
@@ -47,6 +47,7 @@ public:
 	bool isCompatible(const Format &other) const;
 	bool isCompressed() const;
 	VkFormat getDecompressedFormat() const;
+	bool isSampledCompressed() const;
 	int blockWidth() const;
 	int blockHeight() const;
 	int bytesPerBlock() const;
@@ -21,6 +21,23 @@
 #include <memory.h>
 #include <algorithm>
 
+namespace {
+
+// Returns the aspects of an attachment whose load or store operation is VK_ATTACHMENT_*_OP_DONT_CARE
+template<typename Op>
+VkImageAspectFlags dontCareAspects(const VkAttachmentDescription &attachment, Op op, Op stencilOp, Op dontCare)
+{
+	VkImageAspectFlags aspectMask = vk::Format(attachment.format).getAspects();
+	if(op != dontCare)
+		aspectMask &= VK_IMAGE_ASPECT_STENCIL_BIT;
+	if(stencilOp != dontCare)
+		aspectMask &= ~VK_IMAGE_ASPECT_STENCIL_BIT;
+
+	return aspectMask;
+}
+
+}  // anonymous namespace
+
 namespace vk {
 
 Framebuffer::Framebuffer(const VkFramebufferCreateInfo *pCreateInfo, void *mem)
@@ -196,6 +213,56 @@ void Framebuffer::resolve(const RenderPass *renderPass, uint32_t subpassIndex)
 	}
 }
 
+// Within the render area, the contents of attachments are undefined before a
+// VK_ATTACHMENT_LOAD_OP_DONT_CARE and after a VK_ATTACHMENT_STORE_OP_DONT_CARE,
+// so clears which haven't been written to memory yet never need to be.
+// With multiview, only the layers in the view masks are rendered to.
+void Framebuffer::discardOnLoad(const RenderPass *renderPass, const VkRect2D &renderArea)
+{
+	for(uint32_t i = 0; i < attachmentCount; i++)
+	{
+		const VkAttachmentDescription attachment = renderPass->getAttachment(i);
+		VkImageAspectFlags aspectMask = dontCareAspects(attachment, attachment.loadOp, attachment.stencilLoadOp, VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+
+		if(!aspectMask || !renderPass->isAttachmentUsed(i))
+		{
+			continue;
+		}
+
+		if(renderPass->isMultiView())
+		{
+			attachments[i]->discardWithLayerMask(aspectMask, renderArea, renderPass->getAttachmentViewMask(i));
+		}
+		else
+		{
+			attachments[i]->discard(aspectMask, renderArea, extent.depth);
+		}
+	}
+}
+
+void Framebuffer::discardOnStore(const RenderPass *renderPass, const VkRect2D &renderArea)
+{
+	for(uint32_t i = 0; i < attachmentCount; i++)
+	{
+		const VkAttachmentDescription attachment = renderPass->getAttachment(i);
+		VkImageAspectFlags aspectMask = dontCareAspects(attachment, attachment.storeOp, attachment.stencilStoreOp, VK_ATTACHMENT_STORE_OP_DONT_CARE);
+
+		if(!aspectMask || !renderPass->isAttachmentUsed(i))
+		{
+			continue;
+		}
+
+		if(renderPass->isMultiView())
+		{
+			attachments[i]->discardWithLayerMask(aspectMask, renderArea, renderPass->getAttachmentViewMask(i));
+		}
+		else
+		{
+			attachments[i]->discard(aspectMask, renderArea, extent.depth);
+		}
+	}
+}
+
 size_t Framebuffer::ComputeRequiredAllocationSize(const VkFramebufferCreateInfo *pCreateInfo)
 {
 	const VkBaseInStructure *curInfo = reinterpret_cast<const VkBaseInStructure *>(pCreateInfo->pNext);
@@ -35,6 +35,8 @@ public:
 	void setAttachment(ImageView *imageView, uint32_t index);
 	ImageView *getAttachment(uint32_t index) const;
 	void resolve(const RenderPass *renderPass, uint32_t subpassIndex);
+	void discardOnLoad(const RenderPass *renderPass, const VkRect2D &renderArea);
+	void discardOnStore(const RenderPass *renderPass, const VkRect2D &renderArea);
 
 	const VkExtent3D &getExtent() const { return extent; }
 
@@ -315,6 +315,8 @@ static const std::unordered_map<std::string, PFN_vkVoidFunction> deviceFunctionP
 	MAKE_VULKAN_DEVICE_ENTRY(vkCmdEndRenderPass2),
 	MAKE_VULKAN_DEVICE_ENTRY(vkCmdNextSubpass2),
 	MAKE_VULKAN_DEVICE_ENTRY(vkResetQueryPool),
+	MAKE_VULKAN_DEVICE_ENTRY(vkCmdDrawIndirectCount),
+	MAKE_VULKAN_DEVICE_ENTRY(vkCmdDrawIndexedIndirectCount),
 	// VK_KHR_timeline_semaphore
 	MAKE_VULKAN_DEVICE_ENTRY(vkGetSemaphoreCounterValue),
 	MAKE_VULKAN_DEVICE_ENTRY(vkSignalSemaphore),
@@ -381,6 +383,13 @@ static const std::vector<std::pair<const char *, std::unordered_map<std::string,
 	        MAKE_VULKAN_DEVICE_ENTRY(vkCmdNextSubpass2KHR),
 	        MAKE_VULKAN_DEVICE_ENTRY(vkCmdEndRenderPass2KHR),
 	    } },
+	// VK_KHR_draw_indirect_count
+	{
+	    VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME,
+	    {
+	        MAKE_VULKAN_DEVICE_ENTRY(vkCmdDrawIndirectCountKHR),
+	        MAKE_VULKAN_DEVICE_ENTRY(vkCmdDrawIndexedIndirectCountKHR),
+	    } },
 	// VK_KHR_timeline_semaphore
 	{
 	    VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME,
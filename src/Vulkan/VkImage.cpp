@@ -23,13 +23,22 @@
 #include "Device/BC_Decoder.hpp"
 #include "Device/Blitter.hpp"
 #include "Device/ETC_Decoder.hpp"
+#include "System/Math.hpp"
+
+#include "marl/defer.h"
+#include "marl/scheduler.h"
+#include "marl/waitgroup.h"
 
 #ifdef __ANDROID__
 #	include "System/GrallocAndroid.hpp"
 #	include "VkDeviceMemoryExternalAndroid.hpp"
 #endif
 
+#include <algorithm>
+#include <array>
 #include <cstring>
+#include <thread>
+#include <vector>
 
 namespace {
 
@@ -159,6 +168,158 @@ VkFormat GetImageFormat(const VkImageCreateInfo *pCreateInfo)
 	return pCreateInfo->format;
 }
 
+// Compressed images get a decompressed copy for sampling, unless the sampler
+// can decode their blocks directly. Cube maps keep the copy, since seamless
+// filtering relies on its borders.
+bool RequiresDecompressedImage(const VkImageCreateInfo *pCreateInfo)
+{
+	vk::Format format(pCreateInfo->format);
+	if(!format.isCompressed())
+	{
+		return false;
+	}
+
+	return !format.isSampledCompressed() ||
+	       (pCreateInfo->imageType != VK_IMAGE_TYPE_2D) ||
+	       (pCreateInfo->flags & VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT);
+}
+
+// Images which are only sampled and transferred get sampled from a copy stored
+// in 4x4 texel tiles, so that filter footprints share cache lines. The copy is
+// only written by prepareForSampling(), since they're never rendered to nor
+// used as storage, and transfers access the linear image itself.
+bool RequiresTiledImage(const VkImageCreateInfo *pCreateInfo)
+{
+	const VkImageUsageFlags sampledAndTransfer = VK_IMAGE_USAGE_SAMPLED_BIT |
+	                                             VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+	                                             VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+	vk::Format format(pCreateInfo->format);
+	if(format.isCompressed() || format.isYcbcrFormat() || format.isDepth() || format.isStencil())
+	{
+		return false;
+	}
+
+	// Memory shared with another API is written without telling the image.
+	const auto *nextInfo = reinterpret_cast<const VkBaseInStructure *>(pCreateInfo->pNext);
+	for(; nextInfo != nullptr; nextInfo = nextInfo->pNext)
+	{
+		if((nextInfo->sType == VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO) &&
+		   (reinterpret_cast<const VkExternalMemoryImageCreateInfo *>(nextInfo)->handleTypes != 0))
+		{
+			return false;
+		}
+	}
+
+	return (pCreateInfo->imageType == VK_IMAGE_TYPE_2D) &&
+	       (pCreateInfo->samples == VK_SAMPLE_COUNT_1_BIT) &&
+	       (pCreateInfo->tiling == VK_IMAGE_TILING_OPTIMAL) &&
+	       (pCreateInfo->usage & VK_IMAGE_USAGE_SAMPLED_BIT) &&
+	       ((pCreateInfo->usage & ~sampledAndTransfer) == 0) &&
+	       ((pCreateInfo->flags & ~VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT) == 0);
+}
+
+// Covers any subresource entirely, once clamped to its extent.
+constexpr VkRect2D WHOLE_SUBRESOURCE = { { 0, 0 }, { UINT32_MAX, UINT32_MAX } };
+
+// Beyond this many dirty regions per subresource, they get merged into their
+// bounding rectangle, so that tracking them doesn't outweigh the work it saves.
+constexpr size_t MAX_DIRTY_REGIONS = 8;
+
+bool ContainsRegion(const VkRect2D &outer, const VkRect2D &inner)
+{
+	return (inner.offset.x >= outer.offset.x) &&
+	       (inner.offset.y >= outer.offset.y) &&
+	       (int64_t(inner.offset.x) + inner.extent.width <= int64_t(outer.offset.x) + outer.extent.width) &&
+	       (int64_t(inner.offset.y) + inner.extent.height <= int64_t(outer.offset.y) + outer.extent.height);
+}
+
+VkRect2D BoundingRegion(const VkRect2D &a, const VkRect2D &b)
+{
+	int64_t x0 = std::min(a.offset.x, b.offset.x);
+	int64_t y0 = std::min(a.offset.y, b.offset.y);
+	int64_t x1 = std::max(int64_t(a.offset.x) + a.extent.width, int64_t(b.offset.x) + b.extent.width);
+	int64_t y1 = std::max(int64_t(a.offset.y) + a.extent.height, int64_t(b.offset.y) + b.extent.height);
+
+	return { { int32_t(x0), int32_t(y0) },
+	         { uint32_t(std::min<int64_t>(x1 - x0, UINT32_MAX)), uint32_t(std::min<int64_t>(y1 - y0, UINT32_MAX)) } };
+}
+
+VkRect2D ClampRegion(const VkRect2D &region, const VkExtent3D &extent)
+{
+	int64_t x0 = std::max(region.offset.x, 0);
+	int64_t y0 = std::max(region.offset.y, 0);
+	int64_t x1 = std::min(int64_t(region.offset.x) + region.extent.width, int64_t(extent.width));
+	int64_t y1 = std::min(int64_t(region.offset.y) + region.extent.height, int64_t(extent.height));
+
+	return { { int32_t(x0), int32_t(y0) },
+	         { uint32_t(std::max<int64_t>(x1 - x0, 0)), uint32_t(std::max<int64_t>(y1 - y0, 0)) } };
+}
+
+void AddDirtyRegion(std::vector<VkRect2D> &regions, const VkRect2D &region)
+{
+	for(const VkRect2D &dirty : regions)
+	{
+		if(ContainsRegion(dirty, region))
+		{
+			return;
+		}
+	}
+
+	regions.erase(std::remove_if(regions.begin(), regions.end(),
+	                             [&](const VkRect2D &dirty) { return ContainsRegion(region, dirty); }),
+	              regions.end());
+
+	if(regions.size() < MAX_DIRTY_REGIONS)
+	{
+		regions.push_back(region);
+		return;
+	}
+
+	VkRect2D bounds = region;
+	for(const VkRect2D &dirty : regions)
+	{
+		bounds = BoundingRegion(bounds, dirty);
+	}
+
+	regions.assign(1, bounds);
+}
+
+// Buffer-image copies which move at least this many bytes per task are split across the
+// marl scheduler, into at most MAX_COPY_TASKS tasks.
+constexpr VkDeviceSize MIN_COPY_BYTES_PER_TASK = 512 * 1024;
+constexpr uint32_t MAX_COPY_TASKS = 16;
+
+// Calls copySpans(begin, end) on consecutive ranges of [0, spanCount), in parallel when
+// the spans add up to enough bytes for the scheduling overhead to pay off.
+template<typename Function>
+void CopySpans(uint32_t spanCount, VkDeviceSize spanSize, const Function &copySpans)
+{
+	VkDeviceSize minSpansPerTask = std::max<VkDeviceSize>(MIN_COPY_BYTES_PER_TASK / std::max<VkDeviceSize>(spanSize, 1), 1);
+	VkDeviceSize spansPerTask = std::max<VkDeviceSize>((spanCount + MAX_COPY_TASKS - 1) / MAX_COPY_TASKS, minSpansPerTask);
+
+	if(spansPerTask >= spanCount)
+	{
+		copySpans(0, spanCount);
+		return;
+	}
+
+	marl::WaitGroup wg;
+
+	for(uint32_t begin = 0; begin < spanCount; begin += static_cast<uint32_t>(spansPerTask))
+	{
+		uint32_t end = static_cast<uint32_t>(std::min<VkDeviceSize>(begin + spansPerTask, spanCount));
+
+		wg.add(1);
+		marl::schedule([=, &copySpans] {
+			defer(wg.done());
+			copySpans(begin, end);
+		});
+	}
+
+	wg.wait();
+}
+
 }  // anonymous namespace
 
 namespace vk {
@@ -175,12 +336,17 @@ Image::Image(const VkImageCreateInfo *pCreateInfo, void *mem, Device *device)
     , tiling(pCreateInfo->tiling)
     , usage(pCreateInfo->usage)
 {
-	if(format.isCompressed())
+	if(RequiresDecompressedImage(pCreateInfo))
 	{
 		VkImageCreateInfo compressedImageCreateInfo = *pCreateInfo;
 		compressedImageCreateInfo.format = format.getDecompressedFormat();
 		decompressedImage = new(mem) Image(&compressedImageCreateInfo, nullptr, device);
 	}
+	else if(mem && RequiresTiledImage(pCreateInfo))  // The tiled image has no memory for a copy of its own
+	{
+		tiledImage = new(mem) Image(pCreateInfo, nullptr, device);
+		tiledImage->tiledLayout = true;
+	}
 
 	const auto *nextInfo = reinterpret_cast<const VkBaseInStructure *>(pCreateInfo->pNext);
 	for(; nextInfo != nullptr; nextInfo = nextInfo->pNext)
@@ -199,11 +365,16 @@ void Image::destroy(const VkAllocationCallbacks *pAllocator)
 	{
 		vk::deallocate(decompressedImage, pAllocator);
 	}
+
+	if(tiledImage)
+	{
+		vk::deallocate(tiledImage, pAllocator);
+	}
 }
 
 size_t Image::ComputeRequiredAllocationSize(const VkImageCreateInfo *pCreateInfo)
 {
-	return Format(pCreateInfo->format).isCompressed() ? sizeof(Image) : 0;
+	return (RequiresDecompressedImage(pCreateInfo) || RequiresTiledImage(pCreateInfo)) ? sizeof(Image) : 0;
 }
 
 const VkMemoryRequirements Image::getMemoryRequirements() const
@@ -212,7 +383,8 @@ const VkMemoryRequirements Image::getMemoryRequirements() const
 	memoryRequirements.alignment = vk::REQUIRED_MEMORY_ALIGNMENT;
 	memoryRequirements.memoryTypeBits = vk::MEMORY_TYPE_GENERIC_BIT;
 	memoryRequirements.size = getStorageSize(format.getAspects()) +
-	                          (decompressedImage ? decompressedImage->getStorageSize(decompressedImage->format.getAspects()) : 0);
+	                          (decompressedImage ? decompressedImage->getStorageSize(decompressedImage->format.getAspects()) : 0) +
+	                          (tiledImage ? tiledImage->getStorageSize(tiledImage->format.getAspects()) : 0);
 	return memoryRequirements;
 }
 
@@ -233,7 +405,7 @@ size_t Image::getSizeInBytes(const VkImageSubresourceRange &subresourceRange) co
 			size = (layerCount - 1) * getLayerSize(aspect);
 			for(uint32_t mipLevel = subresourceRange.baseMipLevel; mipLevel <= lastMipLevel; ++mipLevel)
 			{
-				size += getMultiSampledLevelSize(aspect, mipLevel);
+				size += getMipLevelSize(aspect, mipLevel);
 			}
 		}
 		else  // All mip levels used, compute full layer sizes
@@ -245,7 +417,7 @@ size_t Image::getSizeInBytes(const VkImageSubresourceRange &subresourceRange) co
 	{
 		for(uint32_t mipLevel = subresourceRange.baseMipLevel; mipLevel <= lastMipLevel; ++mipLevel)
 		{
-			size += getMultiSampledLevelSize(aspect, mipLevel);
+			size += getMipLevelSize(aspect, mipLevel);
 		}
 	}
 
@@ -266,6 +438,11 @@ void Image::bind(DeviceMemory *pDeviceMemory, VkDeviceSize pMemoryOffset)
 		decompressedImage->deviceMemory = deviceMemory;
 		decompressedImage->memoryOffset = memoryOffset + getStorageSize(format.getAspects());
 	}
+	if(tiledImage)
+	{
+		tiledImage->deviceMemory = deviceMemory;
+		tiledImage->memoryOffset = memoryOffset + getStorageSize(format.getAspects());
+	}
 }
 
 #ifdef __ANDROID__
@@ -339,7 +516,7 @@ void Image::getSubresourceLayout(const VkImageSubresource *pSubresource, VkSubre
 
 	auto aspect = static_cast<VkImageAspectFlagBits>(pSubresource->aspectMask);
 	pLayout->offset = getMemoryOffset(aspect, pSubresource->mipLevel, pSubresource->arrayLayer);
-	pLayout->size = getMultiSampledLevelSize(aspect, pSubresource->mipLevel);
+	pLayout->size = getMipLevelSize(aspect, pSubresource->mipLevel);
 	pLayout->rowPitch = rowPitchBytes(aspect, pSubresource->mipLevel);
 	pLayout->depthPitch = slicePitchBytes(aspect, pSubresource->mipLevel);
 	pLayout->arrayPitch = getLayerSize(aspect);
@@ -370,6 +547,11 @@ void Image::copyTo(Image *dstImage, const VkImageCopy &region) const
 		UNSUPPORTED("dstSubresource.aspectMask %X", region.dstSubresource.aspectMask);
 	}
 
+	prepareForTransfer({ region.srcSubresource.aspectMask, region.srcSubresource.mipLevel, 1,
+	                     region.srcSubresource.baseArrayLayer, region.srcSubresource.layerCount });
+	dstImage->prepareForTransfer({ region.dstSubresource.aspectMask, region.dstSubresource.mipLevel, 1,
+	                               region.dstSubresource.baseArrayLayer, region.dstSubresource.layerCount });
+
 	VkImageAspectFlagBits srcAspect = static_cast<VkImageAspectFlagBits>(region.srcSubresource.aspectMask);
 	VkImageAspectFlagBits dstAspect = static_cast<VkImageAspectFlagBits>(region.dstSubresource.aspectMask);
 
@@ -388,10 +570,11 @@ void Image::copyTo(Image *dstImage, const VkImageCopy &region) const
 	bool one3D = (srcImageType == VK_IMAGE_TYPE_3D) != (dstImageType == VK_IMAGE_TYPE_3D);
 	bool both3D = (srcImageType == VK_IMAGE_TYPE_3D) && (dstImageType == VK_IMAGE_TYPE_3D);
 
-	// Texel layout pitches, using the VkSubresourceLayout nomenclature.
-	int srcRowPitch = rowPitchBytes(srcAspect, region.srcSubresource.mipLevel);
+	// Texel layout pitches, using the VkSubresourceLayout nomenclature. The rows of the samples of
+	// multisampled images are interleaved, so they're copied like the rows of a taller image.
+	int srcRowPitch = samplePitchBytes(srcAspect, region.srcSubresource.mipLevel);
 	int srcDepthPitch = slicePitchBytes(srcAspect, region.srcSubresource.mipLevel);
-	int dstRowPitch = dstImage->rowPitchBytes(dstAspect, region.dstSubresource.mipLevel);
+	int dstRowPitch = dstImage->samplePitchBytes(dstAspect, region.dstSubresource.mipLevel);
 	int dstDepthPitch = dstImage->slicePitchBytes(dstAspect, region.dstSubresource.mipLevel);
 	VkDeviceSize srcArrayPitch = getLayerSize(srcAspect);
 	VkDeviceSize dstArrayPitch = dstImage->getLayerSize(dstAspect);
@@ -409,12 +592,11 @@ void Image::copyTo(Image *dstImage, const VkImageCopy &region) const
 
 	// Copies between 2D and 3D images are treated as layers, so only use depth as the slice count when
 	// both images are 3D.
-	// Multisample images are currently implemented similar to 3D images by storing one sample per slice.
-	// TODO(b/160600347): Store samples consecutively.
-	uint32_t sliceCount = both3D ? copyExtent.depth : samples;
+	uint32_t sliceCount = both3D ? copyExtent.depth : 1;
+	uint32_t rowCount = copyExtent.height * samples;
 
 	bool isSingleSlice = (sliceCount == 1);
-	bool isSingleRow = (copyExtent.height == 1) && isSingleSlice;
+	bool isSingleRow = (rowCount == 1) && isSingleSlice;
 	// In order to copy multiple rows using a single memcpy call, we
 	// have to make sure that we need to copy the entire row and that
 	// both source and destination rows have the same size in bytes
@@ -451,7 +633,7 @@ void Image::copyTo(Image *dstImage, const VkImageCopy &region) const
 		}
 		else if(isEntireRow && isSingleSlice)  // Copy one slice
 		{
-			size_t copySize = copyExtent.height * srcRowPitch;
+			size_t copySize = rowCount * srcRowPitch;
 			ASSERT((srcLayer + copySize) < end());
 			ASSERT((dstLayer + copySize) < dstImage->end());
 			memcpy(dstLayer, srcLayer, copySize);
@@ -465,7 +647,7 @@ void Image::copyTo(Image *dstImage, const VkImageCopy &region) const
 		}
 		else if(isEntireRow)  // Copy slice by slice
 		{
-			size_t sliceSize = copyExtent.height * srcRowPitch;
+			size_t sliceSize = rowCount * srcRowPitch;
 			const uint8_t *srcSlice = srcLayer;
 			uint8_t *dstSlice = dstLayer;
 
@@ -491,7 +673,7 @@ void Image::copyTo(Image *dstImage, const VkImageCopy &region) const
 				const uint8_t *srcRow = srcSlice;
 				uint8_t *dstRow = dstSlice;
 
-				for(uint32_t y = 0; y < copyExtent.height; y++)
+				for(uint32_t y = 0; y < rowCount; y++)
 				{
 					ASSERT((srcRow + rowSize) < end());
 					ASSERT((dstRow + rowSize) < dstImage->end());
@@ -511,8 +693,9 @@ void Image::copyTo(Image *dstImage, const VkImageCopy &region) const
 		dstLayer += dstLayerPitch;
 	}
 
-	dstImage->contentsChanged({ region.dstSubresource.aspectMask, region.dstSubresource.mipLevel, 1,
-	                            region.dstSubresource.baseArrayLayer, region.dstSubresource.layerCount });
+	// The copy extent is in blocks, which may differ in size between compatible formats.
+	dstImage->contentsChanged(region.dstSubresource, region.dstOffset,
+	                          { copyExtent.width * dstFormat.blockWidth(), copyExtent.height * dstFormat.blockHeight(), copyExtent.depth });
 }
 
 void Image::copy(Buffer *buffer, const VkBufferImageCopy &region, bool bufferIsSource)
@@ -531,6 +714,9 @@ void Image::copy(Buffer *buffer, const VkBufferImageCopy &region, bool bufferIsS
 			break;
 	}
 
+	prepareForTransfer({ region.imageSubresource.aspectMask, region.imageSubresource.mipLevel, 1,
+	                     region.imageSubresource.baseArrayLayer, region.imageSubresource.layerCount });
+
 	auto aspect = static_cast<VkImageAspectFlagBits>(region.imageSubresource.aspectMask);
 	Format copyFormat = getFormat(aspect);
 
@@ -593,56 +779,50 @@ void Image::copy(Buffer *buffer, const VkBufferImageCopy &region, bool bufferIsS
 	VkDeviceSize srcLayerSize = bufferIsSource ? bufferSlicePitchBytes : imageLayerSize;
 	VkDeviceSize dstLayerSize = bufferIsSource ? imageLayerSize : bufferSlicePitchBytes;
 
-	for(uint32_t i = 0; i < region.imageSubresource.layerCount; i++)
+	// Each layer is copied as sliceCount x spanCount spans which don't depend on each other,
+	// so large copies can be split across threads. Spans are either single rows, whole
+	// slices, or pieces of one contiguous range of memory.
+	bool isContiguous = isSingleRow || (isEntireRow && isSingleSlice) || isEntireSlice;
+	uint32_t sliceCount = isContiguous ? 1 : imageExtent.depth;
+	uint32_t spanCount = 1;
+	VkDeviceSize spanSize = copySize;
+	VkDeviceSize srcSpanPitchBytes = 0;
+	VkDeviceSize dstSpanPitchBytes = 0;
+
+	if(isContiguous)
 	{
-		if(isSingleRow || (isEntireRow && isSingleSlice) || isEntireSlice)
-		{
-			ASSERT(((bufferIsSource ? dstMemory : srcMemory) + copySize) < end());
-			ASSERT(((bufferIsSource ? srcMemory : dstMemory) + copySize) < buffer->end());
-			memcpy(dstMemory, srcMemory, copySize);
-		}
-		else if(isEntireRow)  // Copy slice by slice
-		{
-			uint8_t *srcSliceMemory = srcMemory;
-			uint8_t *dstSliceMemory = dstMemory;
-			for(uint32_t z = 0; z < imageExtent.depth; z++)
-			{
-				ASSERT(((bufferIsSource ? dstSliceMemory : srcSliceMemory) + copySize) < end());
-				ASSERT(((bufferIsSource ? srcSliceMemory : dstSliceMemory) + copySize) < buffer->end());
-				memcpy(dstSliceMemory, srcSliceMemory, copySize);
-				srcSliceMemory += srcSlicePitchBytes;
-				dstSliceMemory += dstSlicePitchBytes;
-			}
-		}
-		else  // Copy row by row
+		spanSize = std::min(copySize, MIN_COPY_BYTES_PER_TASK);
+		spanCount = static_cast<uint32_t>((copySize + spanSize - 1) / spanSize);
+		srcSpanPitchBytes = spanSize;
+		dstSpanPitchBytes = spanSize;
+	}
+	else if(!isEntireRow)  // Copy row by row
+	{
+		spanCount = imageExtent.height;
+		srcSpanPitchBytes = srcRowPitchBytes;
+		dstSpanPitchBytes = dstRowPitchBytes;
+	}
+
+	CopySpans(region.imageSubresource.layerCount * sliceCount * spanCount, spanSize, [&](uint32_t first, uint32_t last) {
+		for(uint32_t i = first; i < last; i++)
 		{
-			uint8_t *srcLayerMemory = srcMemory;
-			uint8_t *dstLayerMemory = dstMemory;
-			for(uint32_t z = 0; z < imageExtent.depth; z++)
-			{
-				uint8_t *srcSliceMemory = srcLayerMemory;
-				uint8_t *dstSliceMemory = dstLayerMemory;
-				for(uint32_t y = 0; y < imageExtent.height; y++)
-				{
-					ASSERT(((bufferIsSource ? dstSliceMemory : srcSliceMemory) + copySize) < end());
-					ASSERT(((bufferIsSource ? srcSliceMemory : dstSliceMemory) + copySize) < buffer->end());
-					memcpy(dstSliceMemory, srcSliceMemory, copySize);
-					srcSliceMemory += srcRowPitchBytes;
-					dstSliceMemory += dstRowPitchBytes;
-				}
-				srcLayerMemory += srcSlicePitchBytes;
-				dstLayerMemory += dstSlicePitchBytes;
-			}
-		}
+			uint32_t span = i % spanCount;
+			uint32_t slice = (i / spanCount) % sliceCount;
+			uint32_t layer = i / (spanCount * sliceCount);
 
-		srcMemory += srcLayerSize;
-		dstMemory += dstLayerSize;
-	}
+			const uint8_t *srcSpanMemory = srcMemory + layer * srcLayerSize + slice * srcSlicePitchBytes + span * srcSpanPitchBytes;
+			uint8_t *dstSpanMemory = dstMemory + layer * dstLayerSize + slice * dstSlicePitchBytes + span * dstSpanPitchBytes;
+			VkDeviceSize size = isContiguous ? std::min(spanSize, copySize - span * spanSize) : copySize;
+
+			ASSERT(((bufferIsSource ? dstSpanMemory : srcSpanMemory) + size) < end());
+			ASSERT(((bufferIsSource ? srcSpanMemory : dstSpanMemory) + size) < buffer->end());
+			memcpy(dstSpanMemory, srcSpanMemory, size);
+		}
+	});
 
 	if(bufferIsSource)
 	{
-		contentsChanged({ region.imageSubresource.aspectMask, region.imageSubresource.mipLevel, 1,
-		                  region.imageSubresource.baseArrayLayer, region.imageSubresource.layerCount });
+		contentsChanged(region.imageSubresource, region.imageOffset, region.imageExtent);
 	}
 }
 
@@ -804,7 +984,13 @@ int Image::rowPitchBytes(VkImageAspectFlagBits aspect, uint32_t mipLevel) const
 		return extentInBlocks.width * usedFormat.bytesPerBlock();
 	}
 
-	return usedFormat.pitchB(mipLevelExtent.width, borderSize(), true);
+	if(tiledLayout)  // Padded to whole tiles
+	{
+		return usedFormat.pitchB(sw::align<4>(mipLevelExtent.width), 0, true);
+	}
+
+	// The samples of multisampled images are interleaved row by row, see samplePitchBytes()
+	return usedFormat.pitchB(mipLevelExtent.width, borderSize(), true) * samples;
 }
 
 int Image::slicePitchBytes(VkImageAspectFlagBits aspect, uint32_t mipLevel) const
@@ -821,7 +1007,20 @@ int Image::slicePitchBytes(VkImageAspectFlagBits aspect, uint32_t mipLevel) cons
 		return extentInBlocks.height * extentInBlocks.width * usedFormat.bytesPerBlock();
 	}
 
-	return usedFormat.sliceB(mipLevelExtent.width, mipLevelExtent.height, borderSize(), true);
+	if(tiledLayout)  // Padded to whole tiles
+	{
+		return usedFormat.sliceB(sw::align<4>(mipLevelExtent.width), sw::align<4>(mipLevelExtent.height), 0, true);
+	}
+
+	return usedFormat.sliceB(mipLevelExtent.width, mipLevelExtent.height, borderSize(), true) * samples;
+}
+
+int Image::samplePitchBytes(VkImageAspectFlagBits aspect, uint32_t mipLevel) const
+{
+	// Each row of a multisampled image holds the corresponding row of every sample, one after
+	// the other, so that all samples of a pixel quad are close together in memory. Multisampled
+	// images are never compressed, tiled, or 3D.
+	return rowPitchBytes(aspect, mipLevel) / samples;
 }
 
 Format Image::getFormat(VkImageAspectFlagBits aspect) const
@@ -889,7 +1088,7 @@ VkDeviceSize Image::getMemoryOffset(VkImageAspectFlagBits aspect, uint32_t mipLe
 	VkDeviceSize offset = getMemoryOffset(aspect);
 	for(uint32_t i = 0; i < mipLevel; ++i)
 	{
-		offset += getMultiSampledLevelSize(aspect, i);
+		offset += getMipLevelSize(aspect, i);
 	}
 	return offset;
 }
@@ -904,11 +1103,6 @@ VkDeviceSize Image::getMipLevelSize(VkImageAspectFlagBits aspect, uint32_t mipLe
 	return getMipLevelExtent(aspect, mipLevel).depth * slicePitchBytes(aspect, mipLevel);
 }
 
-VkDeviceSize Image::getMultiSampledLevelSize(VkImageAspectFlagBits aspect, uint32_t mipLevel) const
-{
-	return getMipLevelSize(aspect, mipLevel) * samples;
-}
-
 bool Image::is3DSlice() const
 {
 	return ((imageType == VK_IMAGE_TYPE_3D) && (flags & VK_IMAGE_CREATE_2D_ARRAY_COMPATIBLE_BIT));
@@ -937,7 +1131,7 @@ VkDeviceSize Image::getLayerSize(VkImageAspectFlagBits aspect) const
 
 	for(uint32_t mipLevel = 0; mipLevel < mipLevels; ++mipLevel)
 	{
-		layerSize += getMultiSampledLevelSize(aspect, mipLevel);
+		layerSize += getMipLevelSize(aspect, mipLevel);
 	}
 
 	return layerSize;
@@ -965,6 +1159,12 @@ VkDeviceSize Image::getStorageSize(VkImageAspectFlags aspectMask) const
 
 const Image *Image::getSampledImage(const vk::Format &imageViewFormat) const
 {
+	// Tiled copies have the image's format, which views reinterpret like the image itself.
+	if(tiledImage)
+	{
+		return tiledImage;
+	}
+
 	bool isImageViewCompressed = imageViewFormat.isCompressed();
 	if(decompressedImage && !isImageViewCompressed)
 	{
@@ -972,14 +1172,19 @@ const Image *Image::getSampledImage(const vk::Format &imageViewFormat) const
 		ASSERT(format.bytesPerBlock() == imageViewFormat.bytesPerBlock());
 	}
 	// If the ImageView's format is compressed, then we do need to decompress the image so that
-	// it may be sampled properly by texture sampling functions, which don't support compressed
-	// textures. If the ImageView's format is NOT compressed, then we reinterpret cast the
+	// it may be sampled properly by texture sampling functions, unless they decode its blocks
+	// directly. If the ImageView's format is NOT compressed, then we reinterpret cast the
 	// compressed image into the ImageView's format, so we must return the compressed image as is.
 	return (decompressedImage && isImageViewCompressed) ? decompressedImage : this;
 }
 
 void Image::blitTo(Image *dstImage, const VkImageBlit &region, VkFilter filter) const
 {
+	prepareForTransfer({ region.srcSubresource.aspectMask, region.srcSubresource.mipLevel, 1,
+	                     region.srcSubresource.baseArrayLayer, region.srcSubresource.layerCount });
+	dstImage->prepareForTransfer({ region.dstSubresource.aspectMask, region.dstSubresource.mipLevel, 1,
+	                               region.dstSubresource.baseArrayLayer, region.dstSubresource.layerCount });
+
 	device->getBlitter()->blit(this, dstImage, region, filter);
 }
 
@@ -990,11 +1195,19 @@ void Image::copyTo(uint8_t *dst, unsigned int dstPitch) const
 
 void Image::resolveTo(Image *dstImage, const VkImageResolve &region) const
 {
+	prepareForTransfer({ region.srcSubresource.aspectMask, region.srcSubresource.mipLevel, 1,
+	                     region.srcSubresource.baseArrayLayer, region.srcSubresource.layerCount });
+	dstImage->prepareForTransfer({ region.dstSubresource.aspectMask, region.dstSubresource.mipLevel, 1,
+	                               region.dstSubresource.baseArrayLayer, region.dstSubresource.layerCount });
+
 	device->getBlitter()->resolve(this, dstImage, region);
 }
 
 void Image::resolveDepthStencilTo(const ImageView *src, ImageView *dst, const VkSubpassDescriptionDepthStencilResolve &dsResolve) const
 {
+	src->prepareForTransfer();
+	dst->prepareForTransfer();
+
 	device->getBlitter()->resolveDepthStencil(src, dst, dsResolve);
 }
 
@@ -1026,6 +1239,12 @@ uint32_t Image::getLastMipLevel(const VkImageSubresourceRange &subresourceRange)
 
 void Image::clear(void *pixelData, VkFormat pixelFormat, const vk::Format &viewFormat, const VkImageSubresourceRange &subresourceRange, const VkRect2D &renderArea)
 {
+	if(canDeferClears())
+	{
+		deferClear(pixelData, pixelFormat, viewFormat, subresourceRange, &renderArea);
+		return;
+	}
+
 	device->getBlitter()->clear(pixelData, pixelFormat, this, viewFormat, subresourceRange, &renderArea);
 }
 
@@ -1033,6 +1252,13 @@ void Image::clear(const VkClearColorValue &color, const VkImageSubresourceRange
 {
 	ASSERT(subresourceRange.aspectMask == VK_IMAGE_ASPECT_COLOR_BIT);
 
+	if(canDeferClears())
+	{
+		deferClear(color.float32, getClearFormat(), format, subresourceRange, nullptr);
+		return;
+	}
+
+	prepareForTransfer(subresourceRange);
 	device->getBlitter()->clear((void *)color.float32, getClearFormat(), this, format, subresourceRange);
 }
 
@@ -1045,14 +1271,30 @@ void Image::clear(const VkClearDepthStencilValue &color, const VkImageSubresourc
 	{
 		VkImageSubresourceRange depthSubresourceRange = subresourceRange;
 		depthSubresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-		device->getBlitter()->clear((void *)(&color.depth), VK_FORMAT_D32_SFLOAT, this, format, depthSubresourceRange);
+
+		if(canDeferClears())
+		{
+			deferClear(&color.depth, VK_FORMAT_D32_SFLOAT, format, depthSubresourceRange, nullptr);
+		}
+		else
+		{
+			device->getBlitter()->clear((void *)(&color.depth), VK_FORMAT_D32_SFLOAT, this, format, depthSubresourceRange);
+		}
 	}
 
 	if(subresourceRange.aspectMask & VK_IMAGE_ASPECT_STENCIL_BIT)
 	{
 		VkImageSubresourceRange stencilSubresourceRange = subresourceRange;
 		stencilSubresourceRange.aspectMask = VK_IMAGE_ASPECT_STENCIL_BIT;
-		device->getBlitter()->clear((void *)(&color.stencil), VK_FORMAT_S8_UINT, this, format, stencilSubresourceRange);
+
+		if(canDeferClears())
+		{
+			deferClear(&color.stencil, VK_FORMAT_S8_UINT, format, stencilSubresourceRange, nullptr);
+		}
+		else
+		{
+			device->getBlitter()->clear((void *)(&color.stencil), VK_FORMAT_S8_UINT, this, format, stencilSubresourceRange);
+		}
 	}
 }
 
@@ -1084,9 +1326,160 @@ void Image::clear(const VkClearValue &clearValue, const vk::Format &viewFormat,
 	}
 }
 
+bool Image::canDeferClears() const
+{
+	// Only attachments benefit, since they're typically cleared every frame and then
+	// mostly overdrawn. Memory which can be observed outside of the device's transfer,
+	// sampling and rendering paths must hold the cleared contents right away.
+	return (usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)) &&
+	       (tiling == VK_IMAGE_TILING_OPTIMAL) &&
+	       (imageType != VK_IMAGE_TYPE_3D) &&
+	       (format.bytes() <= 16) &&
+	       !(flags & VK_IMAGE_CREATE_ALIAS_BIT) &&
+	       !requiresPreprocessing() &&
+	       (supportedExternalMemoryHandleTypes == 0) &&
+	       !(deviceMemory && deviceMemory->hasExternalImageProperties());
+}
+
+uint32_t Image::getClearTilesIndex(const VkImageSubresource &subresource) const
+{
+	uint32_t plane = (subresource.aspectMask == VK_IMAGE_ASPECT_STENCIL_BIT) ? 1 : 0;
+
+	return (plane * mipLevels + subresource.mipLevel) * arrayLayers + subresource.arrayLayer;
+}
+
+void Image::deferClear(const void *pixelData, VkFormat pixelFormat, const vk::Format &viewFormat, const VkImageSubresourceRange &subresourceRange, const VkRect2D *renderArea)
+{
+	// Only the clear value is recorded. The tiles are left untouched until they're
+	// accessed again, so a subsequent clear simply replaces this one.
+	VkImageAspectFlagBits aspect = static_cast<VkImageAspectFlagBits>(subresourceRange.aspectMask);
+	if(viewFormat.getAspectFormat(aspect) == VK_FORMAT_UNDEFINED)
+	{
+		return;
+	}
+
+	uint8_t texel[16];
+	device->getBlitter()->packClearValue(pixelData, pixelFormat, viewFormat, aspect, texel);
+
+	if(!clearTiles)
+	{
+		clearTiles.reset(new std::unique_ptr<ClearTiles>[2 * mipLevels * arrayLayers]);
+		hasPendingClears = true;
+	}
+
+	uint32_t lastLayer = getLastLayerIndex(subresourceRange);
+	uint32_t lastMipLevel = getLastMipLevel(subresourceRange);
+
+	VkImageSubresource subresource = {
+		subresourceRange.aspectMask,
+		subresourceRange.baseMipLevel,
+		subresourceRange.baseArrayLayer
+	};
+
+	for(subresource.mipLevel = subresourceRange.baseMipLevel;
+	    subresource.mipLevel <= lastMipLevel;
+	    subresource.mipLevel++)
+	{
+		VkExtent3D mipLevelExtent = getMipLevelExtent(aspect, subresource.mipLevel);
+		VkRect2D area = renderArea ? *renderArea : VkRect2D{ { 0, 0 }, { mipLevelExtent.width, mipLevelExtent.height } };
+
+		for(subresource.arrayLayer = subresourceRange.baseArrayLayer;
+		    subresource.arrayLayer <= lastLayer;
+		    subresource.arrayLayer++)
+		{
+			std::unique_ptr<ClearTiles> &tiles = clearTiles[getClearTilesIndex(subresource)];
+			if(!tiles)
+			{
+				tiles.reset(new ClearTiles(this, subresource));
+			}
+
+			tiles->clear(area, texel);
+		}
+	}
+}
+
+ClearTiles *Image::getPendingClearTiles(const VkImageSubresource &subresource) const
+{
+	if(!hasPendingClears)
+	{
+		return nullptr;
+	}
+
+	ClearTiles *tiles = clearTiles[getClearTilesIndex(subresource)].get();
+
+	return (tiles && tiles->isPending()) ? tiles : nullptr;
+}
+
+void Image::resolvePendingClears(const VkImageSubresourceRange &subresourceRange) const
+{
+	if(!hasPendingClears)
+	{
+		return;
+	}
+
+	uint32_t lastLayer = getLastLayerIndex(subresourceRange);
+	uint32_t lastMipLevel = getLastMipLevel(subresourceRange);
+
+	for(VkImageAspectFlags aspect : { VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_ASPECT_DEPTH_BIT, VK_IMAGE_ASPECT_STENCIL_BIT })
+	{
+		if(!(subresourceRange.aspectMask & aspect))
+		{
+			continue;
+		}
+
+		VkImageSubresource subresource = { aspect, subresourceRange.baseMipLevel, subresourceRange.baseArrayLayer };
+
+		for(subresource.arrayLayer = subresourceRange.baseArrayLayer;
+		    subresource.arrayLayer <= lastLayer;
+		    subresource.arrayLayer++)
+		{
+			for(subresource.mipLevel = subresourceRange.baseMipLevel;
+			    subresource.mipLevel <= lastMipLevel;
+			    subresource.mipLevel++)
+			{
+				if(ClearTiles *tiles = getPendingClearTiles(subresource))
+				{
+					tiles->resolve();
+				}
+			}
+		}
+	}
+}
+
+void Image::discardPendingClears(const VkImageSubresourceRange &subresourceRange, const VkRect2D &renderArea)
+{
+	uint32_t lastLayer = getLastLayerIndex(subresourceRange);
+	uint32_t lastMipLevel = getLastMipLevel(subresourceRange);
+
+	for(VkImageAspectFlags aspect : { VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_ASPECT_DEPTH_BIT, VK_IMAGE_ASPECT_STENCIL_BIT })
+	{
+		if(!(subresourceRange.aspectMask & aspect))
+		{
+			continue;
+		}
+
+		VkImageSubresource subresource = { aspect, subresourceRange.baseMipLevel, subresourceRange.baseArrayLayer };
+
+		for(subresource.mipLevel = subresourceRange.baseMipLevel;
+		    subresource.mipLevel <= lastMipLevel;
+		    subresource.mipLevel++)
+		{
+			for(subresource.arrayLayer = subresourceRange.baseArrayLayer;
+			    subresource.arrayLayer <= lastLayer;
+			    subresource.arrayLayer++)
+			{
+				if(ClearTiles *tiles = getPendingClearTiles(subresource))
+				{
+					tiles->discard(renderArea);
+				}
+			}
+		}
+	}
+}
+
 bool Image::requiresPreprocessing() const
 {
-	return (isCube() && (arrayLayers >= 6)) || decompressedImage;
+	return (isCube() && (arrayLayers >= 6)) || decompressedImage || tiledImage;
 }
 
 void Image::contentsChanged(const VkImageSubresourceRange &subresourceRange, ContentsChangedContext contentsChangedContext)
@@ -1100,13 +1493,31 @@ void Image::contentsChanged(const VkImageSubresourceRange &subresourceRange, Con
 		return;
 	}
 
-	// If this isn't a cube or a compressed image, we'll never need dirtyResources,
+	// If this isn't a cube, compressed, or tiled image, we'll never need dirtyResources,
 	// so we can skip updating dirtyResources
 	if(!requiresPreprocessing())
 	{
 		return;
 	}
 
+	markDirty(subresourceRange, nullptr);
+}
+
+void Image::contentsChanged(const VkImageSubresourceLayers &subresourceLayers, const VkOffset3D &offset, const VkExtent3D &extent)
+{
+	if(!requiresPreprocessing())
+	{
+		return;
+	}
+
+	const VkRect2D region = { { offset.x, offset.y }, { extent.width, extent.height } };
+	markDirty({ subresourceLayers.aspectMask, subresourceLayers.mipLevel, 1,
+	            subresourceLayers.baseArrayLayer, subresourceLayers.layerCount },
+	          &region);
+}
+
+void Image::markDirty(const VkImageSubresourceRange &subresourceRange, const VkRect2D *region) const
+{
 	uint32_t lastLayer = getLastLayerIndex(subresourceRange);
 	uint32_t lastMipLevel = getLastMipLevel(subresourceRange);
 
@@ -1125,19 +1536,29 @@ void Image::contentsChanged(const VkImageSubresourceRange &subresourceRange, Con
 		    subresource.mipLevel <= lastMipLevel;
 		    subresource.mipLevel++)
 		{
-			dirtySubresources.insert(subresource);
+			AddDirtyRegion(dirtySubresources[subresource], region ? *region : WHOLE_SUBRESOURCE);
 		}
 	}
+
+	hasDirtySubresources = true;
 }
 
 void Image::prepareForSampling(const VkImageSubresourceRange &subresourceRange)
 {
-	// If this isn't a cube or a compressed image, there's nothing to do
+	resolvePendingClears(subresourceRange);
+
+	// If this isn't a cube, compressed, or tiled image, there's nothing to do
 	if(!requiresPreprocessing())
 	{
 		return;
 	}
 
+	// Keep the common case of sampling unchanged contents from contending for the lock
+	if(!hasDirtySubresources)
+	{
+		return;
+	}
+
 	uint32_t lastLayer = getLastLayerIndex(subresourceRange);
 	uint32_t lastMipLevel = getLastMipLevel(subresourceRange);
 
@@ -1154,78 +1575,120 @@ void Image::prepareForSampling(const VkImageSubresourceRange &subresourceRange)
 		return;
 	}
 
-	// First, decompress all relevant dirty subregions
-	for(subresource.arrayLayer = subresourceRange.baseArrayLayer;
-	    subresource.arrayLayer <= lastLayer;
-	    subresource.arrayLayer++)
+	// Layers beyond the last group of 6 can't be part of a cube map
+	uint32_t cubeCount = (isCube() && (arrayLayers >= 6)) ? (arrayLayers / 6) : 0;
+
+	for(subresource.mipLevel = subresourceRange.baseMipLevel;
+	    subresource.mipLevel <= lastMipLevel;
+	    subresource.mipLevel++)
 	{
-		for(subresource.mipLevel = subresourceRange.baseMipLevel;
-		    subresource.mipLevel <= lastMipLevel;
-		    subresource.mipLevel++)
+		// Bounds of the changed regions of each cube face, whose edges get copied into the borders of its neighbors
+		std::vector<std::array<VkRect2D, 6>> cubeRegions(cubeCount);
+		// All aspects of the images which need preprocessing have the same extent
+		VkExtent3D mipLevelExtent = getMipLevelExtent(VK_IMAGE_ASPECT_COLOR_BIT, subresource.mipLevel);
+		for(auto &faceRegions : cubeRegions)
 		{
-			auto it = dirtySubresources.find(subresource);
-			if(it != dirtySubresources.end())
-			{
-				decompress(subresource);
-			}
+			faceRegions.fill({ { 0, 0 }, { 0, 0 } });
 		}
-	}
 
-	// Second, update cubemap borders
-	for(subresource.arrayLayer = subresourceRange.baseArrayLayer;
-	    subresource.arrayLayer <= lastLayer;
-	    subresource.arrayLayer++)
-	{
-		for(subresource.mipLevel = subresourceRange.baseMipLevel;
-		    subresource.mipLevel <= lastMipLevel;
-		    subresource.mipLevel++)
+		for(subresource.arrayLayer = subresourceRange.baseArrayLayer;
+		    subresource.arrayLayer <= lastLayer;
+		    subresource.arrayLayer++)
 		{
 			auto it = dirtySubresources.find(subresource);
-			if(it != dirtySubresources.end())
+			if(it == dirtySubresources.end())
+			{
+				continue;
+			}
+
+			// First, decompress the dirty regions
+			for(const VkRect2D &dirtyRegion : it->second)
 			{
-				if(updateCube(subresource))
+				VkRect2D region = ClampRegion(dirtyRegion, mipLevelExtent);
+				decompress(subresource, region);
+				tile(subresource, region);
+
+				uint32_t cube = subresource.arrayLayer / 6;
+				if(cube < cubeCount)
 				{
-					// updateCube() updates all layers of all cubemaps at once, so remove entries to avoid duplicating effort
-					VkImageSubresource cleanSubresource = subresource;
-					for(cleanSubresource.arrayLayer = 0; cleanSubresource.arrayLayer < arrayLayers - 5;)
-					{
-						// Delete one cube's worth of dirty subregions
-						for(uint32_t i = 0; i < 6; i++, cleanSubresource.arrayLayer++)
-						{
-							auto it = dirtySubresources.find(cleanSubresource);
-							if(it != dirtySubresources.end())
-							{
-								dirtySubresources.erase(it);
-							}
-						}
-					}
+					VkRect2D &faceRegion = cubeRegions[cube][subresource.arrayLayer % 6];
+					faceRegion = (faceRegion.extent.width == 0) ? region : BoundingRegion(faceRegion, region);
 				}
 			}
+
+			dirtySubresources.erase(it);
 		}
-	}
 
-	// Finally, mark all updated subregions clean
-	for(subresource.arrayLayer = subresourceRange.baseArrayLayer;
-	    subresource.arrayLayer <= lastLayer;
-	    subresource.arrayLayer++)
-	{
-		for(subresource.mipLevel = subresourceRange.baseMipLevel;
-		    subresource.mipLevel <= lastMipLevel;
-		    subresource.mipLevel++)
+		// Finally, update the cube borders next to the changed face edges
+		for(uint32_t cube = 0; cube < cubeCount; cube++)
 		{
-			auto it = dirtySubresources.find(subresource);
-			if(it != dirtySubresources.end())
+			const std::array<VkRect2D, 6> &faceRegions = cubeRegions[cube];
+			if(std::any_of(faceRegions.begin(), faceRegions.end(), [](const VkRect2D &region) { return region.extent.width != 0; }))
 			{
-				dirtySubresources.erase(it);
+				updateCube({ subresource.aspectMask, subresource.mipLevel, cube * 6 }, faceRegions);
 			}
 		}
 	}
+
+	if(dirtySubresources.empty())
+	{
+		hasDirtySubresources = false;
+	}
 }
 
-void Image::decompress(const VkImageSubresource &subresource)
+void Image::prepareForTransfer(const VkImageSubresourceRange &subresourceRange) const
 {
-	if(decompressedImage)
+	resolvePendingClears(subresourceRange);
+}
+
+void Image::tile(const VkImageSubresource &subresource, const VkRect2D &region)
+{
+	if(!tiledImage || (region.extent.width == 0) || (region.extent.height == 0))
+	{
+		return;
+	}
+
+	// Each 4x4 tile takes up 16 consecutive texels of row (y & ~3) of the tiled
+	// image, which holds the four rows of the tile back to back. Texels past the
+	// edges of the level only pad the tiles, and are never sampled.
+	auto aspect = static_cast<VkImageAspectFlagBits>(subresource.aspectMask);
+	VkExtent3D mipLevelExtent = getMipLevelExtent(aspect, subresource.mipLevel);
+	int bytes = format.bytes();
+	int pitchB = rowPitchBytes(aspect, subresource.mipLevel);
+	int tiledPitchB = tiledImage->rowPitchBytes(aspect, subresource.mipLevel);
+
+	const uint8_t *source = static_cast<const uint8_t *>(getTexelPointer({ 0, 0, 0 }, subresource));
+	uint8_t *dest = static_cast<uint8_t *>(tiledImage->getTexelPointer({ 0, 0, 0 }, subresource));
+
+	int x0 = region.offset.x & ~3;
+	int x1 = region.offset.x + region.extent.width;
+	int y1 = region.offset.y + region.extent.height;
+
+	for(int y = region.offset.y; y < y1; y++)
 	{
+		for(int x = x0; x < x1; x += 4)
+		{
+			int texels = std::min(4, static_cast<int>(mipLevelExtent.width) - x);
+			memcpy(dest + (y & ~3) * tiledPitchB + (x * 4 + (y & 3) * 4) * bytes,
+			       source + y * pitchB + x * bytes, texels * bytes);
+		}
+	}
+}
+
+void Image::decompress(const VkImageSubresource &subresource, const VkRect2D &region)
+{
+	if(decompressedImage && (region.extent.width != 0) && (region.extent.height != 0))
+	{
+		// Only whole blocks can be decoded, and the edges of the level clip them.
+		VkExtent3D mipLevelExtent = getMipLevelExtent(static_cast<VkImageAspectFlagBits>(subresource.aspectMask), subresource.mipLevel);
+		int blockWidth = format.blockWidth();
+		int blockHeight = format.blockHeight();
+		int x0 = (region.offset.x / blockWidth) * blockWidth;
+		int y0 = (region.offset.y / blockHeight) * blockHeight;
+		int x1 = std::min(sw::align(region.offset.x + static_cast<int>(region.extent.width), blockWidth), static_cast<int>(mipLevelExtent.width));
+		int y1 = std::min(sw::align(region.offset.y + static_cast<int>(region.extent.height), blockHeight), static_cast<int>(mipLevelExtent.height));
+		VkRect2D blocks = { { x0, y0 }, { uint32_t(x1 - x0), uint32_t(y1 - y0) } };
+
 		switch(format)
 		{
 			case VK_FORMAT_EAC_R11_UNORM_BLOCK:
@@ -1238,7 +1701,7 @@ void Image::decompress(const VkImageSubresource &subresource)
 			case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
 			case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
 			case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
-				decodeETC2(subresource);
+				decodeETC2(subresource, blocks);
 				break;
 			case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
 			case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
@@ -1256,7 +1719,7 @@ void Image::decompress(const VkImageSubresource &subresource)
 			case VK_FORMAT_BC6H_SFLOAT_BLOCK:
 			case VK_FORMAT_BC7_UNORM_BLOCK:
 			case VK_FORMAT_BC7_SRGB_BLOCK:
-				decodeBC(subresource);
+				decodeBC(subresource, blocks);
 				break;
 			case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
 			case VK_FORMAT_ASTC_5x4_UNORM_BLOCK:
@@ -1286,7 +1749,7 @@ void Image::decompress(const VkImageSubresource &subresource)
 			case VK_FORMAT_ASTC_10x10_SRGB_BLOCK:
 			case VK_FORMAT_ASTC_12x10_SRGB_BLOCK:
 			case VK_FORMAT_ASTC_12x12_SRGB_BLOCK:
-				decodeASTC(subresource);
+				decodeASTC(subresource, blocks);
 				break;
 			default:
 				break;
@@ -1294,26 +1757,14 @@ void Image::decompress(const VkImageSubresource &subresource)
 	}
 }
 
-bool Image::updateCube(const VkImageSubresource &subres)
+void Image::updateCube(const VkImageSubresource &subresource, const std::array<VkRect2D, 6> &faceRegions)
 {
-	if(isCube() && (arrayLayers >= 6))
-	{
-		VkImageSubresource subresource = subres;
-
-		// Update the borders of all the groups of 6 layers that can be part of a cubemaps but don't
-		// touch leftover layers that cannot be part of cubemaps.
-		for(subresource.arrayLayer = 0; subresource.arrayLayer < arrayLayers - 5; subresource.arrayLayer += 6)
-		{
-			device->getBlitter()->updateBorders(decompressedImage ? decompressedImage : this, subresource);
-		}
-
-		return true;
-	}
+	ASSERT(isCube() && (arrayLayers >= subresource.arrayLayer + 6));
 
-	return false;
+	device->getBlitter()->updateBorders(decompressedImage ? decompressedImage : this, subresource, faceRegions);
 }
 
-void Image::decodeETC2(const VkImageSubresource &subresource)
+void Image::decodeETC2(const VkImageSubresource &subresource, const VkRect2D &region)
 {
 	ASSERT(decompressedImage);
 
@@ -1321,37 +1772,39 @@ void Image::decodeETC2(const VkImageSubresource &subresource)
 
 	int bytes = decompressedImage->format.bytes();
 	bool fakeAlpha = (format == VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK) || (format == VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK);
-	size_t sizeToWrite = 0;
 
 	VkExtent3D mipLevelExtent = getMipLevelExtent(static_cast<VkImageAspectFlagBits>(subresource.aspectMask), subresource.mipLevel);
 
 	int pitchB = decompressedImage->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, subresource.mipLevel);
 
-	if(fakeAlpha)
-	{
-		// To avoid overflow in case of cube textures, which are offset in memory to account for the border,
-		// compute the size from the first pixel to the last pixel, excluding any padding or border before
-		// the first pixel or after the last pixel.
-		sizeToWrite = ((mipLevelExtent.height - 1) * pitchB) + (mipLevelExtent.width * bytes);
-	}
+	// Blocks are stored row by row, so narrower regions are decoded one row of blocks at a time.
+	int bandHeight = (region.extent.width == mipLevelExtent.width) ? region.extent.height : format.blockHeight();
+	int y1 = region.offset.y + region.extent.height;
 
 	for(int32_t depth = 0; depth < static_cast<int32_t>(mipLevelExtent.depth); depth++)
 	{
-		uint8_t *source = static_cast<uint8_t *>(getTexelPointer({ 0, 0, depth }, subresource));
-		uint8_t *dest = static_cast<uint8_t *>(decompressedImage->getTexelPointer({ 0, 0, depth }, subresource));
-
-		if(fakeAlpha)
+		for(int y = region.offset.y; y < y1; y += bandHeight)
 		{
-			ASSERT((dest + sizeToWrite) < decompressedImage->end());
-			memset(dest, 0xFF, sizeToWrite);
-		}
+			int height = std::min(bandHeight, y1 - y);
+			uint8_t *source = static_cast<uint8_t *>(getTexelPointer({ region.offset.x, y, depth }, subresource));
+			uint8_t *dest = static_cast<uint8_t *>(decompressedImage->getTexelPointer({ region.offset.x, y, depth }, subresource));
+
+			if(fakeAlpha)
+			{
+				// The decoder doesn't write the alpha channel of opaque formats.
+				for(int row = 0; row < height; row++)
+				{
+					ASSERT((dest + row * pitchB + region.extent.width * bytes) <= decompressedImage->end());
+					memset(dest + row * pitchB, 0xFF, region.extent.width * bytes);
+				}
+			}
 
-		ETC_Decoder::Decode(source, dest, mipLevelExtent.width, mipLevelExtent.height,
-		                    pitchB, bytes, inputType);
+			ETC_Decoder::Decode(source, dest, region.extent.width, height, pitchB, bytes, inputType);
+		}
 	}
 }
 
-void Image::decodeBC(const VkImageSubresource &subresource)
+void Image::decodeBC(const VkImageSubresource &subresource, const VkRect2D &region)
 {
 	ASSERT(decompressedImage);
 
@@ -1364,17 +1817,24 @@ void Image::decodeBC(const VkImageSubresource &subresource)
 
 	int pitchB = decompressedImage->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, subresource.mipLevel);
 
+	// Blocks are stored row by row, so narrower regions are decoded one row of blocks at a time.
+	int bandHeight = (region.extent.width == mipLevelExtent.width) ? region.extent.height : format.blockHeight();
+	int y1 = region.offset.y + region.extent.height;
+
 	for(int32_t depth = 0; depth < static_cast<int32_t>(mipLevelExtent.depth); depth++)
 	{
-		uint8_t *source = static_cast<uint8_t *>(getTexelPointer({ 0, 0, depth }, subresource));
-		uint8_t *dest = static_cast<uint8_t *>(decompressedImage->getTexelPointer({ 0, 0, depth }, subresource));
+		for(int y = region.offset.y; y < y1; y += bandHeight)
+		{
+			uint8_t *source = static_cast<uint8_t *>(getTexelPointer({ region.offset.x, y, depth }, subresource));
+			uint8_t *dest = static_cast<uint8_t *>(decompressedImage->getTexelPointer({ region.offset.x, y, depth }, subresource));
 
-		BC_Decoder::Decode(source, dest, mipLevelExtent.width, mipLevelExtent.height,
-		                   pitchB, bytes, n, noAlphaU);
+			BC_Decoder::Decode(source, dest, region.extent.width, std::min(bandHeight, y1 - y),
+			                   pitchB, bytes, n, noAlphaU);
+		}
 	}
 }
 
-void Image::decodeASTC(const VkImageSubresource &subresource)
+void Image::decodeASTC(const VkImageSubresource &subresource, const VkRect2D &region)
 {
 	ASSERT(decompressedImage);
 
@@ -1387,11 +1847,10 @@ void Image::decodeASTC(const VkImageSubresource &subresource)
 
 	VkExtent3D mipLevelExtent = getMipLevelExtent(static_cast<VkImageAspectFlagBits>(subresource.aspectMask), subresource.mipLevel);
 
-	int xblocks = (mipLevelExtent.width + xBlockSize - 1) / xBlockSize;
-	int yblocks = (mipLevelExtent.height + yBlockSize - 1) / yBlockSize;
+	int xblocks = (region.extent.width + xBlockSize - 1) / xBlockSize;
 	int zblocks = (zBlockSize > 1) ? (mipLevelExtent.depth + zBlockSize - 1) / zBlockSize : 1;
 
-	if(xblocks <= 0 || yblocks <= 0 || zblocks <= 0)
+	if(xblocks <= 0 || region.extent.height == 0 || zblocks <= 0)
 	{
 		return;
 	}
@@ -1399,13 +1858,229 @@ void Image::decodeASTC(const VkImageSubresource &subresource)
 	int pitchB = decompressedImage->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, subresource.mipLevel);
 	int sliceB = decompressedImage->slicePitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, subresource.mipLevel);
 
+	// Blocks are stored row by row, so narrower regions are decoded one row of blocks at a time.
+	int bandHeight = (region.extent.width == mipLevelExtent.width) ? region.extent.height : yBlockSize;
+	int y1 = region.offset.y + region.extent.height;
+
 	for(int32_t depth = 0; depth < static_cast<int32_t>(mipLevelExtent.depth); depth++)
 	{
-		uint8_t *source = static_cast<uint8_t *>(getTexelPointer({ 0, 0, depth }, subresource));
-		uint8_t *dest = static_cast<uint8_t *>(decompressedImage->getTexelPointer({ 0, 0, depth }, subresource));
+		for(int y = region.offset.y; y < y1; y += bandHeight)
+		{
+			int height = std::min(bandHeight, y1 - y);
+			int yblocks = (height + yBlockSize - 1) / yBlockSize;
+			uint8_t *source = static_cast<uint8_t *>(getTexelPointer({ region.offset.x, y, depth }, subresource));
+			uint8_t *dest = static_cast<uint8_t *>(decompressedImage->getTexelPointer({ region.offset.x, y, depth }, subresource));
+
+			ASTC_Decoder::Decode(source, dest, region.extent.width, height, mipLevelExtent.depth, bytes, pitchB, sliceB,
+			                     xBlockSize, yBlockSize, zBlockSize, xblocks, yblocks, zblocks, isUnsigned);
+		}
+	}
+}
+
+ClearTiles::ClearTiles(const Image *image, const VkImageSubresource &subresource)
+    : image(image)
+    , subresource(subresource)
+    , extent(image->getMipLevelExtent(static_cast<VkImageAspectFlagBits>(subresource.aspectMask), subresource.mipLevel))
+    , texelBytes(image->getFormat(static_cast<VkImageAspectFlagBits>(subresource.aspectMask)).bytes())
+    , tilesX((extent.width + Width - 1) / Width)
+    , tilesY((extent.height + Height - 1) / Height)
+    , tiles(new std::atomic<uint8_t>[tilesX * tilesY])
+    , clearValues(new uint8_t[MaxClearValues * Width * texelBytes])
+{
+	for(int i = 0; i < tilesX * tilesY; i++)
+	{
+		tiles[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+void ClearTiles::clear(const VkRect2D &area, const uint8_t *texel)
+{
+	int x0 = std::max(area.offset.x, 0);
+	int y0 = std::max(area.offset.y, 0);
+	int x1 = std::min(area.offset.x + static_cast<int>(area.extent.width), static_cast<int>(extent.width));
+	int y1 = std::min(area.offset.y + static_cast<int>(area.extent.height), static_cast<int>(extent.height));
+	if((x0 >= x1) || (y0 >= y1))
+	{
+		return;
+	}
+
+	uint8_t clearValue = addClearValue(texel);
+
+	for(int tileY = y0 / Height; tileY * Height < y1; tileY++)
+	{
+		for(int tileX = x0 / Width; tileX * Width < x1; tileX++)
+		{
+			VkRect2D tile = getTileRect(tileX, tileY);
+			int tileX1 = tile.offset.x + tile.extent.width;
+			int tileY1 = tile.offset.y + tile.extent.height;
+
+			if((tile.offset.x >= x0) && (tile.offset.y >= y0) && (tileX1 <= x1) && (tileY1 <= y1))
+			{
+				tiles[tileY * tilesX + tileX].store(clearValue, std::memory_order_relaxed);
+			}
+			else
+			{
+				// The rest of a partially cleared tile keeps its previous contents
+				resolveTile(tileX, tileY);
+
+				int left = std::max(x0, static_cast<int>(tile.offset.x));
+				int top = std::max(y0, static_cast<int>(tile.offset.y));
+				VkRect2D partial = { { left, top },
+					                 { static_cast<uint32_t>(std::min(x1, tileX1) - left),
+					                   static_cast<uint32_t>(std::min(y1, tileY1) - top) } };
+				write(partial, clearValue);
+			}
+		}
+	}
+
+	pending = true;
+}
+
+void ClearTiles::resolve(const VkRect2D &area)
+{
+	int x0 = std::max(area.offset.x, 0);
+	int y0 = std::max(area.offset.y, 0);
+	int x1 = std::min(area.offset.x + static_cast<int>(area.extent.width), static_cast<int>(extent.width));
+	int y1 = std::min(area.offset.y + static_cast<int>(area.extent.height), static_cast<int>(extent.height));
+
+	for(int tileY = y0 / Height; tileY * Height < y1; tileY++)
+	{
+		for(int tileX = x0 / Width; tileX * Width < x1; tileX++)
+		{
+			resolveTile(tileX, tileY);
+		}
+	}
+}
+
+void ClearTiles::resolve()
+{
+	for(int tileY = 0; tileY < tilesY; tileY++)
+	{
+		for(int tileX = 0; tileX < tilesX; tileX++)
+		{
+			resolveTile(tileX, tileY);
+		}
+	}
+
+	pending = false;
+}
+
+void ClearTiles::discard(const VkRect2D &area)
+{
+	int x0 = std::max(area.offset.x, 0);
+	int y0 = std::max(area.offset.y, 0);
+	int x1 = std::min(area.offset.x + static_cast<int>(area.extent.width), static_cast<int>(extent.width));
+	int y1 = std::min(area.offset.y + static_cast<int>(area.extent.height), static_cast<int>(extent.height));
+	bool remaining = false;
+
+	for(int tileY = 0; tileY < tilesY; tileY++)
+	{
+		for(int tileX = 0; tileX < tilesX; tileX++)
+		{
+			std::atomic<uint8_t> &tile = tiles[tileY * tilesX + tileX];
+			if(tile.load(std::memory_order_relaxed) == 0)
+			{
+				continue;
+			}
+
+			// Texels outside of the area keep their contents, so the clear of
+			// partially covered tiles must still be written.
+			VkRect2D rect = getTileRect(tileX, tileY);
+			if((rect.offset.x >= x0) && (rect.offset.y >= y0) &&
+			   (rect.offset.x + static_cast<int>(rect.extent.width) <= x1) &&
+			   (rect.offset.y + static_cast<int>(rect.extent.height) <= y1))
+			{
+				tile.store(0, std::memory_order_relaxed);
+			}
+			else
+			{
+				remaining = true;
+			}
+		}
+	}
+
+	pending = remaining;
+}
+
+uint8_t ClearTiles::addClearValue(const uint8_t *texel)
+{
+	for(int i = 0; i < clearValueCount; i++)
+	{
+		if(memcmp(&clearValues[i * Width * texelBytes], texel, texelBytes) == 0)
+		{
+			return static_cast<uint8_t>(i + 1);
+		}
+	}
+
+	if(clearValueCount == MaxClearValues)
+	{
+		// Values can't be replaced while tiles refer to them
+		resolve();
+		clearValueCount = 0;
+	}
+
+	uint8_t *row = &clearValues[clearValueCount * Width * texelBytes];
+	for(int x = 0; x < Width; x++)
+	{
+		memcpy(row + x * texelBytes, texel, texelBytes);
+	}
+
+	return static_cast<uint8_t>(++clearValueCount);
+}
+
+VkRect2D ClearTiles::getTileRect(int tileX, int tileY) const
+{
+	int x = tileX * Width;
+	int y = tileY * Height;
+
+	return { { x, y },
+		     { static_cast<uint32_t>(std::min(Width, static_cast<int>(extent.width) - x)),
+		       static_cast<uint32_t>(std::min(Height, static_cast<int>(extent.height) - y)) } };
+}
+
+void ClearTiles::resolveTile(int tileX, int tileY)
+{
+	std::atomic<uint8_t> &tile = tiles[tileY * tilesX + tileX];
+	uint8_t clearValue = tile.load(std::memory_order_acquire);
+
+	while(clearValue != 0)
+	{
+		if(clearValue == Resolving)
+		{
+			// Another thread is writing the tile
+			std::this_thread::yield();
+			clearValue = tile.load(std::memory_order_acquire);
+		}
+		else if(tile.compare_exchange_weak(clearValue, Resolving, std::memory_order_acquire))
+		{
+			write(getTileRect(tileX, tileY), clearValue);
+			tile.store(0, std::memory_order_release);
+			return;
+		}
+	}
+}
+
+void ClearTiles::write(const VkRect2D &area, uint8_t clearValue) const
+{
+	VkImageAspectFlagBits aspect = static_cast<VkImageAspectFlagBits>(subresource.aspectMask);
+	int rowPitchBytes = image->rowPitchBytes(aspect, subresource.mipLevel);
+	int samplePitchBytes = image->samplePitchBytes(aspect, subresource.mipLevel);
+	size_t rowBytes = area.extent.width * texelBytes;
+	const uint8_t *row = &clearValues[(clearValue - 1) * Width * texelBytes];
+
+	uint8_t *slice = static_cast<uint8_t *>(image->getTexelPointer({ area.offset.x, area.offset.y, 0 }, subresource));
+
+	for(int sample = 0; sample < image->getSampleCountFlagBits(); sample++)
+	{
+		uint8_t *texels = slice;
+
+		for(uint32_t y = 0; y < area.extent.height; y++)
+		{
+			memcpy(texels, row, rowBytes);
+			texels += rowPitchBytes;
+		}
 
-		ASTC_Decoder::Decode(source, dest, mipLevelExtent.width, mipLevelExtent.height, mipLevelExtent.depth, bytes, pitchB, sliceB,
-		                     xBlockSize, yBlockSize, zBlockSize, xblocks, yblocks, zblocks, isUnsigned);
+		slice += samplePitchBytes;
 	}
 }
 
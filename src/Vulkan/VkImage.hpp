@@ -24,13 +24,19 @@
 #	include <vulkan/vk_android_native_buffer.h>  // For VkSwapchainImageUsageFlagsANDROID and buffer_handle_t
 #endif
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace vk {
 
 class Buffer;
 class Device;
 class DeviceMemory;
+class Image;
 class ImageView;
 
 #ifdef __ANDROID__
@@ -43,6 +49,57 @@ struct BackingMemory
 };
 #endif
 
+// Clears of a subresource which haven't been written to memory yet, tracked per
+// tile of Width x Height texels. Each tile is written out on its own the first
+// time it's accessed, so that rendering only writes the cleared tiles it draws to.
+// Clears and discards are recorded while no draw uses the subresource, but tiles
+// may be resolved concurrently.
+class ClearTiles
+{
+public:
+	// Tiles span a pair of rows, the unit in which the renderer distributes rows
+	// among its clusters, so a tile is only ever drawn to by a single cluster.
+	static constexpr int Width = 32;
+	static constexpr int Height = 2;
+
+	ClearTiles(const Image *image, const VkImageSubresource &subresource);
+
+	bool isPending() const { return pending; }
+
+	// Clears the area to the given value, packed in the format of the subresource.
+	void clear(const VkRect2D &area, const uint8_t *texel);
+	// Writes the pending clears of the tiles intersecting the area.
+	void resolve(const VkRect2D &area);
+	void resolve();
+	// Drops the pending clears of the tiles inside the area, leaving their contents undefined.
+	void discard(const VkRect2D &area);
+
+private:
+	static constexpr int MaxClearValues = 8;
+	static constexpr uint8_t Resolving = 0xFF;
+
+	uint8_t addClearValue(const uint8_t *texel);
+	VkRect2D getTileRect(int tileX, int tileY) const;
+	void resolveTile(int tileX, int tileY);
+	void write(const VkRect2D &area, uint8_t clearValue) const;
+
+	const Image *const image;
+	const VkImageSubresource subresource;
+	const VkExtent3D extent;
+	const int texelBytes;
+	const int tilesX;
+	const int tilesY;
+
+	// Per tile, 0 when its memory is up to date, the 1-based index of its pending clear
+	// value, or Resolving while a thread writes it out.
+	std::unique_ptr<std::atomic<uint8_t>[]> tiles;
+	// A row of Width texels per clear value. Values are only added, so that
+	// concurrent resolves never observe them changing.
+	std::unique_ptr<uint8_t[]> clearValues;
+	int clearValueCount = 0;
+	std::atomic<bool> pending = { false };
+};
+
 class Image : public Object<Image, VkImage>
 {
 public:
@@ -89,6 +146,7 @@ public:
 	VkExtent3D getMipLevelExtent(VkImageAspectFlagBits aspect, uint32_t mipLevel) const;
 	int rowPitchBytes(VkImageAspectFlagBits aspect, uint32_t mipLevel) const;
 	int slicePitchBytes(VkImageAspectFlagBits aspect, uint32_t mipLevel) const;
+	int samplePitchBytes(VkImageAspectFlagBits aspect, uint32_t mipLevel) const;
 	void *getTexelPointer(const VkOffset3D &offset, const VkImageSubresource &subresource) const;
 	bool isCube() const;
 	bool is3DSlice() const;
@@ -104,7 +162,12 @@ public:
 		USING_STORAGE = 1
 	};
 	void contentsChanged(const VkImageSubresourceRange &subresourceRange, ContentsChangedContext contentsChangedContext = DIRECT_MEMORY_ACCESS);
+	void contentsChanged(const VkImageSubresourceLayers &subresourceLayers, const VkOffset3D &offset, const VkExtent3D &extent);
+	void prepareForTransfer(const VkImageSubresourceRange &subresourceRange) const;
+	ClearTiles *getPendingClearTiles(const VkImageSubresource &subresource) const;
+	void discardPendingClears(const VkImageSubresourceRange &subresourceRange, const VkRect2D &renderArea);
 	const Image *getSampledImage(const vk::Format &imageViewFormat) const;
+	bool hasTiledLayout() const { return tiledLayout; }
 
 #ifdef __ANDROID__
 	void setBackingMemory(BackingMemory &bm)
@@ -121,7 +184,6 @@ public:
 private:
 	void copy(Buffer *buffer, const VkBufferImageCopy &region, bool bufferIsSource);
 	VkDeviceSize getStorageSize(VkImageAspectFlags flags) const;
-	VkDeviceSize getMultiSampledLevelSize(VkImageAspectFlagBits aspect, uint32_t mipLevel) const;
 	VkDeviceSize getLayerOffset(VkImageAspectFlagBits aspect, uint32_t mipLevel) const;
 	VkDeviceSize getMemoryOffset(VkImageAspectFlagBits aspect, uint32_t mipLevel) const;
 	VkDeviceSize getMemoryOffset(VkImageAspectFlagBits aspect, uint32_t mipLevel, uint32_t layer) const;
@@ -132,13 +194,19 @@ private:
 	VkExtent2D bufferExtentInBlocks(const VkExtent2D &extent, const VkBufferImageCopy &region) const;
 	VkFormat getClearFormat() const;
 	void clear(void *pixelData, VkFormat pixelFormat, const vk::Format &viewFormat, const VkImageSubresourceRange &subresourceRange, const VkRect2D &renderArea);
+	bool canDeferClears() const;
+	void deferClear(const void *pixelData, VkFormat pixelFormat, const vk::Format &viewFormat, const VkImageSubresourceRange &subresourceRange, const VkRect2D *renderArea);
+	void resolvePendingClears(const VkImageSubresourceRange &subresourceRange) const;
+	uint32_t getClearTilesIndex(const VkImageSubresource &subresource) const;
 	int borderSize() const;
 	bool requiresPreprocessing() const;
-	void decompress(const VkImageSubresource &subresource);
-	bool updateCube(const VkImageSubresource &subresource);
-	void decodeETC2(const VkImageSubresource &subresource);
-	void decodeBC(const VkImageSubresource &subresource);
-	void decodeASTC(const VkImageSubresource &subresource);
+	void markDirty(const VkImageSubresourceRange &subresourceRange, const VkRect2D *region) const;
+	void decompress(const VkImageSubresource &subresource, const VkRect2D &region);
+	void updateCube(const VkImageSubresource &subresource, const std::array<VkRect2D, 6> &faceRegions);
+	void decodeETC2(const VkImageSubresource &subresource, const VkRect2D &region);
+	void decodeBC(const VkImageSubresource &subresource, const VkRect2D &region);
+	void decodeASTC(const VkImageSubresource &subresource, const VkRect2D &region);
+	void tile(const VkImageSubresource &subresource, const VkRect2D &region);
 
 	const Device *const device = nullptr;
 	VkDeviceSize memoryOffset = 0;
@@ -152,6 +220,8 @@ private:
 	VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL;
 	VkImageUsageFlags usage = (VkImageUsageFlags)0;
 	Image *decompressedImage = nullptr;
+	Image *tiledImage = nullptr;  // Copy which is sampled instead, see RequiresTiledImage()
+	bool tiledLayout = false;     // Stored in 4x4 texel tiles, see tile()
 #ifdef __ANDROID__
 	BackingMemory backingMemory = {};
 #endif
@@ -188,8 +258,17 @@ private:
 		VkImageSubresource subresource;
 	};
 
-	marl::mutex mutex;
-	std::unordered_set<Subresource, Subresource> dirtySubresources GUARDED_BY(mutex);
+	mutable marl::mutex mutex;
+	// Regions of each subresource which changed since it was last prepared for sampling.
+	mutable std::unordered_map<Subresource, std::vector<VkRect2D>, Subresource> dirtySubresources GUARDED_BY(mutex);
+	// Tells whether dirtySubresources is empty without taking the lock. Writes are ordered
+	// before sampling by the application's synchronization, which makes them visible.
+	mutable std::atomic<bool> hasDirtySubresources = { false };
+
+	// Clear state of each subresource, see deferClear(). Allocated by the first deferred
+	// clear, before hasPendingClears is set, and only read afterwards.
+	std::unique_ptr<std::unique_ptr<ClearTiles>[]> clearTiles;
+	std::atomic<bool> hasPendingClears = { false };
 };
 
 static inline Image *Cast(VkImage object)
@@ -17,6 +17,7 @@
 #include "VkImage.hpp"
 #include "System/Math.hpp"
 
+#include <algorithm>
 #include <climits>
 
 namespace vk {
@@ -80,12 +81,17 @@ VkImageSubresourceRange ResolveRemainingLevelsLayers(VkImageSubresourceRange ran
 
 Identifier::Identifier(const Image *image, VkImageViewType type, VkFormat fmt, VkComponentMapping mapping)
 {
+	// Compressed views which are sampled through a decompressed copy of the image
+	// must not share sampling routines with those whose blocks get decoded directly.
+	const Image *sampledImage = image->getSampledImage(fmt);
+
 	imageViewType = type;
-	format = Format::mapTo8bit(fmt);
+	format = Format::mapTo8bit((sampledImage->getFormat() != image->getFormat()) ? VkFormat(sampledImage->getFormat()) : fmt);
 	r = mapping.r;
 	g = mapping.g;
 	b = mapping.b;
 	a = mapping.a;
+	tiled = sampledImage->hasTiledLayout();
 }
 
 Identifier::Identifier(VkFormat fmt)
@@ -196,6 +202,29 @@ void ImageView::clearWithLayerMask(const VkClearValue &clearValue, VkImageAspect
 	}
 }
 
+void ImageView::discard(VkImageAspectFlags aspectMask, const VkRect2D &renderArea, uint32_t layerCount)
+{
+	// Layers past those of the framebuffer aren't rendered to
+	VkImageSubresourceRange sr = subresourceRange;
+	sr.aspectMask = aspectMask;
+	sr.layerCount = std::min(layerCount, subresourceRange.layerCount);
+	image->discardPendingClears(sr, renderArea);
+}
+
+void ImageView::discardWithLayerMask(VkImageAspectFlags aspectMask, const VkRect2D &renderArea, uint32_t layerMask)
+{
+	while(layerMask)
+	{
+		uint32_t layer = sw::log2i(layerMask);
+		layerMask &= ~(1 << layer);
+		VkImageSubresourceRange sr = subresourceRange;
+		sr.aspectMask = aspectMask;
+		sr.baseArrayLayer += layer;
+		sr.layerCount = 1;
+		image->discardPendingClears(sr, renderArea);
+	}
+}
+
 void ImageView::resolve(ImageView *resolveAttachment, int layer)
 {
 	if((subresourceRange.levelCount != 1) || (resolveAttachment->subresourceRange.levelCount != 1))
@@ -289,7 +318,8 @@ const Image *ImageView::getImage(Usage usage) const
 
 Format ImageView::getFormat(Usage usage) const
 {
-	Format imageFormat = ((usage == RAW) || (getImage(usage) == image)) ? format : getImage(usage)->getFormat();
+	// Copies of the image which have its format are reinterpreted by the view like the image itself.
+	Format imageFormat = ((usage == RAW) || (getImage(usage)->getFormat() == image->getFormat())) ? format : getImage(usage)->getFormat();
 	return imageFormat.getAspectFormat(subresourceRange.aspectMask);
 }
 
@@ -303,9 +333,9 @@ int ImageView::slicePitchBytes(VkImageAspectFlagBits aspect, uint32_t mipLevel,
 	return getImage(usage)->slicePitchBytes(aspect, subresourceRange.baseMipLevel + mipLevel);
 }
 
-int ImageView::getMipLevelSize(VkImageAspectFlagBits aspect, uint32_t mipLevel, Usage usage) const
+int ImageView::samplePitchBytes(VkImageAspectFlagBits aspect, uint32_t mipLevel, Usage usage) const
 {
-	return getImage(usage)->getMipLevelSize(aspect, subresourceRange.baseMipLevel + mipLevel);
+	return getImage(usage)->samplePitchBytes(aspect, subresourceRange.baseMipLevel + mipLevel);
 }
 
 int ImageView::layerPitchBytes(VkImageAspectFlagBits aspect, Usage usage) const
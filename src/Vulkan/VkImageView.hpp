@@ -53,6 +53,7 @@ union Identifier
 		uint32_t g : 3;
 		uint32_t b : 3;
 		uint32_t a : 3;
+		uint32_t tiled : 1;
 	};
 };
 
@@ -79,6 +80,8 @@ public:
 	void resolve(ImageView *resolveAttachment);
 	void resolve(ImageView *resolveAttachment, int layer);
 	void resolveWithLayerMask(ImageView *resolveAttachment, uint32_t layerMask);
+	void discard(VkImageAspectFlags aspectMask, const VkRect2D &renderArea, uint32_t layerCount);
+	void discardWithLayerMask(VkImageAspectFlags aspectMask, const VkRect2D &renderArea, uint32_t layerMask);
 	void resolveDepthStencil(ImageView *resolveAttachment, const VkSubpassDescriptionDepthStencilResolve &dsResolve);
 
 	VkImageViewType getType() const { return viewType; }
@@ -86,7 +89,7 @@ public:
 	Format getFormat(VkImageAspectFlagBits aspect) const { return image->getFormat(aspect); }
 	int rowPitchBytes(VkImageAspectFlagBits aspect, uint32_t mipLevel, Usage usage = RAW) const;
 	int slicePitchBytes(VkImageAspectFlagBits aspect, uint32_t mipLevel, Usage usage = RAW) const;
-	int getMipLevelSize(VkImageAspectFlagBits aspect, uint32_t mipLevel, Usage usage = RAW) const;
+	int samplePitchBytes(VkImageAspectFlagBits aspect, uint32_t mipLevel, Usage usage = RAW) const;
 	int layerPitchBytes(VkImageAspectFlagBits aspect, Usage usage = RAW) const;
 	VkExtent2D getMipLevelExtent(uint32_t mipLevel) const;
 	VkExtent2D getMipLevelExtent(uint32_t mipLevel, VkImageAspectFlagBits aspect) const;
@@ -113,6 +116,11 @@ public:
 	void contentsChanged() { image->contentsChanged(subresourceRange, Image::USING_STORAGE); }
 
 	void prepareForSampling() { image->prepareForSampling(subresourceRange); }
+	void prepareForTransfer() const { image->prepareForTransfer(subresourceRange); }
+	ClearTiles *getPendingClearTiles(VkImageAspectFlagBits aspect, uint32_t layer) const
+	{
+		return image->getPendingClearTiles({ aspect, subresourceRange.baseMipLevel, subresourceRange.baseArrayLayer + layer });
+	}
 
 	const VkComponentMapping &getComponentMapping() const { return components; }
 	const VkImageSubresourceRange &getSubresourceRange() const { return subresourceRange; }
@@ -73,7 +73,7 @@ const VkPhysicalDeviceFeatures &PhysicalDevice::getFeatures() const
 #endif
 		VK_TRUE,   // textureCompressionBC
 		VK_TRUE,   // occlusionQueryPrecise
-		VK_FALSE,  // pipelineStatisticsQuery
+		VK_TRUE,   // pipelineStatisticsQuery
 		VK_TRUE,   // vertexPipelineStoresAndAtomics
 		VK_TRUE,   // fragmentStoresAndAtomics
 		VK_FALSE,  // shaderTessellationAndGeometryPointSize
@@ -285,7 +285,7 @@ template<typename T>
 static void getPhysicalDeviceVulkan12Features(T *features)
 {
 	features->samplerMirrorClampToEdge = VK_FALSE;
-	features->drawIndirectCount = VK_FALSE;
+	features->drawIndirectCount = VK_TRUE;
 	getPhysicalDevice8BitStorageFeaturesKHR(features);
 	features->shaderBufferInt64Atomics = VK_FALSE;
 	features->shaderSharedInt64Atomics = VK_FALSE;
@@ -650,6 +650,16 @@ void PhysicalDevice::getProperties(const VkExternalMemoryHandleTypeFlagBits *han
 		return;
 	}
 #endif
+#if SWIFTSHADER_EXTERNAL_MEMORY_DMA_BUF
+	if(*handleType == VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT)
+	{
+		// dma-bufs can be imported, but SwiftShader memory is never backed by one.
+		extMemProperties->compatibleHandleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT;
+		extMemProperties->exportFromImportedHandleTypes = 0;
+		extMemProperties->externalMemoryFeatures = VK_EXTERNAL_MEMORY_FEATURE_IMPORTABLE_BIT;
+		return;
+	}
+#endif
 #if SWIFTSHADER_EXTERNAL_MEMORY_ANDROID_HARDWARE_BUFFER
 	if(*handleType == VK_EXTERNAL_MEMORY_HANDLE_TYPE_ANDROID_HARDWARE_BUFFER_BIT_ANDROID)
 	{
@@ -668,6 +678,13 @@ void PhysicalDevice::getProperties(const VkExternalMemoryHandleTypeFlagBits *han
 		return;
 	}
 #endif
+	if(*handleType == VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT || *handleType == VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_MAPPED_FOREIGN_MEMORY_BIT_EXT)
+	{
+		extMemProperties->compatibleHandleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT | VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_MAPPED_FOREIGN_MEMORY_BIT_EXT;
+		extMemProperties->exportFromImportedHandleTypes = 0;
+		extMemProperties->externalMemoryFeatures = VK_EXTERNAL_MEMORY_FEATURE_IMPORTABLE_BIT;
+		return;
+	}
 	extMemProperties->compatibleHandleTypes = 0;
 	extMemProperties->exportFromImportedHandleTypes = 0;
 	extMemProperties->externalMemoryFeatures = 0;
@@ -685,6 +702,16 @@ void PhysicalDevice::getProperties(const VkExternalMemoryHandleTypeFlagBits *han
 		return;
 	}
 #endif
+#if SWIFTSHADER_EXTERNAL_MEMORY_DMA_BUF
+	if(*handleType == VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT)
+	{
+		// dma-bufs can be imported, but SwiftShader memory is never backed by one.
+		extMemProperties->compatibleHandleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT;
+		extMemProperties->exportFromImportedHandleTypes = 0;
+		extMemProperties->externalMemoryFeatures = VK_EXTERNAL_MEMORY_FEATURE_IMPORTABLE_BIT;
+		return;
+	}
+#endif
 #if SWIFTSHADER_EXTERNAL_MEMORY_ANDROID_HARDWARE_BUFFER
 	if(*handleType == VK_EXTERNAL_MEMORY_HANDLE_TYPE_ANDROID_HARDWARE_BUFFER_BIT_ANDROID)
 	{
@@ -703,6 +730,13 @@ void PhysicalDevice::getProperties(const VkExternalMemoryHandleTypeFlagBits *han
 		return;
 	}
 #endif
+	if(*handleType == VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT || *handleType == VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_MAPPED_FOREIGN_MEMORY_BIT_EXT)
+	{
+		extMemProperties->compatibleHandleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT | VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_MAPPED_FOREIGN_MEMORY_BIT_EXT;
+		extMemProperties->exportFromImportedHandleTypes = 0;
+		extMemProperties->externalMemoryFeatures = VK_EXTERNAL_MEMORY_FEATURE_IMPORTABLE_BIT;
+		return;
+	}
 	extMemProperties->compatibleHandleTypes = 0;
 	extMemProperties->exportFromImportedHandleTypes = 0;
 	extMemProperties->externalMemoryFeatures = 0;
@@ -18,13 +18,19 @@
 #include "VkDevice.hpp"
 #include "VkPipelineCache.hpp"
 #include "VkPipelineLayout.hpp"
+#include "VkQueryPool.hpp"
 #include "VkRenderPass.hpp"
 #include "VkShaderModule.hpp"
 #include "VkStringify.hpp"
 #include "Pipeline/ComputeProgram.hpp"
 #include "Pipeline/SpirvShader.hpp"
+#include "System/Math.hpp"
+#include "System/SharedCache.hpp"
 
+#include "marl/defer.h"
+#include "marl/scheduler.h"
 #include "marl/trace.h"
+#include "marl/waitgroup.h"
 
 #include "spirv-tools/optimizer.hpp"
 
@@ -102,9 +108,102 @@ std::vector<uint32_t> preprocessSpirv(
 	return optimized;
 }
 
+// OptimizedCodeKey identifies the input of preprocessSpirv(). The content hash
+// only selects the bucket; on a hash match the instructions and specialization
+// info themselves are compared.
+struct OptimizedCodeKey
+{
+	OptimizedCodeKey() = default;
+	OptimizedCodeKey(const vk::PipelineCache::SpirvShaderKey &key, bool optimize)
+	    : insns(key.getInsns())
+	    , specializationInfo(key.getSpecialization())
+	    , optimize(optimize)
+	    , hash(sw::Murmur3_128(&optimize, sizeof(optimize), key.getCodeHash()))
+	{}
+
+	bool operator==(const OptimizedCodeKey &other) const
+	{
+		return hash == other.hash &&
+		       optimize == other.optimize &&
+		       insns == other.insns &&
+		       specializationInfo == other.specializationInfo;
+	}
+
+	struct Hash
+	{
+		std::size_t operator()(const OptimizedCodeKey &key) const noexcept { return sw::Hash128::Hash()(key.hash); }
+	};
+
+	std::vector<uint32_t> insns;
+	vk::SpecializationInfo specializationInfo = nullptr;
+	bool optimize = false;
+	sw::Hash128 hash;
+};
+
+// SharedShaderKey identifies a SpirvShader which does not depend on a render
+// pass.
+struct SharedShaderKey
+{
+	SharedShaderKey() = default;
+	SharedShaderKey(const OptimizedCodeKey &code, const vk::PipelineCache::SpirvShaderKey &key, bool robustBufferAccess)
+	    : code(code)
+	    , entryPointName(key.getEntryPointName())
+	    , pipelineStage(key.getPipelineStage())
+	    , robustBufferAccess(robustBufferAccess)
+	{
+		sw::Hash128 keyHash = sw::Murmur3_128(entryPointName.data(), entryPointName.size(), code.hash);
+		keyHash = sw::Murmur3_128(&pipelineStage, sizeof(pipelineStage), keyHash);
+		keyHash = sw::Murmur3_128(&robustBufferAccess, sizeof(robustBufferAccess), keyHash);
+		hash = sw::Hash128::Hash()(keyHash);
+	}
+
+	bool operator==(const SharedShaderKey &other) const
+	{
+		return pipelineStage == other.pipelineStage &&
+		       robustBufferAccess == other.robustBufferAccess &&
+		       entryPointName == other.entryPointName &&
+		       code == other.code;
+	}
+
+	struct Hash
+	{
+		std::size_t operator()(const SharedShaderKey &key) const noexcept { return key.hash; }
+	};
+
+	OptimizedCodeKey code;
+	std::string entryPointName;
+	VkShaderStageFlagBits pipelineStage = VK_SHADER_STAGE_ALL;
+	bool robustBufferAccess = false;
+	std::size_t hash = 0;
+};
+
+// OptimizedCode is the result of preprocessSpirv() for a given module and
+// specialization. The serial ID identifies the code for the routine caches,
+// so identical code shares routines even across shader modules.
+struct OptimizedCode
+{
+	std::vector<uint32_t> code;
+	uint32_t serialID;
+};
+
+// Without a VkPipelineCache, every pipeline would otherwise re-run the
+// SPIR-V optimizer, even for modules it has seen before.
+sw::SharedCache<OptimizedCodeKey, OptimizedCode, OptimizedCodeKey::Hash> &optimizedCodeCache()
+{
+	static sw::SharedCache<OptimizedCodeKey, OptimizedCode, OptimizedCodeKey::Hash> cache(256);
+	return cache;
+}
+
+// SpirvShaders which do not depend on a render pass are shared too, so their
+// analysis is only performed once.
+sw::SharedCache<SharedShaderKey, sw::SpirvShader, SharedShaderKey::Hash> &spirvShaderCache()
+{
+	static sw::SharedCache<SharedShaderKey, sw::SpirvShader, SharedShaderKey::Hash> cache(64);
+	return cache;
+}
+
 std::shared_ptr<sw::SpirvShader> createShader(
     const vk::PipelineCache::SpirvShaderKey &key,
-    const vk::ShaderModule *module,
     bool robustBufferAccess,
     const std::shared_ptr<vk::dbg::Context> &dbgctx)
 {
@@ -113,16 +212,29 @@ std::shared_ptr<sw::SpirvShader> createShader(
 	// instructions.
 	const bool optimize = !dbgctx;
 
-	auto code = preprocessSpirv(key.getInsns(), key.getSpecializationInfo(), optimize);
-	ASSERT(code.size() > 0);
+	const OptimizedCodeKey codeKey(key, optimize);
+	auto optimized = optimizedCodeCache().getOrCreate(codeKey, [&] {
+		auto result = std::make_shared<OptimizedCode>();
+		result->code = preprocessSpirv(key.getInsns(), key.getSpecializationInfo(), optimize);
+		result->serialID = vk::ShaderModule::nextSerialID();
+		return result;
+	});
+	ASSERT(optimized->code.size() > 0);
 
-	// If the pipeline has specialization constants, assume they're unique and
-	// use a new serial ID so the shader gets recompiled.
-	uint32_t codeSerialID = (key.getSpecializationInfo() ? vk::ShaderModule::nextSerialID() : module->getSerialID());
+	auto create = [&] {
+		// TODO(b/119409619): use allocator.
+		return std::make_shared<sw::SpirvShader>(optimized->serialID, key.getPipelineStage(), key.getEntryPointName().c_str(),
+		                                         optimized->code, key.getRenderPass(), key.getSubpassIndex(), robustBufferAccess, dbgctx);
+	};
 
-	// TODO(b/119409619): use allocator.
-	return std::make_shared<sw::SpirvShader>(codeSerialID, key.getPipelineStage(), key.getEntryPointName().c_str(),
-	                                         code, key.getRenderPass(), key.getSubpassIndex(), robustBufferAccess, dbgctx);
+	// The render pass and debugger context are device objects, which the
+	// shared cache must not hold on to.
+	if(key.getRenderPass() || dbgctx)
+	{
+		return create();
+	}
+
+	return spirvShaderCache().getOrCreate(SharedShaderKey(codeKey, key, robustBufferAccess), create);
 }
 
 std::shared_ptr<sw::ComputeProgram> createProgram(vk::Device *device, const vk::PipelineCache::ComputeProgramKey &key)
@@ -221,6 +333,9 @@ const std::shared_ptr<sw::SpirvShader> GraphicsPipeline::getShader(const VkShade
 
 void GraphicsPipeline::compileShaders(const VkAllocationCallbacks *pAllocator, const VkGraphicsPipelineCreateInfo *pCreateInfo, PipelineCache *pPipelineCache)
 {
+	// The stages are independent, so each one is compiled in its own task.
+	marl::WaitGroup wg;
+
 	for(auto pStage = pCreateInfo->pStages; pStage != pCreateInfo->pStages + pCreateInfo->stageCount; pStage++)
 	{
 		if(pStage->flags != 0)
@@ -229,25 +344,33 @@ void GraphicsPipeline::compileShaders(const VkAllocationCallbacks *pAllocator, c
 			UNSUPPORTED("pStage->flags %d", int(pStage->flags));
 		}
 
-		const ShaderModule *module = vk::Cast(pStage->module);
-		const PipelineCache::SpirvShaderKey key(pStage->stage, pStage->pName, module->getCode(),
-		                                        vk::Cast(pCreateInfo->renderPass), pCreateInfo->subpass,
-		                                        pStage->pSpecializationInfo);
-		auto pipelineStage = key.getPipelineStage();
-
-		if(pPipelineCache)
-		{
-			auto shader = pPipelineCache->getOrCreateShader(key, [&] {
-				return createShader(key, module, robustBufferAccess, device->getDebuggerContext());
-			});
-			setShader(pipelineStage, shader);
-		}
-		else
-		{
-			auto shader = createShader(key, module, robustBufferAccess, device->getDebuggerContext());
-			setShader(pipelineStage, shader);
-		}
+		wg.add(1);
+		marl::schedule([=] {
+			defer(wg.done());
+			MARL_SCOPED_EVENT("compileShaders stage %d", int(pStage->stage));
+
+			const ShaderModule *module = vk::Cast(pStage->module);
+			const PipelineCache::SpirvShaderKey key(pStage->stage, pStage->pName, module->getCode(),
+			                                        vk::Cast(pCreateInfo->renderPass), pCreateInfo->subpass,
+			                                        pStage->pSpecializationInfo);
+			auto pipelineStage = key.getPipelineStage();
+
+			if(pPipelineCache)
+			{
+				auto shader = pPipelineCache->getOrCreateShader(key, [&] {
+					return createShader(key, robustBufferAccess, device->getDebuggerContext());
+				});
+				setShader(pipelineStage, shader);
+			}
+			else
+			{
+				auto shader = createShader(key, robustBufferAccess, device->getDebuggerContext());
+				setShader(pipelineStage, shader);
+			}
+		});
 	}
+
+	wg.wait();
 }
 
 ComputePipeline::ComputePipeline(const VkComputePipelineCreateInfo *pCreateInfo, void *mem, Device *device)
@@ -279,7 +402,7 @@ void ComputePipeline::compileShaders(const VkAllocationCallbacks *pAllocator, co
 	if(pPipelineCache)
 	{
 		shader = pPipelineCache->getOrCreateShader(shaderKey, [&] {
-			return createShader(shaderKey, module, robustBufferAccess, device->getDebuggerContext());
+			return createShader(shaderKey, robustBufferAccess, device->getDebuggerContext());
 		});
 
 		const PipelineCache::ComputeProgramKey programKey(shader.get(), layout);
@@ -289,7 +412,7 @@ void ComputePipeline::compileShaders(const VkAllocationCallbacks *pAllocator, co
 	}
 	else
 	{
-		shader = createShader(shaderKey, module, robustBufferAccess, device->getDebuggerContext());
+		shader = createShader(shaderKey, robustBufferAccess, device->getDebuggerContext());
 		const PipelineCache::ComputeProgramKey programKey(shader.get(), layout);
 		program = createProgram(device, programKey);
 	}
@@ -300,13 +423,22 @@ void ComputePipeline::run(uint32_t baseGroupX, uint32_t baseGroupY, uint32_t bas
                           vk::DescriptorSet::Array const &descriptorSetObjects,
                           vk::DescriptorSet::Bindings const &descriptorSets,
                           vk::DescriptorSet::DynamicOffsets const &descriptorDynamicOffsets,
-                          vk::Pipeline::PushConstantStorage const &pushConstants)
+                          vk::Pipeline::PushConstantStorage const &pushConstants,
+                          vk::Query *statisticsQuery)
 {
 	ASSERT_OR_RETURN(program != nullptr);
 	program->run(
 	    descriptorSetObjects, descriptorSets, descriptorDynamicOffsets, pushConstants,
 	    baseGroupX, baseGroupY, baseGroupZ,
 	    groupCountX, groupCountY, groupCountZ);
+
+	if(statisticsQuery)
+	{
+		auto &modes = shader->getModes();
+		uint64_t invocationsPerWorkgroup = modes.WorkgroupSizeX * modes.WorkgroupSizeY * modes.WorkgroupSizeZ;
+		uint64_t groupCount = uint64_t(groupCountX) * groupCountY * groupCountZ;
+		statisticsQuery->add(VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT, groupCount * invocationsPerWorkgroup);
+	}
 }
 
 }  // namespace vk
@@ -32,6 +32,7 @@ namespace dbg {
 class Context;
 }  // namespace dbg
 
+class Query;
 class ShaderModule;
 
 class Pipeline
@@ -146,7 +147,8 @@ public:
 	         vk::DescriptorSet::Array const &descriptorSetObjects,
 	         vk::DescriptorSet::Bindings const &descriptorSets,
 	         vk::DescriptorSet::DynamicOffsets const &descriptorDynamicOffsets,
-	         vk::Pipeline::PushConstantStorage const &pushConstants);
+	         vk::Pipeline::PushConstantStorage const &pushConstants,
+	         vk::Query *statisticsQuery);
 
 protected:
 	std::shared_ptr<sw::SpirvShader> shader;
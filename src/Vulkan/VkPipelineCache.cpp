@@ -30,48 +30,34 @@ PipelineCache::SpirvShaderKey::SpirvShaderKey(const VkShaderStageFlagBits pipeli
     , subpassIndex(subpassIndex)
     , specializationInfo(specializationInfo)
 {
-}
-
-bool PipelineCache::SpirvShaderKey::operator<(const SpirvShaderKey &other) const
-{
-	if(pipelineStage != other.pipelineStage)
-	{
-		return pipelineStage < other.pipelineStage;
-	}
-
-	if(renderPass != other.renderPass)
-	{
-		return renderPass < other.renderPass;
-	}
-
-	if(subpassIndex != other.subpassIndex)
-	{
-		return subpassIndex < other.subpassIndex;
-	}
+	codeHash = sw::Murmur3_128(insns.data(), insns.size() * sizeof(uint32_t));
 
-	if(insns.size() != other.insns.size())
+	if(const VkSpecializationInfo *info = specializationInfo.get())
 	{
-		return insns.size() < other.insns.size();
+		codeHash = sw::Murmur3_128(&info->mapEntryCount, sizeof(info->mapEntryCount), codeHash);
+		codeHash = sw::Murmur3_128(info->pMapEntries, info->mapEntryCount * sizeof(VkSpecializationMapEntry), codeHash);
+		codeHash = sw::Murmur3_128(&info->dataSize, sizeof(info->dataSize), codeHash);
+		codeHash = sw::Murmur3_128(info->pData, info->dataSize, codeHash);
 	}
 
-	if(entryPointName.size() != other.entryPointName.size())
-	{
-		return entryPointName.size() < other.entryPointName.size();
-	}
-
-	int cmp = memcmp(entryPointName.c_str(), other.entryPointName.c_str(), entryPointName.size());
-	if(cmp != 0)
-	{
-		return cmp < 0;
-	}
-
-	cmp = memcmp(insns.data(), other.insns.data(), insns.size() * sizeof(uint32_t));
-	if(cmp != 0)
-	{
-		return cmp < 0;
-	}
+	sw::Hash128 keyHash = sw::Murmur3_128(entryPointName.data(), entryPointName.size(), codeHash);
+	keyHash = sw::Murmur3_128(&pipelineStage, sizeof(pipelineStage), keyHash);
+	keyHash = sw::Murmur3_128(&renderPass, sizeof(renderPass), keyHash);
+	keyHash = sw::Murmur3_128(&subpassIndex, sizeof(subpassIndex), keyHash);
+	hash = sw::Hash128::Hash()(keyHash);
+}
 
-	return (specializationInfo < other.specializationInfo);
+bool PipelineCache::SpirvShaderKey::operator==(const SpirvShaderKey &other) const
+{
+	// The content hash rejects most mismatches early, but only comparing the
+	// instructions and specialization info guarantees a match.
+	return pipelineStage == other.pipelineStage &&
+	       renderPass == other.renderPass &&
+	       subpassIndex == other.subpassIndex &&
+	       codeHash == other.codeHash &&
+	       entryPointName == other.entryPointName &&
+	       insns == other.insns &&
+	       specializationInfo == other.specializationInfo;
 }
 
 PipelineCache::PipelineCache(const VkPipelineCacheCreateInfo *pCreateInfo, void *mem)
@@ -17,6 +17,7 @@
 
 #include "VkObject.hpp"
 #include "VkSpecializationInfo.hpp"
+#include "System/Math.hpp"
 
 #include "marl/mutex.h"
 #include "marl/tsa.h"
@@ -26,6 +27,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace sw {
@@ -61,7 +63,12 @@ public:
 		               const uint32_t subpassIndex,
 		               const vk::SpecializationInfo &specializationInfo);
 
-		bool operator<(const SpirvShaderKey &other) const;
+		bool operator==(const SpirvShaderKey &other) const;
+
+		struct Hash
+		{
+			std::size_t operator()(const SpirvShaderKey &key) const noexcept { return key.hash; }
+		};
 
 		const VkShaderStageFlagBits &getPipelineStage() const { return pipelineStage; }
 		const std::string &getEntryPointName() const { return entryPointName; }
@@ -69,6 +76,11 @@ public:
 		const vk::RenderPass *getRenderPass() const { return renderPass; }
 		uint32_t getSubpassIndex() const { return subpassIndex; }
 		const VkSpecializationInfo *getSpecializationInfo() const { return specializationInfo.get(); }
+		const vk::SpecializationInfo &getSpecialization() const { return specializationInfo; }
+
+		// getCodeHash() returns the content hash of the instructions and the
+		// specialization info, which together determine the optimized SPIR-V.
+		const sw::Hash128 &getCodeHash() const { return codeHash; }
 
 	private:
 		const VkShaderStageFlagBits pipelineStage;
@@ -77,6 +89,8 @@ public:
 		const vk::RenderPass *renderPass;
 		const uint32_t subpassIndex;
 		const vk::SpecializationInfo specializationInfo;
+		sw::Hash128 codeHash;
+		std::size_t hash;
 	};
 
 	// getOrCreateShader() queries the cache for a shader with the given key.
@@ -130,7 +144,7 @@ private:
 	uint8_t *data = nullptr;
 
 	marl::mutex spirvShadersMutex;
-	std::map<SpirvShaderKey, std::shared_ptr<sw::SpirvShader>> spirvShaders GUARDED_BY(spirvShadersMutex);
+	std::unordered_map<SpirvShaderKey, std::shared_ptr<sw::SpirvShader>, SpirvShaderKey::Hash> spirvShaders GUARDED_BY(spirvShadersMutex);
 
 	marl::mutex computeProgramsMutex;
 	std::map<ComputeProgramKey, std::shared_ptr<sw::ComputeProgram>> computePrograms GUARDED_BY(computeProgramsMutex);
@@ -144,27 +158,37 @@ static inline PipelineCache *Cast(VkPipelineCache object)
 template<typename Function>
 std::shared_ptr<sw::ComputeProgram> PipelineCache::getOrCreateComputeProgram(const PipelineCache::ComputeProgramKey &key, Function &&create)
 {
-	marl::lock lock(computeProgramsMutex);
+	{
+		marl::lock lock(computeProgramsMutex);
 
-	auto it = computePrograms.find(key);
-	if(it != computePrograms.end()) { return it->second; }
+		auto it = computePrograms.find(key);
+		if(it != computePrograms.end()) { return it->second; }
+	}
 
+	// Pipelines can be compiled concurrently, so don't hold the lock while
+	// creating the program. If another thread added the same key in the
+	// meantime, its program is kept so all users share one instance.
 	auto created = create();
-	computePrograms.emplace(key, created);
-	return created;
+
+	marl::lock lock(computeProgramsMutex);
+	return computePrograms.emplace(key, created).first->second;
 }
 
 template<typename Function>
 std::shared_ptr<sw::SpirvShader> PipelineCache::getOrCreateShader(const PipelineCache::SpirvShaderKey &key, Function &&create)
 {
-	marl::lock lock(spirvShadersMutex);
+	{
+		marl::lock lock(spirvShadersMutex);
 
-	auto it = spirvShaders.find(key);
-	if(it != spirvShaders.end()) { return it->second; }
+		auto it = spirvShaders.find(key);
+		if(it != spirvShaders.end()) { return it->second; }
+	}
 
+	// See getOrCreateComputeProgram() for why the lock isn't held here.
 	auto created = create();
-	spirvShaders.emplace(key, created);
-	return created;
+
+	marl::lock lock(spirvShadersMutex);
+	return spirvShaders.emplace(key, created).first->second;
 }
 
 }  // namespace vk
@@ -14,6 +14,8 @@
 
 #include "VkQueryPool.hpp"
 
+#include "System/Math.hpp"
+
 #include <chrono>
 #include <cstring>
 #include <new>
@@ -24,8 +26,14 @@ Query::Query()
     : finished(marl::Event::Mode::Manual)
     , state(UNAVAILABLE)
     , type(INVALID_TYPE)
+    , pipelineStatistics(0)
     , value(0)
-{}
+{
+	for(auto &counter : statistics)
+	{
+		counter = 0;
+	}
+}
 
 void Query::reset()
 {
@@ -33,14 +41,20 @@ void Query::reset()
 	auto prevState = state.exchange(UNAVAILABLE);
 	ASSERT(prevState != ACTIVE);
 	type = INVALID_TYPE;
+	pipelineStatistics = 0;
 	value = 0;
+	for(auto &counter : statistics)
+	{
+		counter = 0;
+	}
 }
 
-void Query::prepare(VkQueryType ty)
+void Query::prepare(VkQueryType ty, VkQueryPipelineStatisticFlags stats)
 {
 	auto prevState = state.exchange(ACTIVE);
 	ASSERT(prevState == UNAVAILABLE);
 	type = ty;
+	pipelineStatistics = stats;
 }
 
 void Query::start()
@@ -64,6 +78,10 @@ Query::Data Query::getData() const
 	Data out;
 	out.state = state;
 	out.value = value;
+	for(int i = 0; i < PIPELINE_STATISTICS_COUNT; i++)
+	{
+		out.statistics[i] = statistics[i];
+	}
 	return out;
 }
 
@@ -72,6 +90,16 @@ VkQueryType Query::getType() const
 	return type;
 }
 
+VkQueryPipelineStatisticFlags Query::getPipelineStatistics() const
+{
+	return pipelineStatistics;
+}
+
+bool Query::hasPipelineStatistic(VkQueryPipelineStatisticFlagBits statistic) const
+{
+	return (pipelineStatistics & statistic) != 0;
+}
+
 void Query::wait()
 {
 	finished.wait();
@@ -87,21 +115,25 @@ void Query::add(int64_t v)
 	value += v;
 }
 
+void Query::add(VkQueryPipelineStatisticFlagBits statistic, int64_t v)
+{
+	if(hasPipelineStatistic(statistic))
+	{
+		statistics[sw::log2i(statistic)] += v;
+	}
+}
+
 QueryPool::QueryPool(const VkQueryPoolCreateInfo *pCreateInfo, void *mem)
     : pool(reinterpret_cast<Query *>(mem))
     , type(pCreateInfo->queryType)
     , count(pCreateInfo->queryCount)
+    , pipelineStatistics((pCreateInfo->queryType == VK_QUERY_TYPE_PIPELINE_STATISTICS) ? pCreateInfo->pipelineStatistics : 0)
 {
-	// According to the Vulkan 1.2 spec, section 30. Features:
-	// "pipelineStatisticsQuery specifies whether the pipeline statistics
-	//  queries are supported. If this feature is not enabled, queries of
-	//  type VK_QUERY_TYPE_PIPELINE_STATISTICS cannot be created, and
-	//  none of the VkQueryPipelineStatisticFlagBits bits can be set in the
-	//  pipelineStatistics member of the VkQueryPoolCreateInfo structure."
-	if(type == VK_QUERY_TYPE_PIPELINE_STATISTICS)
-	{
-		UNSUPPORTED("VkPhysicalDeviceFeatures::pipelineStatisticsQuery");
-	}
+	// "pipelineStatistics is a bitmask of VkQueryPipelineStatisticFlagBits
+	//  specifying which counters will be returned in queries on the new pool"
+	// Geometry and tessellation shaders are not supported, so their counters
+	// always remain zero.
+	ASSERT((pipelineStatistics & ~((1u << Query::PIPELINE_STATISTICS_COUNT) - 1)) == 0);
 
 	// Construct all queries
 	for(uint32_t i = 0; i < count; i++)
@@ -152,6 +184,25 @@ VkResult QueryPool::getResults(uint32_t firstQuery, uint32_t queryCount, size_t
 
 		const auto current = query.getData();
 
+		// Pipeline statistics queries return one value per enabled counter, in
+		// order of increasing bit value. All other queries return a single value.
+		int64_t values[Query::PIPELINE_STATISTICS_COUNT];
+		uint32_t valueCount = 0;
+		if(type == VK_QUERY_TYPE_PIPELINE_STATISTICS)
+		{
+			for(int statistic = 0; statistic < Query::PIPELINE_STATISTICS_COUNT; statistic++)
+			{
+				if(pipelineStatistics & (1u << statistic))
+				{
+					values[valueCount++] = current.statistics[statistic];
+				}
+			}
+		}
+		else
+		{
+			values[valueCount++] = current.value;
+		}
+
 		bool writeResult = true;
 		if(current.state == Query::ACTIVE || (current.state == Query::UNAVAILABLE && !(flags & VK_QUERY_RESULT_WAIT_BIT)))
 		{
@@ -164,11 +215,14 @@ VkResult QueryPool::getResults(uint32_t firstQuery, uint32_t queryCount, size_t
 			uint64_t *result64 = reinterpret_cast<uint64_t *>(data);
 			if(writeResult)
 			{
-				result64[0] = current.value;
+				for(uint32_t j = 0; j < valueCount; j++)
+				{
+					result64[j] = values[j];
+				}
 			}
 			if(flags & VK_QUERY_RESULT_WITH_AVAILABILITY_BIT)  // Output query availablity
 			{
-				result64[1] = current.state;
+				result64[valueCount] = current.state;
 			}
 		}
 		else
@@ -176,11 +230,14 @@ VkResult QueryPool::getResults(uint32_t firstQuery, uint32_t queryCount, size_t
 			uint32_t *result32 = reinterpret_cast<uint32_t *>(data);
 			if(writeResult)
 			{
-				result32[0] = static_cast<uint32_t>(current.value);
+				for(uint32_t j = 0; j < valueCount; j++)
+				{
+					result32[j] = static_cast<uint32_t>(values[j]);
+				}
 			}
 			if(flags & VK_QUERY_RESULT_WITH_AVAILABILITY_BIT)  // Output query availablity
 			{
-				result32[1] = current.state;
+				result32[valueCount] = current.state;
 			}
 		}
 	}
@@ -198,7 +255,7 @@ void QueryPool::begin(uint32_t query, VkQueryControlFlags flags)
 		UNSUPPORTED("vkCmdBeginQuery::flags %d", int(flags));
 	}
 
-	pool[query].prepare(type);
+	pool[query].prepare(type, pipelineStatistics);
 	pool[query].start();
 }
 
@@ -31,6 +31,9 @@ class Query
 public:
 	static auto constexpr INVALID_TYPE = VK_QUERY_TYPE_MAX_ENUM;
 
+	// Number of VkQueryPipelineStatisticFlagBits, each of which has its own counter.
+	static constexpr int PIPELINE_STATISTICS_COUNT = 11;
+
 	Query();
 
 	enum State
@@ -44,16 +47,21 @@ public:
 	{
 		State state;    // The current query state.
 		int64_t value;  // The current query value.
+
+		// The current pipeline statistics counters, indexed by statistic bit.
+		int64_t statistics[PIPELINE_STATISTICS_COUNT];
 	};
 
 	// reset() sets the state of the Query to UNAVAILABLE, sets the type to
-	// INVALID_TYPE and clears the query value.
+	// INVALID_TYPE and clears the query value and statistics.
 	// reset() must not be called while the query is in the ACTIVE state.
 	void reset();
 
 	// prepare() sets the Query type to ty, and sets the state to ACTIVE.
+	// For VK_QUERY_TYPE_PIPELINE_STATISTICS queries, statistics holds the
+	// set of counters gathered while the query is active.
 	// prepare() must not be called when the query is already ACTIVE.
-	void prepare(VkQueryType ty);
+	void prepare(VkQueryType ty, VkQueryPipelineStatisticFlags statistics = 0);
 
 	// start() begins a query task which is closed with a call to finish().
 	// Query tasks can be nested.
@@ -75,18 +83,32 @@ public:
 	// getType() returns the type of query.
 	VkQueryType getType() const;
 
+	// getPipelineStatistics() returns the set of pipeline statistics gathered
+	// by a VK_QUERY_TYPE_PIPELINE_STATISTICS query.
+	VkQueryPipelineStatisticFlags getPipelineStatistics() const;
+
+	// hasPipelineStatistic() returns true if the statistic is gathered by
+	// this query.
+	bool hasPipelineStatistic(VkQueryPipelineStatisticFlagBits statistic) const;
+
 	// set() replaces the current query value with val.
 	void set(int64_t val);
 
 	// add() adds val to the current query value.
 	void add(int64_t val);
 
+	// add() adds val to the counter of the given pipeline statistic.
+	// Statistics which are not gathered by this query are ignored.
+	void add(VkQueryPipelineStatisticFlagBits statistic, int64_t val);
+
 private:
 	marl::WaitGroup wg;
 	marl::Event finished;
 	std::atomic<State> state;
 	std::atomic<VkQueryType> type;
+	std::atomic<VkQueryPipelineStatisticFlags> pipelineStatistics;
 	std::atomic<int64_t> value;
+	std::atomic<int64_t> statistics[PIPELINE_STATISTICS_COUNT];
 };
 
 class QueryPool : public Object<QueryPool, VkQueryPool>
@@ -111,6 +133,7 @@ private:
 	Query *pool;
 	VkQueryType type;
 	uint32_t count;
+	VkQueryPipelineStatisticFlags pipelineStatistics;
 };
 
 static inline QueryPool *Cast(VkQueryPool object)
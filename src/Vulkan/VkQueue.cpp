@@ -273,6 +273,11 @@ void Queue::taskLoop(marl::Scheduler *scheduler)
 			case Task::SUBMIT_QUEUE:
 				submitQueue(task);
 				break;
+#ifndef __ANDROID__
+			case Task::PRESENT:
+				presentQueue(task);
+				break;
+#endif
 			default:
 				UNREACHABLE("task.type %d", static_cast<int>(task.type));
 				break;
@@ -310,21 +315,45 @@ void Queue::garbageCollect()
 #ifndef __ANDROID__
 VkResult Queue::present(const VkPresentInfoKHR *presentInfo)
 {
-	// This is a hack to deal with screen tearing for now.
-	// Need to correctly implement threading using VkSemaphore
-	// to get rid of it. b/132458423
-	waitIdle();
+	bool async = true;
+	for(uint32_t i = 0; i < presentInfo->swapchainCount; i++)
+	{
+		async = async && vk::Cast(presentInfo->pSwapchains[i])->canPresentAsync();
+	}
 
-	for(uint32_t i = 0; i < presentInfo->waitSemaphoreCount; i++)
+	if(!async)
 	{
-		vk::DynamicCast<BinarySemaphore>(presentInfo->pWaitSemaphores[i])->wait();
+		// The surface can only be presented to from this thread, so wait for
+		// all the work it depends on before copying the image out.
+		waitIdle();
+
+		for(uint32_t i = 0; i < presentInfo->waitSemaphoreCount; i++)
+		{
+			vk::DynamicCast<BinarySemaphore>(presentInfo->pWaitSemaphores[i])->wait();
+		}
 	}
 
+	auto present = std::make_shared<PresentInfo>();
+
 	VkResult commandResult = VK_SUCCESS;
 
 	for(uint32_t i = 0; i < presentInfo->swapchainCount; i++)
 	{
-		VkResult perSwapchainResult = vk::Cast(presentInfo->pSwapchains[i])->present(presentInfo->pImageIndices[i]);
+		auto *swapchain = vk::Cast(presentInfo->pSwapchains[i]);
+		uint32_t imageIndex = presentInfo->pImageIndices[i];
+
+		VkResult perSwapchainResult = swapchain->queuePresent(imageIndex);
+		if(perSwapchainResult == VK_SUCCESS)
+		{
+			if(async)
+			{
+				present->images.emplace_back(swapchain, imageIndex);
+			}
+			else
+			{
+				perSwapchainResult = swapchain->present(imageIndex);
+			}
+		}
 
 		if(presentInfo->pResults)
 		{
@@ -342,8 +371,45 @@ VkResult Queue::present(const VkPresentInfoKHR *presentInfo)
 		}
 	}
 
+	if(async)
+	{
+		// The present is ordered after all previously submitted work by the
+		// queue thread, so the application can carry on recording the next
+		// frame while this one is being rendered.
+		for(uint32_t i = 0; i < presentInfo->waitSemaphoreCount; i++)
+		{
+			present->waitSemaphores.push_back(vk::DynamicCast<BinarySemaphore>(presentInfo->pWaitSemaphores[i]));
+		}
+
+		Task task;
+		task.type = Task::PRESENT;
+		task.present = present;
+		pending.put(task);
+	}
+
 	return commandResult;
 }
+
+void Queue::presentQueue(const Task &task)
+{
+	MARL_SCOPED_EVENT("presentQueue");
+
+	for(auto *semaphore : task.present->waitSemaphores)
+	{
+		semaphore->wait();
+	}
+
+	if(renderer)
+	{
+		renderer->synchronize();
+	}
+
+	for(auto &image : task.present->images)
+	{
+		// Errors are reported by the swapchain on its next use.
+		image.first->present(image.second);
+	}
+}
 #endif
 
 void Queue::beginDebugUtilsLabel(const VkDebugUtilsLabelEXT *pLabelInfo)
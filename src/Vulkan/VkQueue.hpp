@@ -19,7 +19,10 @@
 #include "Device/Renderer.hpp"
 #include "System/Synchronization.hpp"
 
+#include <memory>
 #include <thread>
+#include <utility>
+#include <vector>
 
 namespace marl {
 class Scheduler;
@@ -34,8 +37,10 @@ class Renderer;
 
 namespace vk {
 
+class BinarySemaphore;
 class Device;
 class Fence;
+class SwapchainKHR;
 
 class Queue
 {
@@ -61,16 +66,26 @@ public:
 	void insertDebugUtilsLabel(const VkDebugUtilsLabelEXT *pLabelInfo);
 
 private:
+	// PresentInfo holds the state of a vkQueuePresentKHR() call which is
+	// performed by the queue thread, after all previously submitted work.
+	struct PresentInfo
+	{
+		std::vector<BinarySemaphore *> waitSemaphores;
+		std::vector<std::pair<SwapchainKHR *, uint32_t>> images;
+	};
+
 	struct Task
 	{
 		uint32_t submitCount = 0;
 		VkSubmitInfo *pSubmits = nullptr;
 		std::shared_ptr<sw::CountedEvent> events;
+		std::shared_ptr<PresentInfo> present;
 
 		enum Type
 		{
 			KILL_THREAD,
-			SUBMIT_QUEUE
+			SUBMIT_QUEUE,
+			PRESENT
 		};
 		Type type = SUBMIT_QUEUE;
 	};
@@ -78,6 +93,9 @@ private:
 	void taskLoop(marl::Scheduler *scheduler);
 	void garbageCollect();
 	void submitQueue(const Task &task);
+#ifndef __ANDROID__
+	void presentQueue(const Task &task);
+#endif
 
 	Device *device;
 	std::unique_ptr<sw::Renderer> renderer;
@@ -105,4 +105,9 @@ bool SpecializationInfo::operator<(const SpecializationInfo &specializationInfo)
 	return false;
 }
 
+bool SpecializationInfo::operator==(const SpecializationInfo &specializationInfo) const
+{
+	return !(*this < specializationInfo) && !(specializationInfo < *this);
+}
+
 }  // namespace vk
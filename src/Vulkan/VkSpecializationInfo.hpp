@@ -26,6 +26,7 @@ struct SpecializationInfo
 	SpecializationInfo(const VkSpecializationInfo *specializationInfo);
 
 	bool operator<(const SpecializationInfo &specializationInfo) const;
+	bool operator==(const SpecializationInfo &specializationInfo) const;
 
 	const VkSpecializationInfo *get() const { return info.get(); }
 
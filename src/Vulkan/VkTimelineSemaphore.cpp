@@ -15,11 +15,6 @@
 #include "VkTimelineSemaphore.hpp"
 #include "VkSemaphore.hpp"
 
-#include "marl/blockingcall.h"
-#include "marl/conditionvariable.h"
-
-#include <vector>
-
 namespace vk {
 
 TimelineSemaphore::TimelineSemaphore(const VkSemaphoreCreateInfo *pCreateInfo, void *mem, const VkAllocationCallbacks *pAllocator)
@@ -28,14 +23,7 @@ TimelineSemaphore::TimelineSemaphore(const VkSemaphoreCreateInfo *pCreateInfo, v
 	SemaphoreCreateInfo info(pCreateInfo);
 	ASSERT(info.semaphoreType == VK_SEMAPHORE_TYPE_TIMELINE);
 	type = info.semaphoreType;
-	shared = marl::Allocator::Default->make_shared<TimelineSemaphore::Shared>(marl::Allocator::Default, info.initialPayload);
-}
-
-TimelineSemaphore::TimelineSemaphore()
-    : Semaphore(VK_SEMAPHORE_TYPE_TIMELINE)
-{
-	type = VK_SEMAPHORE_TYPE_TIMELINE;
-	shared = marl::Allocator::Default->make_shared<TimelineSemaphore::Shared>(marl::Allocator::Default, 0);
+	counter = info.initialPayload;
 }
 
 size_t TimelineSemaphore::ComputeRequiredAllocationSize(const VkSemaphoreCreateInfo *pCreateInfo)
@@ -45,101 +33,179 @@ size_t TimelineSemaphore::ComputeRequiredAllocationSize(const VkSemaphoreCreateI
 
 void TimelineSemaphore::destroy(const VkAllocationCallbacks *pAllocator)
 {
+	ASSERT(waiterCount == 0);
 }
 
 void TimelineSemaphore::signal(uint64_t value)
 {
-	return shared->signal(value);
-}
+	uint64_t current = counter;
+	do
+	{
+		if(current >= value)
+		{
+			return;
+		}
+	} while(!counter.compare_exchange_weak(current, value));
+
+	// Pairs with the increment in link(): either this sees the new node, or
+	// link() sees the new payload.
+	if(waiterCount == 0)
+	{
+		return;
+	}
 
-void TimelineSemaphore::Shared::signal(uint64_t value)
-{
 	marl::lock lock(mutex);
-	if(counter < value)
+	for(Waiter::Node *node = waiters; node != nullptr;)
 	{
-		counter = value;
-		cv.notify_all();
-		for(auto dep : deps)
+		Waiter::Node *next = node->next;
+		if(node->value <= value)
 		{
-			dep->signal(id, counter);
+			unlinkLocked(node);
+			node->waiter->notify();
 		}
+		node = next;
 	}
 }
 
 void TimelineSemaphore::wait(uint64_t value)
 {
-	shared->wait(value);
+	TimelineSemaphore *semaphore = this;
+	Wait(1, &semaphore, &value, false);
 }
 
-void TimelineSemaphore::Shared::wait(uint64_t value)
+void TimelineSemaphore::Wait(uint32_t count, TimelineSemaphore *const *semaphores, const uint64_t *values, bool waitAny)
 {
-	marl::lock lock(mutex);
-	cv.wait(lock, [&]() { return counter == value; });
+	if(Reached(count, semaphores, values, waitAny))
+	{
+		return;
+	}
+
+	Waiter waiter(count, semaphores, values, waitAny);
+	waiter.wait();
 }
 
-uint64_t TimelineSemaphore::getCounterValue()
+bool TimelineSemaphore::Reached(uint32_t count, TimelineSemaphore *const *semaphores, const uint64_t *values, bool waitAny)
 {
-	return shared->getCounterValue();
+	uint32_t reached = 0;
+	for(uint32_t i = 0; i < count; i++)
+	{
+		if(semaphores[i]->counter >= values[i])
+		{
+			reached++;
+		}
+	}
+
+	return (reached == count) || (waitAny && (reached > 0));
 }
 
-uint64_t TimelineSemaphore::Shared::getCounterValue()
+uint64_t TimelineSemaphore::getCounterValue()
 {
-	marl::lock lock(mutex);
 	return counter;
 }
 
-std::atomic<int> TimelineSemaphore::Shared::nextId;
-
-TimelineSemaphore::Shared::Shared(marl::Allocator *allocator, uint64_t initialState)
-    : cv(allocator)
-    , counter(initialState)
-    , id(nextId++)
+void TimelineSemaphore::link(Waiter::Node *node)
 {
+	marl::lock lock(mutex);
+
+	node->prev = nullptr;
+	node->next = waiters;
+	if(waiters)
+	{
+		waiters->prev = node;
+	}
+	waiters = node;
+	node->linked = true;
+	waiterCount++;
+
+	// A signal which didn't see the node yet must have updated the payload.
+	if(counter >= node->value)
+	{
+		unlinkLocked(node);
+		node->waiter->notify();
+	}
 }
 
-void TimelineSemaphore::Shared::signal(int parentId, uint64_t value)
+void TimelineSemaphore::unlink(Waiter::Node *node)
 {
 	marl::lock lock(mutex);
-	auto it = waitMap.find(parentId);
-	// Either we aren't waiting for a signal, or parentId is not something we're waiting for
-	// Reject any signals that we aren't waiting on
-	if(counter == 0 && it != waitMap.end() && value == it->second)
+	if(node->linked)
 	{
-		// Stop waiting on all parents once we find a signal
-		waitMap.clear();
-		counter = 1;
-		cv.notify_all();
-		for(auto dep : deps)
-		{
-			dep->signal(id, counter);
-		}
+		unlinkLocked(node);
 	}
 }
 
-void TimelineSemaphore::addDependent(TimelineSemaphore &other, uint64_t waitValue)
+void TimelineSemaphore::unlinkLocked(Waiter::Node *node)
 {
-	shared->addDependent(other);
-	other.addDependency(shared->id, waitValue);
+	if(node->prev)
+	{
+		node->prev->next = node->next;
+	}
+	else
+	{
+		waiters = node->next;
+	}
+
+	if(node->next)
+	{
+		node->next->prev = node->prev;
+	}
+
+	node->linked = false;
+	waiterCount--;
 }
 
-void TimelineSemaphore::Shared::addDependent(TimelineSemaphore &other)
+TimelineSemaphore::Waiter::Waiter(uint32_t count, TimelineSemaphore *const *semaphores, const uint64_t *values, bool waitAny)
 {
-	marl::lock lock(mutex);
-	deps.push_back(other.shared);
+	{
+		marl::lock lock(mutex);
+		pending = waitAny ? 1 : count;
+	}
+
+	// The nodes are linked by address, so they must not move once the first
+	// one is linked.
+	nodes.resize(count);
+
+	for(uint32_t i = 0; i < count; i++)
+	{
+		if(semaphores[i]->counter >= values[i])
+		{
+			notify();
+			continue;
+		}
+
+		Node &node = nodes[i];
+		node.semaphore = semaphores[i];
+		node.waiter = this;
+		node.value = values[i];
+		node.semaphore->link(&node);
+	}
 }
 
-void TimelineSemaphore::addDependency(int id, uint64_t waitValue)
+TimelineSemaphore::Waiter::~Waiter()
 {
-	shared->addDependency(id, waitValue);
+	// Once unlinked, no signal can reach this waiter anymore.
+	for(Node &node : nodes)
+	{
+		if(node.semaphore)
+		{
+			node.semaphore->unlink(&node);
+		}
+	}
 }
 
-void TimelineSemaphore::Shared::addDependency(int id, uint64_t waitValue)
+void TimelineSemaphore::Waiter::wait()
 {
 	marl::lock lock(mutex);
-	auto mapPos = waitMap.find(id);
-	ASSERT(mapPos == waitMap.end());
+	cv.wait(lock, [&]() REQUIRES(mutex) { return pending == 0; });
+}
 
-	waitMap.insert(mapPos, std::make_pair(id, waitValue));
+void TimelineSemaphore::Waiter::notify()
+{
+	marl::lock lock(mutex);
+	if(pending > 0 && --pending == 0)
+	{
+		cv.notify_all();
+	}
 }
 
 }  // namespace vk
@@ -20,20 +20,19 @@
 #include "VkSemaphore.hpp"
 
 #include "marl/conditionvariable.h"
+#include "marl/containers.h"
 #include "marl/mutex.h"
+#include "marl/tsa.h"
 
-#include "System/Synchronization.hpp"
-
+#include <atomic>
 #include <chrono>
 
 namespace vk {
 
-struct Shared;
-
 // Timeline Semaphores track a 64-bit payload instead of a binary payload.
 //
 // A timeline does not have a "signaled" and "unsignalled" state. Threads instead wait
-// for the payload to become a certain value. When a thread signals the timeline, it provides
+// for the payload to reach a certain value. When a thread signals the timeline, it provides
 // a new payload that is greater than the current payload.
 //
 // There is no way to reset a timeline or to decrease the payload's value. A user must instead
@@ -42,123 +41,118 @@ class TimelineSemaphore : public Semaphore, public Object<TimelineSemaphore, VkS
 {
 public:
 	TimelineSemaphore(const VkSemaphoreCreateInfo *pCreateInfo, void *mem, const VkAllocationCallbacks *pAllocator);
-	TimelineSemaphore();
 
 	static size_t ComputeRequiredAllocationSize(const VkSemaphoreCreateInfo *pCreateInfo);
 
-	// Block until this semaphore is signaled with the specified value;
+	// Block until the payload reaches the specified value.
 	void wait(uint64_t value);
 
-	// Wait until a certain amount of time has passed or until the specified value is signaled.
+	// Wait until a certain amount of time has passed or until the payload reaches the specified value.
 	template<class CLOCK, class DURATION>
 	VkResult wait(uint64_t value, const std::chrono::time_point<CLOCK, DURATION> end_ns);
 
-	// Set the payload to the specified value and signal all waiting threads.
+	// Block until any, or all, of the semaphores' payloads reach their respective values.
+	static void Wait(uint32_t count, TimelineSemaphore *const *semaphores, const uint64_t *values, bool waitAny);
+
+	// Same as above, but gives up once end_ns has passed.
+	template<class CLOCK, class DURATION>
+	static VkResult Wait(uint32_t count, TimelineSemaphore *const *semaphores, const uint64_t *values, bool waitAny,
+	                     const std::chrono::time_point<CLOCK, DURATION> end_ns);
+
+	// Set the payload to the specified value and wake the threads waiting for it.
 	void signal(uint64_t value);
 
 	// Retrieve the current payload. This should not be used to make thread execution decisions
 	// as there's no guarantee that the value returned here matches the actual payload's value.
 	uint64_t getCounterValue();
 
-	// Dependent timeline semaphores allow an 'any' semaphore to be created that can wait on the
-	// state of multiple other timeline semaphores and be signaled like a binary semaphore
-	// if any of its parent semaphores are signaled with a certain value.
-	//
-	// Since a timeline semaphore can be signalled with nearly any value, but threads waiting
-	// on a timeline semaphore only unblock when a specific value is signaled, dependents can't
-	// naively become signaled whenever their parent semaphores are signaled with a new value.
-	// Instead, the dependent semaphore needs to wait for its parent semaphore to be signaled
-	// with a specific value as well. This specific value may differ for each parent semaphore.
-	//
-	// So this function adds other as a dependent semaphore, and tells it to only become unsignaled
-	// by this semaphore when this semaphore is signaled with waitValue.
-	void addDependent(TimelineSemaphore &other, uint64_t waitValue);
-	void addDependency(int id, uint64_t waitValue);
-
-	// Tells this semaphore to become signaled as part of a dependency chain when the parent semaphore
-	// with the specified id is signaled with the specified waitValue.
-	void addToWaitMap(int parentId, uint64_t waitValue);
-
 	// Clean up any allocated resources
 	void destroy(const VkAllocationCallbacks *pAllocator);
 
 private:
-	// Track the 64-bit payload. Timeline Semaphores have a shared_ptr<Shared>
-	// that they can pass to other Timeline Semaphores to create dependency chains.
-	struct Shared
+	// Returns true if any, or all, of the semaphores' payloads reached their respective values.
+	static bool Reached(uint32_t count, TimelineSemaphore *const *semaphores, const uint64_t *values, bool waitAny);
+
+	// A thread blocked on one or more timeline semaphores. Its nodes are linked into the
+	// wait list of each semaphore it waits on, and the signals which reach their values
+	// unlink them and wake the thread directly. A multi-semaphore wait is thus a single
+	// waiter rather than a chain of semaphores, and signals never look past their own list.
+	class Waiter
 	{
-	private:
-		// Guards access to all the resources that may be accessed by other threads.
-		// No clang Thread Safety Analysis is used on variables guarded by mutex
-		// as there is an issue with TSA. Despite instrumenting everything properly,
-		// compilation will fail when a lambda function uses a guarded resource.
-		marl::mutex mutex;
-
-		static std::atomic<int> nextId;
-
 	public:
-		Shared(marl::Allocator *allocator, uint64_t initialState);
+		Waiter(uint32_t count, TimelineSemaphore *const *semaphores, const uint64_t *values, bool waitAny);
+		~Waiter();
 
-		// Block until this semaphore is signaled with the specified value;
-		void wait(uint64_t value);
-		// Wait until a certain amount of time has passed or until the specified value is signaled.
-		template<class CLOCK, class DURATION>
-		VkResult wait(uint64_t value, const std::chrono::time_point<CLOCK, DURATION> end_ns);
+		void wait();
 
-		// Pass a signal down to a dependent.
-		void signal(int parentId, uint64_t value);
-		// Set the payload to the specified value and signal all waiting threads.
-		void signal(uint64_t value);
+		template<class CLOCK, class DURATION>
+		bool wait(const std::chrono::time_point<CLOCK, DURATION> end_ns);
 
-		// Retrieve the current payload. This should not be used to make thread execution decisions
-		// as there's no guarantee that the value returned here matches the actual payload's value.
-		uint64_t getCounterValue();
+	private:
+		friend class TimelineSemaphore;
 
-		// Add the other semaphore's Shared to deps.
-		void addDependent(TimelineSemaphore &other);
+		struct Node
+		{
+			TimelineSemaphore *semaphore = nullptr;
+			Waiter *waiter = nullptr;
+			uint64_t value = 0;
+			Node *prev = nullptr;
+			Node *next = nullptr;
+			bool linked = false;
+		};
 
-		// Add {id, waitValue} as a key-value pair to waitMap.
-		void addDependency(int id, uint64_t waitValue);
+		// Called by a semaphore which reached the value of one of the nodes.
+		void notify();
 
-		// Entry point to the marl threading library that handles blocking and unblocking.
+		marl::mutex mutex;
 		marl::ConditionVariable cv;
+		// Number of semaphores which still have to reach their value.
+		uint32_t pending GUARDED_BY(mutex) = 0;
+		marl::containers::vector<Node, 4> nodes;
+	};
 
-		// TODO(b/181683382) -- Add Thread Safety Analysis instrumentation when it can properly
-		// analyze lambdas.
-		// The 64-bit payload.
-		uint64_t counter;
-
-		// A list of this semaphore's dependents.
-		marl::containers::vector<std::shared_ptr<Shared>, 1> deps;
+	// Adds node to the wait list, unless the payload already reached its value.
+	void link(Waiter::Node *node);
+	// Removes node from the wait list, if it's still on it.
+	void unlink(Waiter::Node *node);
+	void unlinkLocked(Waiter::Node *node) REQUIRES(mutex);
 
-		// A map of {parentId: waitValue} pairs that tracks when this semaphore should unblock if it's
-		// signaled as a dependent by another semaphore.
-		std::map<int, uint64_t> waitMap;
+	// The 64-bit payload. It only increases, so it can be read without holding the mutex.
+	std::atomic<uint64_t> counter;
 
-		// An ID that's unique for each instance of Shared
-		const int id;
-	};
+	// Number of nodes in the wait list. Signals skip taking the mutex when it's zero.
+	std::atomic<uint32_t> waiterCount = { 0 };
 
-	std::shared_ptr<Shared> shared;
+	marl::mutex mutex;
+	Waiter::Node *waiters GUARDED_BY(mutex) = nullptr;
 };
 
 template<typename Clock, typename Duration>
 VkResult TimelineSemaphore::wait(uint64_t value,
                                  const std::chrono::time_point<Clock, Duration> timeout)
 {
-	return shared->wait(value, timeout);
+	TimelineSemaphore *semaphore = this;
+	return Wait(1, &semaphore, &value, false, timeout);
 }
 
 template<typename Clock, typename Duration>
-VkResult TimelineSemaphore::Shared::wait(uint64_t value,
-                                         const std::chrono::time_point<Clock, Duration> timeout)
+VkResult TimelineSemaphore::Wait(uint32_t count, TimelineSemaphore *const *semaphores, const uint64_t *values, bool waitAny,
+                                 const std::chrono::time_point<Clock, Duration> timeout)
 {
-	marl::lock lock(mutex);
-	if(!cv.wait_until(lock, timeout, [&]() { return counter == value; }))
+	if(Reached(count, semaphores, values, waitAny))
 	{
-		return VK_TIMEOUT;
+		return VK_SUCCESS;
 	}
-	return VK_SUCCESS;
+
+	Waiter waiter(count, semaphores, values, waitAny);
+	return waiter.wait(timeout) ? VK_SUCCESS : VK_TIMEOUT;
+}
+
+template<typename Clock, typename Duration>
+bool TimelineSemaphore::Waiter::wait(const std::chrono::time_point<Clock, Duration> timeout)
+{
+	marl::lock lock(mutex);
+	return cv.wait_until(lock, timeout, [&]() REQUIRES(mutex) { return pending == 0; });
 }
 
 }  // namespace vk
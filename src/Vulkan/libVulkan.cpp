@@ -91,10 +91,12 @@
 
 #include "Reactor/Nucleus.hpp"
 
+#include "marl/defer.h"
 #include "marl/mutex.h"
 #include "marl/scheduler.h"
 #include "marl/thread.h"
 #include "marl/tsa.h"
+#include "marl/waitgroup.h"
 
 #include "System/CPUID.hpp"
 
@@ -182,6 +184,39 @@ void initializeLibrary()
 	(void)doOnce;
 }
 
+// compilePipelines() calls compile(i) for each pipeline of a vkCreate*Pipelines()
+// call. The pipelines are compiled concurrently on the device's scheduler, and
+// the stages of each pipeline may be further split into tasks. Each call only
+// writes to its own pipeline, so the results don't depend on scheduling order.
+template<typename Function>
+void compilePipelines(vk::Device *device, uint32_t count, Function &&compile)
+{
+	// The application's thread must be bound to the scheduler to enqueue tasks.
+	marl::Scheduler *scheduler = device->getScheduler();
+	bool bind = (marl::Scheduler::get() == nullptr);
+	if(bind)
+	{
+		scheduler->bind();
+	}
+	defer(if(bind) { marl::Scheduler::unbind(); });
+
+	if(count == 1)
+	{
+		compile(0);
+		return;
+	}
+
+	marl::WaitGroup wg(count);
+	for(uint32_t i = 0; i < count; i++)
+	{
+		marl::schedule([&compile, wg, i] {
+			defer(wg.done());
+			compile(i);
+		});
+	}
+	wg.wait();
+}
+
 template<class T>
 void ValidateRenderPassPNextChain(VkDevice device, const T *pCreateInfo)
 {
@@ -396,6 +431,9 @@ static const ExtensionProperties deviceExtensionProperties[] = {
 #if SWIFTSHADER_EXTERNAL_MEMORY_OPAQUE_FD
 	{ { VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME, VK_KHR_EXTERNAL_MEMORY_FD_SPEC_VERSION } },
 #endif
+#if SWIFTSHADER_EXTERNAL_MEMORY_DMA_BUF
+	{ { VK_EXT_EXTERNAL_MEMORY_DMA_BUF_EXTENSION_NAME, VK_EXT_EXTERNAL_MEMORY_DMA_BUF_SPEC_VERSION } },
+#endif
 
 	{ { VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME, VK_EXT_EXTERNAL_MEMORY_HOST_SPEC_VERSION } },
 
@@ -416,6 +454,7 @@ static const ExtensionProperties deviceExtensionProperties[] = {
 	{ { VK_EXT_SCALAR_BLOCK_LAYOUT_EXTENSION_NAME, VK_EXT_SCALAR_BLOCK_LAYOUT_SPEC_VERSION } },
 	{ { VK_EXT_SEPARATE_STENCIL_USAGE_EXTENSION_NAME, VK_EXT_SEPARATE_STENCIL_USAGE_SPEC_VERSION } },
 	{ { VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME, VK_KHR_DEPTH_STENCIL_RESOLVE_SPEC_VERSION } },
+	{ { VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME, VK_KHR_DRAW_INDIRECT_COUNT_SPEC_VERSION } },
 	{ { VK_KHR_IMAGE_FORMAT_LIST_EXTENSION_NAME, VK_KHR_IMAGE_FORMAT_LIST_SPEC_VERSION } },
 	{ { VK_KHR_IMAGELESS_FRAMEBUFFER_EXTENSION_NAME, VK_KHR_IMAGELESS_FRAMEBUFFER_SPEC_VERSION } },
 	{ { VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME, VK_KHR_SHADER_FLOAT_CONTROLS_SPEC_VERSION } },
@@ -868,6 +907,14 @@ VKAPI_ATTR VkResult VKAPI_CALL vkCreateDevice(VkPhysicalDevice physicalDevice, c
 				(void)hostQueryResetFeatures->hostQueryReset;
 				break;
 			}
+			case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES:
+			{
+				const VkPhysicalDeviceTimelineSemaphoreFeatures *timelineSemaphoreFeatures = reinterpret_cast<const VkPhysicalDeviceTimelineSemaphoreFeatures *>(extensionCreateInfo);
+
+				// VK_KHR_timeline_semaphore is always enabled.
+				(void)timelineSemaphoreFeatures->timelineSemaphore;
+				break;
+			}
 			default:
 				// "the [driver] must skip over, without processing (other than reading the sType and pNext members) any structures in the chain with sType values not defined by [supported extenions]"
 				LOG_TRAP("pCreateInfo->pNext sType = %s", vk::Stringify(extensionCreateInfo->sType).c_str());
@@ -1037,10 +1084,16 @@ VKAPI_ATTR VkResult VKAPI_CALL vkAllocateMemory(VkDevice device, const VkMemoryA
 			case VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR:
 			{
 				auto *importInfo = reinterpret_cast<const VkImportMemoryFdInfoKHR *>(allocationInfo);
-				if(importInfo->handleType != VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT)
+				switch(importInfo->handleType)
 				{
-					UNSUPPORTED("importInfo->handleType %u", importInfo->handleType);
-					return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+					case VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT:
+#	if SWIFTSHADER_EXTERNAL_MEMORY_DMA_BUF
+					case VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT:
+#	endif
+						break;
+					default:
+						UNSUPPORTED("importInfo->handleType %u", importInfo->handleType);
+						return VK_ERROR_INVALID_EXTERNAL_HANDLE;
 				}
 				break;
 			}
@@ -1147,10 +1200,16 @@ VKAPI_ATTR VkResult VKAPI_CALL vkGetMemoryFdPropertiesKHR(VkDevice device, VkExt
 	TRACE("(VkDevice device = %p, VkExternalMemoryHandleTypeFlagBits handleType = %x, int fd = %d, VkMemoryFdPropertiesKHR* pMemoryFdProperties = %p)",
 	      device, handleType, fd, pMemoryFdProperties);
 
-	if(handleType != VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT)
+	switch(handleType)
 	{
-		UNSUPPORTED("handleType %u", handleType);
-		return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+		case VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT:
+#	if SWIFTSHADER_EXTERNAL_MEMORY_DMA_BUF
+		case VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT:
+#	endif
+			break;
+		default:
+			UNSUPPORTED("handleType %u", handleType);
+			return VK_ERROR_INVALID_EXTERNAL_HANDLE;
 	}
 
 	if(fd < 0)
@@ -1217,7 +1276,11 @@ VKAPI_ATTR VkResult VKAPI_CALL vkGetMemoryHostPointerPropertiesEXT(VkDevice devi
 		UNSUPPORTED("handleType %u", handleType);
 		return VK_ERROR_INVALID_EXTERNAL_HANDLE;
 	}
-	pMemoryHostPointerProperties->memoryTypeBits = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	const VkPhysicalDeviceMemoryProperties &memoryProperties =
+	    vk::PhysicalDevice::GetMemoryProperties();
+
+	// All SwiftShader memory types are host visible and can wrap host memory.
+	pMemoryHostPointerProperties->memoryTypeBits = (1U << memoryProperties.memoryTypeCount) - 1U;
 
 	return VK_SUCCESS;
 }
@@ -1982,11 +2045,7 @@ VKAPI_ATTR VkResult VKAPI_CALL vkCreateGraphicsPipelines(VkDevice device, VkPipe
 	{
 		VkResult result = vk::GraphicsPipeline::Create(pAllocator, &pCreateInfos[i], &pPipelines[i], vk::Cast(device));
 
-		if(result == VK_SUCCESS)
-		{
-			static_cast<vk::GraphicsPipeline *>(vk::Cast(pPipelines[i]))->compileShaders(pAllocator, &pCreateInfos[i], vk::Cast(pipelineCache));
-		}
-		else
+		if(result != VK_SUCCESS)
 		{
 			// According to the Vulkan spec, section 9.4. Multiple Pipeline Creation
 			// "When an application attempts to create many pipelines in a single command,
@@ -2001,6 +2060,13 @@ VKAPI_ATTR VkResult VKAPI_CALL vkCreateGraphicsPipelines(VkDevice device, VkPipe
 		}
 	}
 
+	compilePipelines(vk::Cast(device), createInfoCount, [&](uint32_t i) {
+		if(pPipelines[i] != VK_NULL_HANDLE)
+		{
+			static_cast<vk::GraphicsPipeline *>(vk::Cast(pPipelines[i]))->compileShaders(pAllocator, &pCreateInfos[i], vk::Cast(pipelineCache));
+		}
+	});
+
 	return errorResult;
 }
 
@@ -2014,11 +2080,7 @@ VKAPI_ATTR VkResult VKAPI_CALL vkCreateComputePipelines(VkDevice device, VkPipel
 	{
 		VkResult result = vk::ComputePipeline::Create(pAllocator, &pCreateInfos[i], &pPipelines[i], vk::Cast(device));
 
-		if(result == VK_SUCCESS)
-		{
-			static_cast<vk::ComputePipeline *>(vk::Cast(pPipelines[i]))->compileShaders(pAllocator, &pCreateInfos[i], vk::Cast(pipelineCache));
-		}
-		else
+		if(result != VK_SUCCESS)
 		{
 			// According to the Vulkan spec, section 9.4. Multiple Pipeline Creation
 			// "When an application attempts to create many pipelines in a single command,
@@ -2033,6 +2095,13 @@ VKAPI_ATTR VkResult VKAPI_CALL vkCreateComputePipelines(VkDevice device, VkPipel
 		}
 	}
 
+	compilePipelines(vk::Cast(device), createInfoCount, [&](uint32_t i) {
+		if(pPipelines[i] != VK_NULL_HANDLE)
+		{
+			static_cast<vk::ComputePipeline *>(vk::Cast(pPipelines[i]))->compileShaders(pAllocator, &pCreateInfos[i], vk::Cast(pipelineCache));
+		}
+	});
+
 	return errorResult;
 }
 
@@ -2526,6 +2595,22 @@ VKAPI_ATTR void VKAPI_CALL vkCmdDrawIndexedIndirect(VkCommandBuffer commandBuffe
 	vk::Cast(commandBuffer)->drawIndexedIndirect(vk::Cast(buffer), offset, drawCount, stride);
 }
 
+VKAPI_ATTR void VKAPI_CALL vkCmdDrawIndirectCount(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countBufferOffset, uint32_t maxDrawCount, uint32_t stride)
+{
+	TRACE("(VkCommandBuffer commandBuffer = %p, VkBuffer buffer = %p, VkDeviceSize offset = %d, VkBuffer countBuffer = %p, VkDeviceSize countBufferOffset = %d, uint32_t maxDrawCount = %d, uint32_t stride = %d)",
+	      commandBuffer, static_cast<void *>(buffer), int(offset), static_cast<void *>(countBuffer), int(countBufferOffset), int(maxDrawCount), int(stride));
+
+	vk::Cast(commandBuffer)->drawIndirectCount(vk::Cast(buffer), offset, vk::Cast(countBuffer), countBufferOffset, maxDrawCount, stride);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDrawIndexedIndirectCount(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countBufferOffset, uint32_t maxDrawCount, uint32_t stride)
+{
+	TRACE("(VkCommandBuffer commandBuffer = %p, VkBuffer buffer = %p, VkDeviceSize offset = %d, VkBuffer countBuffer = %p, VkDeviceSize countBufferOffset = %d, uint32_t maxDrawCount = %d, uint32_t stride = %d)",
+	      commandBuffer, static_cast<void *>(buffer), int(offset), static_cast<void *>(countBuffer), int(countBufferOffset), int(maxDrawCount), int(stride));
+
+	vk::Cast(commandBuffer)->drawIndexedIndirectCount(vk::Cast(buffer), offset, vk::Cast(countBuffer), countBufferOffset, maxDrawCount, stride);
+}
+
 VKAPI_ATTR void VKAPI_CALL vkCmdDispatch(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
 {
 	TRACE("(VkCommandBuffer commandBuffer = %p, uint32_t groupCountX = %d, uint32_t groupCountY = %d, uint32_t groupCountZ = %d)",
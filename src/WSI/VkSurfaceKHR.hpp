@@ -19,6 +19,8 @@
 #include "Vulkan/VkObject.hpp"
 #include "Vulkan/VulkanPlatform.hpp"
 
+#include "marl/mutex.h"
+
 #include <vector>
 
 namespace vk {
@@ -46,6 +48,7 @@ public:
 	const Image *getImage() const { return image; }
 	DeviceMemory *getImageMemory() const { return imageMemory; }
 	bool isAvailable() const { return (imageStatus == AVAILABLE); }
+	PresentImageStatus getStatus() const { return imageStatus; }
 	bool exists() const { return (imageStatus != NONEXISTENT); }
 	void setStatus(PresentImageStatus status) { imageStatus = status; }
 
@@ -87,10 +90,26 @@ public:
 
 	VkResult getPresentRectangles(uint32_t *pRectCount, VkRect2D *pRects) const;
 
+	// Returns memory which the presentation engine reads from directly, for
+	// the image to be bound to, so that present() doesn't have to copy it.
+	// Returns nullptr if the image should have memory of its own. The memory
+	// remains valid until detachImage() is called for the image.
+	virtual void *allocateImageMemory(PresentImage *image, size_t size) { return nullptr; }
+
 	virtual void attachImage(PresentImage *image) = 0;
 	virtual void detachImage(PresentImage *image) = 0;
 	virtual VkResult present(PresentImage *image) = 0;
 
+	// Returns true if present() may be called from the queue's thread rather
+	// than the application's. Surfaces which share a connection with the
+	// application that isn't safe to use concurrently must return false.
+	virtual bool canPresentAsync() const { return true; }
+
+	// Presentation may happen on the queue's thread while the application
+	// attaches or detaches images, so callers must hold this mutex when
+	// calling attachImage(), detachImage() and present().
+	marl::mutex &getMutex() { return mutex; }
+
 	void associateSwapchain(SwapchainKHR *swapchain);
 	void disassociateSwapchain();
 	bool hasAssociatedSwapchain();
@@ -100,6 +119,7 @@ protected:
 
 private:
 	SwapchainKHR *associatedSwapchain = nullptr;
+	marl::mutex mutex;
 };
 
 static inline SurfaceKHR *Cast(VkSurfaceKHR object)
@@ -20,6 +20,7 @@
 #include "Vulkan/VkSemaphore.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <cstring>
 
 namespace vk {
@@ -35,11 +36,21 @@ SwapchainKHR::SwapchainKHR(const VkSwapchainCreateInfoKHR *pCreateInfo, void *me
 
 void SwapchainKHR::destroy(const VkAllocationCallbacks *pAllocator)
 {
+	marl::lock lock(mutex);
+
+	// Deferred presents may still be reading from the images.
+	imagePresented.wait(lock, [this]() REQUIRES(mutex) {
+		return std::none_of(images, images + imageCount, [](const PresentImage &image) {
+			return image.getStatus() == PRESENTING;
+		});
+	});
+
 	for(uint32_t i = 0; i < imageCount; i++)
 	{
 		PresentImage &currentImage = images[i];
 		if(currentImage.exists())
 		{
+			marl::lock surfaceLock(surface->getMutex());
 			surface->detachImage(&currentImage);
 			currentImage.clear();
 		}
@@ -60,6 +71,8 @@ size_t SwapchainKHR::ComputeRequiredAllocationSize(const VkSwapchainCreateInfoKH
 
 void SwapchainKHR::retire()
 {
+	marl::lock lock(mutex);
+
 	if(!retired)
 	{
 		retired = true;
@@ -70,6 +83,7 @@ void SwapchainKHR::retire()
 			PresentImage &currentImage = images[i];
 			if(currentImage.isAvailable())
 			{
+				marl::lock surfaceLock(surface->getMutex());
 				surface->detachImage(&currentImage);
 				currentImage.clear();
 			}
@@ -134,10 +148,24 @@ VkResult SwapchainKHR::createImages(VkDevice device, const VkSwapchainCreateInfo
 		}
 
 		allocInfo.allocationSize = currentImage.getImage()->getMemoryRequirements().size;
+		allocInfo.pNext = nullptr;
+
+		marl::lock surfaceLock(surface->getMutex());
+
+		VkImportMemoryHostPointerInfoEXT importInfo = {};
+		importInfo.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT;
+		importInfo.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+		importInfo.pHostPointer = surface->allocateImageMemory(&currentImage, allocInfo.allocationSize);
+
+		if(importInfo.pHostPointer)
+		{
+			allocInfo.pNext = &importInfo;
+		}
 
 		status = currentImage.allocateAndBindImageMemory(device, allocInfo);
 		if(status != VK_SUCCESS)
 		{
+			surface->detachImage(&currentImage);
 			return status;
 		}
 
@@ -172,44 +200,115 @@ VkResult SwapchainKHR::getImages(uint32_t *pSwapchainImageCount, VkImage *pSwapc
 
 VkResult SwapchainKHR::getNextImage(uint64_t timeout, BinarySemaphore *semaphore, Fence *fence, uint32_t *pImageIndex)
 {
-	for(uint32_t i = 0; i < imageCount; i++)
+	marl::lock lock(mutex);
+
+	if(presentResult != VK_SUCCESS)
 	{
-		PresentImage &currentImage = images[i];
-		if(currentImage.isAvailable())
+		return presentResult;
+	}
+
+	auto findImage = [this]() REQUIRES(mutex) {
+		return std::find_if(images, images + imageCount, [](const PresentImage &image) {
+			return image.isAvailable();
+		});
+	};
+
+	auto isPresenting = [this]() REQUIRES(mutex) {
+		return std::any_of(images, images + imageCount, [](const PresentImage &image) {
+			return image.getStatus() == PRESENTING;
+		});
+	};
+
+	// Only wait if a deferred present will eventually release an image.
+	PresentImage *image = findImage();
+	if(image == images + imageCount && timeout > 0 && isPresenting())
+	{
+		auto ready = [&]() REQUIRES(mutex) {
+			image = findImage();
+			return image != images + imageCount || !isPresenting();
+		};
+
+		auto now = std::chrono::system_clock::now();
+		auto maxTimeout = std::chrono::nanoseconds::max() - now.time_since_epoch();
+		if(timeout >= static_cast<uint64_t>(maxTimeout.count()))
+		{
+			imagePresented.wait(lock, ready);
+		}
+		else
 		{
-			currentImage.setStatus(DRAWING);
-			*pImageIndex = i;
+			imagePresented.wait_until(lock, now + std::chrono::nanoseconds(timeout), ready);
+		}
+	}
 
-			if(semaphore)
-			{
-				semaphore->signal();
-			}
+	if(image == images + imageCount)
+	{
+		return (timeout > 0) ? VK_TIMEOUT : VK_NOT_READY;
+	}
 
-			if(fence)
-			{
-				fence->complete();
-			}
+	image->setStatus(DRAWING);
+	*pImageIndex = static_cast<uint32_t>(image - images);
 
-			return VK_SUCCESS;
-		}
+	if(semaphore)
+	{
+		semaphore->signal();
+	}
+
+	if(fence)
+	{
+		fence->complete();
+	}
+
+	return VK_SUCCESS;
+}
+
+VkResult SwapchainKHR::queuePresent(uint32_t index)
+{
+	marl::lock lock(mutex);
+
+	if(presentResult != VK_SUCCESS)
+	{
+		images[index].setStatus(AVAILABLE);
+		return presentResult;
 	}
 
-	return (timeout > 0) ? VK_TIMEOUT : VK_NOT_READY;
+	images[index].setStatus(PRESENTING);
+
+	return VK_SUCCESS;
 }
 
 VkResult SwapchainKHR::present(uint32_t index)
 {
 	auto &image = images[index];
-	image.setStatus(PRESENTING);
-	VkResult result = surface->present(&image);
+	ASSERT(image.getStatus() == PRESENTING);
+
+	// Surfaces read the image's memory directly, so a pending clear has to be written first
+	image.getImage()->prepareForTransfer({ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 });
+
+	VkResult result = VK_SUCCESS;
+	{
+		marl::lock surfaceLock(surface->getMutex());
+		result = surface->present(&image);
+	}
+
+	marl::lock lock(mutex);
 	image.setStatus(AVAILABLE);
 
+	// Errors are reported by the next call to vkQueuePresentKHR() or
+	// vkAcquireNextImageKHR() if the present was deferred.
+	if(result < VK_SUCCESS && presentResult == VK_SUCCESS)
+	{
+		presentResult = result;
+	}
+
 	if(retired)
 	{
+		marl::lock surfaceLock(surface->getMutex());
 		surface->detachImage(&image);
 		image.clear();
 	}
 
+	imagePresented.notify_all();
+
 	return result;
 }
 
@@ -19,6 +19,10 @@
 #include "Vulkan/VkImage.hpp"
 #include "Vulkan/VkObject.hpp"
 
+#include "marl/conditionvariable.h"
+#include "marl/mutex.h"
+#include "marl/tsa.h"
+
 #include <vector>
 
 namespace vk {
@@ -44,14 +48,23 @@ public:
 
 	VkResult getNextImage(uint64_t timeout, BinarySemaphore *semaphore, Fence *fence, uint32_t *pImageIndex);
 
+	// queuePresent() hands the image over to the presentation engine. If the
+	// presentation is deferred, the image is only made available for
+	// acquisition again once present() has been called for it.
+	VkResult queuePresent(uint32_t index);
 	VkResult present(uint32_t index);
+	bool canPresentAsync() const { return surface->canPresentAsync(); }
 	PresentImage const &getImage(uint32_t imageIndex) { return images[imageIndex]; }
 
 private:
 	SurfaceKHR *surface = nullptr;
 	PresentImage *images = nullptr;
 	uint32_t imageCount = 0;
-	bool retired = false;
+
+	marl::mutex mutex;
+	marl::ConditionVariable imagePresented;
+	bool retired GUARDED_BY(mutex) = false;
+	VkResult presentResult GUARDED_BY(mutex) = VK_SUCCESS;  // First error of a deferred present
 
 	void resetImages();
 };
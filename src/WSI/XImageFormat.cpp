@@ -0,0 +1,86 @@
+// Copyright 2021 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "XImageFormat.hpp"
+
+namespace {
+
+// Channel scales 8-bit channel values to the bits of a visual's mask.
+struct Channel
+{
+	explicit Channel(uint32_t mask)
+	{
+		if(mask != 0)
+		{
+			while(((mask >> shift) & 1) == 0)
+			{
+				shift++;
+			}
+
+			max = mask >> shift;
+		}
+	}
+
+	uint32_t scale(uint8_t c) const
+	{
+		return ((c * max + 127) / 255) << shift;
+	}
+
+	int shift = 0;
+	uint32_t max = 0;
+};
+
+}  // anonymous namespace
+
+namespace vk {
+
+bool XImageFormat::isB8G8R8X8() const
+{
+	// Pixels are read from memory as B, G, R, X bytes in increasing order.
+	return bitsPerPixel == 32 && lsbFirst &&
+	       redMask == 0x00FF0000 && greenMask == 0x0000FF00 && blueMask == 0x000000FF;
+}
+
+size_t XImageFormat::pitch(uint32_t width) const
+{
+	size_t bits = static_cast<size_t>(width) * bitsPerPixel;
+	return (bits + scanlinePad - 1) / scanlinePad * scanlinePad / 8;
+}
+
+void XImageFormat::convert(uint8_t *dst, size_t dstPitch, const uint8_t *src, size_t srcPitch, uint32_t width, uint32_t height) const
+{
+	const Channel red(redMask);
+	const Channel green(greenMask);
+	const Channel blue(blueMask);
+	const int bytesPerPixel = bitsPerPixel / 8;
+
+	for(uint32_t y = 0; y < height; y++)
+	{
+		const uint8_t *s = src + y * srcPitch;
+		uint8_t *d = dst + y * dstPitch;
+
+		for(uint32_t x = 0; x < width; x++, s += 4, d += bytesPerPixel)
+		{
+			uint32_t pixel = red.scale(s[2]) | green.scale(s[1]) | blue.scale(s[0]);
+
+			for(int i = 0; i < bytesPerPixel; i++)
+			{
+				int byte = lsbFirst ? i : (bytesPerPixel - 1 - i);
+				d[byte] = static_cast<uint8_t>(pixel >> (8 * i));
+			}
+		}
+	}
+}
+
+}  // namespace vk
@@ -0,0 +1,47 @@
+// Copyright 2021 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SWIFTSHADER_XIMAGEFORMAT_HPP_
+#define SWIFTSHADER_XIMAGEFORMAT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vk {
+
+// XImageFormat describes the pixels of a window's ZPixmap images, which the
+// B8G8R8A8 swapchain images are presented as.
+struct XImageFormat
+{
+	uint32_t redMask = 0x00FF0000;
+	uint32_t greenMask = 0x0000FF00;
+	uint32_t blueMask = 0x000000FF;
+	int bitsPerPixel = 32;
+	int scanlinePad = 32;  // Rows are padded to a multiple of this many bits
+	bool lsbFirst = true;  // Image byte order of the server
+
+	// Returns the size of a row of |width| pixels, in bytes.
+	size_t pitch(uint32_t width) const;
+
+	// Returns true if B8G8R8A8 pixels are in this format already, so images
+	// can be presented without converting them.
+	bool isB8G8R8X8() const;
+
+	// Converts |height| rows of |width| B8G8R8A8 pixels to this format.
+	void convert(uint8_t *dst, size_t dstPitch, const uint8_t *src, size_t srcPitch, uint32_t width, uint32_t height) const;
+};
+
+}  // namespace vk
+
+#endif  // SWIFTSHADER_XIMAGEFORMAT_HPP_
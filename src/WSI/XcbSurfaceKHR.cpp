@@ -19,7 +19,12 @@
 
 #include "System/SharedLibrary.hpp"
 
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include <cstring>
 #include <memory>
+#include <vector>
 
 namespace {
 
@@ -31,15 +36,36 @@ void getFuncAddress(void *lib, const char *name, FPTR *out)
 
 struct LibXcbExports
 {
-	LibXcbExports(void *lib)
+	LibXcbExports(void *lib, void *libShm)
 	{
 		getFuncAddress(lib, "xcb_create_gc", &xcb_create_gc);
 		getFuncAddress(lib, "xcb_flush", &xcb_flush);
 		getFuncAddress(lib, "xcb_free_gc", &xcb_free_gc);
 		getFuncAddress(lib, "xcb_generate_id", &xcb_generate_id);
+		getFuncAddress(lib, "xcb_get_extension_data", &xcb_get_extension_data);
 		getFuncAddress(lib, "xcb_get_geometry", &xcb_get_geometry);
 		getFuncAddress(lib, "xcb_get_geometry_reply", &xcb_get_geometry_reply);
+		getFuncAddress(lib, "xcb_get_window_attributes", &xcb_get_window_attributes);
+		getFuncAddress(lib, "xcb_get_window_attributes_reply", &xcb_get_window_attributes_reply);
+		getFuncAddress(lib, "xcb_get_setup", &xcb_get_setup);
+		getFuncAddress(lib, "xcb_setup_roots_iterator", &xcb_setup_roots_iterator);
+		getFuncAddress(lib, "xcb_screen_next", &xcb_screen_next);
+		getFuncAddress(lib, "xcb_screen_allowed_depths_iterator", &xcb_screen_allowed_depths_iterator);
+		getFuncAddress(lib, "xcb_depth_next", &xcb_depth_next);
+		getFuncAddress(lib, "xcb_depth_visuals_iterator", &xcb_depth_visuals_iterator);
+		getFuncAddress(lib, "xcb_visualtype_next", &xcb_visualtype_next);
+		getFuncAddress(lib, "xcb_setup_pixmap_formats_iterator", &xcb_setup_pixmap_formats_iterator);
+		getFuncAddress(lib, "xcb_format_next", &xcb_format_next);
 		getFuncAddress(lib, "xcb_put_image", &xcb_put_image);
+		getFuncAddress(lib, "xcb_request_check", &xcb_request_check);
+
+		if(libShm)
+		{
+			getFuncAddress(libShm, "xcb_shm_id", &xcb_shm_id);
+			getFuncAddress(libShm, "xcb_shm_attach_checked", &xcb_shm_attach_checked);
+			getFuncAddress(libShm, "xcb_shm_detach", &xcb_shm_detach);
+			getFuncAddress(libShm, "xcb_shm_put_image", &xcb_shm_put_image);
+		}
 	}
 
 	xcb_void_cookie_t (*xcb_create_gc)(xcb_connection_t *c, xcb_gcontext_t cid, xcb_drawable_t drawable, uint32_t value_mask, const void *value_list);
@@ -48,7 +74,28 @@ struct LibXcbExports
 	uint32_t (*xcb_generate_id)(xcb_connection_t *c);
 	xcb_get_geometry_cookie_t (*xcb_get_geometry)(xcb_connection_t *c, xcb_drawable_t drawable);
 	xcb_get_geometry_reply_t *(*xcb_get_geometry_reply)(xcb_connection_t *c, xcb_get_geometry_cookie_t cookie, xcb_generic_error_t **e);
+	xcb_get_window_attributes_cookie_t (*xcb_get_window_attributes)(xcb_connection_t *c, xcb_window_t window);
+	xcb_get_window_attributes_reply_t *(*xcb_get_window_attributes_reply)(xcb_connection_t *c, xcb_get_window_attributes_cookie_t cookie, xcb_generic_error_t **e);
+	const xcb_setup_t *(*xcb_get_setup)(xcb_connection_t *c);
+	xcb_screen_iterator_t (*xcb_setup_roots_iterator)(const xcb_setup_t *R);
+	void (*xcb_screen_next)(xcb_screen_iterator_t *i);
+	xcb_depth_iterator_t (*xcb_screen_allowed_depths_iterator)(const xcb_screen_t *R);
+	void (*xcb_depth_next)(xcb_depth_iterator_t *i);
+	xcb_visualtype_iterator_t (*xcb_depth_visuals_iterator)(const xcb_depth_t *R);
+	void (*xcb_visualtype_next)(xcb_visualtype_iterator_t *i);
+	xcb_format_iterator_t (*xcb_setup_pixmap_formats_iterator)(const xcb_setup_t *R);
+	void (*xcb_format_next)(xcb_format_iterator_t *i);
 	xcb_void_cookie_t (*xcb_put_image)(xcb_connection_t *c, uint8_t format, xcb_drawable_t drawable, xcb_gcontext_t gc, uint16_t width, uint16_t height, int16_t dst_x, int16_t dst_y, uint8_t left_pad, uint8_t depth, uint32_t data_len, const uint8_t *data);
+	const xcb_query_extension_reply_t *(*xcb_get_extension_data)(xcb_connection_t *c, xcb_extension_t *ext);
+	xcb_generic_error_t *(*xcb_request_check)(xcb_connection_t *c, xcb_void_cookie_t cookie);
+
+	// MIT-SHM, from libxcb-shm. Null if the library isn't available.
+	// xcb/shm.h is an optional development package, so segments are passed
+	// as the uint32_t that xcb_shm_seg_t is defined as.
+	xcb_extension_t *xcb_shm_id = nullptr;
+	xcb_void_cookie_t (*xcb_shm_attach_checked)(xcb_connection_t *c, uint32_t shmseg, uint32_t shmid, uint8_t read_only) = nullptr;
+	xcb_void_cookie_t (*xcb_shm_detach)(xcb_connection_t *c, uint32_t shmseg) = nullptr;
+	xcb_void_cookie_t (*xcb_shm_put_image)(xcb_connection_t *c, xcb_drawable_t drawable, xcb_gcontext_t gc, uint16_t total_width, uint16_t total_height, uint16_t src_x, uint16_t src_y, uint16_t src_width, uint16_t src_height, int16_t dst_x, int16_t dst_y, uint8_t depth, uint8_t format, uint8_t send_event, uint32_t shmseg, uint32_t offset) = nullptr;
 };
 
 class LibXcb
@@ -68,14 +115,16 @@ private:
 	LibXcbExports *loadExports()
 	{
 		static auto exports = [] {
+			void *libShm = getProcAddress(RTLD_DEFAULT, "xcb_shm_id") ? RTLD_DEFAULT : loadLibrary("libxcb-shm.so.0");
+
 			if(getProcAddress(RTLD_DEFAULT, "xcb_create_gc"))
 			{
-				return std::make_unique<LibXcbExports>(RTLD_DEFAULT);
+				return std::make_unique<LibXcbExports>(RTLD_DEFAULT, libShm);
 			}
 
 			if(auto lib = loadLibrary("libxcb.so.1"))
 			{
-				return std::make_unique<LibXcbExports>(lib);
+				return std::make_unique<LibXcbExports>(lib, libShm);
 			}
 
 			return std::unique_ptr<LibXcbExports>();
@@ -105,6 +154,51 @@ VkExtent2D getWindowSize(xcb_connection_t *connection, xcb_window_t window)
 	return windowExtent;
 }
 
+// Returns the format of the window's images, and sets |depth| to its depth.
+vk::XImageFormat getWindowFormat(xcb_connection_t *connection, xcb_window_t window, uint8_t *depth)
+{
+	vk::XImageFormat format;
+
+	auto attributes = libXcb->xcb_get_window_attributes_reply(connection, libXcb->xcb_get_window_attributes(connection, window), nullptr);
+	if(!attributes)
+	{
+		return format;
+	}
+
+	const xcb_setup_t *setup = libXcb->xcb_get_setup(connection);
+	format.lsbFirst = (setup->image_byte_order == XCB_IMAGE_ORDER_LSB_FIRST);
+
+	for(auto screen = libXcb->xcb_setup_roots_iterator(setup); screen.rem; libXcb->xcb_screen_next(&screen))
+	{
+		for(auto d = libXcb->xcb_screen_allowed_depths_iterator(screen.data); d.rem; libXcb->xcb_depth_next(&d))
+		{
+			for(auto visual = libXcb->xcb_depth_visuals_iterator(d.data); visual.rem; libXcb->xcb_visualtype_next(&visual))
+			{
+				if(visual.data->visual_id == attributes->visual)
+				{
+					*depth = d.data->depth;
+					format.redMask = visual.data->red_mask;
+					format.greenMask = visual.data->green_mask;
+					format.blueMask = visual.data->blue_mask;
+				}
+			}
+		}
+	}
+
+	free(attributes);
+
+	for(auto pixmapFormat = libXcb->xcb_setup_pixmap_formats_iterator(setup); pixmapFormat.rem; libXcb->xcb_format_next(&pixmapFormat))
+	{
+		if(pixmapFormat.data->depth == *depth)
+		{
+			format.bitsPerPixel = pixmapFormat.data->bits_per_pixel;
+			format.scanlinePad = pixmapFormat.data->scanline_pad;
+		}
+	}
+
+	return format;
+}
+
 }  // anonymous namespace
 
 namespace vk {
@@ -118,6 +212,15 @@ XcbSurfaceKHR::XcbSurfaceKHR(const VkXcbSurfaceCreateInfoKHR *pCreateInfo, void
     : connection(pCreateInfo->connection)
     , window(pCreateInfo->window)
 {
+	// Sending a request for an extension the server doesn't support would
+	// shut down the connection, so check for it first.
+	if(libXcb->xcb_shm_id)
+	{
+		auto extension = libXcb->xcb_get_extension_data(connection, libXcb->xcb_shm_id);
+		mitShm = extension && extension->present;
+	}
+
+	format = getWindowFormat(connection, window, &depth);
 }
 
 void XcbSurfaceKHR::destroySurface(const VkAllocationCallbacks *pAllocator)
@@ -141,6 +244,71 @@ VkResult XcbSurfaceKHR::getSurfaceCapabilities(VkSurfaceCapabilitiesKHR *pSurfac
 	return VK_SUCCESS;
 }
 
+XcbSurfaceKHR::SharedMemory XcbSurfaceKHR::createSharedMemory(size_t size)
+{
+	SharedMemory shm;
+
+	int id = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+	if(id < 0)
+	{
+		return shm;
+	}
+
+	void *address = shmat(id, nullptr, 0);
+	if(address == reinterpret_cast<void *>(-1))
+	{
+		shmctl(id, IPC_RMID, nullptr);
+		return shm;
+	}
+
+	uint32_t segment = libXcb->xcb_generate_id(connection);
+	xcb_generic_error_t *error = libXcb->xcb_request_check(connection, libXcb->xcb_shm_attach_checked(connection, segment, id, 1));
+
+	// The segment is destroyed once both the server and this process have
+	// detached from it, or if the attach failed.
+	shmctl(id, IPC_RMID, nullptr);
+
+	if(error)
+	{
+		// Most likely a remote connection, which can't share memory.
+		free(error);
+		shmdt(address);
+		mitShm = false;
+		return shm;
+	}
+
+	shm.segment = segment;
+	shm.address = address;
+
+	return shm;
+}
+
+void XcbSurfaceKHR::destroySharedMemory(const SharedMemory &shm)
+{
+	libXcb->xcb_shm_detach(connection, shm.segment);
+	shmdt(shm.address);
+}
+
+void *XcbSurfaceKHR::allocateImageMemory(PresentImage *image, size_t size)
+{
+	// The server can read images from their own memory if they don't need to
+	// be converted.
+	if(!mitShm || !format.isB8G8R8X8())
+	{
+		return nullptr;
+	}
+
+	SharedMemory shm = createSharedMemory(size);
+	if(!shm.address)
+	{
+		return nullptr;
+	}
+
+	sharedMemory[image] = shm;
+
+	return shm.address;
+}
+
 void XcbSurfaceKHR::attachImage(PresentImage *image)
 {
 	auto gc = libXcb->xcb_generate_id(connection);
@@ -149,6 +317,18 @@ void XcbSurfaceKHR::attachImage(PresentImage *image)
 	libXcb->xcb_create_gc(connection, gc, window, XCB_GC_FOREGROUND | XCB_GC_BACKGROUND, values);
 
 	graphicsContexts[image] = gc;
+
+	if(mitShm && (sharedMemory.find(image) == sharedMemory.end()))
+	{
+		// Images are converted into a segment of their own.
+		const VkExtent3D &extent = image->getImage()->getExtent();
+
+		SharedMemory shm = createSharedMemory(extent.height * format.pitch(extent.width));
+		if(shm.address)
+		{
+			sharedMemory[image] = shm;
+		}
+	}
 }
 
 void XcbSurfaceKHR::detachImage(PresentImage *image)
@@ -159,6 +339,13 @@ void XcbSurfaceKHR::detachImage(PresentImage *image)
 		libXcb->xcb_free_gc(connection, it->second);
 		graphicsContexts.erase(it);
 	}
+
+	auto shm = sharedMemory.find(image);
+	if(shm != sharedMemory.end())
+	{
+		destroySharedMemory(shm->second);
+		sharedMemory.erase(shm);
+	}
 }
 
 VkResult XcbSurfaceKHR::present(PresentImage *image)
@@ -174,18 +361,64 @@ VkResult XcbSurfaceKHR::present(PresentImage *image)
 			return VK_ERROR_OUT_OF_DATE_KHR;
 		}
 
-		// TODO: Convert image if not RGB888.
 		int stride = image->getImage()->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
 		auto buffer = reinterpret_cast<uint8_t *>(image->getImageMemory()->getOffsetPointer(0));
+		size_t pitch = format.pitch(extent.width);
+
+		auto shm = sharedMemory.find(image);
+		if(shm != sharedMemory.end())
+		{
+			// The image is bound to the segment, unless it needs converting.
+			uint16_t totalWidth = stride * 8 / format.bitsPerPixel;
+
+			if(shm->second.address != buffer)
+			{
+				// The server is done reading the segment of the previous present
+				// of this image, as it already replied to the geometry request.
+				format.convert(static_cast<uint8_t *>(shm->second.address), pitch, buffer, stride, extent.width, extent.height);
+				totalWidth = extent.width;
+			}
+
+			libXcb->xcb_shm_put_image(
+			    connection,
+			    window,
+			    it->second,
+			    totalWidth, extent.height,    // total width, height
+			    0, 0,                         // src x, y
+			    extent.width, extent.height,  // src width, height
+			    0, 0,                         // dst x, y
+			    depth,
+			    XCB_IMAGE_FORMAT_Z_PIXMAP,
+			    0,  // send_event
+			    shm->second.segment,
+			    0  // offset
+			);
+
+			libXcb->xcb_flush(connection);
+
+			return VK_SUCCESS;
+		}
+
+		// Rows are put whole, and clipped to the window.
+		std::vector<uint8_t> converted;
 		size_t bufferSize = extent.height * stride;
-		constexpr int depth = 24;  // TODO: Actually use window display depth.
+		uint16_t totalWidth = stride * 8 / format.bitsPerPixel;
+
+		if(!format.isB8G8R8X8())
+		{
+			converted.resize(extent.height * pitch);
+			format.convert(converted.data(), pitch, buffer, stride, extent.width, extent.height);
+			buffer = converted.data();
+			bufferSize = converted.size();
+			totalWidth = extent.width;
+		}
 
 		libXcb->xcb_put_image(
 		    connection,
 		    XCB_IMAGE_FORMAT_Z_PIXMAP,
 		    window,
 		    it->second,
-		    extent.width,
+		    totalWidth,
 		    extent.height,
 		    0, 0,  // dst x, y
 		    0,     // left_pad
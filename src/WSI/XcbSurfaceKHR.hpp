@@ -16,6 +16,7 @@
 #define SWIFTSHADER_XCBSURFACEKHR_HPP
 
 #include "VkSurfaceKHR.hpp"
+#include "XImageFormat.hpp"
 #include "Vulkan/VkObject.hpp"
 
 #include <vulkan/vulkan_xcb.h>
@@ -36,6 +37,7 @@ public:
 
 	VkResult getSurfaceCapabilities(VkSurfaceCapabilitiesKHR *pSurfaceCapabilities) const override;
 
+	void *allocateImageMemory(PresentImage *image, size_t size) override;
 	virtual void attachImage(PresentImage *image) override;
 	virtual void detachImage(PresentImage *image) override;
 	VkResult present(PresentImage *image) override;
@@ -43,9 +45,26 @@ public:
 	static bool hasLibXCB();
 
 private:
+	// SharedMemory is a MIT-SHM segment which the server reads images from,
+	// instead of receiving their pixels over the X connection. Images are
+	// bound to it, or converted into it if their format differs from the
+	// window's.
+	struct SharedMemory
+	{
+		uint32_t segment = 0;  // xcb_shm_seg_t
+		void *address = nullptr;
+	};
+
+	SharedMemory createSharedMemory(size_t size);
+	void destroySharedMemory(const SharedMemory &shm);
+
 	xcb_connection_t *connection;
 	xcb_window_t window;
+	bool mitShm = false;
+	XImageFormat format;
+	uint8_t depth = 24;
 	std::unordered_map<PresentImage *, uint32_t> graphicsContexts;
+	std::unordered_map<PresentImage *, SharedMemory> sharedMemory;
 };
 
 }  // namespace vk
@@ -17,6 +17,32 @@
 #include "Vulkan/VkDeviceMemory.hpp"
 #include "Vulkan/VkImage.hpp"
 
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include <vector>
+
+namespace {
+
+int (*PreviousXErrorHandler)(Display *display, XErrorEvent *event) = nullptr;
+bool shmBadAccess = false;
+
+// Catches BadAccess errors so we can fall back to not using MIT-SHM
+int XShmErrorHandler(Display *display, XErrorEvent *event)
+{
+	if(event->error_code == BadAccess)
+	{
+		shmBadAccess = true;
+		return 0;
+	}
+	else
+	{
+		return PreviousXErrorHandler(display, event);
+	}
+}
+
+}  // anonymous namespace
+
 namespace vk {
 
 XlibSurfaceKHR::XlibSurfaceKHR(const VkXlibSurfaceCreateInfoKHR *pCreateInfo, void *mem)
@@ -26,10 +52,26 @@ XlibSurfaceKHR::XlibSurfaceKHR(const VkXlibSurfaceCreateInfoKHR *pCreateInfo, vo
 	int screen = DefaultScreen(pDisplay);
 	gc = libX11->XDefaultGC(pDisplay, screen);
 
-	XVisualInfo xVisual;
-	Status status = libX11->XMatchVisualInfo(pDisplay, screen, 32, TrueColor, &xVisual);
-	bool match = (status != 0 && xVisual.blue_mask == 0xFF);
-	visual = match ? xVisual.visual : libX11->XDefaultVisual(pDisplay, screen);
+	// Images are presented in the format of the window's visual.
+	XWindowAttributes attr;
+	libX11->XGetWindowAttributes(pDisplay, window, &attr);
+	visual = attr.visual;
+	depth = attr.depth;
+
+	format.redMask = visual->red_mask;
+	format.greenMask = visual->green_mask;
+	format.blueMask = visual->blue_mask;
+
+	XImage *xImage = libX11->XCreateImage(pDisplay, visual, depth, ZPixmap, 0, nullptr, 1, 1, 32, 0);
+	if(xImage)
+	{
+		format.bitsPerPixel = xImage->bits_per_pixel;
+		format.scanlinePad = xImage->bitmap_pad;
+		format.lsbFirst = (xImage->byte_order == LSBFirst);
+		XDestroyImage(xImage);
+	}
+
+	mitShm = (libX11->XShmQueryExtension && libX11->XShmQueryExtension(pDisplay) == True);
 }
 
 void XlibSurfaceKHR::destroySurface(const VkAllocationCallbacks *pAllocator)
@@ -55,19 +97,125 @@ VkResult XlibSurfaceKHR::getSurfaceCapabilities(VkSurfaceCapabilitiesKHR *pSurfa
 	return VK_SUCCESS;
 }
 
-void XlibSurfaceKHR::attachImage(PresentImage *image)
+bool XlibSurfaceKHR::createSharedMemory(size_t size, XShmSegmentInfo *shminfo)
 {
-	XWindowAttributes attr;
-	libX11->XGetWindowAttributes(pDisplay, window, &attr);
+	shminfo->shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+	shminfo->shmaddr = static_cast<char *>(shmat(shminfo->shmid, 0, 0));
+	shminfo->readOnly = True;
+
+	if(shminfo->shmid >= 0 && shminfo->shmaddr != reinterpret_cast<char *>(-1))
+	{
+		PreviousXErrorHandler = libX11->XSetErrorHandler(XShmErrorHandler);
+		libX11->XShmAttach(pDisplay, shminfo);  // May produce a BadAccess error
+		libX11->XSync(pDisplay, False);
+		libX11->XSetErrorHandler(PreviousXErrorHandler);
+	}
+	else
+	{
+		shmBadAccess = true;
+	}
+
+	if(shminfo->shmid >= 0)
+	{
+		// Destroyed once both the server and this process detach.
+		shmctl(shminfo->shmid, IPC_RMID, 0);
+	}
+
+	if(!shmBadAccess)
+	{
+		return true;
+	}
+
+	// Most likely a remote display. Don't try again.
+	mitShm = false;
+	shmBadAccess = false;
+
+	if(shminfo->shmaddr != reinterpret_cast<char *>(-1))
+	{
+		shmdt(shminfo->shmaddr);
+	}
+
+	return false;
+}
+
+void *XlibSurfaceKHR::allocateImageMemory(PresentImage *image, size_t size)
+{
+	// The server can read images from their own memory if they don't need to
+	// be converted.
+	if(!mitShm || !format.isB8G8R8X8())
+	{
+		return nullptr;
+	}
+
+	XShmSegmentInfo shminfo = {};
+	if(!createSharedMemory(size, &shminfo))
+	{
+		return nullptr;
+	}
+
+	shmMap[image] = shminfo;
 
+	return shminfo.shmaddr;
+}
+
+void XlibSurfaceKHR::attachImage(PresentImage *image)
+{
 	const VkExtent3D &extent = image->getImage()->getExtent();
 
 	int bytes_per_line = image->getImage()->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
 	char *buffer = static_cast<char *>(image->getImageMemory()->getOffsetPointer(0));
 
-	XImage *xImage = libX11->XCreateImage(pDisplay, visual, attr.depth, ZPixmap, 0, buffer, extent.width, extent.height, 32, bytes_per_line);
+	auto shm = shmMap.find(image);
+	if(shm != shmMap.end())
+	{
+		// The image is bound to the segment, which the server reads the
+		// whole rows of. The XImage refers to the segment info.
+		XImage *xImage = libX11->XShmCreateImage(pDisplay, visual, depth, ZPixmap, buffer, &shm->second, bytes_per_line * 8 / format.bitsPerPixel, extent.height);
+
+		if(xImage)
+		{
+			imageMap[image] = xImage;
+			return;
+		}
+
+		libX11->XShmDetach(pDisplay, &shm->second);
+		shmdt(shm->second.shmaddr);
+		shmMap.erase(shm);
+	}
+	else if(mitShm)
+	{
+		// Presenting converts the image into a segment of its own. The XImage
+		// refers to the segment info, so it must not move.
+		XShmSegmentInfo &shminfo = shmMap[image];
+		XImage *xImage = libX11->XShmCreateImage(pDisplay, visual, depth, ZPixmap, 0, &shminfo, extent.width, extent.height);
+
+		if(xImage)
+		{
+			if(createSharedMemory(xImage->bytes_per_line * xImage->height, &shminfo))
+			{
+				xImage->data = shminfo.shmaddr;
+				imageMap[image] = xImage;
+				return;
+			}
+
+			XDestroyImage(xImage);
+		}
+
+		shmMap.erase(image);
+	}
 
-	imageMap[image] = xImage;
+	if(format.isB8G8R8X8())
+	{
+		imageMap[image] = libX11->XCreateImage(pDisplay, visual, depth, ZPixmap, 0, buffer, extent.width, extent.height, 32, bytes_per_line);
+	}
+	else
+	{
+		// Presenting converts the image into a buffer of its own.
+		std::vector<char> &converted = conversionMap[image];
+		converted.resize(extent.height * format.pitch(extent.width));
+
+		imageMap[image] = libX11->XCreateImage(pDisplay, visual, depth, ZPixmap, 0, converted.data(), extent.width, extent.height, format.scanlinePad, format.pitch(extent.width));
+	}
 }
 
 void XlibSurfaceKHR::detachImage(PresentImage *image)
@@ -80,6 +228,16 @@ void XlibSurfaceKHR::detachImage(PresentImage *image)
 		XDestroyImage(xImage);
 		imageMap.erase(it);
 	}
+
+	auto shm = shmMap.find(image);
+	if(shm != shmMap.end())
+	{
+		libX11->XShmDetach(pDisplay, &shm->second);
+		shmdt(shm->second.shmaddr);
+		shmMap.erase(shm);
+	}
+
+	conversionMap.erase(image);
 }
 
 VkResult XlibSurfaceKHR::present(PresentImage *image)
@@ -101,11 +259,28 @@ VkResult XlibSurfaceKHR::present(PresentImage *image)
 				return VK_ERROR_OUT_OF_DATE_KHR;
 			}
 
-			libX11->XPutImage(pDisplay, window, gc, xImage, 0, 0, 0, 0, extent.width, extent.height);
+			int pitch = image->getImage()->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
+			auto source = static_cast<const uint8_t *>(image->getImageMemory()->getOffsetPointer(0));
+
+			if(xImage->data != reinterpret_cast<const char *>(source))
+			{
+				// The server has finished reading the segment for the previous
+				// present of this image, as it replied to XGetWindowAttributes().
+				format.convert(reinterpret_cast<uint8_t *>(xImage->data), xImage->bytes_per_line, source, pitch, extent.width, extent.height);
+			}
+
+			if(shmMap.find(image) != shmMap.end())
+			{
+				libX11->XShmPutImage(pDisplay, window, gc, xImage, 0, 0, 0, 0, extent.width, extent.height, False);
+			}
+			else
+			{
+				libX11->XPutImage(pDisplay, window, gc, xImage, 0, 0, 0, 0, extent.width, extent.height);
+			}
 		}
 	}
 
 	return VK_SUCCESS;
 }
 
-}  // namespace vk
\ No newline at end of file
+}  // namespace vk
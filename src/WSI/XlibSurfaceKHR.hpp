@@ -16,12 +16,14 @@
 #define SWIFTSHADER_XLIBSURFACEKHR_HPP
 
 #include "VkSurfaceKHR.hpp"
+#include "XImageFormat.hpp"
 #include "libX11.hpp"
 #include "Vulkan/VkObject.hpp"
 
 #include <vulkan/vulkan_xlib.h>
 
 #include <unordered_map>
+#include <vector>
 
 namespace vk {
 
@@ -36,16 +38,30 @@ public:
 
 	VkResult getSurfaceCapabilities(VkSurfaceCapabilitiesKHR *pSurfaceCapabilities) const override;
 
+	void *allocateImageMemory(PresentImage *image, size_t size) override;
 	virtual void attachImage(PresentImage *image) override;
 	virtual void detachImage(PresentImage *image) override;
 	VkResult present(PresentImage *image) override;
 
+	// The Display belongs to the application, and Xlib is not thread-safe
+	// unless it called XInitThreads().
+	bool canPresentAsync() const override { return false; }
+
 private:
+	// Creates and attaches a MIT-SHM segment. Disables MIT-SHM if the server
+	// can't attach to it.
+	bool createSharedMemory(size_t size, XShmSegmentInfo *shminfo);
+
 	Display *const pDisplay;
 	const Window window;
 	GC gc;
 	Visual *visual = nullptr;
+	int depth = 24;
+	XImageFormat format;
+	bool mitShm = false;
 	std::unordered_map<PresentImage *, XImage *> imageMap;
+	std::unordered_map<PresentImage *, XShmSegmentInfo> shmMap;         // MIT-SHM images
+	std::unordered_map<PresentImage *, std::vector<char>> conversionMap;  // Converted images
 };
 
 }  // namespace vk
@@ -922,6 +922,50 @@ TEST_F(SwiftShaderTest, ClearDirtyTexture)
 	Uninitialize();
 }
 
+// Tests that a partial update of a texture which is stored in a different
+// internal format keeps the rest of the rendered contents.
+TEST_F(SwiftShaderTest, TexSubImageAfterRendering)
+{
+	Initialize(3, false);
+
+	const GLuint red = 0xC00003FF;     // GL_UNSIGNED_INT_2_10_10_10_REV
+	const GLuint green = 0xC00FFC00;
+	GLuint tex_data[16 * 16];
+	for(GLuint &texel : tex_data)
+	{
+		texel = red;
+	}
+
+	GLuint tex = 1;
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB10_A2, 16, 16, 0, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, tex_data);
+	EXPECT_NO_GL_ERROR();
+
+	GLuint fbo = 1;
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+	EXPECT_NO_GL_ERROR();
+	EXPECT_GLENUM_EQ(GL_FRAMEBUFFER_COMPLETE, glCheckFramebufferStatus(GL_FRAMEBUFFER));
+
+	glClearColor(0.0f, 0.0f, 1.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	EXPECT_NO_GL_ERROR();
+
+	GLuint sub_data[2 * 2] = { green, green, green, green };
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 5, 6, 2, 2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, sub_data);
+	EXPECT_NO_GL_ERROR();
+
+	const unsigned char blue_color[4] = { 0, 0, 255, 255 };
+	const unsigned char green_color[4] = { 0, 255, 0, 255 };
+	expectFramebufferColor(green_color, 5, 6);
+	expectFramebufferColor(green_color, 6, 7);
+	expectFramebufferColor(blue_color, 0, 0);
+	expectFramebufferColor(blue_color, 7, 6);
+	expectFramebufferColor(blue_color, 15, 15);
+
+	Uninitialize();
+}
+
 // Tests copying between textures of different floating-point formats using a framebuffer object.
 TEST_F(SwiftShaderTest, CopyTexImage)
 {
@@ -2133,6 +2177,109 @@ TEST_F(SwiftShaderTest, SwitchDefaultOnly)
 		})");
 }
 
+// Test that #extension directives only affect the shader which contains them,
+// now that the compiler and its built-in symbol table are reused.
+TEST_F(SwiftShaderTest, CompilerReuse_ExtensionDirectiveScope)
+{
+	Initialize(2, false);
+
+	const std::string enabled =
+	    R"(#extension GL_OES_standard_derivatives : enable
+		precision mediump float;
+		varying float v;
+		void main()
+		{
+		    gl_FragColor = vec4(dFdx(v));
+		})";
+
+	const std::string disabled =
+	    R"(precision mediump float;
+		varying float v;
+		void main()
+		{
+		    gl_FragColor = vec4(dFdx(v));
+		})";
+
+	for(int i = 0; i < 2; i++)
+	{
+		GLuint shader = MakeShader(enabled, GL_FRAGMENT_SHADER);
+		glDeleteShader(shader);
+
+		const char *c_source[1] = { disabled.c_str() };
+		shader = glCreateShader(GL_FRAGMENT_SHADER);
+		glShaderSource(shader, 1, c_source, nullptr);
+		glCompileShader(shader);
+
+		GLint compileStatus = GL_TRUE;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
+		EXPECT_EQ(compileStatus, GL_FALSE);
+		glDeleteShader(shader);
+
+		// The second iteration uses newly created compilers.
+		glReleaseShaderCompiler();
+		EXPECT_NO_GL_ERROR();
+	}
+
+	Uninitialize();
+}
+
+// Compiles many different shaders with the same compilers. Each program must
+// only have the uniforms of its own shaders, so no state may be carried over
+// from an earlier compile.
+TEST_F(SwiftShaderTest, ReusedCompilersCompileDistinctShaders)
+{
+	Initialize(3, false);
+
+	for(int i = 0; i < 64; i++)
+	{
+		const std::string n = std::to_string(i);
+		const bool scaled = (i % 2) != 0;
+
+		const std::string vs =
+		    R"(#version 300 es
+			in vec4 position;
+			uniform mat4 transform;
+			out vec2 texCoord;
+			void main()
+			{
+			    texCoord = position.xy * 0.5 + 0.5;
+			    gl_Position = transform * position + vec4()" + n + R"(.0);
+			})";
+
+		const std::string fs =
+		    std::string(R"(#version 300 es
+			precision mediump float;
+			uniform sampler2D tex;
+			)") + (scaled ? "uniform float scale;" : "") + R"(
+			in vec2 texCoord;
+			out vec4 fragColor;
+			void main()
+			{
+			    vec4 color = texture(tex, texCoord);
+			    fragColor = clamp(color * )" + (scaled ? "scale" : n + ".0") + R"(, 0.0, 1.0);
+			})";
+
+		const ProgramHandles ph = createProgram(vs, fs);
+
+		GLint activeUniforms = 0;
+		glGetProgramiv(ph.program, GL_ACTIVE_UNIFORMS, &activeUniforms);
+		EXPECT_EQ(activeUniforms, scaled ? 3 : 2) << "iteration " << i;
+		EXPECT_EQ(glGetUniformLocation(ph.program, "scale") != -1, scaled) << "iteration " << i;
+
+		deleteProgram(ph);
+
+		// Halfway through, continue with newly created compilers.
+		if(i == 31)
+		{
+			glReleaseShaderCompiler();
+		}
+	}
+
+	EXPECT_NO_GL_ERROR();
+
+	Uninitialize();
+}
+
 #ifndef EGL_ANGLE_iosurface_client_buffer
 #	define EGL_ANGLE_iosurface_client_buffer 1
 #	define EGL_IOSURFACE_ANGLE 0x3454
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "Coroutine.hpp"
+#include "ExecutableMemory.hpp"
 #include "Print.hpp"
 #include "Reactor.hpp"
 
@@ -22,6 +23,8 @@
 #include <cmath>
 #include <experimental/filesystem>
 #include <fstream>
+#include <set>
+#include <sstream>
 #include <thread>
 #include <tuple>
 
@@ -136,6 +139,153 @@ TEST(ReactorUnitTests, Trampoline)
 	EXPECT_EQ(result, 80);
 }
 
+// Creates and releases many small routines, whose code is packed into shared
+// executable memory, and checks that every live routine still runs correctly.
+TEST(ReactorUnitTests, ManySmallRoutines)
+{
+	using RoutineType = FunctionT<int(int)>::RoutineType;
+
+	auto generate = [](int addend) {
+		FunctionT<int(int)> function;
+		{
+			Int x = function.Arg<0>();
+			Return(x + addend);
+		}
+
+		return function(testName().c_str());
+	};
+
+	std::vector<RoutineType> routines;
+	for(int i = 0; i < 256; i++)
+	{
+		routines.push_back(generate(i));
+	}
+
+	// Release every other routine, then fill the freed space again.
+	for(int i = 0; i < 256; i += 2)
+	{
+		routines[i] = RoutineType();
+	}
+
+	for(int i = 0; i < 256; i += 2)
+	{
+		routines[i] = generate(i);
+	}
+
+	for(int i = 0; i < 256; i++)
+	{
+		EXPECT_EQ(routines[i](100), 100 + i) << "i: " << i;
+	}
+}
+
+#if defined(__linux__)
+// Released pages are reset, and reused before the arena maps more memory.
+TEST(ReactorUnitTests, CodeArenaPagesReused)
+{
+	CodeArena arena(CodeArena::Pages);
+	const size_t pageSize = memoryPageSize();
+	const size_t allocationCount = 1024;
+
+	std::set<void *> released;
+	for(size_t i = 0; i < allocationCount; i++)
+	{
+		void *writable = nullptr;
+		void *page = arena.allocate(pageSize, pageSize, &writable);
+		ASSERT_NE(page, nullptr);
+		EXPECT_EQ(writable, page);
+		memset(page, 0xC3, pageSize);
+		protectMemoryPages(page, pageSize, PERMISSION_READ | PERMISSION_EXECUTE);
+		released.insert(page);
+	}
+
+	CodeArena::Stats stats = arena.stats();
+	EXPECT_EQ(released.size(), allocationCount);
+	EXPECT_EQ(stats.usedBytes, allocationCount * pageSize);
+	EXPECT_EQ(stats.slabCount, allocationCount * pageSize / stats.slabBytes);
+
+	for(void *page : released)
+	{
+		EXPECT_TRUE(arena.deallocate(page, pageSize));
+	}
+
+	EXPECT_EQ(arena.stats().usedBytes, arena.stats().releasedBytes);
+
+	for(size_t i = 0; i < allocationCount; i++)
+	{
+		void *writable = nullptr;
+		uint8_t *page = static_cast<uint8_t *>(arena.allocate(pageSize, pageSize, &writable));
+		ASSERT_NE(page, nullptr);
+		EXPECT_TRUE(released.count(page) != 0) << "i: " << i;
+
+		// Reused pages are writable, and don't contain stale code.
+		EXPECT_EQ(page[0], 0) << "i: " << i;
+		page[0] = 0xC3;
+	}
+
+	EXPECT_EQ(arena.stats().slabCount, stats.slabCount);
+	EXPECT_EQ(arena.stats().usedBytes, allocationCount * pageSize);
+	EXPECT_EQ(arena.stats().releasedBytes, 0u);
+}
+
+// Small allocations share pages, and are zeroed when they're reused.
+TEST(ReactorUnitTests, CodeArenaPacksSmallAllocations)
+{
+	CodeArena arena(CodeArena::Packed);
+	const size_t pageSize = memoryPageSize();
+	const size_t allocationCount = 1024;
+	const size_t size = 100;
+
+	std::set<void *> released;
+	std::set<uintptr_t> pages;
+	for(size_t i = 0; i < allocationCount; i++)
+	{
+		void *writable = nullptr;
+		void *code = arena.allocate(size, 16, &writable);
+		if(!code && i == 0)
+		{
+			GTEST_SKIP() << "Shared executable memory is not supported";
+		}
+
+		ASSERT_NE(code, nullptr);
+		EXPECT_NE(writable, code);
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(code) % 16, 0u);
+
+		// The code is written through one view, and visible in the other.
+		memset(writable, 0xC3, size);
+		EXPECT_EQ(static_cast<uint8_t *>(code)[size - 1], 0xC3) << "i: " << i;
+
+		released.insert(code);
+		pages.insert(reinterpret_cast<uintptr_t>(code) & ~(pageSize - 1));
+	}
+
+	CodeArena::Stats stats = arena.stats();
+	EXPECT_EQ(released.size(), allocationCount);
+	EXPECT_LE(pages.size(), allocationCount * 128 / pageSize + 1);
+	EXPECT_EQ(stats.slabCount, 1u);
+	EXPECT_LE(stats.usedBytes, allocationCount * 128);
+
+	for(void *code : released)
+	{
+		EXPECT_TRUE(arena.deallocate(code, size));
+	}
+
+	EXPECT_EQ(arena.stats().usedBytes, arena.stats().releasedBytes);
+
+	for(size_t i = 0; i < allocationCount; i++)
+	{
+		void *writable = nullptr;
+		uint8_t *code = static_cast<uint8_t *>(arena.allocate(size, 16, &writable));
+		ASSERT_NE(code, nullptr);
+		EXPECT_TRUE(released.count(code) != 0) << "i: " << i;
+		EXPECT_EQ(code[0], 0) << "i: " << i;
+		EXPECT_EQ(code[size - 1], 0) << "i: " << i;
+	}
+
+	EXPECT_EQ(arena.stats().slabCount, 1u);
+	EXPECT_EQ(arena.stats().releasedBytes, 0u);
+}
+#endif  // defined(__linux__)
+
 TEST(ReactorUnitTests, Uninitialized)
 {
 	FunctionT<int()> function;
@@ -3014,6 +3164,60 @@ TEST(ReactorUnitTests, Intrinsics_Gather)
 	EXPECT_EQ(result[3], 130);
 }
 
+TEST(ReactorUnitTests, MaskedLoadStoreFloat4)
+{
+	Function<Void(Pointer<Float4> in, Pointer<Float4> out)> function;
+	{
+		Pointer<Float4> in = function.Arg<0>();
+		Pointer<Float4> out = function.Arg<1>();
+
+		unsigned int alignment = 4;
+		Float4 x = MaskedLoad(in, Int4(~0, 0, ~0, ~0), alignment, true);
+		Float4 y = x * x + Float4(1.0f);
+
+		// Only store the lanes where x > 2.
+		MaskedStore(out, y, CmpNLE(x, Float4(2.0f)), alignment);
+	}
+
+	float in[4] = { 3, 4, 1, 5 };
+	float out[4] = { -1, -1, -1, -1 };
+
+	auto routine = function(testName().c_str());
+	auto entry = (void (*)(float *, float *))routine->getEntry();
+
+	entry(in, out);
+
+	EXPECT_EQ(out[0], 10);
+	EXPECT_EQ(out[1], -1);
+	EXPECT_EQ(out[2], -1);
+	EXPECT_EQ(out[3], 26);
+}
+
+TEST(ReactorUnitTests, MaskedLoadStoreInt4)
+{
+	Function<Void(Pointer<Int4> in, Pointer<Int4> out)> function;
+	{
+		Pointer<Int4> in = function.Arg<0>();
+		Pointer<Int4> out = function.Arg<1>();
+
+		Int4 x = MaskedLoad(in, Int4(~0), 4);
+		MaskedStore(out, -x, CmpLT(x, Int4(0)), 4);
+	}
+
+	int in[4] = { -1, 2, -3, 4 };
+	int out[4] = { 0, 0, 0, 0 };
+
+	auto routine = function(testName().c_str());
+	auto entry = (void (*)(int *, int *))routine->getEntry();
+
+	entry(in, out);
+
+	EXPECT_EQ(out[0], 1);
+	EXPECT_EQ(out[1], 0);
+	EXPECT_EQ(out[2], 3);
+	EXPECT_EQ(out[3], 0);
+}
+
 TEST(ReactorUnitTests, ExtractFromRValue)
 {
 	Function<Void(Pointer<Int4> values, Pointer<Int4> result)> function;
@@ -0,0 +1,86 @@
+// Copyright 2021 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "System/SharedCache.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace sw;
+
+namespace {
+
+// Hashes every key to the same bucket, so that lookups can only succeed
+// through the key comparison.
+struct CollidingHash
+{
+	std::size_t operator()(const std::string &) const noexcept { return 0; }
+};
+
+}  // namespace
+
+TEST(SharedCache, MissCreatesAndHitReuses)
+{
+	SharedCache<std::string, int> cache(4);
+	int created = 0;
+	auto create = [&] { return std::make_shared<int>(++created); };
+
+	auto a = cache.getOrCreate("a", create);
+	ASSERT_EQ(created, 1);
+	ASSERT_EQ(*a, 1);
+
+	auto b = cache.getOrCreate("b", create);
+	ASSERT_EQ(created, 2);
+	ASSERT_EQ(*b, 2);
+
+	ASSERT_EQ(cache.getOrCreate("a", create), a);
+	ASSERT_EQ(cache.getOrCreate("b", create), b);
+	ASSERT_EQ(created, 2);
+}
+
+TEST(SharedCache, CollidingKeysAreDistinct)
+{
+	SharedCache<std::string, std::string, CollidingHash> cache(4);
+	auto create = [](const char *data) { return [=] { return std::make_shared<std::string>(data); }; };
+
+	auto a = cache.getOrCreate("a", create("a"));
+	auto b = cache.getOrCreate("b", create("b"));
+	ASSERT_NE(a, b);
+	ASSERT_EQ(*a, "a");
+	ASSERT_EQ(*b, "b");
+
+	ASSERT_EQ(cache.getOrCreate("a", create("x")), a);
+	ASSERT_EQ(cache.getOrCreate("b", create("x")), b);
+}
+
+TEST(SharedCache, EvictedEntriesAreRecreated)
+{
+	SharedCache<int, int> cache(2);
+	int created = 0;
+	auto create = [&] { return std::make_shared<int>(++created); };
+
+	auto first = cache.getOrCreate(1, create);
+	cache.getOrCreate(2, create);
+	cache.getOrCreate(3, create);
+	ASSERT_EQ(created, 3);
+
+	// Entries stay alive for as long as they are referenced, but the cache
+	// no longer returns them once evicted.
+	auto again = cache.getOrCreate(1, create);
+	ASSERT_EQ(created, 4);
+	ASSERT_NE(again, first);
+	ASSERT_EQ(*first, 1);
+}
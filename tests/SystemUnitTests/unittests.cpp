@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "System/Math.hpp"
 #include "System/Memory.hpp"
 #ifdef __linux__
 #	include "System/Linux/MemFd.hpp"
@@ -21,9 +22,43 @@
 #include <gtest/gtest.h>
 
 #include <cstdlib>
+#include <string>
 
 using namespace sw;
 
+// Reference values from the canonical MurmurHash3_x64_128, with lo and hi
+// holding its first and second 64-bit words.
+TEST(Math, Murmur3_128)
+{
+	const std::string fox = "The quick brown fox jumps over the lazy dog";
+	uint8_t bytes[31];
+	for(uint8_t i = 0; i < sizeof(bytes); i++)
+	{
+		bytes[i] = i;
+	}
+
+	Hash128 hash = Murmur3_128(nullptr, 0);
+	EXPECT_EQ(hash.lo, 0u);
+	EXPECT_EQ(hash.hi, 0u);
+
+	hash = Murmur3_128("hello", 5);
+	EXPECT_EQ(hash.lo, 0xcbd8a7b341bd9b02ull);
+	EXPECT_EQ(hash.hi, 0x5b1e906a48ae1d19ull);
+
+	hash = Murmur3_128(fox.data(), fox.size());
+	EXPECT_EQ(hash.lo, 0xe34bbc7bbc071b6cull);
+	EXPECT_EQ(hash.hi, 0x7a433ca9c49a9347ull);
+
+	// Two full blocks followed by a 15 byte tail.
+	hash = Murmur3_128(bytes, sizeof(bytes));
+	EXPECT_EQ(hash.lo, 0x053dd3e1a32cd094ull);
+	EXPECT_EQ(hash.hi, 0x9ee59aefb4005490ull);
+
+	hash = Murmur3_128("hello", 5, Hash128{ 42, 42 });
+	EXPECT_EQ(hash.lo, 0xc4b8b3c960af6f08ull);
+	EXPECT_EQ(hash.hi, 0x2334b875b0efbc7aull);
+}
+
 #ifdef __linux__
 TEST(MemFd, DefaultConstructor)
 {
@@ -0,0 +1,189 @@
+// Copyright 2021 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "VulkanTester.hpp"
+#include "benchmark/benchmark.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Creates a device with VK_KHR_timeline_semaphore and its feature enabled.
+class TimelineSemaphoreTester : public VulkanTester
+{
+public:
+	TimelineSemaphoreTester()
+	{
+		timelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
+	}
+
+protected:
+	std::vector<const char *> getDeviceExtensions() const override
+	{
+		return { VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME };
+	}
+
+	const void *getDeviceFeatures() const override
+	{
+		return &timelineSemaphoreFeatures;
+	}
+
+private:
+	vk::PhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures;
+};
+
+class TimelineSemaphoreBenchmark
+{
+public:
+	void initialize(uint32_t count)
+	{
+		tester.initialize();
+		auto &device = tester.getDevice();
+
+		vk::SemaphoreTypeCreateInfo typeInfo;
+		typeInfo.semaphoreType = vk::SemaphoreType::eTimeline;
+		typeInfo.initialValue = 0;
+
+		vk::SemaphoreCreateInfo createInfo;
+		createInfo.pNext = &typeInfo;
+
+		for(uint32_t i = 0; i < count; i++)
+		{
+			semaphores.push_back(device.createSemaphore(createInfo));
+		}
+	}
+
+	~TimelineSemaphoreBenchmark()
+	{
+		auto &device = tester.getDevice();
+		for(auto semaphore : semaphores)
+		{
+			device.destroySemaphore(semaphore, nullptr);
+		}
+	}
+
+	vk::Semaphore semaphore(uint32_t i) const
+	{
+		return semaphores[i];
+	}
+
+	void signal(vk::Semaphore semaphore, uint64_t value)
+	{
+		vk::SemaphoreSignalInfo signalInfo;
+		signalInfo.semaphore = semaphore;
+		signalInfo.value = value;
+
+		tester.getDevice().signalSemaphoreKHR(signalInfo);
+	}
+
+	// Waits for any, or all, of the semaphores to reach value.
+	void wait(const std::vector<vk::Semaphore> &waitSemaphores, uint64_t value, bool waitAny)
+	{
+		std::vector<uint64_t> values(waitSemaphores.size(), value);
+
+		vk::SemaphoreWaitInfo waitInfo;
+		waitInfo.flags = waitAny ? vk::SemaphoreWaitFlagBits::eAny : vk::SemaphoreWaitFlags();
+		waitInfo.semaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+		waitInfo.pSemaphores = waitSemaphores.data();
+		waitInfo.pValues = values.data();
+
+		tester.getDevice().waitSemaphoresKHR(waitInfo, UINT64_MAX);
+	}
+
+private:
+	TimelineSemaphoreTester tester;
+	std::vector<vk::Semaphore> semaphores;  // Owning handles
+};
+
+// Signals a semaphore and waits for the value on the same thread, which never blocks.
+static void TimelineSemaphore_SignalWait(benchmark::State &state)
+{
+	TimelineSemaphoreBenchmark benchmark;
+	benchmark.initialize(1);
+
+	std::vector<vk::Semaphore> semaphore = { benchmark.semaphore(0) };
+	uint64_t value = 0;
+
+	for(auto _ : state)
+	{
+		value++;
+		benchmark.signal(semaphore[0], value);
+		benchmark.wait(semaphore, value, false);
+	}
+}
+
+// Measures the latency of waking waiting threads under contention. Each of
+// state.range(0) threads waits for any of state.range(1) semaphores, of which
+// the benchmark thread signals one per iteration. It then waits for all the
+// threads to acknowledge through their own semaphore.
+static void TimelineSemaphore_WaitAnyRoundTrip(benchmark::State &state)
+{
+	const uint32_t threadCount = static_cast<uint32_t>(state.range(0));
+	const uint32_t semaphoreCount = static_cast<uint32_t>(state.range(1));
+
+	TimelineSemaphoreBenchmark benchmark;
+	benchmark.initialize(semaphoreCount + threadCount);
+
+	std::vector<vk::Semaphore> signaled;
+	for(uint32_t i = 0; i < semaphoreCount; i++)
+	{
+		signaled.push_back(benchmark.semaphore(i));
+	}
+
+	std::vector<vk::Semaphore> acknowledged;
+	for(uint32_t i = 0; i < threadCount; i++)
+	{
+		acknowledged.push_back(benchmark.semaphore(semaphoreCount + i));
+	}
+
+	std::atomic<bool> done = { false };
+	std::vector<std::thread> threads;
+	for(uint32_t i = 0; i < threadCount; i++)
+	{
+		threads.emplace_back([&, i]() {
+			for(uint64_t value = 1;; value++)
+			{
+				benchmark.wait(signaled, value, true);
+				if(done)
+				{
+					break;
+				}
+
+				benchmark.signal(acknowledged[i], value);
+			}
+		});
+	}
+
+	uint64_t value = 0;
+	for(auto _ : state)
+	{
+		value++;
+		benchmark.signal(signaled[value % semaphoreCount], value);
+		benchmark.wait(acknowledged, value, false);
+	}
+
+	done = true;
+	for(auto semaphore : signaled)
+	{
+		benchmark.signal(semaphore, value + 1);
+	}
+
+	for(auto &thread : threads)
+	{
+		thread.join();
+	}
+}
+
+BENCHMARK(TimelineSemaphore_SignalWait)->Unit(benchmark::kMicrosecond);
+BENCHMARK(TimelineSemaphore_WaitAnyRoundTrip)->Args({ 1, 1 })->Args({ 4, 4 })->Args({ 4, 64 })->Args({ 16, 64 })->Unit(benchmark::kMicrosecond)->UseRealTime();
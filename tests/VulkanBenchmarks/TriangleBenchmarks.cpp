@@ -145,6 +145,90 @@ static void TriangleInterpolateColor(benchmark::State &state, Multisample multis
 	RunBenchmark(state, tester);
 }
 
+// Draws a grid of sub-pixel triangles, which leaves vertex attribute fetch and
+// processing as the bulk of the work. Reports vertices per second.
+static void TriangleVertexFetch(benchmark::State &state, Multisample multisample)
+{
+	struct Vertex
+	{
+		float position[3];
+		int8_t normal[4];
+		uint8_t color[4];
+		uint16_t texCoord[2];
+	};
+
+	const int gridSize = 256;
+	std::vector<Vertex> vertexBufferData;
+	vertexBufferData.reserve(gridSize * gridSize * 3);
+
+	for(int y = 0; y < gridSize; y++)
+	{
+		for(int x = 0; x < gridSize; x++)
+		{
+			float cx = -1.0f + (2.0f * x + 1.0f) / gridSize;
+			float cy = -1.0f + (2.0f * y + 1.0f) / gridSize;
+			uint8_t shade = static_cast<uint8_t>(x ^ y);
+			uint16_t u = static_cast<uint16_t>(x * 0xFFFF / gridSize);
+			uint16_t v = static_cast<uint16_t>(y * 0xFFFF / gridSize);
+
+			vertexBufferData.push_back({ { cx, cy, 0.5f }, { 0, 0, 127, 0 }, { shade, 0, 0, 255 }, { u, v } });
+			vertexBufferData.push_back({ { cx + 0.001f, cy, 0.5f }, { 0, 127, 0, 0 }, { 0, shade, 0, 255 }, { u, v } });
+			vertexBufferData.push_back({ { cx, cy + 0.001f, 0.5f }, { 127, 0, 0, 0 }, { 0, 0, shade, 255 }, { u, v } });
+		}
+	}
+
+	DrawTester tester(multisample);
+
+	tester.onCreateVertexBuffers([&vertexBufferData](DrawTester &tester) {
+		std::vector<vk::VertexInputAttributeDescription> inputAttributes;
+		inputAttributes.push_back(vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, position)));
+		inputAttributes.push_back(vk::VertexInputAttributeDescription(1, 0, vk::Format::eR8G8B8A8Snorm, offsetof(Vertex, normal)));
+		inputAttributes.push_back(vk::VertexInputAttributeDescription(2, 0, vk::Format::eR8G8B8A8Unorm, offsetof(Vertex, color)));
+		inputAttributes.push_back(vk::VertexInputAttributeDescription(3, 0, vk::Format::eR16G16Unorm, offsetof(Vertex, texCoord)));
+
+		tester.addVertexBuffer(vertexBufferData.data(), vertexBufferData.size() * sizeof(Vertex), std::move(inputAttributes));
+	});
+
+	tester.onCreateVertexShader([](DrawTester &tester) {
+		const char *vertexShader = R"(#version 310 es
+			layout(location = 0) in vec3 inPos;
+			layout(location = 1) in vec3 inNormal;
+			layout(location = 2) in vec4 inColor;
+			layout(location = 3) in vec2 inTexCoord;
+
+			layout(location = 0) out vec4 outColor;
+
+			void main()
+			{
+				float light = max(dot(inNormal, vec3(0.0, 0.0, 1.0)), 0.25);
+				outColor = vec4(inColor.rgb * light, inColor.a) + vec4(inTexCoord, 0.0, 0.0);
+				gl_Position = vec4(inPos.xyz, 1.0);
+			})";
+
+		return tester.createShaderModule(vertexShader, EShLanguage::EShLangVertex);
+	});
+
+	tester.onCreateFragmentShader([](DrawTester &tester) {
+		const char *fragmentShader = R"(#version 310 es
+			precision highp float;
+
+			layout(location = 0) in vec4 inColor;
+
+			layout(location = 0) out vec4 outColor;
+
+			void main()
+			{
+				outColor = inColor;
+			})";
+
+		return tester.createShaderModule(fragmentShader, EShLanguage::EShLangFragment);
+	});
+
+	RunBenchmark(state, tester);
+
+	state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(vertexBufferData.size()));
+}
+
 static void TriangleSampleTexture(benchmark::State &state, Multisample multisample)
 {
 	DrawTester tester(multisample);
@@ -284,6 +368,7 @@ static void TriangleSampleTexture(benchmark::State &state, Multisample multisamp
 BENCHMARK_CAPTURE(TriangleSolidColor, TriangleSolidColor, Multisample::False)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
 BENCHMARK_CAPTURE(TriangleInterpolateColor, TriangleInterpolateColor, Multisample::False)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
 BENCHMARK_CAPTURE(TriangleSampleTexture, TriangleSampleTexture, Multisample::False)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
+BENCHMARK_CAPTURE(TriangleVertexFetch, TriangleVertexFetch, Multisample::False)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
 BENCHMARK_CAPTURE(TriangleSolidColor, TriangleSolidColor_Multisample, Multisample::True)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
 BENCHMARK_CAPTURE(TriangleInterpolateColor, TriangleInterpolateColor_Multisample, Multisample::True)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
 BENCHMARK_CAPTURE(TriangleSampleTexture, TriangleSampleTexture_Multisample, Multisample::True)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
@@ -0,0 +1,851 @@
+// Copyright 2021 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "VulkanTest.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// Clears of attachments are written out in tiles of 32x2 texels. Neither
+// dimension is a multiple of them, so the image edges fall inside partial tiles.
+constexpr uint32_t kWidth = 100;
+constexpr uint32_t kHeight = 37;
+constexpr VkFormat kFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+constexpr VkClearColorValue kRed = { { 1.0f, 0.0f, 0.0f, 1.0f } };
+constexpr VkClearColorValue kGreen = { { 0.0f, 1.0f, 0.0f, 1.0f } };
+constexpr VkClearColorValue kBlue = { { 0.0f, 0.0f, 1.0f, 1.0f } };
+constexpr uint32_t kRedTexel = 0xFF0000FF;
+constexpr uint32_t kGreenTexel = 0xFF00FF00;
+constexpr uint32_t kBlueTexel = 0xFFFF0000;
+
+// The size of the tiles in which pending clears are tracked.
+constexpr uint32_t kTileWidth = 32;
+constexpr uint32_t kTileHeight = 2;
+
+// Starts and ends inside tiles, both horizontally and vertically.
+constexpr VkRect2D kPartialArea = { { 5, 3 }, { 40, 7 } };
+// Also covers whole tiles.
+constexpr VkRect2D kDiscardArea = { { 20, 3 }, { 70, 30 } };
+
+bool Contains(const VkRect2D &rect, uint32_t x, uint32_t y)
+{
+	return (x >= static_cast<uint32_t>(rect.offset.x)) && (x < rect.offset.x + rect.extent.width) &&
+	       (y >= static_cast<uint32_t>(rect.offset.y)) && (y < rect.offset.y + rect.extent.height);
+}
+
+// Returns whether the tile of the texel lies entirely inside the rect, so
+// that a discard of the rect drops the tile's pending clear.
+bool TileInside(const VkRect2D &rect, uint32_t x, uint32_t y)
+{
+	uint32_t x0 = x - x % kTileWidth;
+	uint32_t y0 = y - y % kTileHeight;
+	uint32_t x1 = std::min(x0 + kTileWidth, kWidth) - 1;
+	uint32_t y1 = std::min(y0 + kTileHeight, kHeight) - 1;
+
+	return Contains(rect, x0, y0) && Contains(rect, x1, y1);
+}
+
+// #version 450
+// layout(location = 0) in vec4 position;
+// void main()
+// {
+//     gl_Position = position;
+// }
+// clang-format off
+const char *kVertexShader =
+    "OpCapability Shader\n"
+    "OpMemoryModel Logical GLSL450\n"
+    "OpEntryPoint Vertex %1 \"main\" %2 %3\n"
+    "OpDecorate %2 Location 0\n"
+    "OpDecorate %3 BuiltIn Position\n"
+    "%4 = OpTypeVoid\n"
+    "%5 = OpTypeFunction %4\n"            // void()
+    "%6 = OpTypeFloat 32\n"               // float
+    "%7 = OpTypeVector %6 4\n"            // vec4
+    "%8 = OpTypePointer Input %7\n"       // vec4*
+    "%9 = OpTypePointer Output %7\n"      // vec4*
+    "%2 = OpVariable %8 Input\n"          // position
+    "%3 = OpVariable %9 Output\n"         // gl_Position
+    "%1 = OpFunction %4 None %5\n"        // -- Function begin --
+    "%10 = OpLabel\n"
+    "%11 = OpLoad %7 %2\n"
+    "OpStore %3 %11\n"
+    "OpReturn\n"
+    "OpFunctionEnd\n";
+// clang-format on
+
+// #version 450
+// layout(location = 0) out vec4 color;
+// void main()
+// {
+//     color = vec4(0.0, 1.0, 0.0, 1.0);
+// }
+// clang-format off
+const char *kGreenFragmentShader =
+    "OpCapability Shader\n"
+    "OpMemoryModel Logical GLSL450\n"
+    "OpEntryPoint Fragment %1 \"main\" %2\n"
+    "OpExecutionMode %1 OriginUpperLeft\n"
+    "OpDecorate %2 Location 0\n"
+    "%3 = OpTypeVoid\n"
+    "%4 = OpTypeFunction %3\n"                      // void()
+    "%5 = OpTypeFloat 32\n"                         // float
+    "%6 = OpTypeVector %5 4\n"                      // vec4
+    "%7 = OpTypePointer Output %6\n"                // vec4*
+    "%2 = OpVariable %7 Output\n"                   // color
+    "%8 = OpConstant %5 0\n"                        // 0.0f
+    "%9 = OpConstant %5 1\n"                        // 1.0f
+    "%10 = OpConstantComposite %6 %8 %9 %8 %9\n"    // vec4(0.0, 1.0, 0.0, 1.0)
+    "%1 = OpFunction %3 None %4\n"                  // -- Function begin --
+    "%11 = OpLabel\n"
+    "OpStore %2 %10\n"
+    "OpReturn\n"
+    "OpFunctionEnd\n";
+// clang-format on
+
+// #version 450
+// layout(local_size_x = 1, local_size_y = 1) in;
+// layout(binding = 0, std430) buffer OutBuffer
+// {
+//     vec4 Data[];
+// } Out;
+// layout(binding = 1) uniform texture2D Image;
+// void main()
+// {
+//     uvec3 id = gl_GlobalInvocationID;
+//     Out.Data[id.y * 100 + id.x] = texelFetch(Image, ivec2(id.xy), 0);
+// }
+// clang-format off
+const char *kFetchShader =
+    "OpCapability Shader\n"
+    "OpMemoryModel Logical GLSL450\n"
+    "OpEntryPoint GLCompute %1 \"main\" %2\n"
+    "OpExecutionMode %1 LocalSize 1 1 1\n"
+    "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+    "OpDecorate %3 ArrayStride 16\n"
+    "OpMemberDecorate %4 0 Offset 0\n"
+    "OpDecorate %4 BufferBlock\n"
+    "OpDecorate %5 DescriptorSet 0\n"
+    "OpDecorate %5 Binding 0\n"
+    "OpDecorate %6 DescriptorSet 0\n"
+    "OpDecorate %6 Binding 1\n"
+    "%7 = OpTypeVoid\n"
+    "%8 = OpTypeFunction %7\n"                      // void()
+    "%9 = OpTypeInt 32 1\n"                         // int32
+    "%10 = OpTypeInt 32 0\n"                        // uint32
+    "%11 = OpTypeFloat 32\n"                        // float
+    "%12 = OpTypeVector %11 4\n"                    // vec4
+    "%13 = OpTypeVector %10 3\n"                    // uvec3
+    "%14 = OpTypeVector %10 2\n"                    // uvec2
+    "%15 = OpTypeVector %9 2\n"                     // ivec2
+    "%3 = OpTypeRuntimeArray %12\n"                 // vec4[]
+    "%4 = OpTypeStruct %3\n"                        // struct{ vec4[] }
+    "%16 = OpTypePointer Uniform %4\n"              // struct{ vec4[] }*
+    "%5 = OpVariable %16 Uniform\n"                 // struct{ vec4[] }* out
+    "%17 = OpTypeImage %11 2D 0 0 0 1 Unknown\n"    // texture2D
+    "%18 = OpTypePointer UniformConstant %17\n"     // texture2D*
+    "%6 = OpVariable %18 UniformConstant\n"         // texture2D* image
+    "%19 = OpTypePointer Input %13\n"               // uvec3*
+    "%2 = OpVariable %19 Input\n"                   // gl_GlobalInvocationId
+    "%20 = OpTypePointer Uniform %12\n"             // vec4*
+    "%21 = OpConstant %9 0\n"                       // int32(0)
+    "%22 = OpConstant %10 100\n"                    // uint32(kWidth)
+    "%1 = OpFunction %7 None %8\n"                  // -- Function begin --
+    "%23 = OpLabel\n"
+    "%24 = OpLoad %13 %2\n"                         // id
+    "%25 = OpVectorShuffle %14 %24 %24 0 1\n"       // id.xy
+    "%26 = OpBitcast %15 %25\n"                     // ivec2(id.xy)
+    "%27 = OpLoad %17 %6\n"                         // image
+    "%28 = OpImageFetch %12 %27 %26 Lod %21\n"      // texelFetch(image, ivec2(id.xy), 0)
+    "%29 = OpCompositeExtract %10 %24 0\n"          // id.x
+    "%30 = OpCompositeExtract %10 %24 1\n"          // id.y
+    "%31 = OpIMul %10 %30 %22\n"
+    "%32 = OpIAdd %10 %31 %29\n"                    // id.y * 100 + id.x
+    "%33 = OpAccessChain %20 %5 %21 %32\n"          // &out.arr[index]
+    "OpStore %33 %28\n"
+    "OpReturn\n"
+    "OpFunctionEnd\n";
+// clang-format on
+
+}  // anonymous namespace
+
+// ClearTest records clears of kWidth by kHeight images, which attachments
+// only write to memory once each tile is accessed, and checks that every
+// kind of access observes them.
+class ClearTest : public VulkanTest
+{
+protected:
+	ClearTest()
+	    : VulkanTest({ VK_KHR_SURFACE_EXTENSION_NAME, VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME },
+	                 { VK_KHR_SWAPCHAIN_EXTENSION_NAME })
+	{
+	}
+
+	void SetUp() override
+	{
+		VulkanTest::SetUp();
+		ASSERT_FALSE(HasFatalFailure());
+
+		VK_ASSERT(device->CreateCommandPool(&commandPool));
+		beginCommandBuffer();
+	}
+
+	void TearDown() override
+	{
+		for(auto commandBuffer : commandBuffers)
+		{
+			device->FreeCommandBuffer(commandPool, commandBuffer);
+		}
+		device->DestroyCommandPool(commandPool);
+
+		for(auto framebuffer : framebuffers)
+		{
+			device->DestroyFramebuffer(framebuffer);
+		}
+		for(auto renderPass : renderPasses)
+		{
+			device->DestroyRenderPass(renderPass);
+		}
+		for(auto imageView : imageViews)
+		{
+			device->DestroyImageView(imageView);
+		}
+		for(auto image : images)
+		{
+			device->DestroyImage(image);
+		}
+		for(auto buffer : buffers)
+		{
+			device->DestroyBuffer(buffer);
+		}
+		for(auto memory : memories)
+		{
+			device->FreeMemory(memory);
+		}
+
+		VulkanTest::TearDown();
+	}
+
+	// Starts recording a new command buffer.
+	void beginCommandBuffer()
+	{
+		VK_ASSERT(device->AllocateCommandBuffer(commandPool, &commandBuffer));
+		VK_ASSERT(device->BeginCommandBuffer(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, commandBuffer));
+		commandBuffers.push_back(commandBuffer);
+	}
+
+	// Creates a kWidth by kHeight image with the given usage, and a view of it
+	// if it has a color format.
+	void createImage(VkFormat format, VkImageUsageFlags usage, VkImage *image, VkImageView *imageView = nullptr)
+	{
+		VK_ASSERT(device->CreateAttachmentImage(format, kWidth, kHeight, usage, image));
+		images.push_back(*image);
+
+		VkMemoryRequirements requirements;
+		device->GetImageMemoryRequirements(*image, &requirements);
+
+		VkDeviceMemory memory;
+		VK_ASSERT(device->AllocateMemory(requirements.size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memory));
+		memories.push_back(memory);
+		VK_ASSERT(device->BindImageMemory(*image, memory, 0));
+
+		if(imageView)
+		{
+			VK_ASSERT(device->CreateImageView(*image, VK_IMAGE_VIEW_TYPE_2D, format, 1, imageView));
+			imageViews.push_back(*imageView);
+		}
+	}
+
+	// Creates a host visible buffer of the given size and usage, and maps its memory.
+	void createBuffer(VkBufferUsageFlags usage, VkDeviceSize size, VkBuffer *buffer, void **data)
+	{
+		VkDeviceMemory memory;
+		VK_ASSERT(device->AllocateMemory(size, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &memory));
+		memories.push_back(memory);
+		VK_ASSERT(device->CreateBuffer(usage, memory, size, 0, buffer));
+		buffers.push_back(*buffer);
+		VK_ASSERT(device->MapMemory(memory, 0, size, 0, data));
+		memset(*data, 0, size);
+	}
+
+	// Creates a render pass and framebuffer of width by height pixels which
+	// render to the color attachment imageView.
+	void createFramebuffer(VkImageView imageView, VkFormat format, VkAttachmentLoadOp loadOp, uint32_t width, uint32_t height,
+	                       VkRenderPass *renderPass, VkFramebuffer *framebuffer,
+	                       VkAttachmentStoreOp storeOp = VK_ATTACHMENT_STORE_OP_STORE)
+	{
+		VK_ASSERT(device->CreateRenderPass(format, loadOp, storeOp, renderPass));
+		renderPasses.push_back(*renderPass);
+		VK_ASSERT(device->CreateFramebuffer(*renderPass, { imageView }, width, height, framebuffer));
+		framebuffers.push_back(*framebuffer);
+	}
+
+	void beginRenderPass(VkRenderPass renderPass, VkFramebuffer framebuffer, const VkRect2D &renderArea, const VkClearColorValue &color)
+	{
+		VkClearValue clearValue;
+		clearValue.color = color;
+
+		const VkRenderPassBeginInfo info = {
+			VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,  // sType
+			nullptr,                                   // pNext
+			renderPass,                                // renderPass
+			framebuffer,                               // framebuffer
+			renderArea,                                // renderArea
+			1,                                         // clearValueCount
+			&clearValue,                               // pClearValues
+		};
+
+		driver.vkCmdBeginRenderPass(commandBuffer, &info, VK_SUBPASS_CONTENTS_INLINE);
+	}
+
+	// Clears the render area of a kWidth by kHeight color attachment with the
+	// load operation of a render pass.
+	void clearRenderArea(VkImageView imageView, const VkRect2D &renderArea, const VkClearColorValue &color)
+	{
+		VkRenderPass renderPass;
+		VkFramebuffer framebuffer;
+		createFramebuffer(imageView, kFormat, VK_ATTACHMENT_LOAD_OP_CLEAR, kWidth, kHeight, &renderPass, &framebuffer);
+
+		beginRenderPass(renderPass, framebuffer, renderArea, color);
+		driver.vkCmdEndRenderPass(commandBuffer);
+	}
+
+	void clearColorImage(VkImage image, const VkClearColorValue &color)
+	{
+		const VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		driver.vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL, &color, 1, &range);
+	}
+
+	// Makes the results of all previous commands visible to later ones.
+	void barrier()
+	{
+		const VkMemoryBarrier barrier = {
+			VK_STRUCTURE_TYPE_MEMORY_BARRIER,                         // sType
+			nullptr,                                                  // pNext
+			VK_ACCESS_MEMORY_WRITE_BIT,                               // srcAccessMask
+			VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,  // dstAccessMask
+		};
+
+		driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		                            0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	// Submits the command buffer, waits for it to complete, and starts recording a new one.
+	void submit()
+	{
+		VK_ASSERT(driver.vkEndCommandBuffer(commandBuffer));
+		VK_ASSERT(device->QueueSubmitAndWait(commandBuffer));
+		beginCommandBuffer();
+	}
+
+	// Writes the data to the aspect of a kWidth by kHeight image, directly to its memory.
+	void upload(VkImage image, VkImageAspectFlagBits aspect, const void *texels, uint32_t texelBytes)
+	{
+		VkBuffer buffer;
+		void *data = nullptr;
+		createBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, kWidth * kHeight * texelBytes, &buffer, &data);
+		memcpy(data, texels, kWidth * kHeight * texelBytes);
+
+		const VkBufferImageCopy region = {
+			0,                       // bufferOffset
+			0,                       // bufferRowLength
+			0,                       // bufferImageHeight
+			{ aspect, 0, 0, 1 },     // imageSubresource
+			{ 0, 0, 0 },             // imageOffset
+			{ kWidth, kHeight, 1 },  // imageExtent
+		};
+
+		driver.vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+		barrier();
+	}
+
+	// Copies the aspect of a width by height image into a new buffer, and
+	// submits the command buffer. Returns the mapped buffer memory.
+	const uint8_t *readback(VkImage image, VkImageAspectFlagBits aspect, uint32_t texelBytes,
+	                        uint32_t width = kWidth, uint32_t height = kHeight)
+	{
+		VkBuffer buffer;
+		void *data = nullptr;
+		createBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT, width * height * texelBytes, &buffer, &data);
+
+		const VkBufferImageCopy region = {
+			0,                       // bufferOffset
+			0,                       // bufferRowLength
+			0,                       // bufferImageHeight
+			{ aspect, 0, 0, 1 },     // imageSubresource
+			{ 0, 0, 0 },             // imageOffset
+			{ width, height, 1 },    // imageExtent
+		};
+
+		barrier();
+		driver.vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL, buffer, 1, &region);
+		submit();
+
+		return static_cast<const uint8_t *>(data);
+	}
+
+	// Checks that the texels inside the area have the given value, and all others the background value.
+	void expectTexels(const uint32_t *texels, const VkRect2D &area, uint32_t value, uint32_t background,
+	                  uint32_t width = kWidth, uint32_t height = kHeight)
+	{
+		for(uint32_t y = 0; y < height; y++)
+		{
+			for(uint32_t x = 0; x < width; x++)
+			{
+				uint32_t expected = Contains(area, x, y) ? value : background;
+				ASSERT_EQ(texels[y * width + x], expected) << "texel (" << x << ", " << y << ")";
+			}
+		}
+	}
+
+	VkCommandPool commandPool;
+	VkCommandBuffer commandBuffer;
+
+	std::vector<VkCommandBuffer> commandBuffers;
+	std::vector<VkImage> images;
+	std::vector<VkImageView> imageViews;
+	std::vector<VkRenderPass> renderPasses;
+	std::vector<VkFramebuffer> framebuffers;
+	std::vector<VkBuffer> buffers;
+	std::vector<VkDeviceMemory> memories;
+};
+
+// A partial clear over a pending clear must keep the rest of the partially
+// covered tiles, and a clear replaces the one before it.
+TEST_F(ClearTest, ClearThenCopy)
+{
+	VkImage image;
+	VkImageView imageView;
+	createImage(kFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	            &image, &imageView);
+
+	clearColorImage(image, kGreen);
+	clearColorImage(image, kRed);
+	clearRenderArea(imageView, kPartialArea, kBlue);
+
+	auto texels = reinterpret_cast<const uint32_t *>(readback(image, VK_IMAGE_ASPECT_COLOR_BIT, 4));
+	expectTexels(texels, kPartialArea, kBlueTexel, kRedTexel);
+}
+
+// Drawing writes the clear to the tiles it draws to first, and the clear of
+// the tiles it doesn't touch is written by the copy.
+TEST_F(ClearTest, ClearThenDraw)
+{
+	VkImage image;
+	VkImageView imageView;
+	createImage(kFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, &image, &imageView);
+
+	VkRenderPass renderPass;
+	VkFramebuffer framebuffer;
+	createFramebuffer(imageView, kFormat, VK_ATTACHMENT_LOAD_OP_CLEAR, kWidth, kHeight, &renderPass, &framebuffer);
+
+	// Pixel centers are covered from the rectangle's top left edges up to its bottom right ones.
+	const VkRect2D drawArea = { { 8, 6 }, { 32, 14 } };
+	const float x0 = 2.0f * drawArea.offset.x / kWidth - 1.0f;
+	const float y0 = 2.0f * drawArea.offset.y / kHeight - 1.0f;
+	const float x1 = 2.0f * (drawArea.offset.x + drawArea.extent.width) / kWidth - 1.0f;
+	const float y1 = 2.0f * (drawArea.offset.y + drawArea.extent.height) / kHeight - 1.0f;
+	const float vertices[][4] = {
+		{ x0, y0, 0.0f, 1.0f },
+		{ x1, y0, 0.0f, 1.0f },
+		{ x0, y1, 0.0f, 1.0f },
+		{ x0, y1, 0.0f, 1.0f },
+		{ x1, y0, 0.0f, 1.0f },
+		{ x1, y1, 0.0f, 1.0f },
+	};
+
+	VkBuffer vertexBuffer;
+	void *data;
+	createBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof(vertices), &vertexBuffer, &data);
+	memcpy(data, vertices, sizeof(vertices));
+
+	VkShaderModule vertexShader;
+	VkShaderModule fragmentShader;
+	VK_ASSERT(device->CreateShaderModule(compileSpirv(kVertexShader), &vertexShader));
+	VK_ASSERT(device->CreateShaderModule(compileSpirv(kGreenFragmentShader), &fragmentShader));
+
+	VkDescriptorSetLayout descriptorSetLayout;
+	VK_ASSERT(device->CreateDescriptorSetLayout({}, &descriptorSetLayout));
+
+	VkPipelineLayout pipelineLayout;
+	VK_ASSERT(device->CreatePipelineLayout(descriptorSetLayout, &pipelineLayout));
+
+	const VkVertexInputBindingDescription binding = {
+		0,                            // binding
+		sizeof(vertices[0]),          // stride
+		VK_VERTEX_INPUT_RATE_VERTEX,  // inputRate
+	};
+
+	const VkVertexInputAttributeDescription attribute = {
+		0,                              // location
+		0,                              // binding
+		VK_FORMAT_R32G32B32A32_SFLOAT,  // format
+		0,                              // offset
+	};
+
+	const VkPipelineVertexInputStateCreateInfo vertexInput = {
+		VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,  // sType
+		nullptr,                                                    // pNext
+		0,                                                          // flags
+		1,                                                          // vertexBindingDescriptionCount
+		&binding,                                                   // pVertexBindingDescriptions
+		1,                                                          // vertexAttributeDescriptionCount
+		&attribute,                                                 // pVertexAttributeDescriptions
+	};
+
+	const VkPipelineInputAssemblyStateCreateInfo inputAssembly = {
+		VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,  // sType
+		nullptr,                                                      // pNext
+		0,                                                            // flags
+		VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,                          // topology
+		VK_FALSE,                                                     // primitiveRestartEnable
+	};
+
+	const VkPipelineRasterizationStateCreateInfo rasterization = {
+		VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,  // sType
+		nullptr,                                                     // pNext
+		0,                                                           // flags
+		VK_FALSE,                                                    // depthClampEnable
+		VK_FALSE,                                                    // rasterizerDiscardEnable
+		VK_POLYGON_MODE_FILL,                                        // polygonMode
+		VK_CULL_MODE_NONE,                                           // cullMode
+		VK_FRONT_FACE_COUNTER_CLOCKWISE,                             // frontFace
+		VK_FALSE,                                                    // depthBiasEnable
+		0.0f,                                                        // depthBiasConstantFactor
+		0.0f,                                                        // depthBiasClamp
+		0.0f,                                                        // depthBiasSlopeFactor
+		1.0f,                                                        // lineWidth
+	};
+
+	VkPipeline pipeline;
+	VK_ASSERT(device->CreateGraphicsPipeline(vertexShader, fragmentShader, vertexInput, inputAssembly, rasterization,
+	                                         pipelineLayout, renderPass, kWidth, kHeight, &pipeline));
+
+	beginRenderPass(renderPass, framebuffer, { { 0, 0 }, { kWidth, kHeight } }, kRed);
+	driver.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	const VkDeviceSize offset = 0;
+	driver.vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+	driver.vkCmdDraw(commandBuffer, 6, 1, 0, 0);
+	driver.vkCmdEndRenderPass(commandBuffer);
+
+	auto texels = reinterpret_cast<const uint32_t *>(readback(image, VK_IMAGE_ASPECT_COLOR_BIT, 4));
+	expectTexels(texels, drawArea, kGreenTexel, kRedTexel);
+
+	device->DestroyPipeline(pipeline);
+	device->DestroyPipelineLayout(pipelineLayout);
+	device->DestroyDescriptorSetLayout(descriptorSetLayout);
+	device->DestroyShaderModule(fragmentShader);
+	device->DestroyShaderModule(vertexShader);
+}
+
+// Sampling an image writes all of its pending clears first.
+TEST_F(ClearTest, ClearThenSample)
+{
+	VkImage image;
+	VkImageView imageView;
+	createImage(kFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	            &image, &imageView);
+
+	const VkDeviceSize outputSize = kWidth * kHeight * 4 * sizeof(float);
+	VkDeviceMemory outputMemory;
+	VK_ASSERT(device->AllocateMemory(outputSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &outputMemory));
+	memories.push_back(outputMemory);
+
+	VkBuffer outputBuffer;
+	VK_ASSERT(device->CreateStorageBuffer(outputMemory, outputSize, 0, &outputBuffer));
+	buffers.push_back(outputBuffer);
+
+	VkShaderModule shaderModule;
+	VK_ASSERT(device->CreateShaderModule(compileSpirv(kFetchShader), &shaderModule));
+
+	std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings = {
+		{
+		    0,                                  // binding
+		    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,  // descriptorType
+		    1,                                  // descriptorCount
+		    VK_SHADER_STAGE_COMPUTE_BIT,        // stageFlags
+		    0,                                  // pImmutableSamplers
+		},
+		{
+		    1,                                 // binding
+		    VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,  // descriptorType
+		    1,                                 // descriptorCount
+		    VK_SHADER_STAGE_COMPUTE_BIT,       // stageFlags
+		    0,                                 // pImmutableSamplers
+		},
+	};
+
+	VkDescriptorSetLayout descriptorSetLayout;
+	VK_ASSERT(device->CreateDescriptorSetLayout(descriptorSetLayoutBindings, &descriptorSetLayout));
+
+	VkPipelineLayout pipelineLayout;
+	VK_ASSERT(device->CreatePipelineLayout(descriptorSetLayout, &pipelineLayout));
+
+	VkPipeline pipeline;
+	VK_ASSERT(device->CreateComputePipeline(shaderModule, pipelineLayout, &pipeline));
+
+	VkDescriptorPool descriptorPool;
+	VK_ASSERT(device->CreateDescriptorPool({ { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 },
+	                                         { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1 } },
+	                                       &descriptorPool));
+
+	VkDescriptorSet descriptorSet;
+	VK_ASSERT(device->AllocateDescriptorSet(descriptorPool, descriptorSetLayout, &descriptorSet));
+
+	device->UpdateStorageBufferDescriptorSets(descriptorSet, { { outputBuffer, 0, VK_WHOLE_SIZE } });
+	device->UpdateSampledImageDescriptorSet(descriptorSet, 1, imageView);
+
+	clearColorImage(image, kRed);
+	clearRenderArea(imageView, kPartialArea, kBlue);
+	barrier();
+
+	driver.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+	driver.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet,
+	                               0, nullptr);
+	driver.vkCmdDispatch(commandBuffer, kWidth, kHeight, 1);
+	submit();
+
+	float *output;
+	VK_ASSERT(device->MapMemory(outputMemory, 0, outputSize, 0, (void **)&output));
+
+	for(uint32_t y = 0; y < kHeight; y++)
+	{
+		for(uint32_t x = 0; x < kWidth; x++)
+		{
+			const VkClearColorValue &expected = Contains(kPartialArea, x, y) ? kBlue : kRed;
+			for(uint32_t c = 0; c < 4; c++)
+			{
+				ASSERT_EQ(output[(y * kWidth + x) * 4 + c], expected.float32[c])
+				    << "texel (" << x << ", " << y << "), component " << c;
+			}
+		}
+	}
+
+	device->UnmapMemory(outputMemory);
+
+	device->DestroyPipeline(pipeline);
+	device->DestroyPipelineLayout(pipelineLayout);
+	device->DestroyDescriptorSetLayout(descriptorSetLayout);
+	device->DestroyDescriptorPool(descriptorPool);
+	device->DestroyShaderModule(shaderModule);
+}
+
+// The depth and stencil aspects of an image keep separate clear state.
+TEST_F(ClearTest, DepthStencilClearThenCopy)
+{
+	const VkFormat format = VK_FORMAT_D32_SFLOAT_S8_UINT;
+
+	VkImage image;
+	createImage(format, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	            &image);
+
+	const VkClearDepthStencilValue depthStencil = { 0.25f, 0x5A };
+	const VkClearDepthStencilValue stencil = { 0.0f, 0x33 };
+	const VkImageSubresourceRange bothAspects = { VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT, 0, 1, 0, 1 };
+	const VkImageSubresourceRange stencilAspect = { VK_IMAGE_ASPECT_STENCIL_BIT, 0, 1, 0, 1 };
+
+	driver.vkCmdClearDepthStencilImage(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL, &depthStencil, 1, &bothAspects);
+	driver.vkCmdClearDepthStencilImage(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL, &stencil, 1, &stencilAspect);
+
+	auto depth = reinterpret_cast<const float *>(readback(image, VK_IMAGE_ASPECT_DEPTH_BIT, 4));
+	auto stencils = readback(image, VK_IMAGE_ASPECT_STENCIL_BIT, 1);
+
+	for(uint32_t i = 0; i < kWidth * kHeight; i++)
+	{
+		ASSERT_EQ(depth[i], 0.25f) << "texel (" << (i % kWidth) << ", " << (i / kWidth) << ")";
+		ASSERT_EQ(stencils[i], 0x33) << "texel (" << (i % kWidth) << ", " << (i / kWidth) << ")";
+	}
+}
+
+// Presenting an image writes its pending clears. The render pass which
+// doesn't load the image afterwards would otherwise drop them.
+TEST_F(ClearTest, ClearThenPresent)
+{
+	// The extent of headless surfaces.
+	const uint32_t width = 1280;
+	const uint32_t height = 720;
+	const VkFormat format = VK_FORMAT_B8G8R8A8_UNORM;
+
+	const VkHeadlessSurfaceCreateInfoEXT surfaceInfo = {
+		VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT,  // sType
+		nullptr,                                             // pNext
+		0,                                                   // flags
+	};
+
+	VkSurfaceKHR surface;
+	VK_ASSERT(driver.vkCreateHeadlessSurfaceEXT(instance, &surfaceInfo, nullptr, &surface));
+
+	VkSwapchainKHR swapchain;
+	VK_ASSERT(device->CreateSwapchain(surface, format, width, height, &swapchain));
+
+	std::vector<VkImage> swapchainImages;
+	VK_ASSERT(device->GetSwapchainImages(swapchain, swapchainImages));
+
+	uint32_t index;
+	VK_ASSERT(device->AcquireNextImage(swapchain, &index));
+
+	clearColorImage(swapchainImages[index], kRed);
+	submit();
+	VK_ASSERT(device->QueuePresent(swapchain, index));
+
+	VK_ASSERT(device->AcquireNextImage(swapchain, &index));
+
+	VkImageView imageView;
+	VK_ASSERT(device->CreateImageView(swapchainImages[index], VK_IMAGE_VIEW_TYPE_2D, format, 1, &imageView));
+	imageViews.push_back(imageView);
+
+	VkRenderPass renderPass;
+	VkFramebuffer framebuffer;
+	createFramebuffer(imageView, format, VK_ATTACHMENT_LOAD_OP_DONT_CARE, width, height, &renderPass, &framebuffer);
+	beginRenderPass(renderPass, framebuffer, { { 0, 0 }, { width, height } }, kBlue);
+	driver.vkCmdEndRenderPass(commandBuffer);
+
+	auto texels = reinterpret_cast<const uint32_t *>(readback(swapchainImages[index], VK_IMAGE_ASPECT_COLOR_BIT, 4, width, height));
+
+	// Red in B8G8R8A8 order.
+	expectTexels(texels, { { 0, 0 }, { 0, 0 } }, 0, 0xFFFF0000, width, height);
+
+	device->DestroySwapchain(swapchain);
+	driver.vkDestroySurfaceKHR(instance, surface, nullptr);
+}
+
+// Tiles entirely inside the render area of a render pass which doesn't load
+// the attachment never write their pending clear. The clear must still be
+// written to all other tiles, since texels outside the render area keep
+// their contents.
+TEST_F(ClearTest, LoadOpDontCare)
+{
+	VkImage image;
+	VkImageView imageView;
+	createImage(kFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	            &image, &imageView);
+
+	std::vector<uint32_t> green(kWidth * kHeight, kGreenTexel);
+	upload(image, VK_IMAGE_ASPECT_COLOR_BIT, green.data(), 4);
+	clearColorImage(image, kRed);
+
+	VkRenderPass renderPass;
+	VkFramebuffer framebuffer;
+	createFramebuffer(imageView, kFormat, VK_ATTACHMENT_LOAD_OP_DONT_CARE, kWidth, kHeight, &renderPass, &framebuffer);
+	beginRenderPass(renderPass, framebuffer, kDiscardArea, kBlue);
+	driver.vkCmdEndRenderPass(commandBuffer);
+
+	auto texels = reinterpret_cast<const uint32_t *>(readback(image, VK_IMAGE_ASPECT_COLOR_BIT, 4));
+	for(uint32_t y = 0; y < kHeight; y++)
+	{
+		for(uint32_t x = 0; x < kWidth; x++)
+		{
+			uint32_t expected = TileInside(kDiscardArea, x, y) ? kGreenTexel : kRedTexel;
+			ASSERT_EQ(texels[y * kWidth + x], expected) << "texel (" << x << ", " << y << ")";
+		}
+	}
+}
+
+// Tiles entirely inside the render area of a render pass which doesn't store
+// the attachment never write the clear of its load operation. Partially
+// covered tiles hold the load clear inside the render area, and the earlier
+// clear outside of it.
+TEST_F(ClearTest, StoreOpDontCare)
+{
+	VkImage image;
+	VkImageView imageView;
+	createImage(kFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	            &image, &imageView);
+
+	std::vector<uint32_t> green(kWidth * kHeight, kGreenTexel);
+	upload(image, VK_IMAGE_ASPECT_COLOR_BIT, green.data(), 4);
+	clearColorImage(image, kRed);
+
+	VkRenderPass renderPass;
+	VkFramebuffer framebuffer;
+	createFramebuffer(imageView, kFormat, VK_ATTACHMENT_LOAD_OP_CLEAR, kWidth, kHeight, &renderPass, &framebuffer,
+	                  VK_ATTACHMENT_STORE_OP_DONT_CARE);
+	beginRenderPass(renderPass, framebuffer, kDiscardArea, kBlue);
+	driver.vkCmdEndRenderPass(commandBuffer);
+
+	auto texels = reinterpret_cast<const uint32_t *>(readback(image, VK_IMAGE_ASPECT_COLOR_BIT, 4));
+	for(uint32_t y = 0; y < kHeight; y++)
+	{
+		for(uint32_t x = 0; x < kWidth; x++)
+		{
+			uint32_t expected = TileInside(kDiscardArea, x, y) ? kGreenTexel : Contains(kDiscardArea, x, y) ? kBlueTexel : kRedTexel;
+			ASSERT_EQ(texels[y * kWidth + x], expected) << "texel (" << x << ", " << y << ")";
+		}
+	}
+}
+
+// The depth and stencil aspects of an attachment are discarded separately,
+// according to their own load operations.
+class DepthStencilDontCareTest : public ClearTest, public testing::WithParamInterface<VkImageAspectFlagBits>
+{
+};
+
+TEST_P(DepthStencilDontCareTest, LoadOpDontCare)
+{
+	const VkFormat format = VK_FORMAT_D32_SFLOAT_S8_UINT;
+	const VkImageAspectFlagBits dontCareAspect = GetParam();
+
+	VkImage image;
+	createImage(format, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	            &image);
+
+	VkImageView imageView;
+	VK_ASSERT(device->CreateDepthStencilImageView(image, format, &imageView));
+	imageViews.push_back(imageView);
+
+	const VkAttachmentLoadOp depthLoadOp = (dontCareAspect == VK_IMAGE_ASPECT_DEPTH_BIT) ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : VK_ATTACHMENT_LOAD_OP_LOAD;
+	const VkAttachmentLoadOp stencilLoadOp = (dontCareAspect == VK_IMAGE_ASPECT_STENCIL_BIT) ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : VK_ATTACHMENT_LOAD_OP_LOAD;
+
+	VkRenderPass renderPass;
+	VK_ASSERT(device->CreateDepthStencilRenderPass(format, depthLoadOp, stencilLoadOp, &renderPass));
+	renderPasses.push_back(renderPass);
+
+	VkFramebuffer framebuffer;
+	VK_ASSERT(device->CreateFramebuffer(renderPass, { imageView }, kWidth, kHeight, &framebuffer));
+	framebuffers.push_back(framebuffer);
+
+	std::vector<float> depth(kWidth * kHeight, 0.75f);
+	std::vector<uint8_t> stencil(kWidth * kHeight, 0x11);
+	upload(image, VK_IMAGE_ASPECT_DEPTH_BIT, depth.data(), 4);
+	upload(image, VK_IMAGE_ASPECT_STENCIL_BIT, stencil.data(), 1);
+
+	const VkClearDepthStencilValue clearValue = { 0.25f, 0x5A };
+	const VkImageSubresourceRange range = { VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT, 0, 1, 0, 1 };
+	driver.vkCmdClearDepthStencilImage(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL, &clearValue, 1, &range);
+
+	beginRenderPass(renderPass, framebuffer, { { 0, 0 }, { kWidth, kHeight } }, {});
+	driver.vkCmdEndRenderPass(commandBuffer);
+
+	auto depthTexels = reinterpret_cast<const float *>(readback(image, VK_IMAGE_ASPECT_DEPTH_BIT, 4));
+	auto stencilTexels = readback(image, VK_IMAGE_ASPECT_STENCIL_BIT, 1);
+
+	const float expectedDepth = (dontCareAspect == VK_IMAGE_ASPECT_DEPTH_BIT) ? 0.75f : 0.25f;
+	const uint8_t expectedStencil = (dontCareAspect == VK_IMAGE_ASPECT_STENCIL_BIT) ? 0x11 : 0x5A;
+
+	for(uint32_t i = 0; i < kWidth * kHeight; i++)
+	{
+		ASSERT_EQ(depthTexels[i], expectedDepth) << "texel (" << (i % kWidth) << ", " << (i / kWidth) << ")";
+		ASSERT_EQ(stencilTexels[i], expectedStencil) << "texel (" << (i % kWidth) << ", " << (i / kWidth) << ")";
+	}
+}
+
+INSTANTIATE_TEST_SUITE_P(Aspects, DepthStencilDontCareTest,
+                         testing::Values(VK_IMAGE_ASPECT_DEPTH_BIT, VK_IMAGE_ASPECT_STENCIL_BIT));
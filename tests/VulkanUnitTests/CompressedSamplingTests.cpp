@@ -0,0 +1,401 @@
+// Copyright 2021 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "VulkanTest.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <random>
+
+namespace {
+
+// The image is five by five blocks, so that every texel of every block is
+// fetched by one invocation of a 4x4x1 work group.
+constexpr uint32_t kSize = 20;
+constexpr uint32_t kLayers = 6;
+constexpr uint32_t kTexelCount = kSize * kSize * kLayers;
+
+// Region rewritten after the first fetch, touching the left edge of each face.
+constexpr VkOffset3D kUpdateOffset = { 0, 8, 0 };
+constexpr VkExtent3D kUpdateExtent = { 8, 4, 1 };
+constexpr uint32_t kUpdateBlockCount = (kUpdateExtent.width / 4) * (kUpdateExtent.height / 4) * kLayers;
+
+uint32_t blockBytes(VkFormat format)
+{
+	switch(format)
+	{
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+	case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+	case VK_FORMAT_BC4_UNORM_BLOCK:
+	case VK_FORMAT_BC4_SNORM_BLOCK:
+		return 8;
+	default:
+		return 16;
+	}
+}
+
+// #version 450
+// layout(local_size_x = 4, local_size_y = 4) in;
+// layout(binding = 0, std430) buffer OutBuffer
+// {
+//     vec4 Data[];
+// } Out;
+// layout(binding = 1) uniform texture2DArray Image;
+// void main()
+// {
+//     uvec3 id = gl_GlobalInvocationID;
+//     Out.Data[(id.z * 20 + id.y) * 20 + id.x] = texelFetch(Image, ivec3(id), 0);
+// }
+// clang-format off
+const char *kFetchShader =
+    "OpCapability Shader\n"
+    "OpMemoryModel Logical GLSL450\n"
+    "OpEntryPoint GLCompute %1 \"main\" %2\n"
+    "OpExecutionMode %1 LocalSize 4 4 1\n"
+    "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+    "OpDecorate %3 ArrayStride 16\n"
+    "OpMemberDecorate %4 0 Offset 0\n"
+    "OpDecorate %4 BufferBlock\n"
+    "OpDecorate %5 DescriptorSet 0\n"
+    "OpDecorate %5 Binding 0\n"
+    "OpDecorate %6 DescriptorSet 0\n"
+    "OpDecorate %6 Binding 1\n"
+    "%7 = OpTypeVoid\n"
+    "%8 = OpTypeFunction %7\n"                    // void()
+    "%9 = OpTypeInt 32 1\n"                       // int32
+    "%10 = OpTypeInt 32 0\n"                      // uint32
+    "%11 = OpTypeFloat 32\n"                      // float
+    "%12 = OpTypeVector %11 4\n"                  // vec4
+    "%13 = OpTypeVector %10 3\n"                  // uvec3
+    "%14 = OpTypeVector %9 3\n"                   // ivec3
+    "%3 = OpTypeRuntimeArray %12\n"               // vec4[]
+    "%4 = OpTypeStruct %3\n"                      // struct{ vec4[] }
+    "%15 = OpTypePointer Uniform %4\n"            // struct{ vec4[] }*
+    "%5 = OpVariable %15 Uniform\n"               // struct{ vec4[] }* out
+    "%16 = OpTypeImage %11 2D 0 1 0 1 Unknown\n"  // texture2DArray
+    "%17 = OpTypePointer UniformConstant %16\n"   // texture2DArray*
+    "%6 = OpVariable %17 UniformConstant\n"       // texture2DArray* image
+    "%18 = OpTypePointer Input %13\n"             // uvec3*
+    "%2 = OpVariable %18 Input\n"                 // gl_GlobalInvocationId
+    "%19 = OpTypePointer Uniform %12\n"           // vec4*
+    "%20 = OpConstant %9 0\n"                     // int32(0)
+    "%21 = OpConstant %10 20\n"                   // uint32(20)
+    "%1 = OpFunction %7 None %8\n"                // -- Function begin --
+    "%22 = OpLabel\n"
+    "%23 = OpLoad %13 %2\n"                       // id
+    "%24 = OpBitcast %14 %23\n"                   // ivec3(id)
+    "%25 = OpLoad %16 %6\n"                       // image
+    "%26 = OpImageFetch %12 %25 %24 Lod %20\n"    // texelFetch(image, ivec3(id), 0)
+    "%27 = OpCompositeExtract %10 %23 0\n"        // id.x
+    "%28 = OpCompositeExtract %10 %23 1\n"        // id.y
+    "%29 = OpCompositeExtract %10 %23 2\n"        // id.z
+    "%30 = OpIMul %10 %29 %21\n"
+    "%31 = OpIAdd %10 %30 %28\n"
+    "%32 = OpIMul %10 %31 %21\n"
+    "%33 = OpIAdd %10 %32 %27\n"                  // (id.z * 20 + id.y) * 20 + id.x
+    "%34 = OpAccessChain %19 %5 %20 %33\n"        // &out.arr[index]
+    "OpStore %34 %26\n"
+    "OpReturn\n"
+    "OpFunctionEnd\n";
+// clang-format on
+
+}  // anonymous namespace
+
+class CompressedSamplingTest : public VulkanTest, public testing::WithParamInterface<VkFormat>
+{
+protected:
+	// Creates an image with the given create flags, fills all its layers with
+	// blocks, and fetches every texel of it in a compute shader. If update isn't
+	// empty, its blocks are then copied to the update region of every layer and
+	// the texels are fetched again.
+	void fetchTexels(VkImageCreateFlags flags, const std::vector<uint8_t> &blocks, const std::vector<uint8_t> &update,
+	                 VkMemoryRequirements *requirements, std::vector<float> *texels)
+	{
+		const VkFormat format = GetParam();
+		const VkDeviceSize outputSize = kTexelCount * 4 * sizeof(float);
+
+		VkImage image;
+		VK_ASSERT(device->CreateSampledImage(format, kSize, kSize, kLayers, flags, &image));
+		device->GetImageMemoryRequirements(image, requirements);
+
+		VkDeviceMemory imageMemory;
+		VK_ASSERT(device->AllocateMemory(requirements->size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &imageMemory));
+		VK_ASSERT(device->BindImageMemory(image, imageMemory, 0));
+
+		VkImageView imageView;
+		VK_ASSERT(device->CreateImageView(image, VK_IMAGE_VIEW_TYPE_2D_ARRAY, format, kLayers, &imageView));
+
+		// The output comes first to keep it aligned for use as a storage buffer.
+		VkDeviceMemory bufferMemory;
+		VK_ASSERT(device->AllocateMemory(outputSize + blocks.size() + update.size(),
+		                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		                                 &bufferMemory));
+
+		uint8_t *mapped;
+		VK_ASSERT(device->MapMemory(bufferMemory, outputSize, blocks.size() + update.size(), 0, (void **)&mapped));
+		memcpy(mapped, blocks.data(), blocks.size());
+		memcpy(mapped + blocks.size(), update.data(), update.size());
+		device->UnmapMemory(bufferMemory);
+
+		VkBuffer uploadBuffer;
+		VK_ASSERT(device->CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, bufferMemory, blocks.size() + update.size(), outputSize, &uploadBuffer));
+
+		VkBuffer outputBuffer;
+		VK_ASSERT(device->CreateStorageBuffer(bufferMemory, outputSize, 0, &outputBuffer));
+
+		VkShaderModule shaderModule;
+		VK_ASSERT(device->CreateShaderModule(compileSpirv(kFetchShader), &shaderModule));
+
+		std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings = {
+			{
+			    0,                                  // binding
+			    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,  // descriptorType
+			    1,                                  // descriptorCount
+			    VK_SHADER_STAGE_COMPUTE_BIT,        // stageFlags
+			    0,                                  // pImmutableSamplers
+			},
+			{
+			    1,                                 // binding
+			    VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,  // descriptorType
+			    1,                                 // descriptorCount
+			    VK_SHADER_STAGE_COMPUTE_BIT,       // stageFlags
+			    0,                                 // pImmutableSamplers
+			}
+		};
+
+		VkDescriptorSetLayout descriptorSetLayout;
+		VK_ASSERT(device->CreateDescriptorSetLayout(descriptorSetLayoutBindings, &descriptorSetLayout));
+
+		VkPipelineLayout pipelineLayout;
+		VK_ASSERT(device->CreatePipelineLayout(descriptorSetLayout, &pipelineLayout));
+
+		VkPipeline pipeline;
+		VK_ASSERT(device->CreateComputePipeline(shaderModule, pipelineLayout, &pipeline));
+
+		VkDescriptorPool descriptorPool;
+		VK_ASSERT(device->CreateDescriptorPool({ { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 },
+		                                         { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1 } },
+		                                       &descriptorPool));
+
+		VkDescriptorSet descriptorSet;
+		VK_ASSERT(device->AllocateDescriptorSet(descriptorPool, descriptorSetLayout, &descriptorSet));
+
+		device->UpdateStorageBufferDescriptorSets(descriptorSet, { { outputBuffer, 0, VK_WHOLE_SIZE } });
+		device->UpdateSampledImageDescriptorSet(descriptorSet, 1, imageView);
+
+		VkCommandPool commandPool;
+		VK_ASSERT(device->CreateCommandPool(&commandPool));
+
+		VkCommandBuffer commandBuffer;
+		VK_ASSERT(device->AllocateCommandBuffer(commandPool, &commandBuffer));
+		VK_ASSERT(device->BeginCommandBuffer(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, commandBuffer));
+
+		VkImageMemoryBarrier barrier = {
+			VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,  // sType
+			nullptr,                                 // pNext
+			0,                                       // srcAccessMask
+			VK_ACCESS_TRANSFER_WRITE_BIT,            // dstAccessMask
+			VK_IMAGE_LAYOUT_UNDEFINED,               // oldLayout
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,    // newLayout
+			VK_QUEUE_FAMILY_IGNORED,                 // srcQueueFamilyIndex
+			VK_QUEUE_FAMILY_IGNORED,                 // dstQueueFamilyIndex
+			image,                                   // image
+			{
+			    VK_IMAGE_ASPECT_COLOR_BIT,  // aspectMask
+			    0,                          // baseMipLevel
+			    1,                          // levelCount
+			    0,                          // baseArrayLayer
+			    kLayers,                    // layerCount
+			},
+		};
+
+		driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		                            0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		const VkBufferImageCopy region = {
+			0,  // bufferOffset
+			0,  // bufferRowLength
+			0,  // bufferImageHeight
+			{
+			    VK_IMAGE_ASPECT_COLOR_BIT,  // aspectMask
+			    0,                          // mipLevel
+			    0,                          // baseArrayLayer
+			    kLayers,                    // layerCount
+			},
+			{ 0, 0, 0 },          // imageOffset
+			{ kSize, kSize, 1 },  // imageExtent
+		};
+
+		driver.vkCmdCopyBufferToImage(commandBuffer, uploadBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		                            0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		driver.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+		driver.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet,
+		                               0, nullptr);
+		driver.vkCmdDispatch(commandBuffer, kSize / 4, kSize / 4, kLayers);
+
+		if(!update.empty())
+		{
+			barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+
+			driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			                            0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			VkBufferImageCopy updateRegion = region;
+			updateRegion.bufferOffset = blocks.size();
+			updateRegion.imageOffset = kUpdateOffset;
+			updateRegion.imageExtent = kUpdateExtent;
+
+			driver.vkCmdCopyBufferToImage(commandBuffer, uploadBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &updateRegion);
+
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+			driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			                            0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			driver.vkCmdDispatch(commandBuffer, kSize / 4, kSize / 4, kLayers);
+		}
+
+		VK_ASSERT(driver.vkEndCommandBuffer(commandBuffer));
+		VK_ASSERT(device->QueueSubmitAndWait(commandBuffer));
+
+		float *output;
+		VK_ASSERT(device->MapMemory(bufferMemory, 0, outputSize, 0, (void **)&output));
+		texels->assign(output, output + kTexelCount * 4);
+		device->UnmapMemory(bufferMemory);
+
+		device->FreeCommandBuffer(commandPool, commandBuffer);
+		device->DestroyCommandPool(commandPool);
+		device->DestroyPipeline(pipeline);
+		device->DestroyPipelineLayout(pipelineLayout);
+		device->DestroyDescriptorSetLayout(descriptorSetLayout);
+		device->DestroyDescriptorPool(descriptorPool);
+		device->DestroyShaderModule(shaderModule);
+		device->DestroyBuffer(outputBuffer);
+		device->DestroyBuffer(uploadBuffer);
+		device->FreeMemory(bufferMemory);
+		device->DestroyImageView(imageView);
+		device->DestroyImage(image);
+		device->FreeMemory(imageMemory);
+	}
+};
+
+// 2D images of BC1 to BC5 formats are sampled straight from their blocks,
+// while cube compatible images still go through a decompressed copy. Both
+// must fetch the same values from the same random blocks.
+TEST_P(CompressedSamplingTest, DirectFetchMatchesDecompressed)
+{
+	const VkFormat format = GetParam();
+	const uint32_t blocksSize = (kSize / 4) * (kSize / 4) * kLayers * blockBytes(format);
+
+	std::mt19937 random(format);
+	std::vector<uint8_t> blocks(blocksSize);
+	for(auto &byte : blocks)
+	{
+		byte = static_cast<uint8_t>(random());
+	}
+
+	VkMemoryRequirements directRequirements;
+	std::vector<float> direct;
+	fetchTexels(0, blocks, {}, &directRequirements, &direct);
+
+	VkMemoryRequirements decompressedRequirements;
+	std::vector<float> decompressed;
+	fetchTexels(VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT, blocks, {}, &decompressedRequirements, &decompressed);
+
+	// The directly sampled image needs no storage beyond its blocks.
+	EXPECT_LT(directRequirements.size, decompressedRequirements.size);
+	EXPECT_LE(directRequirements.size, blocksSize + 64);
+
+	ASSERT_EQ(direct.size(), decompressed.size());
+	for(uint32_t i = 0; i < kTexelCount; i++)
+	{
+		for(uint32_t c = 0; c < 4; c++)
+		{
+			EXPECT_EQ(direct[i * 4 + c], decompressed[i * 4 + c])
+			    << "texel (" << (i % kSize) << ", " << (i / kSize % kSize) << ", " << (i / (kSize * kSize))
+			    << "), component " << c;
+		}
+	}
+}
+
+// Rewriting part of an image after it has been sampled only decodes the
+// blocks of that region again, which must match the directly sampled blocks.
+TEST_P(CompressedSamplingTest, PartialUpdateMatchesDirect)
+{
+	const VkFormat format = GetParam();
+	const uint32_t blocksSize = (kSize / 4) * (kSize / 4) * kLayers * blockBytes(format);
+
+	std::mt19937 random(format);
+	std::vector<uint8_t> blocks(blocksSize);
+	for(auto &byte : blocks)
+	{
+		byte = static_cast<uint8_t>(random());
+	}
+
+	std::vector<uint8_t> update(kUpdateBlockCount * blockBytes(format));
+	for(auto &byte : update)
+	{
+		byte = static_cast<uint8_t>(random());
+	}
+
+	VkMemoryRequirements requirements;
+	std::vector<float> direct;
+	fetchTexels(0, blocks, update, &requirements, &direct);
+
+	std::vector<float> decompressed;
+	fetchTexels(VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT, blocks, update, &requirements, &decompressed);
+
+	ASSERT_EQ(direct.size(), decompressed.size());
+	for(uint32_t i = 0; i < kTexelCount; i++)
+	{
+		for(uint32_t c = 0; c < 4; c++)
+		{
+			EXPECT_EQ(direct[i * 4 + c], decompressed[i * 4 + c])
+			    << "texel (" << (i % kSize) << ", " << (i / kSize % kSize) << ", " << (i / (kSize * kSize))
+			    << "), component " << c;
+		}
+	}
+}
+
+INSTANTIATE_TEST_SUITE_P(BlockFormats, CompressedSamplingTest,
+                         testing::Values(VK_FORMAT_BC1_RGB_UNORM_BLOCK,
+                                         VK_FORMAT_BC1_RGB_SRGB_BLOCK,
+                                         VK_FORMAT_BC1_RGBA_UNORM_BLOCK,
+                                         VK_FORMAT_BC1_RGBA_SRGB_BLOCK,
+                                         VK_FORMAT_BC2_UNORM_BLOCK,
+                                         VK_FORMAT_BC2_SRGB_BLOCK,
+                                         VK_FORMAT_BC3_UNORM_BLOCK,
+                                         VK_FORMAT_BC3_SRGB_BLOCK,
+                                         VK_FORMAT_BC4_UNORM_BLOCK,
+                                         VK_FORMAT_BC4_SNORM_BLOCK,
+                                         VK_FORMAT_BC5_UNORM_BLOCK,
+                                         VK_FORMAT_BC5_SNORM_BLOCK));
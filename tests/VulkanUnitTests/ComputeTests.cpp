@@ -12,16 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include "Device.hpp"
-#include "Driver.hpp"
+#include "VulkanTest.hpp"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
-#include "spirv-tools/libspirv.hpp"
-
 #include <cstring>
-#include <sstream>
 
 namespace {
 size_t alignUp(size_t val, size_t alignment)
@@ -65,55 +61,6 @@ protected:
 
 Driver ComputeTest::driver;
 
-std::vector<uint32_t> compileSpirv(const char *assembly)
-{
-	spvtools::SpirvTools core(SPV_ENV_VULKAN_1_0);
-
-	core.SetMessageConsumer([](spv_message_level_t, const char *, const spv_position_t &p, const char *m) {
-		FAIL() << p.line << ":" << p.column << ": " << m;
-	});
-
-	std::vector<uint32_t> spirv;
-	EXPECT_TRUE(core.Assemble(assembly, &spirv));
-	EXPECT_TRUE(core.Validate(spirv));
-
-	// Warn if the disassembly does not match the source assembly.
-	// We do this as debugging tests in the debugger is often made much harder
-	// if the SSA names (%X) in the debugger do not match the source.
-	std::string disassembled;
-	core.Disassemble(spirv, &disassembled, SPV_BINARY_TO_TEXT_OPTION_NO_HEADER);
-	if(disassembled != assembly)
-	{
-		printf("-- WARNING: Disassembly does not match assembly: ---\n\n");
-
-		auto splitLines = [](const std::string &str) -> std::vector<std::string> {
-			std::stringstream ss(str);
-			std::vector<std::string> out;
-			std::string line;
-			while(std::getline(ss, line, '\n')) { out.push_back(line); }
-			return out;
-		};
-
-		auto srcLines = splitLines(std::string(assembly));
-		auto disLines = splitLines(disassembled);
-
-		for(size_t line = 0; line < srcLines.size() && line < disLines.size(); line++)
-		{
-			auto srcLine = (line < srcLines.size()) ? srcLines[line] : "<missing>";
-			auto disLine = (line < disLines.size()) ? disLines[line] : "<missing>";
-			if(srcLine != disLine)
-			{
-				printf("%zu: '%s' != '%s'\n", line, srcLine.c_str(), disLine.c_str());
-			}
-		}
-		printf("\n\n---\nExpected:\n\n%s", disassembled.c_str());
-	}
-
-	return spirv;
-}
-
-#define VK_ASSERT(x) ASSERT_EQ(x, VK_SUCCESS)
-
 // Base class for compute tests that read from an input buffer and write to an
 // output buffer of same length.
 class SwiftShaderVulkanBufferToBufferComputeTest : public ComputeTest
@@ -265,19 +212,31 @@ void SwiftShaderVulkanBufferToBufferComputeTest::test(
 	VkCommandBuffer commandBuffer;
 	VK_ASSERT(device->AllocateCommandBuffer(commandPool, &commandBuffer));
 
+	VkQueryPool queryPool;
+	VK_ASSERT(device->CreatePipelineStatisticsQueryPool(VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT, 1, &queryPool));
+
 	VK_ASSERT(device->BeginCommandBuffer(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, commandBuffer));
 
+	driver.vkCmdResetQueryPool(commandBuffer, queryPool, 0, 1);
+
 	driver.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
 
 	driver.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet,
 	                               0, nullptr);
 
+	driver.vkCmdBeginQuery(commandBuffer, queryPool, 0, 0);
 	driver.vkCmdDispatch(commandBuffer, (uint32_t)(numElements / GetParam().localSizeX), 1, 1);
+	driver.vkCmdEndQuery(commandBuffer, queryPool, 0);
 
 	VK_ASSERT(driver.vkEndCommandBuffer(commandBuffer));
 
 	VK_ASSERT(device->QueueSubmitAndWait(commandBuffer));
 
+	uint64_t computeInvocations = 0;
+	VK_ASSERT(device->GetQueryPoolResults(queryPool, 0, 1, sizeof(computeInvocations), &computeInvocations,
+	                                      sizeof(computeInvocations), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+	EXPECT_EQ(computeInvocations, numElements);
+
 	VK_ASSERT(device->MapMemory(memory, 0, buffersSize, 0, (void **)&buffers));
 
 	for(size_t i = 0; i < numElements; ++i)
@@ -296,6 +255,7 @@ void SwiftShaderVulkanBufferToBufferComputeTest::test(
 	buffers = nullptr;
 
 	device->FreeCommandBuffer(commandPool, commandBuffer);
+	device->DestroyQueryPool(queryPool);
 	device->FreeMemory(memory);
 	device->DestroyPipeline(pipeline);
 	device->DestroyCommandPool(commandPool);
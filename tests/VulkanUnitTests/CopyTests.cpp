@@ -0,0 +1,163 @@
+// Copyright 2021 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "VulkanTest.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// Large enough for uploads of most regions to be split across several threads.
+constexpr uint32_t kSize = 1024;
+constexpr VkDeviceSize kImageBytes = kSize * kSize * 4;
+
+struct CopyRegion
+{
+	VkOffset2D offset;
+	VkExtent2D extent;
+	uint32_t bufferRowLength;
+};
+
+}  // anonymous namespace
+
+class BufferImageCopyTest : public VulkanTest, public testing::WithParamInterface<CopyRegion>
+{
+protected:
+	// Creates a host visible buffer of the given size and maps its memory.
+	void createBuffer(VkDeviceSize size, VkBuffer *buffer, VkDeviceMemory *memory, uint8_t **data)
+	{
+		VK_ASSERT(device->AllocateMemory(size,
+		                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		                                 memory));
+		VK_ASSERT(device->CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		                               *memory, size, 0, buffer));
+		VK_ASSERT(device->MapMemory(*memory, 0, size, 0, (void **)data));
+	}
+};
+
+// Uploads random texels into a region of a cleared image, then reads back the
+// whole image. The region must hold the uploaded texels and the rest of the
+// image must be untouched.
+TEST_P(BufferImageCopyTest, UploadRegion)
+{
+	const CopyRegion region = GetParam();
+	const uint32_t bufferRowLength = region.bufferRowLength ? region.bufferRowLength : region.extent.width;
+	const VkDeviceSize uploadBytes = bufferRowLength * region.extent.height * 4;
+
+	VkImage image;
+	VK_ASSERT(device->CreateMipmappedImage(VK_FORMAT_R8G8B8A8_UNORM, kSize, kSize, 1, &image));
+
+	VkMemoryRequirements requirements;
+	device->GetImageMemoryRequirements(image, &requirements);
+
+	VkDeviceMemory imageMemory;
+	VK_ASSERT(device->AllocateMemory(requirements.size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &imageMemory));
+	VK_ASSERT(device->BindImageMemory(image, imageMemory, 0));
+
+	VkBuffer uploadBuffer, imageBuffer;
+	VkDeviceMemory uploadMemory, imageBufferMemory;
+	uint8_t *upload, *texels;
+	createBuffer(uploadBytes, &uploadBuffer, &uploadMemory, &upload);
+	createBuffer(kImageBytes, &imageBuffer, &imageBufferMemory, &texels);
+
+	srand(0x5EED);
+	for(VkDeviceSize i = 0; i < uploadBytes; i++)
+	{
+		upload[i] = static_cast<uint8_t>(rand());
+	}
+	memset(texels, 0, kImageBytes);
+
+	VkCommandPool commandPool;
+	VK_ASSERT(device->CreateCommandPool(&commandPool));
+
+	VkCommandBuffer commandBuffer;
+	VK_ASSERT(device->AllocateCommandBuffer(commandPool, &commandBuffer));
+	VK_ASSERT(device->BeginCommandBuffer(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, commandBuffer));
+
+	const VkMemoryBarrier barrier = {
+		VK_STRUCTURE_TYPE_MEMORY_BARRIER,                            // sType
+		nullptr,                                                     // pNext
+		VK_ACCESS_TRANSFER_WRITE_BIT,                                // srcAccessMask
+		VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,  // dstAccessMask
+	};
+
+	const VkBufferImageCopy wholeImage = {
+		0,                                      // bufferOffset
+		0,                                      // bufferRowLength
+		0,                                      // bufferImageHeight
+		{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },  // imageSubresource
+		{ 0, 0, 0 },                            // imageOffset
+		{ kSize, kSize, 1 },                    // imageExtent
+	};
+
+	const VkBufferImageCopy uploadRegion = {
+		0,                                                 // bufferOffset
+		region.bufferRowLength,                            // bufferRowLength
+		0,                                                 // bufferImageHeight
+		{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },            // imageSubresource
+		{ region.offset.x, region.offset.y, 0 },           // imageOffset
+		{ region.extent.width, region.extent.height, 1 },  // imageExtent
+	};
+
+	driver.vkCmdCopyBufferToImage(commandBuffer, imageBuffer, image, VK_IMAGE_LAYOUT_GENERAL, 1, &wholeImage);
+	driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+	                            0, 1, &barrier, 0, nullptr, 0, nullptr);
+	driver.vkCmdCopyBufferToImage(commandBuffer, uploadBuffer, image, VK_IMAGE_LAYOUT_GENERAL, 1, &uploadRegion);
+	driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+	                            0, 1, &barrier, 0, nullptr, 0, nullptr);
+	driver.vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL, imageBuffer, 1, &wholeImage);
+
+	VK_ASSERT(driver.vkEndCommandBuffer(commandBuffer));
+	VK_ASSERT(device->QueueSubmitAndWait(commandBuffer));
+
+	for(int32_t y = 0; y < static_cast<int32_t>(kSize); y++)
+	{
+		for(int32_t x = 0; x < static_cast<int32_t>(kSize); x++)
+		{
+			int32_t u = x - region.offset.x;
+			int32_t v = y - region.offset.y;
+			bool uploaded = (u >= 0) && (u < static_cast<int32_t>(region.extent.width)) &&
+			                (v >= 0) && (v < static_cast<int32_t>(region.extent.height));
+			const uint8_t zero[4] = {};
+			const uint8_t *expected = uploaded ? upload + (v * bufferRowLength + u) * 4 : zero;
+
+			ASSERT_EQ(memcmp(texels + (y * kSize + x) * 4, expected, 4), 0) << "texel (" << x << ", " << y << ")";
+		}
+	}
+
+	device->UnmapMemory(imageBufferMemory);
+	device->UnmapMemory(uploadMemory);
+
+	device->FreeCommandBuffer(commandPool, commandBuffer);
+	device->DestroyCommandPool(commandPool);
+	device->DestroyBuffer(imageBuffer);
+	device->FreeMemory(imageBufferMemory);
+	device->DestroyBuffer(uploadBuffer);
+	device->FreeMemory(uploadMemory);
+	device->DestroyImage(image);
+	device->FreeMemory(imageMemory);
+}
+
+// Whole images and whole rows are copied as one contiguous range of memory,
+// other regions row by row.
+INSTANTIATE_TEST_SUITE_P(Regions, BufferImageCopyTest,
+                         testing::Values(CopyRegion{ { 0, 0 }, { kSize, kSize }, 0 },
+                                         CopyRegion{ { 0, 100 }, { kSize, 900 }, 0 },
+                                         CopyRegion{ { 7, 5 }, { 1000, 1000 }, 0 },
+                                         CopyRegion{ { 3, 2 }, { 600, 700 }, 640 },
+                                         CopyRegion{ { 11, 13 }, { 5, 3 }, 0 }));
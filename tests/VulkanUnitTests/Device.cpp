@@ -46,7 +46,8 @@ bool Device::IsValid() const
 }
 
 VkResult Device::CreateComputeDevice(
-    Driver const *driver, VkInstance instance, std::unique_ptr<Device> &out)
+    Driver const *driver, VkInstance instance, std::unique_ptr<Device> &out,
+    const std::vector<const char *> &extensions)
 {
 	VkResult result;
 
@@ -77,6 +78,9 @@ VkResult Device::CreateComputeDevice(
 			&queuePrioritory,                            // pQueuePriorities
 		};
 
+		VkPhysicalDeviceFeatures enabledFeatures = {};
+		enabledFeatures.pipelineStatisticsQuery = VK_TRUE;
+
 		const VkDeviceCreateInfo deviceCreateInfo = {
 			VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,  // sType
 			nullptr,                               // pNext
@@ -85,9 +89,9 @@ VkResult Device::CreateComputeDevice(
 			&deviceQueueCreateInfo,                // pQueueCreateInfos
 			0,                                     // enabledLayerCount
 			nullptr,                               // ppEnabledLayerNames
-			0,                                     // enabledExtensionCount
-			nullptr,                               // ppEnabledExtensionNames
-			nullptr,                               // pEnabledFeatures
+			(uint32_t)extensions.size(),           // enabledExtensionCount
+			extensions.data(),                     // ppEnabledExtensionNames
+			&enabledFeatures,                      // pEnabledFeatures
 		};
 
 		VkDevice device;
@@ -147,13 +151,20 @@ VkResult Device::GetPhysicalDevices(
 VkResult Device::CreateStorageBuffer(
     VkDeviceMemory memory, VkDeviceSize size,
     VkDeviceSize offset, VkBuffer *out) const
+{
+	return CreateBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, memory, size, offset, out);
+}
+
+VkResult Device::CreateBuffer(
+    VkBufferUsageFlags usage, VkDeviceMemory memory, VkDeviceSize size,
+    VkDeviceSize offset, VkBuffer *out) const
 {
 	const VkBufferCreateInfo info = {
 		VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,  // sType
 		nullptr,                               // pNext
 		0,                                     // flags
 		size,                                  // size
-		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,    // usage
+		usage,                                 // usage
 		VK_SHARING_MODE_EXCLUSIVE,             // sharingMode
 		0,                                     // queueFamilyIndexCount
 		nullptr,                               // pQueueFamilyIndices
@@ -266,6 +277,120 @@ VkResult Device::CreateComputePipeline(
 	return driver->vkCreateComputePipelines(device, 0, 1, &info, 0, out);
 }
 
+VkResult Device::CreateGraphicsPipeline(VkShaderModule vertexShader, VkShaderModule fragmentShader,
+                                        const VkPipelineVertexInputStateCreateInfo &vertexInput,
+                                        const VkPipelineInputAssemblyStateCreateInfo &inputAssembly,
+                                        const VkPipelineRasterizationStateCreateInfo &rasterization,
+                                        VkPipelineLayout pipelineLayout, VkRenderPass renderPass,
+                                        uint32_t width, uint32_t height, VkPipeline *out) const
+{
+	const VkPipelineShaderStageCreateInfo stages[] = {
+		{
+		    VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,  // sType
+		    nullptr,                                              // pNext
+		    0,                                                    // flags
+		    VK_SHADER_STAGE_VERTEX_BIT,                           // stage
+		    vertexShader,                                         // module
+		    "main",                                               // pName
+		    nullptr,                                              // pSpecializationInfo
+		},
+		{
+		    VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,  // sType
+		    nullptr,                                              // pNext
+		    0,                                                    // flags
+		    VK_SHADER_STAGE_FRAGMENT_BIT,                         // stage
+		    fragmentShader,                                       // module
+		    "main",                                               // pName
+		    nullptr,                                              // pSpecializationInfo
+		},
+	};
+
+	const VkViewport viewport = {
+		0.0f,                        // x
+		0.0f,                        // y
+		static_cast<float>(width),   // width
+		static_cast<float>(height),  // height
+		0.0f,                        // minDepth
+		1.0f,                        // maxDepth
+	};
+
+	const VkRect2D scissor = {
+		{ 0, 0 },           // offset
+		{ width, height },  // extent
+	};
+
+	const VkPipelineViewportStateCreateInfo viewportState = {
+		VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,  // sType
+		nullptr,                                                // pNext
+		0,                                                      // flags
+		1,                                                      // viewportCount
+		&viewport,                                              // pViewports
+		1,                                                      // scissorCount
+		&scissor,                                               // pScissors
+	};
+
+	const VkPipelineMultisampleStateCreateInfo multisampleState = {
+		VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,  // sType
+		nullptr,                                                   // pNext
+		0,                                                         // flags
+		VK_SAMPLE_COUNT_1_BIT,                                     // rasterizationSamples
+		VK_FALSE,                                                  // sampleShadingEnable
+		0.0f,                                                      // minSampleShading
+		nullptr,                                                   // pSampleMask
+		VK_FALSE,                                                  // alphaToCoverageEnable
+		VK_FALSE,                                                  // alphaToOneEnable
+	};
+
+	const VkColorComponentFlags colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+	                                             VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+	const VkPipelineColorBlendAttachmentState blendAttachment = {
+		VK_FALSE,              // blendEnable
+		VK_BLEND_FACTOR_ONE,   // srcColorBlendFactor
+		VK_BLEND_FACTOR_ZERO,  // dstColorBlendFactor
+		VK_BLEND_OP_ADD,       // colorBlendOp
+		VK_BLEND_FACTOR_ONE,   // srcAlphaBlendFactor
+		VK_BLEND_FACTOR_ZERO,  // dstAlphaBlendFactor
+		VK_BLEND_OP_ADD,       // alphaBlendOp
+		colorWriteMask,        // colorWriteMask
+	};
+
+	const VkPipelineColorBlendStateCreateInfo blendState = {
+		VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,  // sType
+		nullptr,                                                   // pNext
+		0,                                                         // flags
+		VK_FALSE,                                                  // logicOpEnable
+		VK_LOGIC_OP_COPY,                                          // logicOp
+		1,                                                         // attachmentCount
+		&blendAttachment,                                          // pAttachments
+		{ 0.0f, 0.0f, 0.0f, 0.0f },                                // blendConstants
+	};
+
+	const VkGraphicsPipelineCreateInfo info = {
+		VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,  // sType
+		nullptr,                                          // pNext
+		0,                                                // flags
+		fragmentShader ? 2u : 1u,                         // stageCount
+		stages,                                           // pStages
+		&vertexInput,                                     // pVertexInputState
+		&inputAssembly,                                   // pInputAssemblyState
+		nullptr,                                          // pTessellationState
+		&viewportState,                                   // pViewportState
+		&rasterization,                                   // pRasterizationState
+		&multisampleState,                                // pMultisampleState
+		nullptr,                                          // pDepthStencilState
+		&blendState,                                      // pColorBlendState
+		nullptr,                                          // pDynamicState
+		pipelineLayout,                                   // layout
+		renderPass,                                       // renderPass
+		0,                                                // subpass
+		0,                                                // basePipelineHandle
+		0,                                                // basePipelineIndex
+	};
+
+	return driver->vkCreateGraphicsPipelines(device, 0, 1, &info, 0, out);
+}
+
 void Device::DestroyPipeline(VkPipeline pipeline) const
 {
 	driver->vkDestroyPipeline(device, pipeline, nullptr);
@@ -291,6 +416,21 @@ VkResult Device::CreateStorageBufferDescriptorPool(uint32_t descriptorCount,
 	return driver->vkCreateDescriptorPool(device, &info, 0, out);
 }
 
+VkResult Device::CreateDescriptorPool(const std::vector<VkDescriptorPoolSize> &sizes,
+                                      VkDescriptorPool *out) const
+{
+	VkDescriptorPoolCreateInfo info = {
+		VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,  // sType
+		nullptr,                                        // pNext
+		0,                                              // flags
+		1,                                              // maxSets
+		(uint32_t)sizes.size(),                         // poolSizeCount
+		sizes.data(),                                   // pPoolSizes
+	};
+
+	return driver->vkCreateDescriptorPool(device, &info, 0, out);
+}
+
 void Device::DestroyDescriptorPool(VkDescriptorPool descriptorPool) const
 {
 	driver->vkDestroyDescriptorPool(device, descriptorPool, nullptr);
@@ -336,6 +476,32 @@ void Device::UpdateStorageBufferDescriptorSets(
 	driver->vkUpdateDescriptorSets(device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
 }
 
+void Device::UpdateSampledImageDescriptorSet(
+    VkDescriptorSet descriptorSet, uint32_t binding,
+    VkImageView imageView) const
+{
+	const VkDescriptorImageInfo imageInfo = {
+		VK_NULL_HANDLE,                            // sampler
+		imageView,                                 // imageView
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,  // imageLayout
+	};
+
+	const VkWriteDescriptorSet write = {
+		VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,  // sType
+		nullptr,                                 // pNext
+		descriptorSet,                           // dstSet
+		binding,                                 // dstBinding
+		0,                                       // dstArrayElement
+		1,                                       // descriptorCount
+		VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,        // descriptorType
+		&imageInfo,                              // pImageInfo
+		nullptr,                                 // pBufferInfo
+		nullptr,                                 // pTexelBufferView
+	};
+
+	driver->vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
 VkResult Device::AllocateMemory(size_t size, VkMemoryPropertyFlags flags, VkDeviceMemory *out) const
 {
 	VkPhysicalDeviceMemoryProperties properties;
@@ -366,6 +532,18 @@ VkResult Device::AllocateMemory(size_t size, VkMemoryPropertyFlags flags, VkDevi
 	return VK_ERROR_OUT_OF_DEVICE_MEMORY;  // TODO: Change to something not made up?
 }
 
+VkResult Device::ImportMemory(const void *importInfo, size_t size, VkDeviceMemory *out) const
+{
+	const VkMemoryAllocateInfo info = {
+		VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,  // sType
+		importInfo,                              // pNext
+		size,                                    // allocationSize
+		0,                                       // memoryTypeIndex
+	};
+
+	return driver->vkAllocateMemory(device, &info, 0, out);
+}
+
 void Device::FreeMemory(VkDeviceMemory memory) const
 {
 	driver->vkFreeMemory(device, memory, nullptr);
@@ -382,6 +560,385 @@ void Device::UnmapMemory(VkDeviceMemory memory) const
 	driver->vkUnmapMemory(device, memory);
 }
 
+VkResult Device::CreateLinearImage(VkFormat format, uint32_t width, uint32_t height,
+                                   VkExternalMemoryHandleTypeFlags handleTypes, VkImage *out) const
+{
+	const VkExternalMemoryImageCreateInfo externalInfo = {
+		VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO,  // sType
+		nullptr,                                              // pNext
+		handleTypes,                                          // handleTypes
+	};
+
+	const VkImageCreateInfo info = {
+		VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,    // sType
+		handleTypes ? &externalInfo : nullptr,  // pNext
+		0,                                      // flags
+		VK_IMAGE_TYPE_2D,                       // imageType
+		format,                                 // format
+		{ width, height, 1 },                   // extent
+		1,                                      // mipLevels
+		1,                                      // arrayLayers
+		VK_SAMPLE_COUNT_1_BIT,                  // samples
+		VK_IMAGE_TILING_LINEAR,                 // tiling
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT,        // usage
+		VK_SHARING_MODE_EXCLUSIVE,              // sharingMode
+		0,                                      // queueFamilyIndexCount
+		nullptr,                                // pQueueFamilyIndices
+		VK_IMAGE_LAYOUT_UNDEFINED,              // initialLayout
+	};
+
+	return driver->vkCreateImage(device, &info, 0, out);
+}
+
+VkResult Device::CreateSampledImage(VkFormat format, uint32_t width, uint32_t height, uint32_t layers,
+                                    VkImageCreateFlags flags, VkImage *out) const
+{
+	const VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT |
+	                                VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+	                                VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+	const VkImageCreateInfo info = {
+		VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,                            // sType
+		nullptr,                                                        // pNext
+		flags,                                                          // flags
+		VK_IMAGE_TYPE_2D,                                               // imageType
+		format,                                                         // format
+		{ width, height, 1 },                                           // extent
+		1,                                                              // mipLevels
+		layers,                                                         // arrayLayers
+		VK_SAMPLE_COUNT_1_BIT,                                          // samples
+		VK_IMAGE_TILING_OPTIMAL,                                        // tiling
+		usage,                                                          // usage
+		VK_SHARING_MODE_EXCLUSIVE,                                      // sharingMode
+		0,                                                              // queueFamilyIndexCount
+		nullptr,                                                        // pQueueFamilyIndices
+		VK_IMAGE_LAYOUT_UNDEFINED,                                      // initialLayout
+	};
+
+	return driver->vkCreateImage(device, &info, 0, out);
+}
+
+VkResult Device::CreateMipmappedImage(VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels,
+                                      VkImage *out) const
+{
+	const VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT |
+	                                VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+	                                VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+	const VkImageCreateInfo info = {
+		VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,  // sType
+		nullptr,                              // pNext
+		0,                                    // flags
+		VK_IMAGE_TYPE_2D,                     // imageType
+		format,                               // format
+		{ width, height, 1 },                 // extent
+		mipLevels,                            // mipLevels
+		1,                                    // arrayLayers
+		VK_SAMPLE_COUNT_1_BIT,                // samples
+		VK_IMAGE_TILING_OPTIMAL,              // tiling
+		usage,                                // usage
+		VK_SHARING_MODE_EXCLUSIVE,            // sharingMode
+		0,                                    // queueFamilyIndexCount
+		nullptr,                              // pQueueFamilyIndices
+		VK_IMAGE_LAYOUT_UNDEFINED,            // initialLayout
+	};
+
+	return driver->vkCreateImage(device, &info, 0, out);
+}
+
+VkResult Device::CreateAttachmentImage(VkFormat format, uint32_t width, uint32_t height,
+                                       VkSampleCountFlagBits samples, VkImage *out) const
+{
+	const VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+	                                VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+	                                VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+	const VkImageCreateInfo info = {
+		VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,  // sType
+		nullptr,                              // pNext
+		0,                                    // flags
+		VK_IMAGE_TYPE_2D,                     // imageType
+		format,                               // format
+		{ width, height, 1 },                 // extent
+		1,                                    // mipLevels
+		1,                                    // arrayLayers
+		samples,                              // samples
+		VK_IMAGE_TILING_OPTIMAL,              // tiling
+		usage,                                // usage
+		VK_SHARING_MODE_EXCLUSIVE,            // sharingMode
+		0,                                    // queueFamilyIndexCount
+		nullptr,                              // pQueueFamilyIndices
+		VK_IMAGE_LAYOUT_UNDEFINED,            // initialLayout
+	};
+
+	return driver->vkCreateImage(device, &info, 0, out);
+}
+
+VkResult Device::CreateAttachmentImage(VkFormat format, uint32_t width, uint32_t height,
+                                       VkImageUsageFlags usage, VkImage *out) const
+{
+	const VkImageCreateInfo info = {
+		VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,  // sType
+		nullptr,                              // pNext
+		0,                                    // flags
+		VK_IMAGE_TYPE_2D,                     // imageType
+		format,                               // format
+		{ width, height, 1 },                 // extent
+		1,                                    // mipLevels
+		1,                                    // arrayLayers
+		VK_SAMPLE_COUNT_1_BIT,                // samples
+		VK_IMAGE_TILING_OPTIMAL,              // tiling
+		usage,                                // usage
+		VK_SHARING_MODE_EXCLUSIVE,            // sharingMode
+		0,                                    // queueFamilyIndexCount
+		nullptr,                              // pQueueFamilyIndices
+		VK_IMAGE_LAYOUT_UNDEFINED,            // initialLayout
+	};
+
+	return driver->vkCreateImage(device, &info, 0, out);
+}
+
+void Device::DestroyImage(VkImage image) const
+{
+	driver->vkDestroyImage(device, image, nullptr);
+}
+
+void Device::GetImageMemoryRequirements(VkImage image, VkMemoryRequirements *out) const
+{
+	driver->vkGetImageMemoryRequirements(device, image, out);
+}
+
+VkResult Device::BindImageMemory(VkImage image, VkDeviceMemory memory, VkDeviceSize offset) const
+{
+	return driver->vkBindImageMemory(device, image, memory, offset);
+}
+
+void Device::GetImageSubresourceLayout(VkImage image, VkSubresourceLayout *out) const
+{
+	const VkImageSubresource subresource = {
+		VK_IMAGE_ASPECT_COLOR_BIT,  // aspectMask
+		0,                          // mipLevel
+		0,                          // arrayLayer
+	};
+
+	driver->vkGetImageSubresourceLayout(device, image, &subresource, out);
+}
+
+VkResult Device::CreateImageView(VkImage image, VkImageViewType viewType, VkFormat format,
+                                 uint32_t layers, VkImageView *out) const
+{
+	const VkImageViewCreateInfo info = {
+		VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,  // sType
+		nullptr,                                   // pNext
+		0,                                         // flags
+		image,                                     // image
+		viewType,                                  // viewType
+		format,                                    // format
+		{
+		    VK_COMPONENT_SWIZZLE_IDENTITY,  // r
+		    VK_COMPONENT_SWIZZLE_IDENTITY,  // g
+		    VK_COMPONENT_SWIZZLE_IDENTITY,  // b
+		    VK_COMPONENT_SWIZZLE_IDENTITY,  // a
+		},
+		{
+		    VK_IMAGE_ASPECT_COLOR_BIT,  // aspectMask
+		    0,                          // baseMipLevel
+		    1,                          // levelCount
+		    0,                          // baseArrayLayer
+		    layers,                     // layerCount
+		},
+	};
+
+	return driver->vkCreateImageView(device, &info, 0, out);
+}
+
+VkResult Device::CreateDepthStencilImageView(VkImage image, VkFormat format, VkImageView *out) const
+{
+	const VkImageViewCreateInfo info = {
+		VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,  // sType
+		nullptr,                                   // pNext
+		0,                                         // flags
+		image,                                     // image
+		VK_IMAGE_VIEW_TYPE_2D,                     // viewType
+		format,                                    // format
+		{
+		    VK_COMPONENT_SWIZZLE_IDENTITY,  // r
+		    VK_COMPONENT_SWIZZLE_IDENTITY,  // g
+		    VK_COMPONENT_SWIZZLE_IDENTITY,  // b
+		    VK_COMPONENT_SWIZZLE_IDENTITY,  // a
+		},
+		{
+		    VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT,  // aspectMask
+		    0,                                                        // baseMipLevel
+		    1,                                                        // levelCount
+		    0,                                                        // baseArrayLayer
+		    1,                                                        // layerCount
+		},
+	};
+
+	return driver->vkCreateImageView(device, &info, 0, out);
+}
+
+void Device::DestroyImageView(VkImageView imageView) const
+{
+	driver->vkDestroyImageView(device, imageView, nullptr);
+}
+
+VkResult Device::CreateSampler(VkFilter filter, VkSampler *out) const
+{
+	const VkSamplerCreateInfo info = {
+		VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,    // sType
+		nullptr,                                  // pNext
+		0,                                        // flags
+		filter,                                   // magFilter
+		filter,                                   // minFilter
+		VK_SAMPLER_MIPMAP_MODE_NEAREST,           // mipmapMode
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,    // addressModeU
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,    // addressModeV
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,    // addressModeW
+		0.0f,                                     // mipLodBias
+		VK_FALSE,                                 // anisotropyEnable
+		1.0f,                                     // maxAnisotropy
+		VK_FALSE,                                 // compareEnable
+		VK_COMPARE_OP_NEVER,                      // compareOp
+		0.0f,                                     // minLod
+		0.0f,                                     // maxLod
+		VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,  // borderColor
+		VK_FALSE,                                 // unnormalizedCoordinates
+	};
+
+	return driver->vkCreateSampler(device, &info, nullptr, out);
+}
+
+void Device::DestroySampler(VkSampler sampler) const
+{
+	driver->vkDestroySampler(device, sampler, nullptr);
+}
+
+VkResult Device::CreateRenderPass(VkFormat format, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp,
+                                  VkRenderPass *out) const
+{
+	const VkAttachmentDescription attachment = {
+		0,                                 // flags
+		format,                            // format
+		VK_SAMPLE_COUNT_1_BIT,             // samples
+		loadOp,                            // loadOp
+		storeOp,                           // storeOp
+		VK_ATTACHMENT_LOAD_OP_DONT_CARE,   // stencilLoadOp
+		VK_ATTACHMENT_STORE_OP_DONT_CARE,  // stencilStoreOp
+		VK_IMAGE_LAYOUT_GENERAL,           // initialLayout
+		VK_IMAGE_LAYOUT_GENERAL,           // finalLayout
+	};
+
+	const VkAttachmentReference colorAttachment = {
+		0,                        // attachment
+		VK_IMAGE_LAYOUT_GENERAL,  // layout
+	};
+
+	const VkSubpassDescription subpass = {
+		0,                                // flags
+		VK_PIPELINE_BIND_POINT_GRAPHICS,  // pipelineBindPoint
+		0,                                // inputAttachmentCount
+		nullptr,                          // pInputAttachments
+		1,                                // colorAttachmentCount
+		&colorAttachment,                 // pColorAttachments
+		nullptr,                          // pResolveAttachments
+		nullptr,                          // pDepthStencilAttachment
+		0,                                // preserveAttachmentCount
+		nullptr,                          // pPreserveAttachments
+	};
+
+	const VkRenderPassCreateInfo info = {
+		VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,  // sType
+		nullptr,                                    // pNext
+		0,                                          // flags
+		1,                                          // attachmentCount
+		&attachment,                                // pAttachments
+		1,                                          // subpassCount
+		&subpass,                                   // pSubpasses
+		0,                                          // dependencyCount
+		nullptr,                                    // pDependencies
+	};
+
+	return driver->vkCreateRenderPass(device, &info, nullptr, out);
+}
+
+VkResult Device::CreateDepthStencilRenderPass(VkFormat format, VkAttachmentLoadOp depthLoadOp,
+                                              VkAttachmentLoadOp stencilLoadOp, VkRenderPass *out) const
+{
+	const VkAttachmentDescription attachment = {
+		0,                             // flags
+		format,                        // format
+		VK_SAMPLE_COUNT_1_BIT,         // samples
+		depthLoadOp,                   // loadOp
+		VK_ATTACHMENT_STORE_OP_STORE,  // storeOp
+		stencilLoadOp,                 // stencilLoadOp
+		VK_ATTACHMENT_STORE_OP_STORE,  // stencilStoreOp
+		VK_IMAGE_LAYOUT_GENERAL,       // initialLayout
+		VK_IMAGE_LAYOUT_GENERAL,       // finalLayout
+	};
+
+	const VkAttachmentReference depthStencilAttachment = {
+		0,                        // attachment
+		VK_IMAGE_LAYOUT_GENERAL,  // layout
+	};
+
+	const VkSubpassDescription subpass = {
+		0,                                // flags
+		VK_PIPELINE_BIND_POINT_GRAPHICS,  // pipelineBindPoint
+		0,                                // inputAttachmentCount
+		nullptr,                          // pInputAttachments
+		0,                                // colorAttachmentCount
+		nullptr,                          // pColorAttachments
+		nullptr,                          // pResolveAttachments
+		&depthStencilAttachment,          // pDepthStencilAttachment
+		0,                                // preserveAttachmentCount
+		nullptr,                          // pPreserveAttachments
+	};
+
+	const VkRenderPassCreateInfo info = {
+		VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,  // sType
+		nullptr,                                    // pNext
+		0,                                          // flags
+		1,                                          // attachmentCount
+		&attachment,                                // pAttachments
+		1,                                          // subpassCount
+		&subpass,                                   // pSubpasses
+		0,                                          // dependencyCount
+		nullptr,                                    // pDependencies
+	};
+
+	return driver->vkCreateRenderPass(device, &info, nullptr, out);
+}
+
+void Device::DestroyRenderPass(VkRenderPass renderPass) const
+{
+	driver->vkDestroyRenderPass(device, renderPass, nullptr);
+}
+
+VkResult Device::CreateFramebuffer(VkRenderPass renderPass, const std::vector<VkImageView> &attachments,
+                                   uint32_t width, uint32_t height, VkFramebuffer *out) const
+{
+	const VkFramebufferCreateInfo info = {
+		VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,  // sType
+		nullptr,                                    // pNext
+		0,                                          // flags
+		renderPass,                                 // renderPass
+		static_cast<uint32_t>(attachments.size()),  // attachmentCount
+		attachments.data(),                         // pAttachments
+		width,                                      // width
+		height,                                     // height
+		1,                                          // layers
+	};
+
+	return driver->vkCreateFramebuffer(device, &info, nullptr, out);
+}
+
+void Device::DestroyFramebuffer(VkFramebuffer framebuffer) const
+{
+	driver->vkDestroyFramebuffer(device, framebuffer, nullptr);
+}
+
 VkResult Device::CreateCommandPool(VkCommandPool *out) const
 {
 	VkCommandPoolCreateInfo info = {
@@ -454,3 +1011,119 @@ VkResult Device::QueueSubmitAndWait(VkCommandBuffer commandBuffer) const
 
 	return driver->vkQueueWaitIdle(queue);
 }
+
+VkResult Device::CreatePipelineStatisticsQueryPool(VkQueryPipelineStatisticFlags statistics,
+                                                   uint32_t count, VkQueryPool *out) const
+{
+	VkQueryPoolCreateInfo info = {
+		VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,  // sType
+		nullptr,                                   // pNext
+		0,                                         // flags
+		VK_QUERY_TYPE_PIPELINE_STATISTICS,         // queryType
+		count,                                     // queryCount
+		statistics,                                // pipelineStatistics
+	};
+	return driver->vkCreateQueryPool(device, &info, nullptr, out);
+}
+
+void Device::DestroyQueryPool(VkQueryPool queryPool) const
+{
+	driver->vkDestroyQueryPool(device, queryPool, nullptr);
+}
+
+VkResult Device::GetQueryPoolResults(VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount,
+                                     size_t dataSize, void *pData, VkDeviceSize stride,
+                                     VkQueryResultFlags flags) const
+{
+	return driver->vkGetQueryPoolResults(device, queryPool, firstQuery, queryCount,
+	                                     dataSize, pData, stride, flags);
+}
+
+VkResult Device::CreateSwapchain(VkSurfaceKHR surface, VkFormat format, uint32_t width, uint32_t height,
+                                 VkSwapchainKHR *out) const
+{
+	const VkSwapchainCreateInfoKHR info = {
+		VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,  // sType
+		nullptr,                                      // pNext
+		0,                                            // flags
+		surface,                                      // surface
+		1,                                            // minImageCount
+		format,                                       // imageFormat
+		VK_COLOR_SPACE_SRGB_NONLINEAR_KHR,            // imageColorSpace
+		{ width, height },                            // imageExtent
+		1,                                            // imageArrayLayers
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+		    VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+		    VK_IMAGE_USAGE_TRANSFER_DST_BIT,  // imageUsage
+		VK_SHARING_MODE_EXCLUSIVE,            // imageSharingMode
+		0,                                    // queueFamilyIndexCount
+		nullptr,                              // pQueueFamilyIndices
+		VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR,  // preTransform
+		VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,      // compositeAlpha
+		VK_PRESENT_MODE_FIFO_KHR,               // presentMode
+		VK_TRUE,                                // clipped
+		VK_NULL_HANDLE,                         // oldSwapchain
+	};
+	return driver->vkCreateSwapchainKHR(device, &info, nullptr, out);
+}
+
+void Device::DestroySwapchain(VkSwapchainKHR swapchain) const
+{
+	driver->vkDestroySwapchainKHR(device, swapchain, nullptr);
+}
+
+VkResult Device::GetSwapchainImages(VkSwapchainKHR swapchain, std::vector<VkImage> &out) const
+{
+	uint32_t count = 0;
+	VkResult result = driver->vkGetSwapchainImagesKHR(device, swapchain, &count, nullptr);
+	if(result != VK_SUCCESS)
+	{
+		return result;
+	}
+
+	out.resize(count);
+	return driver->vkGetSwapchainImagesKHR(device, swapchain, &count, out.data());
+}
+
+VkResult Device::AcquireNextImage(VkSwapchainKHR swapchain, uint32_t *imageIndex) const
+{
+	const VkFenceCreateInfo info = {
+		VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,  // sType
+		nullptr,                              // pNext
+		0,                                    // flags
+	};
+
+	VkFence fence;
+	VkResult result = driver->vkCreateFence(device, &info, nullptr, &fence);
+	if(result != VK_SUCCESS)
+	{
+		return result;
+	}
+
+	result = driver->vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, VK_NULL_HANDLE, fence, imageIndex);
+	if(result == VK_SUCCESS)
+	{
+		result = driver->vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+	}
+
+	driver->vkDestroyFence(device, fence, nullptr);
+	return result;
+}
+
+VkResult Device::QueuePresent(VkSwapchainKHR swapchain, uint32_t imageIndex) const
+{
+	VkQueue queue;
+	driver->vkGetDeviceQueue(device, queueFamilyIndex, 0, &queue);
+
+	const VkPresentInfoKHR info = {
+		VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,  // sType
+		nullptr,                             // pNext
+		0,                                   // waitSemaphoreCount
+		nullptr,                             // pWaitSemaphores
+		1,                                   // swapchainCount
+		&swapchain,                          // pSwapchains
+		&imageIndex,                         // pImageIndices
+		nullptr,                             // pResults
+	};
+	return driver->vkQueuePresentKHR(queue, &info);
+}
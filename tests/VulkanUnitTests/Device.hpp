@@ -29,13 +29,14 @@ public:
 
 	// CreateComputeDevice enumerates the physical devices, looking for a device
 	// that supports compute.
-	// If a compatible physical device is found, then a device is created and
-	// assigned to out.
+	// If a compatible physical device is found, then a device is created with
+	// the given extensions enabled and assigned to out.
 	// If a compatible physical device is not found, VK_SUCCESS will still be
 	// returned (as there was no Vulkan error), but calling Device::IsValid()
 	// on this device will return false.
 	static VkResult CreateComputeDevice(
-	    Driver const *driver, VkInstance instance, std::unique_ptr<Device> &out);
+	    Driver const *driver, VkInstance instance, std::unique_ptr<Device> &out,
+	    const std::vector<const char *> &extensions = {});
 
 	// IsValid returns true if the Device is initialized and can be used.
 	bool IsValid() const;
@@ -46,6 +47,11 @@ public:
 	VkResult CreateStorageBuffer(VkDeviceMemory memory, VkDeviceSize size,
 	                             VkDeviceSize offset, VkBuffer *out) const;
 
+	// CreateBuffer creates a new buffer with the given usage, and
+	// VK_SHARING_MODE_EXCLUSIVE sharing mode.
+	VkResult CreateBuffer(VkBufferUsageFlags usage, VkDeviceMemory memory, VkDeviceSize size,
+	                      VkDeviceSize offset, VkBuffer *out) const;
+
 	// DestroyBuffer destroys a VkBuffer.
 	void DestroyBuffer(VkBuffer buffer) const;
 
@@ -79,6 +85,17 @@ public:
 	                               VkPipelineLayout pipelineLayout,
 	                               VkPipeline *out) const;
 
+	// CreateGraphicsPipeline creates a new graphics pipeline for subpass 0 of
+	// renderPass, with the entry points "main" and a static viewport and
+	// scissor of width by height pixels. Multisampling, blending and depth and
+	// stencil tests are disabled. fragmentShader may be VK_NULL_HANDLE.
+	VkResult CreateGraphicsPipeline(VkShaderModule vertexShader, VkShaderModule fragmentShader,
+	                                const VkPipelineVertexInputStateCreateInfo &vertexInput,
+	                                const VkPipelineInputAssemblyStateCreateInfo &inputAssembly,
+	                                const VkPipelineRasterizationStateCreateInfo &rasterization,
+	                                VkPipelineLayout pipelineLayout, VkRenderPass renderPass,
+	                                uint32_t width, uint32_t height, VkPipeline *out) const;
+
 	// DestroyPipeline destroys a graphics or compute pipeline.
 	void DestroyPipeline(VkPipeline pipeline) const;
 
@@ -87,6 +104,11 @@ public:
 	VkResult CreateStorageBufferDescriptorPool(uint32_t descriptorCount,
 	                                           VkDescriptorPool *out) const;
 
+	// CreateDescriptorPool creates a new descriptor pool that can hold a single
+	// set with the given descriptors.
+	VkResult CreateDescriptorPool(const std::vector<VkDescriptorPoolSize> &sizes,
+	                              VkDescriptorPool *out) const;
+
 	// DestroyDescriptorPool destroys the VkDescriptorPool.
 	void DestroyDescriptorPool(VkDescriptorPool descriptorPool) const;
 
@@ -101,12 +123,22 @@ public:
 	void UpdateStorageBufferDescriptorSets(VkDescriptorSet descriptorSet,
 	                                       const std::vector<VkDescriptorBufferInfo> &bufferInfos) const;
 
+	// UpdateSampledImageDescriptorSet writes imageView as the sampled image at
+	// the given binding of descriptorSet.
+	void UpdateSampledImageDescriptorSet(VkDescriptorSet descriptorSet, uint32_t binding,
+	                                     VkImageView imageView) const;
+
 	// AllocateMemory allocates size bytes from a memory heap that has all the
 	// given flag bits set.
 	// If memory could not be allocated from any heap then
 	// VK_ERROR_OUT_OF_DEVICE_MEMORY is returned.
 	VkResult AllocateMemory(size_t size, VkMemoryPropertyFlags flags, VkDeviceMemory *out) const;
 
+	// ImportMemory creates a size byte allocation backed by the external
+	// memory described by importInfo, which is chained to the
+	// VkMemoryAllocateInfo.
+	VkResult ImportMemory(const void *importInfo, size_t size, VkDeviceMemory *out) const;
+
 	// FreeMemory frees the VkDeviceMemory.
 	void FreeMemory(VkDeviceMemory memory) const;
 
@@ -117,6 +149,93 @@ public:
 	// UnmapMemory wraps vkUnmapMemory, supplying the first VkDevice parameter.
 	void UnmapMemory(VkDeviceMemory memory) const;
 
+	// CreateLinearImage creates a new single-level, linearly tiled 2D image
+	// usable as a transfer destination, which can be bound to external memory
+	// of the given handle types.
+	VkResult CreateLinearImage(VkFormat format, uint32_t width, uint32_t height,
+	                           VkExternalMemoryHandleTypeFlags handleTypes, VkImage *out) const;
+
+	// CreateSampledImage creates a new single-level, optimally tiled 2D image
+	// with the given number of array layers and create flags, usable for
+	// transfers and for sampling.
+	VkResult CreateSampledImage(VkFormat format, uint32_t width, uint32_t height, uint32_t layers,
+	                            VkImageCreateFlags flags, VkImage *out) const;
+
+	// CreateMipmappedImage creates a new optimally tiled 2D image with the
+	// given number of mip levels, usable for transfers and for sampling.
+	VkResult CreateMipmappedImage(VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels,
+	                              VkImage *out) const;
+
+	// CreateAttachmentImage creates a new single-level, optimally tiled 2D image
+	// with the given sample count, usable as a color attachment and for
+	// transfers.
+	VkResult CreateAttachmentImage(VkFormat format, uint32_t width, uint32_t height,
+	                               VkSampleCountFlagBits samples, VkImage *out) const;
+
+	// CreateAttachmentImage creates a new single-sample, single-level, optimally
+	// tiled 2D image with the given usage.
+	VkResult CreateAttachmentImage(VkFormat format, uint32_t width, uint32_t height,
+	                               VkImageUsageFlags usage, VkImage *out) const;
+
+	// DestroyImage destroys a VkImage.
+	void DestroyImage(VkImage image) const;
+
+	// GetImageMemoryRequirements wraps vkGetImageMemoryRequirements, supplying
+	// the first VkDevice parameter.
+	void GetImageMemoryRequirements(VkImage image, VkMemoryRequirements *out) const;
+
+	// BindImageMemory wraps vkBindImageMemory, supplying the first VkDevice
+	// parameter.
+	VkResult BindImageMemory(VkImage image, VkDeviceMemory memory, VkDeviceSize offset) const;
+
+	// GetImageSubresourceLayout returns the layout of the color aspect of the
+	// image's first mip level and array layer.
+	void GetImageSubresourceLayout(VkImage image, VkSubresourceLayout *out) const;
+
+	// CreateImageView creates a new view of the color aspect of all the
+	// image's layers, with the given view type.
+	VkResult CreateImageView(VkImage image, VkImageViewType viewType, VkFormat format,
+	                         uint32_t layers, VkImageView *out) const;
+
+	// CreateDepthStencilImageView creates a new 2D view of the depth and
+	// stencil aspects of the image's first layer.
+	VkResult CreateDepthStencilImageView(VkImage image, VkFormat format, VkImageView *out) const;
+
+	// DestroyImageView destroys a VkImageView.
+	void DestroyImageView(VkImageView imageView) const;
+
+	// CreateSampler creates a new sampler with normalized coordinates, which
+	// clamps them to the edge, and uses the given filter for all lookups.
+	VkResult CreateSampler(VkFilter filter, VkSampler *out) const;
+
+	// DestroySampler destroys a VkSampler.
+	void DestroySampler(VkSampler sampler) const;
+
+	// CreateRenderPass creates a new render pass with a single subpass, which
+	// renders to one color attachment of the given format. The attachment is
+	// loaded and stored with the given operations, and is in the
+	// VK_IMAGE_LAYOUT_GENERAL layout before and after the render pass.
+	VkResult CreateRenderPass(VkFormat format, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp,
+	                          VkRenderPass *out) const;
+
+	// CreateDepthStencilRenderPass creates a new render pass with a single
+	// subpass, which renders to one depth/stencil attachment of the given
+	// format. Each aspect is loaded with its own operation, and stored.
+	// The attachment is in the VK_IMAGE_LAYOUT_GENERAL layout throughout.
+	VkResult CreateDepthStencilRenderPass(VkFormat format, VkAttachmentLoadOp depthLoadOp,
+	                                      VkAttachmentLoadOp stencilLoadOp, VkRenderPass *out) const;
+
+	// DestroyRenderPass destroys a VkRenderPass.
+	void DestroyRenderPass(VkRenderPass renderPass) const;
+
+	// CreateFramebuffer creates a new single-layer framebuffer of width by
+	// height pixels for renderPass, with the given attachments.
+	VkResult CreateFramebuffer(VkRenderPass renderPass, const std::vector<VkImageView> &attachments,
+	                           uint32_t width, uint32_t height, VkFramebuffer *out) const;
+
+	// DestroyFramebuffer destroys a VkFramebuffer.
+	void DestroyFramebuffer(VkFramebuffer framebuffer) const;
+
 	// CreateCommandPool creates a new command pool.
 	VkResult CreateCommandPool(VkCommandPool *out) const;
 
@@ -136,6 +255,39 @@ public:
 	// complete.
 	VkResult QueueSubmitAndWait(VkCommandBuffer commandBuffer) const;
 
+	// CreatePipelineStatisticsQueryPool creates a new pool of count pipeline
+	// statistics queries, gathering the given statistics.
+	VkResult CreatePipelineStatisticsQueryPool(VkQueryPipelineStatisticFlags statistics,
+	                                           uint32_t count, VkQueryPool *out) const;
+
+	// DestroyQueryPool destroys a VkQueryPool.
+	void DestroyQueryPool(VkQueryPool queryPool) const;
+
+	// CreateSwapchain creates a new FIFO swapchain of width by height images
+	// for surface, usable as color attachments and for transfers. The device
+	// must have been created with the VK_KHR_swapchain extension.
+	VkResult CreateSwapchain(VkSurfaceKHR surface, VkFormat format, uint32_t width, uint32_t height,
+	                         VkSwapchainKHR *out) const;
+
+	// DestroySwapchain destroys a VkSwapchainKHR.
+	void DestroySwapchain(VkSwapchainKHR swapchain) const;
+
+	// GetSwapchainImages returns the images of swapchain.
+	VkResult GetSwapchainImages(VkSwapchainKHR swapchain, std::vector<VkImage> &out) const;
+
+	// AcquireNextImage acquires the next presentable image of swapchain and
+	// waits for it to become available.
+	VkResult AcquireNextImage(VkSwapchainKHR swapchain, uint32_t *imageIndex) const;
+
+	// QueuePresent presents the image of swapchain with the given index.
+	VkResult QueuePresent(VkSwapchainKHR swapchain, uint32_t imageIndex) const;
+
+	// GetQueryPoolResults wraps vkGetQueryPoolResults, supplying the first
+	// VkDevice parameter.
+	VkResult GetQueryPoolResults(VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount,
+	                             size_t dataSize, void *pData, VkDeviceSize stride,
+	                             VkQueryResultFlags flags) const;
+
 	static VkResult GetPhysicalDevices(
 	    Driver const *driver, VkInstance instance,
 	    std::vector<VkPhysicalDevice> &out);
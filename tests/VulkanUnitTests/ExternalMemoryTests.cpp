@@ -0,0 +1,225 @@
+// Copyright 2021 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#if defined(__linux__) && !defined(__ANDROID__)
+
+#	include "VulkanTest.hpp"
+
+#	include "gmock/gmock.h"
+#	include "gtest/gtest.h"
+
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/wait.h>
+#	include <unistd.h>
+
+#	include <cstring>
+#	include <functional>
+
+namespace {
+
+constexpr uint32_t kWidth = 64;
+constexpr uint32_t kHeight = 32;
+constexpr uint32_t kClearColor = 0x80FF4020;  // RGBA8 bytes 0x20, 0x40, 0xFF, 0x80
+
+// Runs |check| in a forked process and returns true if it succeeded there.
+// The child process only reads memory, so it never calls back into Vulkan.
+bool RunInChildProcess(const std::function<bool()> &check)
+{
+	pid_t pid = fork();
+	if(pid < 0)
+	{
+		return false;
+	}
+
+	if(pid == 0)
+	{
+		_exit(check() ? 0 : 1);
+	}
+
+	int status = 0;
+	if(waitpid(pid, &status, 0) != pid)
+	{
+		return false;
+	}
+
+	return WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+}
+
+// Returns true if every texel of the image described by |layout| holds the
+// clear color.
+bool HasClearColor(const uint8_t *memory, const VkSubresourceLayout &layout)
+{
+	for(uint32_t y = 0; y < kHeight; y++)
+	{
+		const uint8_t *row = memory + layout.offset + y * layout.rowPitch;
+		for(uint32_t x = 0; x < kWidth; x++)
+		{
+			uint32_t texel;
+			memcpy(&texel, row + x * sizeof(texel), sizeof(texel));
+			if(texel != kClearColor)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+}  // anonymous namespace
+
+class ExternalMemoryTest : public VulkanTest
+{
+protected:
+	// Clears the whole image with kClearColor and waits for completion.
+	void clearImage(VkImage image)
+	{
+		VkCommandPool commandPool;
+		VK_ASSERT(device->CreateCommandPool(&commandPool));
+
+		VkCommandBuffer commandBuffer;
+		VK_ASSERT(device->AllocateCommandBuffer(commandPool, &commandBuffer));
+		VK_ASSERT(device->BeginCommandBuffer(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, commandBuffer));
+
+		VkClearColorValue color;
+		color.uint32[0] = kClearColor & 0xFF;
+		color.uint32[1] = (kClearColor >> 8) & 0xFF;
+		color.uint32[2] = (kClearColor >> 16) & 0xFF;
+		color.uint32[3] = (kClearColor >> 24) & 0xFF;
+
+		const VkImageSubresourceRange range = {
+			VK_IMAGE_ASPECT_COLOR_BIT,  // aspectMask
+			0,                          // baseMipLevel
+			1,                          // levelCount
+			0,                          // baseArrayLayer
+			1,                          // layerCount
+		};
+
+		driver.vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL, &color, 1, &range);
+
+		VK_ASSERT(driver.vkEndCommandBuffer(commandBuffer));
+		VK_ASSERT(device->QueueSubmitAndWait(commandBuffer));
+
+		device->FreeCommandBuffer(commandPool, commandBuffer);
+		device->DestroyCommandPool(commandPool);
+	}
+};
+
+// Render into a sealed memfd imported as a dma-buf, and read the result back
+// from another process through its own mapping of the same region.
+TEST_F(ExternalMemoryTest, DmaBufImportSharedWithChildProcess)
+{
+	VkImage image;
+	VK_ASSERT(device->CreateLinearImage(VK_FORMAT_R8G8B8A8_UINT, kWidth, kHeight,
+	                                    VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT, &image));
+
+	VkMemoryRequirements requirements;
+	device->GetImageMemoryRequirements(image, &requirements);
+
+	int memfd = memfd_create("ExternalMemoryTest", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	ASSERT_GE(memfd, 0);
+	ASSERT_EQ(ftruncate(memfd, requirements.size), 0);
+	ASSERT_EQ(fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL), 0);
+
+	// A successful import takes ownership of the file descriptor.
+	const VkImportMemoryFdInfoKHR importInfo = {
+		VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR,     // sType
+		nullptr,                                         // pNext
+		VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,  // handleType
+		dup(memfd),                                      // fd
+	};
+
+	VkDeviceMemory memory;
+	VK_ASSERT(device->ImportMemory(&importInfo, requirements.size, &memory));
+	VK_ASSERT(device->BindImageMemory(image, memory, 0));
+
+	VkSubresourceLayout layout;
+	device->GetImageSubresourceLayout(image, &layout);
+
+	clearImage(image);
+
+	EXPECT_TRUE(RunInChildProcess([&]() {
+		void *pixels = mmap(nullptr, requirements.size, PROT_READ, MAP_SHARED, memfd, 0);
+		return (pixels != MAP_FAILED) && HasClearColor(static_cast<const uint8_t *>(pixels), layout);
+	}));
+
+	device->DestroyImage(image);
+	device->FreeMemory(memory);
+	close(memfd);
+}
+
+// Importing a region smaller than the allocation must fail rather than fault.
+TEST_F(ExternalMemoryTest, DmaBufImportTooSmall)
+{
+	int memfd = memfd_create("ExternalMemoryTest", MFD_CLOEXEC);
+	ASSERT_GE(memfd, 0);
+	ASSERT_EQ(ftruncate(memfd, 4096), 0);
+
+	const VkImportMemoryFdInfoKHR importInfo = {
+		VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR,     // sType
+		nullptr,                                         // pNext
+		VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,  // handleType
+		memfd,                                           // fd
+	};
+
+	VkDeviceMemory memory;
+	EXPECT_EQ(device->ImportMemory(&importInfo, 2 * 4096, &memory), VK_ERROR_INVALID_EXTERNAL_HANDLE);
+
+	// The application keeps ownership of the descriptor after a failed import.
+	EXPECT_EQ(close(memfd), 0);
+}
+
+// Render into a shared anonymous mapping imported as host memory, and read
+// the result back from another process.
+TEST_F(ExternalMemoryTest, HostPointerImportSharedWithChildProcess)
+{
+	VkImage image;
+	VK_ASSERT(device->CreateLinearImage(VK_FORMAT_R8G8B8A8_UINT, kWidth, kHeight,
+	                                    VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT, &image));
+
+	VkMemoryRequirements requirements;
+	device->GetImageMemoryRequirements(image, &requirements);
+
+	const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	const size_t size = pageSize * ((requirements.size + pageSize - 1) / pageSize);
+	void *host = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	ASSERT_NE(host, MAP_FAILED);
+
+	const VkImportMemoryHostPointerInfoEXT importInfo = {
+		VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT,   // sType
+		nullptr,                                                 // pNext
+		VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT,  // handleType
+		host,                                                    // pHostPointer
+	};
+
+	VkDeviceMemory memory;
+	VK_ASSERT(device->ImportMemory(&importInfo, size, &memory));
+	VK_ASSERT(device->BindImageMemory(image, memory, 0));
+
+	VkSubresourceLayout layout;
+	device->GetImageSubresourceLayout(image, &layout);
+
+	clearImage(image);
+
+	EXPECT_TRUE(RunInChildProcess([&]() {
+		return HasClearColor(static_cast<const uint8_t *>(host), layout);
+	}));
+
+	device->DestroyImage(image);
+	device->FreeMemory(memory);
+	munmap(host, size);
+}
+
+#endif  // defined(__linux__) && !defined(__ANDROID__)
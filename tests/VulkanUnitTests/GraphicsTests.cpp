@@ -0,0 +1,1143 @@
+// Copyright 2021 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "VulkanTest.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <vulkan/vk_ext_provoking_vertex.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <tuple>
+
+namespace {
+
+constexpr uint32_t kSize = 16;
+constexpr VkFormat kFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+// Vertex has a clip space position and a color, which is flat shaded.
+struct Vertex
+{
+	float position[4];
+	float color[4];
+};
+
+// Passes the position and color through.
+// #version 450
+// layout(location = 0) in vec4 inPosition;
+// layout(location = 1) in vec4 inColor;
+// layout(location = 0) out vec4 outColor;
+// void main()
+// {
+//     gl_Position = inPosition;
+//     outColor = inColor;
+// }
+// clang-format off
+const char *kVertexShader =
+    "OpCapability Shader\n"
+    "OpMemoryModel Logical GLSL450\n"
+    "OpEntryPoint Vertex %1 \"main\" %2 %3 %4 %5\n"
+    "OpDecorate %2 Location 0\n"
+    "OpDecorate %3 Location 1\n"
+    "OpDecorate %4 BuiltIn Position\n"
+    "OpDecorate %5 Location 0\n"
+    "%6 = OpTypeVoid\n"
+    "%7 = OpTypeFunction %6\n"         // void()
+    "%8 = OpTypeFloat 32\n"            // float
+    "%9 = OpTypeVector %8 4\n"         // vec4
+    "%10 = OpTypePointer Input %9\n"   // vec4*
+    "%11 = OpTypePointer Output %9\n"  // vec4*
+    "%2 = OpVariable %10 Input\n"      // inPosition
+    "%3 = OpVariable %10 Input\n"      // inColor
+    "%4 = OpVariable %11 Output\n"     // gl_Position
+    "%5 = OpVariable %11 Output\n"     // outColor
+    "%1 = OpFunction %6 None %7\n"     // -- Function begin --
+    "%12 = OpLabel\n"
+    "%13 = OpLoad %9 %2\n"
+    "OpStore %4 %13\n"
+    "%14 = OpLoad %9 %3\n"
+    "OpStore %5 %14\n"
+    "OpReturn\n"
+    "OpFunctionEnd\n";
+// clang-format on
+
+// Writes the color of the provoking vertex.
+// #version 450
+// layout(location = 0) flat in vec4 inColor;
+// layout(location = 0) out vec4 outColor;
+// void main()
+// {
+//     outColor = inColor;
+// }
+// clang-format off
+const char *kFragmentShader =
+    "OpCapability Shader\n"
+    "OpMemoryModel Logical GLSL450\n"
+    "OpEntryPoint Fragment %1 \"main\" %2 %3\n"
+    "OpExecutionMode %1 OriginUpperLeft\n"
+    "OpDecorate %2 Location 0\n"
+    "OpDecorate %2 Flat\n"
+    "OpDecorate %3 Location 0\n"
+    "%4 = OpTypeVoid\n"
+    "%5 = OpTypeFunction %4\n"        // void()
+    "%6 = OpTypeFloat 32\n"           // float
+    "%7 = OpTypeVector %6 4\n"        // vec4
+    "%8 = OpTypePointer Input %7\n"   // vec4*
+    "%9 = OpTypePointer Output %7\n"  // vec4*
+    "%2 = OpVariable %8 Input\n"      // inColor
+    "%3 = OpVariable %9 Output\n"     // outColor
+    "%1 = OpFunction %4 None %5\n"    // -- Function begin --
+    "%10 = OpLabel\n"
+    "%11 = OpLoad %7 %2\n"
+    "OpStore %3 %11\n"
+    "OpReturn\n"
+    "OpFunctionEnd\n";
+// clang-format on
+
+VkPipelineInputAssemblyStateCreateInfo InputAssemblyState(VkPrimitiveTopology topology, VkBool32 primitiveRestartEnable = VK_FALSE)
+{
+	return {
+		VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,  // sType
+		nullptr,                                                      // pNext
+		0,                                                            // flags
+		topology,                                                     // topology
+		primitiveRestartEnable,                                       // primitiveRestartEnable
+	};
+}
+
+VkPipelineRasterizationStateCreateInfo RasterizationState(VkCullModeFlags cullMode = VK_CULL_MODE_NONE, const void *pNext = nullptr)
+{
+	return {
+		VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,  // sType
+		pNext,                                                       // pNext
+		0,                                                           // flags
+		VK_FALSE,                                                    // depthClampEnable
+		VK_FALSE,                                                    // rasterizerDiscardEnable
+		VK_POLYGON_MODE_FILL,                                        // polygonMode
+		cullMode,                                                    // cullMode
+		VK_FRONT_FACE_COUNTER_CLOCKWISE,                             // frontFace
+		VK_FALSE,                                                    // depthBiasEnable
+		0.0f,                                                        // depthBiasConstantFactor
+		0.0f,                                                        // depthBiasClamp
+		0.0f,                                                        // depthBiasSlopeFactor
+		1.0f,                                                        // lineWidth
+	};
+}
+
+}  // anonymous namespace
+
+// GraphicsTest renders Vertex primitives with the shaders above into a
+// kSize by kSize color attachment, which is read back after submission.
+class GraphicsTest : public VulkanTest
+{
+protected:
+	void SetUp() override
+	{
+		VulkanTest::SetUp();
+		ASSERT_FALSE(HasFatalFailure());
+
+		VK_ASSERT(device->CreateAttachmentImage(kFormat, kSize, kSize, VK_SAMPLE_COUNT_1_BIT, &image));
+
+		VkMemoryRequirements requirements;
+		device->GetImageMemoryRequirements(image, &requirements);
+		VK_ASSERT(device->AllocateMemory(requirements.size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &imageMemory));
+		VK_ASSERT(device->BindImageMemory(image, imageMemory, 0));
+		VK_ASSERT(device->CreateImageView(image, VK_IMAGE_VIEW_TYPE_2D, kFormat, 1, &imageView));
+
+		VK_ASSERT(device->CreateRenderPass(kFormat, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, &renderPass));
+		VK_ASSERT(device->CreateFramebuffer(renderPass, { imageView }, kSize, kSize, &framebuffer));
+
+		createBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT, nullptr, sizeof(pixels), &readbackBuffer);
+		readbackMemory = bufferMemories.back();
+
+		VK_ASSERT(device->CreateShaderModule(compileSpirv(kVertexShader), &vertexShader));
+		VK_ASSERT(device->CreateShaderModule(compileSpirv(kFragmentShader), &fragmentShader));
+		VK_ASSERT(device->CreateDescriptorSetLayout({}, &descriptorSetLayout));
+		VK_ASSERT(device->CreatePipelineLayout(descriptorSetLayout, &pipelineLayout));
+
+		VK_ASSERT(device->CreateCommandPool(&commandPool));
+		VK_ASSERT(device->AllocateCommandBuffer(commandPool, &commandBuffer));
+		VK_ASSERT(device->BeginCommandBuffer(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, commandBuffer));
+	}
+
+	void TearDown() override
+	{
+		device->FreeCommandBuffer(commandPool, commandBuffer);
+		device->DestroyCommandPool(commandPool);
+
+		for(auto pipeline : pipelines)
+		{
+			device->DestroyPipeline(pipeline);
+		}
+
+		device->DestroyPipelineLayout(pipelineLayout);
+		device->DestroyDescriptorSetLayout(descriptorSetLayout);
+		device->DestroyShaderModule(fragmentShader);
+		device->DestroyShaderModule(vertexShader);
+
+		for(size_t i = 0; i < buffers.size(); i++)
+		{
+			device->DestroyBuffer(buffers[i]);
+			device->FreeMemory(bufferMemories[i]);
+		}
+
+		device->DestroyFramebuffer(framebuffer);
+		device->DestroyRenderPass(renderPass);
+		device->DestroyImageView(imageView);
+		device->DestroyImage(image);
+		device->FreeMemory(imageMemory);
+
+		VulkanTest::TearDown();
+	}
+
+	// Creates a host visible buffer with the given usage, initialized with
+	// size bytes of data, if not null.
+	void createBuffer(VkBufferUsageFlags usage, const void *data, VkDeviceSize size, VkBuffer *out)
+	{
+		VkDeviceMemory memory;
+		VK_ASSERT(device->AllocateMemory(size, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &memory));
+		VK_ASSERT(device->CreateBuffer(usage, memory, size, 0, out));
+
+		if(data)
+		{
+			void *mapped;
+			VK_ASSERT(device->MapMemory(memory, 0, size, 0, &mapped));
+			memcpy(mapped, data, size);
+			device->UnmapMemory(memory);
+		}
+
+		buffers.push_back(*out);
+		bufferMemories.push_back(memory);
+	}
+
+	// Creates a vertex buffer holding the given vertices.
+	void createVertexBuffer(const std::vector<Vertex> &vertices, VkBuffer *out)
+	{
+		createBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertices.data(), vertices.size() * sizeof(Vertex), out);
+	}
+
+	// Creates a pipeline drawing Vertex primitives with the shaders above.
+	// Without a fragment shader, the attachment contents are undefined.
+	void createPipeline(const VkPipelineInputAssemblyStateCreateInfo &inputAssembly,
+	                    const VkPipelineRasterizationStateCreateInfo &rasterization,
+	                    bool withFragmentShader, VkPipeline *out)
+	{
+		const VkVertexInputBindingDescription binding = {
+			0,                            // binding
+			sizeof(Vertex),               // stride
+			VK_VERTEX_INPUT_RATE_VERTEX,  // inputRate
+		};
+
+		const VkVertexInputAttributeDescription attributes[] = {
+			{ 0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Vertex, position) },
+			{ 1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Vertex, color) },
+		};
+
+		const VkPipelineVertexInputStateCreateInfo vertexInput = {
+			VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,  // sType
+			nullptr,                                                    // pNext
+			0,                                                          // flags
+			1,                                                          // vertexBindingDescriptionCount
+			&binding,                                                   // pVertexBindingDescriptions
+			2,                                                          // vertexAttributeDescriptionCount
+			attributes,                                                 // pVertexAttributeDescriptions
+		};
+
+		VK_ASSERT(device->CreateGraphicsPipeline(vertexShader, withFragmentShader ? fragmentShader : VK_NULL_HANDLE,
+		                                         vertexInput, inputAssembly, rasterization,
+		                                         pipelineLayout, renderPass, kSize, kSize, out));
+		pipelines.push_back(*out);
+	}
+
+	// Begins the render pass, clearing the color attachment to zero.
+	void beginRenderPass()
+	{
+		const VkClearValue clearValue = {};
+
+		const VkRenderPassBeginInfo info = {
+			VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,  // sType
+			nullptr,                                   // pNext
+			renderPass,                                // renderPass
+			framebuffer,                               // framebuffer
+			{ { 0, 0 }, { kSize, kSize } },            // renderArea
+			1,                                         // clearValueCount
+			&clearValue,                               // pClearValues
+		};
+
+		driver.vkCmdBeginRenderPass(commandBuffer, &info, VK_SUBPASS_CONTENTS_INLINE);
+	}
+
+	// Makes the results of all previous commands visible to later ones.
+	void barrier()
+	{
+		const VkMemoryBarrier barrier = {
+			VK_STRUCTURE_TYPE_MEMORY_BARRIER,                         // sType
+			nullptr,                                                  // pNext
+			VK_ACCESS_MEMORY_WRITE_BIT,                               // srcAccessMask
+			VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,  // dstAccessMask
+		};
+
+		driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		                            0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	// Copies the color attachment into the readback buffer, submits the
+	// command buffer and waits for it to complete.
+	void submit()
+	{
+		const VkBufferImageCopy region = {
+			0,                                      // bufferOffset
+			0,                                      // bufferRowLength
+			0,                                      // bufferImageHeight
+			{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },  // imageSubresource
+			{ 0, 0, 0 },                            // imageOffset
+			{ kSize, kSize, 1 },                    // imageExtent
+		};
+
+		barrier();
+		driver.vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL, readbackBuffer, 1, &region);
+
+		VK_ASSERT(driver.vkEndCommandBuffer(commandBuffer));
+		VK_ASSERT(device->QueueSubmitAndWait(commandBuffer));
+
+		void *mapped;
+		VK_ASSERT(device->MapMemory(readbackMemory, 0, sizeof(pixels), 0, &mapped));
+		memcpy(pixels, mapped, sizeof(pixels));
+		device->UnmapMemory(readbackMemory);
+	}
+
+	VkImage image;
+	VkDeviceMemory imageMemory;
+	VkImageView imageView;
+	VkRenderPass renderPass;
+	VkFramebuffer framebuffer;
+	VkShaderModule vertexShader;
+	VkShaderModule fragmentShader;
+	VkDescriptorSetLayout descriptorSetLayout;
+	VkPipelineLayout pipelineLayout;
+	VkCommandPool commandPool;
+	VkCommandBuffer commandBuffer;
+	VkBuffer readbackBuffer;
+	VkDeviceMemory readbackMemory;
+
+	std::vector<VkBuffer> buffers;
+	std::vector<VkDeviceMemory> bufferMemories;
+	std::vector<VkPipeline> pipelines;
+
+	// The color attachment contents, read back by submit().
+	uint32_t pixels[kSize][kSize];
+};
+
+namespace {
+
+// Two triangles covering the whole attachment.
+const std::vector<Vertex> kFullScreenQuad = {
+	{ { -1.0f, -1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f } },
+	{ { 1.0f, -1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f } },
+	{ { -1.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f } },
+	{ { -1.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f } },
+	{ { 1.0f, -1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f } },
+	{ { 1.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f } },
+};
+
+}  // anonymous namespace
+
+TEST_F(GraphicsTest, PipelineStatistics)
+{
+	const VkQueryPipelineStatisticFlags statistics = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+	                                                 VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+	                                                 VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+	                                                 VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+	                                                 VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+	                                                 VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+	VkQueryPool queryPool;
+	VK_ASSERT(device->CreatePipelineStatisticsQueryPool(statistics, 1, &queryPool));
+
+	VkBuffer vertexBuffer;
+	createVertexBuffer(kFullScreenQuad, &vertexBuffer);
+
+	VkPipeline pipeline;
+	createPipeline(InputAssemblyState(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST), RasterizationState(), true, &pipeline);
+
+	driver.vkCmdResetQueryPool(commandBuffer, queryPool, 0, 1);
+	driver.vkCmdBeginQuery(commandBuffer, queryPool, 0, 0);
+
+	beginRenderPass();
+	const VkDeviceSize offset = 0;
+	driver.vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+	driver.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	driver.vkCmdDraw(commandBuffer, 6, 1, 0, 0);
+	driver.vkCmdEndRenderPass(commandBuffer);
+
+	driver.vkCmdEndQuery(commandBuffer, queryPool, 0);
+	submit();
+
+	uint64_t results[6] = {};
+	VK_ASSERT(device->GetQueryPoolResults(queryPool, 0, 1, sizeof(results), results, sizeof(results),
+	                                      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+
+	// Results are ordered by statistic bit.
+	EXPECT_EQ(results[0], 6u);             // Input assembly vertices
+	EXPECT_EQ(results[1], 2u);             // Input assembly primitives
+	EXPECT_EQ(results[2], 6u);             // Vertex shader invocations
+	EXPECT_EQ(results[3], 2u);             // Clipping invocations
+	EXPECT_EQ(results[4], 2u);             // Clipping primitives
+	EXPECT_EQ(results[5], kSize * kSize);  // Fragment shader invocations
+
+	for(uint32_t y = 0; y < kSize; y++)
+	{
+		for(uint32_t x = 0; x < kSize; x++)
+		{
+			ASSERT_EQ(pixels[y][x], 0xFFFFFFFFu) << "pixel (" << x << ", " << y << ")";
+		}
+	}
+
+	device->DestroyQueryPool(queryPool);
+}
+
+// Draws without a fragment shader don't count fragment shader invocations,
+// and must not add those of earlier draws again.
+TEST_F(GraphicsTest, PipelineStatisticsWithoutFragmentShader)
+{
+	VkQueryPool queryPool;
+	VK_ASSERT(device->CreatePipelineStatisticsQueryPool(VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT, 1, &queryPool));
+
+	VkBuffer vertexBuffer;
+	createVertexBuffer(kFullScreenQuad, &vertexBuffer);
+
+	VkPipeline shaded, unshaded;
+	createPipeline(InputAssemblyState(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST), RasterizationState(), true, &shaded);
+	createPipeline(InputAssemblyState(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST), RasterizationState(), false, &unshaded);
+
+	driver.vkCmdResetQueryPool(commandBuffer, queryPool, 0, 1);
+	driver.vkCmdBeginQuery(commandBuffer, queryPool, 0, 0);
+
+	const VkDeviceSize offset = 0;
+	for(VkPipeline pipeline : { shaded, unshaded, unshaded, unshaded })
+	{
+		beginRenderPass();
+		driver.vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+		driver.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		driver.vkCmdDraw(commandBuffer, 6, 1, 0, 0);
+		driver.vkCmdEndRenderPass(commandBuffer);
+
+		// Wait for the draw to finish, so the next one can reuse its resources.
+		barrier();
+	}
+
+	driver.vkCmdEndQuery(commandBuffer, queryPool, 0);
+	submit();
+
+	uint64_t fragmentInvocations = 0;
+	VK_ASSERT(device->GetQueryPoolResults(queryPool, 0, 1, sizeof(fragmentInvocations), &fragmentInvocations,
+	                                      sizeof(fragmentInvocations), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+	EXPECT_EQ(fragmentInvocations, kSize * kSize);
+
+	device->DestroyQueryPool(queryPool);
+}
+
+namespace {
+
+// Vertex with interleaved float3, float2 and float attributes.
+struct InterleavedVertex
+{
+	float position[3];
+	float rg[2];
+	float b;
+};
+
+// Assembles the position and color from the interleaved attributes. The
+// position's w component is the default value of the float3 attribute.
+// #version 450
+// layout(location = 0) in vec4 inPosition;
+// layout(location = 1) in vec2 inRG;
+// layout(location = 2) in float inB;
+// layout(location = 0) out vec4 outColor;
+// void main()
+// {
+//     gl_Position = inPosition;
+//     outColor = vec4(inRG, inB, 1.0);
+// }
+// clang-format off
+const char *kInterleavedVertexShader =
+    "OpCapability Shader\n"
+    "OpMemoryModel Logical GLSL450\n"
+    "OpEntryPoint Vertex %1 \"main\" %2 %3 %4 %5 %6\n"
+    "OpDecorate %2 Location 0\n"
+    "OpDecorate %3 Location 1\n"
+    "OpDecorate %4 Location 2\n"
+    "OpDecorate %5 BuiltIn Position\n"
+    "OpDecorate %6 Location 0\n"
+    "%7 = OpTypeVoid\n"
+    "%8 = OpTypeFunction %7\n"          // void()
+    "%9 = OpTypeFloat 32\n"             // float
+    "%10 = OpTypeVector %9 2\n"         // vec2
+    "%11 = OpTypeVector %9 4\n"         // vec4
+    "%12 = OpConstant %9 1\n"           // 1.0
+    "%13 = OpTypePointer Input %9\n"    // float*
+    "%14 = OpTypePointer Input %10\n"   // vec2*
+    "%15 = OpTypePointer Input %11\n"   // vec4*
+    "%16 = OpTypePointer Output %11\n"  // vec4*
+    "%2 = OpVariable %15 Input\n"       // inPosition
+    "%3 = OpVariable %14 Input\n"       // inRG
+    "%4 = OpVariable %13 Input\n"       // inB
+    "%5 = OpVariable %16 Output\n"      // gl_Position
+    "%6 = OpVariable %16 Output\n"      // outColor
+    "%1 = OpFunction %7 None %8\n"      // -- Function begin --
+    "%17 = OpLabel\n"
+    "%18 = OpLoad %11 %2\n"
+    "OpStore %5 %18\n"
+    "%19 = OpLoad %10 %3\n"
+    "%20 = OpLoad %9 %4\n"
+    "%21 = OpCompositeExtract %9 %19 0\n"
+    "%22 = OpCompositeExtract %9 %19 1\n"
+    "%23 = OpCompositeConstruct %11 %21 %22 %20 %12\n"
+    "OpStore %6 %23\n"
+    "OpReturn\n"
+    "OpFunctionEnd\n";
+// clang-format on
+
+}  // anonymous namespace
+
+// Attributes interleaved in one binding must each be read from their own
+// offset, and every vertex from its own index.
+TEST_F(GraphicsTest, InterleavedAttributes)
+{
+	// Each triangle has its own color, so that vertices read from the wrong
+	// index are visible in the provoking vertex's color.
+	const std::vector<InterleavedVertex> vertices = {
+		{ { -1.0f, -1.0f, 0.0f }, { 1.0f, 0.0f }, 1.0f },
+		{ { 1.0f, -1.0f, 0.0f }, { 1.0f, 0.0f }, 1.0f },
+		{ { -1.0f, 1.0f, 0.0f }, { 1.0f, 0.0f }, 1.0f },
+		{ { 1.0f, 1.0f, 0.0f }, { 0.0f, 1.0f }, 0.0f },
+		{ { -1.0f, 1.0f, 0.0f }, { 0.0f, 1.0f }, 0.0f },
+		{ { 1.0f, -1.0f, 0.0f }, { 0.0f, 1.0f }, 0.0f },
+	};
+
+	VkBuffer vertexBuffer;
+	createBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertices.data(), vertices.size() * sizeof(InterleavedVertex), &vertexBuffer);
+
+	VkShaderModule interleavedVertexShader;
+	VK_ASSERT(device->CreateShaderModule(compileSpirv(kInterleavedVertexShader), &interleavedVertexShader));
+
+	const VkVertexInputBindingDescription binding = {
+		0,                            // binding
+		sizeof(InterleavedVertex),    // stride
+		VK_VERTEX_INPUT_RATE_VERTEX,  // inputRate
+	};
+
+	const VkVertexInputAttributeDescription attributes[] = {
+		{ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(InterleavedVertex, position) },
+		{ 1, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(InterleavedVertex, rg) },
+		{ 2, 0, VK_FORMAT_R32_SFLOAT, offsetof(InterleavedVertex, b) },
+	};
+
+	const VkPipelineVertexInputStateCreateInfo vertexInput = {
+		VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,  // sType
+		nullptr,                                                    // pNext
+		0,                                                          // flags
+		1,                                                          // vertexBindingDescriptionCount
+		&binding,                                                   // pVertexBindingDescriptions
+		3,                                                          // vertexAttributeDescriptionCount
+		attributes,                                                 // pVertexAttributeDescriptions
+	};
+
+	VkPipeline pipeline;
+	VK_ASSERT(device->CreateGraphicsPipeline(interleavedVertexShader, fragmentShader, vertexInput,
+	                                         InputAssemblyState(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST), RasterizationState(),
+	                                         pipelineLayout, renderPass, kSize, kSize, &pipeline));
+	pipelines.push_back(pipeline);
+
+	beginRenderPass();
+	const VkDeviceSize offset = 0;
+	driver.vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+	driver.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	driver.vkCmdDraw(commandBuffer, static_cast<uint32_t>(vertices.size()), 1, 0, 0);
+	driver.vkCmdEndRenderPass(commandBuffer);
+	submit();
+
+	for(uint32_t y = 0; y < kSize; y++)
+	{
+		for(uint32_t x = 0; x < kSize; x++)
+		{
+			// Pixel centers on the diagonal belong to either triangle.
+			if(x + y == kSize - 1)
+			{
+				continue;
+			}
+
+			uint32_t expected = (x + y < kSize - 1) ? 0xFFFF00FFu : 0xFF00FF00u;
+			ASSERT_EQ(pixels[y][x], expected) << "pixel (" << x << ", " << y << ")";
+		}
+	}
+
+	device->DestroyShaderModule(interleavedVertexShader);
+}
+
+namespace {
+
+// Colors of the four quadrants drawn by the indirect draw tests, and the
+// pixels they are read back as.
+const float kQuadrantColors[4][4] = {
+	{ 1.0f, 0.0f, 0.0f, 1.0f },
+	{ 0.0f, 1.0f, 0.0f, 1.0f },
+	{ 0.0f, 0.0f, 1.0f, 1.0f },
+	{ 1.0f, 1.0f, 1.0f, 1.0f },
+};
+const uint32_t kQuadrantPixels[4] = { 0xFF0000FFu, 0xFF00FF00u, 0xFFFF0000u, 0xFFFFFFFFu };
+
+// Returns the corners of the given quadrant, top-left first, with its color.
+std::vector<Vertex> QuadrantCorners(uint32_t quadrant)
+{
+	const float x = (quadrant % 2) ? 0.0f : -1.0f;
+	const float y = (quadrant / 2) ? 0.0f : -1.0f;
+	const float *c = kQuadrantColors[quadrant];
+
+	return {
+		{ { x, y, 0.0f, 1.0f }, { c[0], c[1], c[2], c[3] } },
+		{ { x + 1.0f, y, 0.0f, 1.0f }, { c[0], c[1], c[2], c[3] } },
+		{ { x, y + 1.0f, 0.0f, 1.0f }, { c[0], c[1], c[2], c[3] } },
+		{ { x + 1.0f, y + 1.0f, 0.0f, 1.0f }, { c[0], c[1], c[2], c[3] } },
+	};
+}
+
+// Indirect draw record, padded to test the stride.
+struct DrawIndirectRecord
+{
+	VkDrawIndirectCommand command;
+	uint32_t padding;
+};
+
+struct DrawIndexedIndirectRecord
+{
+	VkDrawIndexedIndirectCommand command;
+	uint32_t padding;
+};
+
+}  // anonymous namespace
+
+// IndirectDrawTest draws each of the four quadrants of the attachment with
+// one indirect record, either indexed or not.
+class IndirectDrawTest : public GraphicsTest
+{
+protected:
+	// Draws the quadrants with the given instance counts. When count is not
+	// null, the draw count is read from a buffer holding it, and limited to
+	// maxDrawCount.
+	void draw(bool indexed, const std::vector<uint32_t> &instanceCounts, const uint32_t *count, uint32_t maxDrawCount)
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint16_t> indices;
+		std::vector<DrawIndirectRecord> records;
+		std::vector<DrawIndexedIndirectRecord> indexedRecords;
+
+		for(uint32_t q = 0; q < 4; q++)
+		{
+			auto corners = QuadrantCorners(q);
+
+			if(indexed)
+			{
+				// Split each quadrant's vertex index between the index values and
+				// the vertex offset, so that both must be applied per record.
+				vertices.insert(vertices.end(), corners.begin(), corners.end());
+				const uint16_t base = 4 * (q % 2);
+				for(uint16_t i : { 0, 1, 2, 2, 1, 3 })
+				{
+					indices.push_back(base + i);
+				}
+
+				indexedRecords.push_back({ { 6, instanceCounts[q], 6 * q, static_cast<int32_t>(4 * q - base), 0 }, 0 });
+			}
+			else
+			{
+				for(uint32_t i : { 0, 1, 2, 2, 1, 3 })
+				{
+					vertices.push_back(corners[i]);
+				}
+
+				records.push_back({ { 6, instanceCounts[q], 6 * q, 0 }, 0 });
+			}
+		}
+
+		VkBuffer vertexBuffer, indirectBuffer, indexBuffer = VK_NULL_HANDLE, countBuffer = VK_NULL_HANDLE;
+		createVertexBuffer(vertices, &vertexBuffer);
+
+		if(indexed)
+		{
+			createBuffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indices.data(), indices.size() * sizeof(uint16_t), &indexBuffer);
+			createBuffer(VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, indexedRecords.data(), indexedRecords.size() * sizeof(DrawIndexedIndirectRecord), &indirectBuffer);
+		}
+		else
+		{
+			createBuffer(VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, records.data(), records.size() * sizeof(DrawIndirectRecord), &indirectBuffer);
+		}
+
+		if(count)
+		{
+			// Place the count at a non-zero offset.
+			const uint32_t countData[2] = { 0, *count };
+			createBuffer(VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, countData, sizeof(countData), &countBuffer);
+		}
+
+		VkPipeline pipeline;
+		createPipeline(InputAssemblyState(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST), RasterizationState(), true, &pipeline);
+
+		beginRenderPass();
+		const VkDeviceSize offset = 0;
+		driver.vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+		driver.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+		if(indexed)
+		{
+			driver.vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+
+			if(count)
+			{
+				driver.vkCmdDrawIndexedIndirectCount(commandBuffer, indirectBuffer, 0, countBuffer, sizeof(uint32_t),
+				                                     maxDrawCount, sizeof(DrawIndexedIndirectRecord));
+			}
+			else
+			{
+				driver.vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, 0, 4, sizeof(DrawIndexedIndirectRecord));
+			}
+		}
+		else
+		{
+			if(count)
+			{
+				driver.vkCmdDrawIndirectCount(commandBuffer, indirectBuffer, 0, countBuffer, sizeof(uint32_t),
+				                              maxDrawCount, sizeof(DrawIndirectRecord));
+			}
+			else
+			{
+				driver.vkCmdDrawIndirect(commandBuffer, indirectBuffer, 0, 4, sizeof(DrawIndirectRecord));
+			}
+		}
+
+		driver.vkCmdEndRenderPass(commandBuffer);
+	}
+
+	// Checks that exactly the quadrants in the drawn mask hold their color,
+	// and that the others are still cleared.
+	void expectQuadrants(uint32_t drawn)
+	{
+		for(uint32_t y = 0; y < kSize; y++)
+		{
+			for(uint32_t x = 0; x < kSize; x++)
+			{
+				const uint32_t q = (x >= kSize / 2) + 2 * (y >= kSize / 2);
+				const uint32_t expected = (drawn & (1 << q)) ? kQuadrantPixels[q] : 0;
+				ASSERT_EQ(pixels[y][x], expected) << "pixel (" << x << ", " << y << ")";
+			}
+		}
+	}
+
+	// Draws the quadrants with single-instance records around a skipped one
+	// and a multi-instance one, which must not be packed together, and checks
+	// the input assembly counts.
+	void testPacking(bool indexed)
+	{
+		VkQueryPool queryPool;
+		VK_ASSERT(device->CreatePipelineStatisticsQueryPool(VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+		                                                        VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT,
+		                                                    1, &queryPool));
+
+		driver.vkCmdResetQueryPool(commandBuffer, queryPool, 0, 1);
+		driver.vkCmdBeginQuery(commandBuffer, queryPool, 0, 0);
+		draw(indexed, { 1, 1, 0, 2 }, nullptr, 0);
+		driver.vkCmdEndQuery(commandBuffer, queryPool, 0);
+		submit();
+
+		uint64_t results[2] = {};
+		VK_ASSERT(device->GetQueryPoolResults(queryPool, 0, 1, sizeof(results), results, sizeof(results),
+		                                      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+		EXPECT_EQ(results[0], 24u);  // Input assembly vertices
+		EXPECT_EQ(results[1], 8u);   // Input assembly primitives
+
+		expectQuadrants(0b1011);
+
+		device->DestroyQueryPool(queryPool);
+	}
+};
+
+TEST_F(IndirectDrawTest, DrawIndirect)
+{
+	testPacking(false);
+}
+
+TEST_F(IndirectDrawTest, DrawIndexedIndirect)
+{
+	testPacking(true);
+}
+
+TEST_F(IndirectDrawTest, DrawIndirectCount)
+{
+	const uint32_t count = 2;
+	draw(false, { 1, 1, 1, 1 }, &count, 4);
+	submit();
+	expectQuadrants(0b0011);
+}
+
+TEST_F(IndirectDrawTest, DrawIndirectCountLimitedByMaxDrawCount)
+{
+	const uint32_t count = 7;
+	draw(false, { 1, 1, 1, 1 }, &count, 3);
+	submit();
+	expectQuadrants(0b0111);
+}
+
+TEST_F(IndirectDrawTest, DrawIndexedIndirectCount)
+{
+	const uint32_t count = 2;
+	draw(true, { 1, 1, 1, 1 }, &count, 4);
+	submit();
+	expectQuadrants(0b0011);
+}
+
+TEST_F(IndirectDrawTest, DrawIndexedIndirectCountLimitedByMaxDrawCount)
+{
+	const uint32_t count = 7;
+	draw(true, { 1, 1, 1, 1 }, &count, 3);
+	submit();
+	expectQuadrants(0b0111);
+}
+
+namespace {
+
+// Index of a primitive restart, for either index type.
+constexpr uint32_t kRestart = ~0u;
+
+// A triangle's vertex ids, followed by the id of its provoking vertex.
+using Triangle = std::array<uint32_t, 4>;
+
+// A row of pixels covered by a single line, and the id of its provoking vertex.
+struct LineRow
+{
+	uint32_t row;
+	uint32_t provokingVertex;
+};
+
+// Returns the twice signed area of the triangle a, b, p.
+float Cross(const float *a, const float *b, const float *p)
+{
+	return (b[0] - a[0]) * (p[1] - a[1]) - (b[1] - a[1]) * (p[0] - a[0]);
+}
+
+}  // anonymous namespace
+
+// PrimitiveAssemblyTest draws primitives whose vertices have distinct flat
+// colors, so the pixels of each primitive identify its provoking vertex.
+// The vertices are either drawn in order, or indexed with 16 or 32 bit
+// indices from a vertex buffer in reverse order.
+class PrimitiveAssemblyTest : public GraphicsTest, public testing::WithParamInterface<std::tuple<VkIndexType, bool>>
+{
+protected:
+	VkIndexType indexType() const { return std::get<0>(GetParam()); }
+	bool provokeFirst() const { return std::get<1>(GetParam()); }
+
+	// Adds a vertex at the given framebuffer position, and returns its id.
+	uint32_t addVertex(float x, float y)
+	{
+		const uint32_t id = static_cast<uint32_t>(positions.size());
+		positions.push_back({ x, y });
+		return id;
+	}
+
+	// Adds the vertices of a triangle strip covering the given rectangle,
+	// with its first triangle facing the front. Returns their ids.
+	std::vector<uint32_t> addStrip(float x0, float y0, float x1, float y1, uint32_t vertexCount)
+	{
+		const float dx = (x1 - x0) / ((vertexCount - 1) / 2);
+		std::vector<uint32_t> ids;
+		for(uint32_t i = 0; i < vertexCount; i++)
+		{
+			ids.push_back(addVertex(x0 + (i / 2) * dx, (i % 2) ? y1 : y0));
+		}
+		return ids;
+	}
+
+	// Draws the given vertices, where kRestart enables primitive restart.
+	void draw(VkPrimitiveTopology topology, const std::vector<uint32_t> &ids, VkCullModeFlags cullMode = VK_CULL_MODE_NONE)
+	{
+		const VkPipelineRasterizationProvokingVertexStateCreateInfoEXT provokingVertex = {
+			VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_PROVOKING_VERTEX_STATE_CREATE_INFO_EXT,                  // sType
+			nullptr,                                                                                           // pNext
+			provokeFirst() ? VK_PROVOKING_VERTEX_MODE_FIRST_VERTEX_EXT : VK_PROVOKING_VERTEX_MODE_LAST_VERTEX_EXT,  // provokingVertexMode
+		};
+
+		const bool restart = std::find(ids.begin(), ids.end(), kRestart) != ids.end();
+		const uint32_t count = static_cast<uint32_t>(ids.size());
+		const uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+
+		std::vector<Vertex> vertices;
+		std::vector<uint8_t> indices;
+		for(uint32_t i = 0; i < (indexType() == VK_INDEX_TYPE_NONE_KHR ? count : vertexCount); i++)
+		{
+			const uint32_t id = (indexType() == VK_INDEX_TYPE_NONE_KHR) ? ids[i] : vertexCount - 1 - i;
+			vertices.push_back({ { 2.0f * positions[id][0] / kSize - 1.0f, 2.0f * positions[id][1] / kSize - 1.0f, 0.0f, 1.0f },
+			                     { (id + 1) / 255.0f, 0.0f, 0.0f, 1.0f } });
+		}
+
+		for(uint32_t id : ids)
+		{
+			const uint32_t index = (id == kRestart) ? kRestart : vertexCount - 1 - id;
+			if(indexType() == VK_INDEX_TYPE_UINT16)
+			{
+				const uint16_t index16 = static_cast<uint16_t>(index);
+				indices.insert(indices.end(), reinterpret_cast<const uint8_t *>(&index16), reinterpret_cast<const uint8_t *>(&index16 + 1));
+			}
+			else if(indexType() == VK_INDEX_TYPE_UINT32)
+			{
+				indices.insert(indices.end(), reinterpret_cast<const uint8_t *>(&index), reinterpret_cast<const uint8_t *>(&index + 1));
+			}
+		}
+
+		VkBuffer vertexBuffer;
+		createVertexBuffer(vertices, &vertexBuffer);
+
+		VkPipeline pipeline;
+		createPipeline(InputAssemblyState(topology, restart ? VK_TRUE : VK_FALSE), RasterizationState(cullMode, &provokingVertex), true, &pipeline);
+
+		beginRenderPass();
+		const VkDeviceSize offset = 0;
+		driver.vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+		driver.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+		if(indexType() == VK_INDEX_TYPE_NONE_KHR)
+		{
+			driver.vkCmdDraw(commandBuffer, count, 1, 0, 0);
+		}
+		else
+		{
+			VkBuffer indexBuffer;
+			createBuffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indices.data(), indices.size(), &indexBuffer);
+			driver.vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, indexType());
+			driver.vkCmdDrawIndexed(commandBuffer, count, 1, 0, 0, 0);
+		}
+
+		driver.vkCmdEndRenderPass(commandBuffer);
+		submit();
+	}
+
+	// Returns the color written for the given vertex id.
+	static uint32_t pixel(uint32_t id)
+	{
+		return 0xFF000000u | (id + 1);
+	}
+
+	// Checks that the pixels whose center is more than half a pixel inside a
+	// triangle have the color of its provoking vertex.
+	void expectTriangles(const std::vector<Triangle> &triangles)
+	{
+		for(const Triangle &triangle : triangles)
+		{
+			const float *a = positions[triangle[0]].data();
+			const float *b = positions[triangle[1]].data();
+			const float *c = positions[triangle[2]].data();
+			const float sign = (Cross(a, b, c) > 0.0f) ? 1.0f : -1.0f;
+
+			int inside = 0;
+			for(uint32_t y = 0; y < kSize; y++)
+			{
+				for(uint32_t x = 0; x < kSize; x++)
+				{
+					const float p[2] = { x + 0.5f, y + 0.5f };
+					if(sign * Cross(a, b, p) > 0.5f * Distance(a, b) &&
+					   sign * Cross(b, c, p) > 0.5f * Distance(b, c) &&
+					   sign * Cross(c, a, p) > 0.5f * Distance(c, a))
+					{
+						ASSERT_EQ(pixels[y][x], pixel(triangle[3])) << "pixel (" << x << ", " << y << ") of triangle " << triangle[0]
+						                                          << ", " << triangle[1] << ", " << triangle[2];
+						inside++;
+					}
+				}
+			}
+
+			ASSERT_GT(inside, 0) << "triangle " << triangle[0] << ", " << triangle[1] << ", " << triangle[2] << " covers no pixel";
+		}
+	}
+
+	// Checks that each row is covered by a single line, with the color of
+	// its provoking vertex.
+	void expectLines(const std::vector<LineRow> &rows)
+	{
+		for(const LineRow &row : rows)
+		{
+			int covered = 0;
+			for(uint32_t x = 0; x < kSize; x++)
+			{
+				if(pixels[row.row][x] != 0)
+				{
+					ASSERT_EQ(pixels[row.row][x], pixel(row.provokingVertex)) << "pixel (" << x << ", " << row.row << ")";
+					covered++;
+				}
+			}
+
+			ASSERT_GT(covered, 0) << "row " << row.row;
+		}
+	}
+
+	// Vertex positions in framebuffer coordinates, by id.
+	std::vector<std::array<float, 2>> positions;
+
+private:
+	static float Distance(const float *a, const float *b)
+	{
+		return std::hypot(b[0] - a[0], b[1] - a[1]);
+	}
+};
+
+// The triangle counts are not multiples of four, so that every topology is
+// assembled both four primitives at a time and one at a time.
+TEST_P(PrimitiveAssemblyTest, TriangleList)
+{
+	std::vector<uint32_t> ids;
+	std::vector<Triangle> triangles;
+	for(uint32_t i = 0; i < 7; i++)
+	{
+		const float x = 4.0f * (i % 4);
+		const float y = 8.0f * (i / 4);
+		const uint32_t a = addVertex(x, y);
+		const uint32_t b = addVertex(x, y + 8.0f);
+		const uint32_t c = addVertex(x + 4.0f, y);
+		ids.insert(ids.end(), { a, b, c });
+		triangles.push_back({ a, b, c, provokeFirst() ? a : c });
+	}
+
+	draw(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, ids);
+	expectTriangles(triangles);
+}
+
+// Odd triangles of a strip have their winding reversed. With back faces
+// culled, the whole strip is only drawn if that is accounted for.
+TEST_P(PrimitiveAssemblyTest, TriangleStrip)
+{
+	const std::vector<uint32_t> ids = addStrip(0.0f, 0.0f, 16.0f, 16.0f, 12);
+	std::vector<Triangle> triangles;
+	for(size_t i = 0; i + 2 < ids.size(); i++)
+	{
+		triangles.push_back({ ids[i], ids[i + 1], ids[i + 2], provokeFirst() ? ids[i] : ids[i + 2] });
+	}
+
+	draw(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP, ids, VK_CULL_MODE_BACK_BIT);
+	expectTriangles(triangles);
+}
+
+TEST_P(PrimitiveAssemblyTest, TriangleFan)
+{
+	// Wedges around the top-left corner, up to the bottom and right edges.
+	const uint32_t wedges = 7;
+	std::vector<uint32_t> ids = { addVertex(0.0f, 0.0f) };
+	for(uint32_t i = 0; i <= wedges; i++)
+	{
+		const float angle = 1.5707963f * i / wedges;
+		const float distance = 16.0f / std::max(std::cos(angle), std::sin(angle));
+		ids.push_back(addVertex(distance * std::cos(angle), distance * std::sin(angle)));
+	}
+
+	std::vector<Triangle> triangles;
+	for(uint32_t i = 1; i <= wedges; i++)
+	{
+		triangles.push_back({ ids[0], ids[i], ids[i + 1], provokeFirst() ? ids[i] : ids[i + 1] });
+	}
+
+	draw(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN, ids);
+	expectTriangles(triangles);
+}
+
+TEST_P(PrimitiveAssemblyTest, LineList)
+{
+	std::vector<uint32_t> ids;
+	std::vector<LineRow> rows;
+	for(uint32_t i = 0; i < 7; i++)
+	{
+		const float y = 2.0f * i + 0.5f;
+		const uint32_t a = addVertex(0.0f, y);
+		const uint32_t b = addVertex(16.0f, y);
+		ids.insert(ids.end(), { a, b });
+		rows.push_back({ 2 * i, provokeFirst() ? a : b });
+	}
+
+	draw(VK_PRIMITIVE_TOPOLOGY_LINE_LIST, ids);
+	expectLines(rows);
+}
+
+TEST_P(PrimitiveAssemblyTest, LineStrip)
+{
+	// Zigzags down two rows per line, so that the odd rows are only covered
+	// by a single line.
+	std::vector<uint32_t> ids;
+	for(uint32_t i = 0; i < 8; i++)
+	{
+		ids.push_back(addVertex((i % 2) ? 15.5f : 0.5f, 2.0f * i + 0.5f));
+	}
+
+	std::vector<LineRow> rows;
+	for(uint32_t i = 0; i < 7; i++)
+	{
+		rows.push_back({ 2 * i + 1, provokeFirst() ? ids[i] : ids[i + 1] });
+	}
+
+	draw(VK_PRIMITIVE_TOPOLOGY_LINE_STRIP, ids);
+	expectLines(rows);
+}
+
+// Restarting a triangle strip starts it over with an even triangle, and no
+// triangle joins the strips on either side of a restart.
+TEST_P(PrimitiveAssemblyTest, PrimitiveRestart)
+{
+	if(indexType() == VK_INDEX_TYPE_NONE_KHR)
+	{
+		GTEST_SKIP() << "primitive restart requires indices";
+	}
+
+	// The restart index is at an odd position, past the first 16 bytes of
+	// indices. Treating it as a vertex would flip the winding of the second
+	// strip, and cull it.
+	const std::vector<uint32_t> top = addStrip(0.0f, 0.0f, 16.0f, 6.0f, 8);
+	const std::vector<uint32_t> bottom = addStrip(0.0f, 10.0f, 16.0f, 16.0f, 8);
+
+	std::vector<uint32_t> ids = top;
+	ids.push_back(kRestart);
+	ids.insert(ids.end(), bottom.begin(), bottom.end());
+
+	std::vector<Triangle> triangles;
+	for(const auto &strip : { top, bottom })
+	{
+		for(size_t i = 0; i + 2 < strip.size(); i++)
+		{
+			triangles.push_back({ strip[i], strip[i + 1], strip[i + 2], provokeFirst() ? strip[i] : strip[i + 2] });
+		}
+	}
+
+	draw(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP, ids, VK_CULL_MODE_BACK_BIT);
+	expectTriangles(triangles);
+
+	for(uint32_t y = 6; y < 10; y++)
+	{
+		for(uint32_t x = 0; x < kSize; x++)
+		{
+			ASSERT_EQ(pixels[y][x], 0u) << "pixel (" << x << ", " << y << ")";
+		}
+	}
+}
+
+INSTANTIATE_TEST_SUITE_P(IndexTypes, PrimitiveAssemblyTest,
+                         testing::Combine(testing::Values(VK_INDEX_TYPE_NONE_KHR, VK_INDEX_TYPE_UINT16, VK_INDEX_TYPE_UINT32),
+                                          testing::Bool()));
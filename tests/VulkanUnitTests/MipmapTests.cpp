@@ -0,0 +1,193 @@
+// Copyright 2021 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "VulkanTest.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+// Large enough for the blit into the second level to be split into several
+// bands of rows, while the smaller levels are blitted in a single pass.
+constexpr uint32_t kSize = 512;
+constexpr uint32_t kMipLevels = 4;
+
+// Returns the byte offset of each mip level in a tightly packed buffer
+// holding all levels of a kSize x kSize RGBA8 image.
+VkDeviceSize levelOffset(uint32_t mipLevel)
+{
+	VkDeviceSize offset = 0;
+	for(uint32_t level = 0; level < mipLevel; level++)
+	{
+		offset += (kSize >> level) * (kSize >> level) * 4;
+	}
+
+	return offset;
+}
+
+}  // anonymous namespace
+
+class MipmapTest : public VulkanTest, public testing::WithParamInterface<VkFilter>
+{
+protected:
+};
+
+// Generates a mip chain with one vkCmdBlitImage per level, the way engines
+// typically do, and checks each level against a 2x2 box filter (linear) or
+// a single texel (nearest) of the level it was generated from.
+TEST_P(MipmapTest, GenerateWithBlits)
+{
+	const VkFilter filter = GetParam();
+	const VkDeviceSize bufferSize = levelOffset(kMipLevels);
+
+	VkImage image;
+	VK_ASSERT(device->CreateMipmappedImage(VK_FORMAT_R8G8B8A8_UNORM, kSize, kSize, kMipLevels, &image));
+
+	VkMemoryRequirements requirements;
+	device->GetImageMemoryRequirements(image, &requirements);
+
+	VkDeviceMemory imageMemory;
+	VK_ASSERT(device->AllocateMemory(requirements.size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &imageMemory));
+	VK_ASSERT(device->BindImageMemory(image, imageMemory, 0));
+
+	VkDeviceMemory bufferMemory;
+	VK_ASSERT(device->AllocateMemory(bufferSize,
+	                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+	                                 &bufferMemory));
+
+	VkBuffer buffer;
+	VK_ASSERT(device->CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	                               bufferMemory, bufferSize, 0, &buffer));
+
+	uint8_t *texels;
+	VK_ASSERT(device->MapMemory(bufferMemory, 0, bufferSize, 0, (void **)&texels));
+
+	srand(0x5EED);
+	for(VkDeviceSize i = 0; i < levelOffset(1); i++)
+	{
+		texels[i] = static_cast<uint8_t>(rand());
+	}
+
+	VkCommandPool commandPool;
+	VK_ASSERT(device->CreateCommandPool(&commandPool));
+
+	VkCommandBuffer commandBuffer;
+	VK_ASSERT(device->AllocateCommandBuffer(commandPool, &commandBuffer));
+	VK_ASSERT(device->BeginCommandBuffer(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, commandBuffer));
+
+	const VkMemoryBarrier barrier = {
+		VK_STRUCTURE_TYPE_MEMORY_BARRIER,                            // sType
+		nullptr,                                                     // pNext
+		VK_ACCESS_TRANSFER_WRITE_BIT,                                // srcAccessMask
+		VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,  // dstAccessMask
+	};
+
+	const VkBufferImageCopy upload = {
+		0,                                      // bufferOffset
+		0,                                      // bufferRowLength
+		0,                                      // bufferImageHeight
+		{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },  // imageSubresource
+		{ 0, 0, 0 },                            // imageOffset
+		{ kSize, kSize, 1 },                    // imageExtent
+	};
+
+	driver.vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_GENERAL, 1, &upload);
+
+	for(uint32_t level = 1; level < kMipLevels; level++)
+	{
+		driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		                            0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		const int32_t srcSize = kSize >> (level - 1);
+		const int32_t dstSize = kSize >> level;
+
+		const VkImageBlit blit = {
+			{ VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1 },      // srcSubresource
+			{ { 0, 0, 0 }, { srcSize, srcSize, 1 } },            // srcOffsets
+			{ VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 },          // dstSubresource
+			{ { 0, 0, 0 }, { dstSize, dstSize, 1 } },            // dstOffsets
+		};
+
+		driver.vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL, image, VK_IMAGE_LAYOUT_GENERAL,
+		                      1, &blit, filter);
+	}
+
+	driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+	                            0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	for(uint32_t level = 1; level < kMipLevels; level++)
+	{
+		const VkBufferImageCopy readback = {
+			levelOffset(level),                         // bufferOffset
+			0,                                          // bufferRowLength
+			0,                                          // bufferImageHeight
+			{ VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 },  // imageSubresource
+			{ 0, 0, 0 },                                // imageOffset
+			{ kSize >> level, kSize >> level, 1 },      // imageExtent
+		};
+
+		driver.vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL, buffer, 1, &readback);
+	}
+
+	VK_ASSERT(driver.vkEndCommandBuffer(commandBuffer));
+	VK_ASSERT(device->QueueSubmitAndWait(commandBuffer));
+
+	for(uint32_t level = 1; level < kMipLevels; level++)
+	{
+		const uint32_t srcSize = kSize >> (level - 1);
+		const uint32_t dstSize = kSize >> level;
+		const uint8_t *src = texels + levelOffset(level - 1);
+		const uint8_t *dst = texels + levelOffset(level);
+
+		for(uint32_t y = 0; y < dstSize; y++)
+		{
+			for(uint32_t x = 0; x < dstSize; x++)
+			{
+				for(uint32_t c = 0; c < 4; c++)
+				{
+					const uint8_t *s = src + ((2 * y) * srcSize + (2 * x)) * 4 + c;
+
+					// The center of the destination texel lies on the corner shared by
+					// four source texels. Nearest filtering picks the bottom-right one.
+					int expected = s[srcSize * 4 + 4];
+
+					if(filter == VK_FILTER_LINEAR)
+					{
+						expected = (s[0] + s[4] + s[srcSize * 4] + s[srcSize * 4 + 4] + 2) / 4;
+					}
+
+					// Allow for the blitter's rounding of the filtered value
+					ASSERT_LE(abs(dst[(y * dstSize + x) * 4 + c] - expected), 1)
+					    << "level " << level << " texel (" << x << ", " << y << ") component " << c;
+				}
+			}
+		}
+	}
+
+	device->UnmapMemory(bufferMemory);
+
+	device->FreeCommandBuffer(commandPool, commandBuffer);
+	device->DestroyCommandPool(commandPool);
+	device->DestroyBuffer(buffer);
+	device->FreeMemory(bufferMemory);
+	device->DestroyImage(image);
+	device->FreeMemory(imageMemory);
+}
+
+INSTANTIATE_TEST_SUITE_P(Filters, MipmapTest,
+                         testing::Values(VK_FILTER_NEAREST, VK_FILTER_LINEAR));
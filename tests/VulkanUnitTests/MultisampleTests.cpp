@@ -0,0 +1,210 @@
+// Copyright 2021 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "VulkanTest.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// The width is odd so that the rows of each sample don't line up with any
+// power of two.
+constexpr uint32_t kWidth = 19;
+constexpr uint32_t kHeight = 13;
+constexpr VkOffset3D kCopyOffset = { 5, 3, 0 };
+constexpr VkExtent3D kCopyExtent = { 8, 6, 1 };
+
+const VkClearColorValue kBackground = { { 1.0f, 0.0f, 0.0f, 1.0f } };
+const VkClearColorValue kForeground = { { 0.0f, 1.0f, 0.0f, 1.0f } };
+
+// Returns the bytes of a texel of the given format holding the clear color.
+std::vector<uint8_t> texelBytes(VkFormat format, const VkClearColorValue &color)
+{
+	std::vector<uint8_t> texel;
+
+	switch(format)
+	{
+	case VK_FORMAT_R8G8B8A8_UNORM:
+		for(float component : color.float32)
+		{
+			texel.push_back(static_cast<uint8_t>(component * 255.0f));
+		}
+		break;
+	case VK_FORMAT_R32G32B32A32_SFLOAT:
+		texel.resize(sizeof(color.float32));
+		memcpy(texel.data(), color.float32, sizeof(color.float32));
+		break;
+	default:
+		break;
+	}
+
+	return texel;
+}
+
+}  // anonymous namespace
+
+class MultisampleTest : public VulkanTest, public testing::WithParamInterface<VkFormat>
+{
+protected:
+	// Creates an image with the given sample count and binds new memory to it.
+	void createImage(VkSampleCountFlagBits samples, VkImage *image, VkDeviceMemory *memory)
+	{
+		VK_ASSERT(device->CreateAttachmentImage(GetParam(), kWidth, kHeight, samples, image));
+
+		VkMemoryRequirements requirements;
+		device->GetImageMemoryRequirements(*image, &requirements);
+
+		VK_ASSERT(device->AllocateMemory(requirements.size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, memory));
+		VK_ASSERT(device->BindImageMemory(*image, *memory, 0));
+	}
+};
+
+// Copies a region between two cleared 4x multisampled images, then resolves
+// the destination. Every sample of the copied region must have been replaced
+// for its pixels to resolve to the foreground color.
+TEST_P(MultisampleTest, CopyAndResolve)
+{
+	const VkFormat format = GetParam();
+	const std::vector<uint8_t> background = texelBytes(format, kBackground);
+	const std::vector<uint8_t> foreground = texelBytes(format, kForeground);
+	const VkDeviceSize bufferSize = kWidth * kHeight * background.size();
+
+	VkImage background4x, foreground4x, resolved;
+	VkDeviceMemory background4xMemory, foreground4xMemory, resolvedMemory;
+	createImage(VK_SAMPLE_COUNT_4_BIT, &background4x, &background4xMemory);
+	createImage(VK_SAMPLE_COUNT_4_BIT, &foreground4x, &foreground4xMemory);
+	createImage(VK_SAMPLE_COUNT_1_BIT, &resolved, &resolvedMemory);
+
+	VkDeviceMemory bufferMemory;
+	VK_ASSERT(device->AllocateMemory(bufferSize,
+	                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+	                                 &bufferMemory));
+
+	VkBuffer buffer;
+	VK_ASSERT(device->CreateBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT, bufferMemory, bufferSize, 0, &buffer));
+
+	VkCommandPool commandPool;
+	VK_ASSERT(device->CreateCommandPool(&commandPool));
+
+	VkCommandBuffer commandBuffer;
+	VK_ASSERT(device->AllocateCommandBuffer(commandPool, &commandBuffer));
+	VK_ASSERT(device->BeginCommandBuffer(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, commandBuffer));
+
+	const VkMemoryBarrier barrier = {
+		VK_STRUCTURE_TYPE_MEMORY_BARRIER,                            // sType
+		nullptr,                                                     // pNext
+		VK_ACCESS_TRANSFER_WRITE_BIT,                                // srcAccessMask
+		VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,  // dstAccessMask
+	};
+
+	const VkImageSubresourceRange range = {
+		VK_IMAGE_ASPECT_COLOR_BIT,  // aspectMask
+		0,                          // baseMipLevel
+		1,                          // levelCount
+		0,                          // baseArrayLayer
+		1,                          // layerCount
+	};
+
+	const VkImageSubresourceLayers layers = {
+		VK_IMAGE_ASPECT_COLOR_BIT,  // aspectMask
+		0,                          // mipLevel
+		0,                          // baseArrayLayer
+		1,                          // layerCount
+	};
+
+	// Clearing twice must leave only the second clear value, even when clears are deferred.
+	driver.vkCmdClearColorImage(commandBuffer, background4x, VK_IMAGE_LAYOUT_GENERAL, &kForeground, 1, &range);
+	driver.vkCmdClearColorImage(commandBuffer, background4x, VK_IMAGE_LAYOUT_GENERAL, &kBackground, 1, &range);
+	driver.vkCmdClearColorImage(commandBuffer, foreground4x, VK_IMAGE_LAYOUT_GENERAL, &kForeground, 1, &range);
+	driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+	                            0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	const VkImageCopy copy = {
+		layers,       // srcSubresource
+		kCopyOffset,  // srcOffset
+		layers,       // dstSubresource
+		kCopyOffset,  // dstOffset
+		kCopyExtent,  // extent
+	};
+
+	driver.vkCmdCopyImage(commandBuffer, foreground4x, VK_IMAGE_LAYOUT_GENERAL, background4x, VK_IMAGE_LAYOUT_GENERAL,
+	                      1, &copy);
+	driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+	                            0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	const VkImageResolve resolve = {
+		layers,                  // srcSubresource
+		{ 0, 0, 0 },             // srcOffset
+		layers,                  // dstSubresource
+		{ 0, 0, 0 },             // dstOffset
+		{ kWidth, kHeight, 1 },  // extent
+	};
+
+	driver.vkCmdResolveImage(commandBuffer, background4x, VK_IMAGE_LAYOUT_GENERAL, resolved, VK_IMAGE_LAYOUT_GENERAL,
+	                         1, &resolve);
+	driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+	                            0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	const VkBufferImageCopy readback = {
+		0,                       // bufferOffset
+		0,                       // bufferRowLength
+		0,                       // bufferImageHeight
+		layers,                  // imageSubresource
+		{ 0, 0, 0 },             // imageOffset
+		{ kWidth, kHeight, 1 },  // imageExtent
+	};
+
+	driver.vkCmdCopyImageToBuffer(commandBuffer, resolved, VK_IMAGE_LAYOUT_GENERAL, buffer, 1, &readback);
+
+	VK_ASSERT(driver.vkEndCommandBuffer(commandBuffer));
+	VK_ASSERT(device->QueueSubmitAndWait(commandBuffer));
+
+	uint8_t *texels;
+	VK_ASSERT(device->MapMemory(bufferMemory, 0, bufferSize, 0, (void **)&texels));
+
+	for(int32_t y = 0; y < static_cast<int32_t>(kHeight); y++)
+	{
+		for(int32_t x = 0; x < static_cast<int32_t>(kWidth); x++)
+		{
+			bool copied = (x >= kCopyOffset.x) && (x < kCopyOffset.x + static_cast<int32_t>(kCopyExtent.width)) &&
+			              (y >= kCopyOffset.y) && (y < kCopyOffset.y + static_cast<int32_t>(kCopyExtent.height));
+			const std::vector<uint8_t> &expected = copied ? foreground : background;
+
+			EXPECT_EQ(memcmp(texels + (y * kWidth + x) * expected.size(), expected.data(), expected.size()), 0)
+			    << "texel (" << x << ", " << y << ")";
+		}
+	}
+
+	device->UnmapMemory(bufferMemory);
+
+	device->FreeCommandBuffer(commandPool, commandBuffer);
+	device->DestroyCommandPool(commandPool);
+	device->DestroyBuffer(buffer);
+	device->FreeMemory(bufferMemory);
+	device->DestroyImage(resolved);
+	device->FreeMemory(resolvedMemory);
+	device->DestroyImage(foreground4x);
+	device->FreeMemory(foreground4xMemory);
+	device->DestroyImage(background4x);
+	device->FreeMemory(background4xMemory);
+}
+
+// RGBA8 takes the fast resolve path, while float formats go through a blit routine.
+INSTANTIATE_TEST_SUITE_P(ColorFormats, MultisampleTest,
+                         testing::Values(VK_FORMAT_R8G8B8A8_UNORM,
+                                         VK_FORMAT_R32G32B32A32_SFLOAT));
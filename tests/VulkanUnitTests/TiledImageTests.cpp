@@ -0,0 +1,442 @@
+// Copyright 2021 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "VulkanTest.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <array>
+#include <cstring>
+#include <random>
+
+namespace {
+
+// Neither dimension is a multiple of the 4x4 tiles, so the edges of the
+// image fall inside partially used tiles.
+constexpr uint32_t kWidth = 19;
+constexpr uint32_t kHeight = 13;
+constexpr uint32_t kLayers = 2;
+constexpr uint32_t kTexelCount = kWidth * kHeight * kLayers;
+
+uint32_t texelBytes(VkFormat format)
+{
+	switch(format)
+	{
+	case VK_FORMAT_R8_UNORM:
+		return 1;
+	case VK_FORMAT_R8G8_UNORM:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+// Returns the normalized components of the 8-bit UNORM texel, in RGBA order.
+std::array<float, 4> expectedTexel(VkFormat format, const uint8_t *texel)
+{
+	switch(format)
+	{
+	case VK_FORMAT_R8_UNORM:
+		return { texel[0] / 255.0f, 0.0f, 0.0f, 1.0f };
+	case VK_FORMAT_R8G8_UNORM:
+		return { texel[0] / 255.0f, texel[1] / 255.0f, 0.0f, 1.0f };
+	case VK_FORMAT_B8G8R8A8_UNORM:
+		return { texel[2] / 255.0f, texel[1] / 255.0f, texel[0] / 255.0f, texel[3] / 255.0f };
+	default:
+		return { texel[0] / 255.0f, texel[1] / 255.0f, texel[2] / 255.0f, texel[3] / 255.0f };
+	}
+}
+
+// #version 450
+// layout(local_size_x = 1, local_size_y = 1) in;
+// layout(binding = 0, std430) buffer OutBuffer
+// {
+//     vec4 Data[];
+// } Out;
+// layout(binding = 1) uniform texture2DArray Image;
+// layout(binding = 2) uniform sampler Sampler;
+// void main()
+// {
+//     uvec3 id = gl_GlobalInvocationID;
+//     uint index = ((id.z * 13 + id.y) * 19 + id.x) * 2;
+//     Out.Data[index] = texelFetch(Image, ivec3(id), 0);
+//     vec2 uv = (vec2(id.xy) + 0.5) / vec2(19, 13);
+//     Out.Data[index + 1] = textureLod(sampler2DArray(Image, Sampler), vec3(uv, id.z), 0);
+// }
+// clang-format off
+const char *kFetchAndSampleShader =
+    "OpCapability Shader\n"
+    "OpMemoryModel Logical GLSL450\n"
+    "OpEntryPoint GLCompute %1 \"main\" %2\n"
+    "OpExecutionMode %1 LocalSize 1 1 1\n"
+    "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+    "OpDecorate %3 ArrayStride 16\n"
+    "OpMemberDecorate %4 0 Offset 0\n"
+    "OpDecorate %4 BufferBlock\n"
+    "OpDecorate %5 DescriptorSet 0\n"
+    "OpDecorate %5 Binding 0\n"
+    "OpDecorate %6 DescriptorSet 0\n"
+    "OpDecorate %6 Binding 1\n"
+    "OpDecorate %7 DescriptorSet 0\n"
+    "OpDecorate %7 Binding 2\n"
+    "%8 = OpTypeVoid\n"
+    "%9 = OpTypeFunction %8\n"                      // void()
+    "%10 = OpTypeInt 32 1\n"                        // int32
+    "%11 = OpTypeInt 32 0\n"                        // uint32
+    "%12 = OpTypeFloat 32\n"                        // float
+    "%13 = OpTypeVector %12 4\n"                    // vec4
+    "%14 = OpTypeVector %11 3\n"                    // uvec3
+    "%15 = OpTypeVector %10 3\n"                    // ivec3
+    "%16 = OpTypeVector %12 3\n"                    // vec3
+    "%3 = OpTypeRuntimeArray %13\n"                 // vec4[]
+    "%4 = OpTypeStruct %3\n"                        // struct{ vec4[] }
+    "%17 = OpTypePointer Uniform %4\n"              // struct{ vec4[] }*
+    "%5 = OpVariable %17 Uniform\n"                 // struct{ vec4[] }* out
+    "%18 = OpTypeImage %12 2D 0 1 0 1 Unknown\n"    // texture2DArray
+    "%19 = OpTypePointer UniformConstant %18\n"     // texture2DArray*
+    "%6 = OpVariable %19 UniformConstant\n"         // texture2DArray* image
+    "%20 = OpTypeSampler\n"                         // sampler
+    "%21 = OpTypePointer UniformConstant %20\n"     // sampler*
+    "%7 = OpVariable %21 UniformConstant\n"         // sampler* sampler
+    "%22 = OpTypeSampledImage %18\n"                // sampler2DArray
+    "%23 = OpTypePointer Input %14\n"               // uvec3*
+    "%2 = OpVariable %23 Input\n"                   // gl_GlobalInvocationId
+    "%24 = OpTypePointer Uniform %13\n"             // vec4*
+    "%25 = OpConstant %10 0\n"                      // int32(0)
+    "%26 = OpConstant %11 19\n"                     // uint32(19)
+    "%27 = OpConstant %11 13\n"                     // uint32(13)
+    "%28 = OpConstant %11 2\n"                      // uint32(2)
+    "%29 = OpConstant %11 1\n"                      // uint32(1)
+    "%30 = OpConstant %12 0.5\n"                    // 0.5f
+    "%31 = OpConstant %12 19\n"                     // 19.0f
+    "%32 = OpConstant %12 13\n"                     // 13.0f
+    "%33 = OpConstant %12 0\n"                      // 0.0f
+    "%1 = OpFunction %8 None %9\n"                  // -- Function begin --
+    "%34 = OpLabel\n"
+    "%35 = OpLoad %14 %2\n"                         // id
+    "%36 = OpBitcast %15 %35\n"                     // ivec3(id)
+    "%37 = OpLoad %18 %6\n"                         // image
+    "%38 = OpImageFetch %13 %37 %36 Lod %25\n"      // texelFetch(image, ivec3(id), 0)
+    "%39 = OpCompositeExtract %11 %35 0\n"          // id.x
+    "%40 = OpCompositeExtract %11 %35 1\n"          // id.y
+    "%41 = OpCompositeExtract %11 %35 2\n"          // id.z
+    "%42 = OpIMul %11 %41 %27\n"
+    "%43 = OpIAdd %11 %42 %40\n"
+    "%44 = OpIMul %11 %43 %26\n"
+    "%45 = OpIAdd %11 %44 %39\n"                    // (id.z * 13 + id.y) * 19 + id.x
+    "%46 = OpIMul %11 %45 %28\n"                    // index
+    "%47 = OpAccessChain %24 %5 %25 %46\n"          // &out.arr[index]
+    "OpStore %47 %38\n"
+    "%48 = OpConvertUToF %12 %39\n"
+    "%49 = OpConvertUToF %12 %40\n"
+    "%50 = OpConvertUToF %12 %41\n"
+    "%51 = OpFAdd %12 %48 %30\n"
+    "%52 = OpFAdd %12 %49 %30\n"
+    "%53 = OpFDiv %12 %51 %31\n"
+    "%54 = OpFDiv %12 %52 %32\n"
+    "%55 = OpCompositeConstruct %16 %53 %54 %50\n"  // vec3(uv, id.z)
+    "%56 = OpLoad %20 %7\n"                         // sampler
+    "%57 = OpSampledImage %22 %37 %56\n"            // sampler2DArray(image, sampler)
+    "%58 = OpImageSampleExplicitLod %13 %57 %55 Lod %33\n"
+    "%59 = OpIAdd %11 %46 %29\n"                    // index + 1
+    "%60 = OpAccessChain %24 %5 %25 %59\n"          // &out.arr[index + 1]
+    "OpStore %60 %58\n"
+    "OpReturn\n"
+    "OpFunctionEnd\n";
+// clang-format on
+
+}  // anonymous namespace
+
+class TiledImageTest : public VulkanTest, public testing::WithParamInterface<VkFormat>
+{
+protected:
+};
+
+// Images which are only sampled and transferred get sampled from a copy stored
+// in 4x4 texel tiles. Both texel fetches and filtered lookups must find the
+// uploaded texels, and copying the image back must find them too.
+TEST_P(TiledImageTest, SampleAndCopyBack)
+{
+	const VkFormat format = GetParam();
+	const VkDeviceSize outputSize = kTexelCount * 2 * 4 * sizeof(float);
+	const VkDeviceSize texelsSize = kTexelCount * texelBytes(format);
+
+	std::mt19937 random(format);
+	std::vector<uint8_t> texels(texelsSize);
+	for(auto &byte : texels)
+	{
+		byte = static_cast<uint8_t>(random());
+	}
+
+	VkImage image;
+	VK_ASSERT(device->CreateSampledImage(format, kWidth, kHeight, kLayers, 0, &image));
+
+	VkMemoryRequirements requirements;
+	device->GetImageMemoryRequirements(image, &requirements);
+
+	// Tiled images are padded to whole tiles.
+	EXPECT_GE(requirements.size, 20 * 16 * kLayers * texelBytes(format));
+
+	VkDeviceMemory imageMemory;
+	VK_ASSERT(device->AllocateMemory(requirements.size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &imageMemory));
+	VK_ASSERT(device->BindImageMemory(image, imageMemory, 0));
+
+	VkImageView imageView;
+	VK_ASSERT(device->CreateImageView(image, VK_IMAGE_VIEW_TYPE_2D_ARRAY, format, kLayers, &imageView));
+
+	VkSampler sampler;
+	VK_ASSERT(device->CreateSampler(VK_FILTER_NEAREST, &sampler));
+
+	// The output comes first to keep it aligned for use as a storage buffer,
+	// followed by the uploaded texels and the ones copied back.
+	VkDeviceMemory bufferMemory;
+	VK_ASSERT(device->AllocateMemory(outputSize + 2 * texelsSize,
+	                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+	                                 &bufferMemory));
+
+	uint8_t *mapped;
+	VK_ASSERT(device->MapMemory(bufferMemory, outputSize, 2 * texelsSize, 0, (void **)&mapped));
+	memcpy(mapped, texels.data(), texelsSize);
+	memset(mapped + texelsSize, 0, texelsSize);
+	device->UnmapMemory(bufferMemory);
+
+	VkBuffer transferBuffer;
+	VK_ASSERT(device->CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	                               bufferMemory, 2 * texelsSize, outputSize, &transferBuffer));
+
+	VkBuffer outputBuffer;
+	VK_ASSERT(device->CreateStorageBuffer(bufferMemory, outputSize, 0, &outputBuffer));
+
+	VkShaderModule shaderModule;
+	VK_ASSERT(device->CreateShaderModule(compileSpirv(kFetchAndSampleShader), &shaderModule));
+
+	std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings = {
+		{
+		    0,                                  // binding
+		    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,  // descriptorType
+		    1,                                  // descriptorCount
+		    VK_SHADER_STAGE_COMPUTE_BIT,        // stageFlags
+		    0,                                  // pImmutableSamplers
+		},
+		{
+		    1,                                 // binding
+		    VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,  // descriptorType
+		    1,                                 // descriptorCount
+		    VK_SHADER_STAGE_COMPUTE_BIT,       // stageFlags
+		    0,                                 // pImmutableSamplers
+		},
+		{
+		    2,                            // binding
+		    VK_DESCRIPTOR_TYPE_SAMPLER,   // descriptorType
+		    1,                            // descriptorCount
+		    VK_SHADER_STAGE_COMPUTE_BIT,  // stageFlags
+		    &sampler,                     // pImmutableSamplers
+		}
+	};
+
+	VkDescriptorSetLayout descriptorSetLayout;
+	VK_ASSERT(device->CreateDescriptorSetLayout(descriptorSetLayoutBindings, &descriptorSetLayout));
+
+	VkPipelineLayout pipelineLayout;
+	VK_ASSERT(device->CreatePipelineLayout(descriptorSetLayout, &pipelineLayout));
+
+	VkPipeline pipeline;
+	VK_ASSERT(device->CreateComputePipeline(shaderModule, pipelineLayout, &pipeline));
+
+	VkDescriptorPool descriptorPool;
+	VK_ASSERT(device->CreateDescriptorPool({ { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 },
+	                                         { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1 },
+	                                         { VK_DESCRIPTOR_TYPE_SAMPLER, 1 } },
+	                                       &descriptorPool));
+
+	VkDescriptorSet descriptorSet;
+	VK_ASSERT(device->AllocateDescriptorSet(descriptorPool, descriptorSetLayout, &descriptorSet));
+
+	device->UpdateStorageBufferDescriptorSets(descriptorSet, { { outputBuffer, 0, VK_WHOLE_SIZE } });
+	device->UpdateSampledImageDescriptorSet(descriptorSet, 1, imageView);
+
+	VkCommandPool commandPool;
+	VK_ASSERT(device->CreateCommandPool(&commandPool));
+
+	// Uploads the texels of region, samples the whole image, and copies it back.
+	auto uploadSampleAndCopyBack = [&](const VkBufferImageCopy &region, VkAccessFlags srcAccessMask,
+	                                   VkImageLayout oldLayout) {
+		VkCommandBuffer commandBuffer;
+		VK_ASSERT(device->AllocateCommandBuffer(commandPool, &commandBuffer));
+		VK_ASSERT(device->BeginCommandBuffer(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, commandBuffer));
+
+		VkImageMemoryBarrier barrier = {
+			VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,  // sType
+			nullptr,                                 // pNext
+			srcAccessMask,                           // srcAccessMask
+			VK_ACCESS_TRANSFER_WRITE_BIT,            // dstAccessMask
+			oldLayout,                               // oldLayout
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,    // newLayout
+			VK_QUEUE_FAMILY_IGNORED,                 // srcQueueFamilyIndex
+			VK_QUEUE_FAMILY_IGNORED,                 // dstQueueFamilyIndex
+			image,                                   // image
+			{
+			    VK_IMAGE_ASPECT_COLOR_BIT,  // aspectMask
+			    0,                          // baseMipLevel
+			    1,                          // levelCount
+			    0,                          // baseArrayLayer
+			    kLayers,                    // layerCount
+			},
+		};
+
+		driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		                            0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		driver.vkCmdCopyBufferToImage(commandBuffer, transferBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		                            0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		driver.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+		driver.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet,
+		                               0, nullptr);
+		driver.vkCmdDispatch(commandBuffer, kWidth, kHeight, kLayers);
+
+		barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+		driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		                            0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		const VkBufferImageCopy wholeImage = {
+			texelsSize,  // bufferOffset
+			0,           // bufferRowLength
+			0,           // bufferImageHeight
+			{
+			    VK_IMAGE_ASPECT_COLOR_BIT,  // aspectMask
+			    0,                          // mipLevel
+			    0,                          // baseArrayLayer
+			    kLayers,                    // layerCount
+			},
+			{ 0, 0, 0 },             // imageOffset
+			{ kWidth, kHeight, 1 },  // imageExtent
+		};
+
+		driver.vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, transferBuffer, 1, &wholeImage);
+
+		VK_ASSERT(driver.vkEndCommandBuffer(commandBuffer));
+		VK_ASSERT(device->QueueSubmitAndWait(commandBuffer));
+
+		device->FreeCommandBuffer(commandPool, commandBuffer);
+	};
+
+	// Checks the sampled texels and the ones copied back against texels.
+	auto expectTexels = [&]() {
+		float *output;
+		VK_ASSERT(device->MapMemory(bufferMemory, 0, outputSize + 2 * texelsSize, 0, (void **)&output));
+
+		for(uint32_t i = 0; i < kTexelCount; i++)
+		{
+			std::array<float, 4> expected = expectedTexel(format, &texels[i * texelBytes(format)]);
+
+			for(uint32_t c = 0; c < 4; c++)
+			{
+				EXPECT_FLOAT_EQ(output[i * 8 + c], expected[c])
+				    << "fetched texel (" << (i % kWidth) << ", " << (i / kWidth % kHeight) << ", " << (i / (kWidth * kHeight))
+				    << "), component " << c;
+				EXPECT_NEAR(output[i * 8 + 4 + c], expected[c], 0.5f / 255.0f)
+				    << "sampled texel (" << (i % kWidth) << ", " << (i / kWidth % kHeight) << ", " << (i / (kWidth * kHeight))
+				    << "), component " << c;
+			}
+		}
+
+		const uint8_t *copied = reinterpret_cast<const uint8_t *>(output) + outputSize + texelsSize;
+		EXPECT_EQ(memcmp(copied, texels.data(), texelsSize), 0);
+
+		device->UnmapMemory(bufferMemory);
+	};
+
+	VkBufferImageCopy region = {
+		0,  // bufferOffset
+		0,  // bufferRowLength
+		0,  // bufferImageHeight
+		{
+		    VK_IMAGE_ASPECT_COLOR_BIT,  // aspectMask
+		    0,                          // mipLevel
+		    0,                          // baseArrayLayer
+		    kLayers,                    // layerCount
+		},
+		{ 0, 0, 0 },             // imageOffset
+		{ kWidth, kHeight, 1 },  // imageExtent
+	};
+
+	uploadSampleAndCopyBack(region, 0, VK_IMAGE_LAYOUT_UNDEFINED);
+	expectTexels();
+
+	// Update a region of the second layer which isn't aligned to the tiles. The
+	// tiled copy must pick up the change, and the previous copy back must have
+	// left the image's own texels alone.
+	const VkOffset3D offset = { 5, 6, 0 };
+	const VkExtent3D extent = { 9, 5, 1 };
+	for(uint32_t y = offset.y; y < offset.y + extent.height; y++)
+	{
+		for(uint32_t x = offset.x; x < offset.x + extent.width; x++)
+		{
+			for(uint32_t b = 0; b < texelBytes(format); b++)
+			{
+				texels[((kHeight + y) * kWidth + x) * texelBytes(format) + b] = static_cast<uint8_t>(random());
+			}
+		}
+	}
+
+	VK_ASSERT(device->MapMemory(bufferMemory, 0, outputSize + 2 * texelsSize, 0, (void **)&mapped));
+	memset(mapped, 0, outputSize);
+	memcpy(mapped + outputSize, texels.data(), texelsSize);
+	memset(mapped + outputSize + texelsSize, 0, texelsSize);
+	device->UnmapMemory(bufferMemory);
+
+	region.bufferOffset = ((kHeight + offset.y) * kWidth + offset.x) * texelBytes(format);
+	region.bufferRowLength = kWidth;
+	region.bufferImageHeight = kHeight;
+	region.imageSubresource.baseArrayLayer = 1;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = offset;
+	region.imageExtent = extent;
+
+	uploadSampleAndCopyBack(region, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+	expectTexels();
+
+	device->DestroyCommandPool(commandPool);
+	device->DestroyPipeline(pipeline);
+	device->DestroyPipelineLayout(pipelineLayout);
+	device->DestroyDescriptorSetLayout(descriptorSetLayout);
+	device->DestroyDescriptorPool(descriptorPool);
+	device->DestroyShaderModule(shaderModule);
+	device->DestroyBuffer(outputBuffer);
+	device->DestroyBuffer(transferBuffer);
+	device->FreeMemory(bufferMemory);
+	device->DestroySampler(sampler);
+	device->DestroyImageView(imageView);
+	device->DestroyImage(image);
+	device->FreeMemory(imageMemory);
+}
+
+INSTANTIATE_TEST_SUITE_P(TexelFormats, TiledImageTest,
+                         testing::Values(VK_FORMAT_R8_UNORM,
+                                         VK_FORMAT_R8G8_UNORM,
+                                         VK_FORMAT_R8G8B8A8_UNORM,
+                                         VK_FORMAT_B8G8R8A8_UNORM));
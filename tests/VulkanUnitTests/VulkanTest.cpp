@@ -0,0 +1,113 @@
+// Copyright 2021 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "VulkanTest.hpp"
+
+#include "spirv-tools/libspirv.hpp"
+
+#include <sstream>
+#include <string>
+
+Driver VulkanTest::driver;
+
+VulkanTest::VulkanTest(std::vector<const char *> instanceExtensions,
+                       std::vector<const char *> deviceExtensions)
+    : instanceExtensions(std::move(instanceExtensions))
+    , deviceExtensions(std::move(deviceExtensions))
+{
+}
+
+void VulkanTest::SetUpTestSuite()
+{
+	ASSERT_TRUE(driver.loadSwiftShader());
+}
+
+void VulkanTest::TearDownTestSuite()
+{
+	driver.unload();
+}
+
+void VulkanTest::SetUp()
+{
+	const VkInstanceCreateInfo createInfo = {
+		VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,            // sType
+		nullptr,                                           // pNext
+		0,                                                 // flags
+		nullptr,                                           // pApplicationInfo
+		0,                                                 // enabledLayerCount
+		nullptr,                                           // ppEnabledLayerNames
+		static_cast<uint32_t>(instanceExtensions.size()),  // enabledExtensionCount
+		instanceExtensions.data(),                         // ppEnabledExtensionNames
+	};
+
+	VK_ASSERT(driver.vkCreateInstance(&createInfo, nullptr, &instance));
+	ASSERT_TRUE(driver.resolve(instance));
+
+	// SwiftShader's only queue family supports graphics too.
+	VK_ASSERT(Device::CreateComputeDevice(&driver, instance, device, deviceExtensions));
+	ASSERT_TRUE(device->IsValid());
+}
+
+void VulkanTest::TearDown()
+{
+	device.reset(nullptr);
+	driver.vkDestroyInstance(instance, nullptr);
+}
+
+std::vector<uint32_t> compileSpirv(const char *assembly)
+{
+	spvtools::SpirvTools core(SPV_ENV_VULKAN_1_0);
+
+	core.SetMessageConsumer([](spv_message_level_t, const char *, const spv_position_t &p, const char *m) {
+		FAIL() << p.line << ":" << p.column << ": " << m;
+	});
+
+	std::vector<uint32_t> spirv;
+	EXPECT_TRUE(core.Assemble(assembly, &spirv));
+	EXPECT_TRUE(core.Validate(spirv));
+
+	// Warn if the disassembly does not match the source assembly.
+	// We do this as debugging tests in the debugger is often made much harder
+	// if the SSA names (%X) in the debugger do not match the source.
+	std::string disassembled;
+	core.Disassemble(spirv, &disassembled, SPV_BINARY_TO_TEXT_OPTION_NO_HEADER);
+	if(disassembled != assembly)
+	{
+		printf("-- WARNING: Disassembly does not match assembly: ---\n\n");
+
+		auto splitLines = [](const std::string &str) -> std::vector<std::string> {
+			std::stringstream ss(str);
+			std::vector<std::string> out;
+			std::string line;
+			while(std::getline(ss, line, '\n')) { out.push_back(line); }
+			return out;
+		};
+
+		auto srcLines = splitLines(std::string(assembly));
+		auto disLines = splitLines(disassembled);
+
+		for(size_t line = 0; line < srcLines.size() && line < disLines.size(); line++)
+		{
+			auto srcLine = (line < srcLines.size()) ? srcLines[line] : "<missing>";
+			auto disLine = (line < disLines.size()) ? disLines[line] : "<missing>";
+			if(srcLine != disLine)
+			{
+				printf("%zu: '%s' != '%s'\n", line, srcLine.c_str(), disLine.c_str());
+			}
+		}
+		printf("\n\n---\nExpected:\n\n%s", disassembled.c_str());
+	}
+
+	return spirv;
+}
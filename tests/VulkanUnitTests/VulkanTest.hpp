@@ -0,0 +1,57 @@
+// Copyright 2021 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VULKAN_TEST_HPP_
+#define VULKAN_TEST_HPP_
+
+#include "Device.hpp"
+#include "Driver.hpp"
+
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <vector>
+
+#define VK_ASSERT(x) ASSERT_EQ(x, VK_SUCCESS)
+
+// VulkanTest loads SwiftShader once per test suite, and creates an instance
+// and a device for each test. Parameterized tests derive from it and from
+// testing::WithParamInterface.
+class VulkanTest : public testing::Test
+{
+protected:
+	VulkanTest(std::vector<const char *> instanceExtensions = {},
+	           std::vector<const char *> deviceExtensions = {});
+
+	static void SetUpTestSuite();
+	static void TearDownTestSuite();
+
+	void SetUp() override;
+	void TearDown() override;
+
+	static Driver driver;
+
+	VkInstance instance = VK_NULL_HANDLE;
+	std::unique_ptr<Device> device;
+
+private:
+	const std::vector<const char *> instanceExtensions;
+	const std::vector<const char *> deviceExtensions;
+};
+
+// compileSpirv assembles and validates the given SPIR-V assembly, and warns if
+// its disassembly does not match the source.
+std::vector<uint32_t> compileSpirv(const char *assembly);
+
+#endif  // VULKAN_TEST_HPP_
@@ -0,0 +1,273 @@
+// Copyright 2021 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "VulkanTest.hpp"
+
+#include <xcb/xcb.h>
+// Must come after xcb.h
+#include <vulkan/vulkan_xcb.h>
+
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+extern char **environ;
+
+// XcbPresentTest presents to a window of an Xvfb server with the screen depth
+// given by the test parameter. Tests are skipped if Xvfb can't be started.
+class XcbPresentTest : public VulkanTest, public testing::WithParamInterface<int>
+{
+protected:
+	static constexpr uint32_t kWidth = 61;
+	static constexpr uint32_t kHeight = 17;
+
+	XcbPresentTest()
+	    : VulkanTest({ VK_KHR_SURFACE_EXTENSION_NAME, VK_KHR_XCB_SURFACE_EXTENSION_NAME },
+	                 { VK_KHR_SWAPCHAIN_EXTENSION_NAME })
+	{
+	}
+
+	void SetUp() override
+	{
+		startServer();
+		if(IsSkipped() || HasFatalFailure())
+		{
+			return;
+		}
+
+		connection = xcb_connect(display.c_str(), nullptr);
+		ASSERT_EQ(xcb_connection_has_error(connection), 0);
+
+		xcb_screen_t *screen = xcb_setup_roots_iterator(xcb_get_setup(connection)).data;
+
+		window = xcb_generate_id(connection);
+		xcb_create_window(connection, XCB_COPY_FROM_PARENT, window, screen->root, 0, 0, kWidth, kHeight, 0,
+		                  XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual, 0, nullptr);
+		xcb_map_window(connection, window);
+		free(xcb_get_input_focus_reply(connection, xcb_get_input_focus(connection), nullptr));  // Sync
+
+		VulkanTest::SetUp();
+		ASSERT_FALSE(HasFatalFailure());
+
+		auto vkCreateXcbSurfaceKHR = reinterpret_cast<PFN_vkCreateXcbSurfaceKHR>(
+		    driver.vk_icdGetInstanceProcAddr(instance, "vkCreateXcbSurfaceKHR"));
+		ASSERT_NE(vkCreateXcbSurfaceKHR, nullptr);
+
+		const VkXcbSurfaceCreateInfoKHR surfaceInfo = {
+			VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR,  // sType
+			nullptr,                                        // pNext
+			0,                                              // flags
+			connection,                                     // connection
+			window,                                         // window
+		};
+		VK_ASSERT(vkCreateXcbSurfaceKHR(instance, &surfaceInfo, nullptr, &surface));
+
+		VK_ASSERT(device->CreateCommandPool(&commandPool));
+	}
+
+	void TearDown() override
+	{
+		if(device)
+		{
+			device->DestroyCommandPool(commandPool);
+		}
+		if(surface != VK_NULL_HANDLE)
+		{
+			driver.vkDestroySurfaceKHR(instance, surface, nullptr);
+		}
+		if(instance != VK_NULL_HANDLE)
+		{
+			VulkanTest::TearDown();
+		}
+		if(connection)
+		{
+			xcb_disconnect(connection);
+		}
+		if(server > 0)
+		{
+			kill(server, SIGTERM);
+			waitpid(server, nullptr, 0);
+		}
+	}
+
+	// Starts Xvfb, and sets display to its name once it's ready for
+	// connections.
+	void startServer()
+	{
+		int fds[2];
+		ASSERT_EQ(pipe(fds), 0);
+
+		std::string depth = std::to_string(GetParam());
+		std::string displayFd = std::to_string(fds[1]);
+		std::string screen = std::to_string(kWidth) + "x" + std::to_string(kHeight) + "x" + depth;
+		const char *argv[] = { "Xvfb", "-displayfd", displayFd.c_str(), "-screen", "0", screen.c_str(), "-nolisten", "tcp", nullptr };
+
+		int error = posix_spawnp(&server, "Xvfb", nullptr, nullptr, const_cast<char **>(argv), environ);
+		close(fds[1]);
+
+		// Xvfb writes the display number once it's ready, and closes the pipe
+		// when it fails to start.
+		std::string number;
+		pollfd pfd = { fds[0], POLLIN, 0 };
+		char c;
+		while(error == 0 && poll(&pfd, 1, 10000) == 1 && read(fds[0], &c, 1) == 1 && c != '\n')
+		{
+			number += c;
+		}
+		close(fds[0]);
+
+		if(error != 0)
+		{
+			server = 0;
+		}
+
+		if(number.empty())
+		{
+			GTEST_SKIP() << "Xvfb is not available";
+		}
+
+		display = ":" + number;
+	}
+
+	// Clears the next image of swapchain to color, and presents it.
+	void clearAndPresent(VkSwapchainKHR swapchain, const std::vector<VkImage> &images, VkClearColorValue color)
+	{
+		uint32_t index;
+		VK_ASSERT(device->AcquireNextImage(swapchain, &index));
+
+		VkCommandBuffer commandBuffer;
+		VK_ASSERT(device->AllocateCommandBuffer(commandPool, &commandBuffer));
+		VK_ASSERT(device->BeginCommandBuffer(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, commandBuffer));
+
+		const VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		driver.vkCmdClearColorImage(commandBuffer, images[index], VK_IMAGE_LAYOUT_GENERAL, &color, 1, &range);
+
+		VK_ASSERT(driver.vkEndCommandBuffer(commandBuffer));
+		VK_ASSERT(device->QueueSubmitAndWait(commandBuffer));
+		device->FreeCommandBuffer(commandPool, commandBuffer);
+
+		VK_ASSERT(device->QueuePresent(swapchain, index));
+	}
+
+	// Reads the pixels of the window, as 32-bit values of the screen's depth.
+	std::vector<uint32_t> readWindow()
+	{
+		std::vector<uint32_t> pixels;
+
+		xcb_get_image_reply_t *reply = xcb_get_image_reply(
+		    connection, xcb_get_image(connection, XCB_IMAGE_FORMAT_Z_PIXMAP, window, 0, 0, kWidth, kHeight, ~0u), nullptr);
+		EXPECT_NE(reply, nullptr);
+		if(!reply)
+		{
+			return pixels;
+		}
+
+		const xcb_setup_t *setup = xcb_get_setup(connection);
+		int bitsPerPixel = 0;
+		int scanlinePad = 0;
+		for(auto format = xcb_setup_pixmap_formats_iterator(setup); format.rem; xcb_format_next(&format))
+		{
+			if(format.data->depth == reply->depth)
+			{
+				bitsPerPixel = format.data->bits_per_pixel;
+				scanlinePad = format.data->scanline_pad;
+			}
+		}
+
+		const uint8_t *data = xcb_get_image_data(reply);
+		size_t pitch = (kWidth * bitsPerPixel + scanlinePad - 1) / scanlinePad * scanlinePad / 8;
+		EXPECT_EQ(xcb_get_image_data_length(reply), pitch * kHeight);
+
+		for(uint32_t y = 0; y < kHeight; y++)
+		{
+			for(uint32_t x = 0; x < kWidth; x++)
+			{
+				const uint8_t *p = data + y * pitch + x * bitsPerPixel / 8;
+
+				uint32_t pixel = 0;
+				for(int i = 0; i < bitsPerPixel / 8; i++)
+				{
+					int byte = (setup->image_byte_order == XCB_IMAGE_ORDER_LSB_FIRST) ? i : (bitsPerPixel / 8 - 1 - i);
+					pixel |= p[byte] << (8 * i);
+				}
+
+				pixels.push_back(pixel & ((1ull << reply->depth) - 1));
+			}
+		}
+
+		free(reply);
+
+		return pixels;
+	}
+
+	std::string display;
+	pid_t server = 0;
+	xcb_connection_t *connection = nullptr;
+	xcb_window_t window = 0;
+	VkSurfaceKHR surface = VK_NULL_HANDLE;
+	VkCommandPool commandPool = VK_NULL_HANDLE;
+};
+
+// Swapchain images are presented in the format of the window. At depth 24
+// the server reads them from their own memory, and at depth 16 they are
+// converted first.
+TEST_P(XcbPresentTest, ClearAndPresent)
+{
+	VkSwapchainKHR swapchain;
+	VK_ASSERT(device->CreateSwapchain(surface, VK_FORMAT_B8G8R8A8_UNORM, kWidth, kHeight, &swapchain));
+
+	std::vector<VkImage> images;
+	VK_ASSERT(device->GetSwapchainImages(swapchain, images));
+
+	// Each color is presented from a different image if there's more than one.
+	const VkClearColorValue colors[] = {
+		{ { 1.0f, 0.0f, 0.0f, 1.0f } },
+		{ { 0.0f, 1.0f, 0.0f, 1.0f } },
+		{ { 0.0f, 0.0f, 1.0f, 1.0f } },
+	};
+	const uint32_t expected24[] = { 0xFF0000, 0x00FF00, 0x0000FF };
+	const uint32_t expected16[] = { 0xF800, 0x07E0, 0x001F };
+
+	for(int i = 0; i < 3; i++)
+	{
+		clearAndPresent(swapchain, images, colors[i]);
+		ASSERT_FALSE(HasFatalFailure());
+
+		// Waits for the present to be done.
+		uint32_t index;
+		VK_ASSERT(device->AcquireNextImage(swapchain, &index));
+
+		std::vector<uint32_t> pixels = readWindow();
+		ASSERT_EQ(pixels.size(), kWidth * kHeight);
+
+		uint32_t expected = (GetParam() == 24) ? expected24[i] : expected16[i];
+		for(uint32_t j = 0; j < pixels.size(); j++)
+		{
+			ASSERT_EQ(pixels[j], expected) << "pixel (" << (j % kWidth) << ", " << (j / kWidth) << ") of color " << i;
+		}
+
+		// Releases the image again.
+		VK_ASSERT(device->QueuePresent(swapchain, index));
+	}
+
+	device->DestroySwapchain(swapchain);
+}
+
+INSTANTIATE_TEST_SUITE_P(Depths, XcbPresentTest, testing::Values(24, 16));
@@ -338,17 +338,18 @@ void VulkanTester::initialize()
 	queueCreateInfo.queueCount = 1;
 	queueCreateInfo.pQueuePriorities = &defaultQueuePriority;
 
-	std::vector<const char *> deviceExtensions = {
-		VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-	};
+	std::vector<const char *> deviceExtensions = getDeviceExtensions();
+	deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 
 	vk::DeviceCreateInfo deviceCreateInfo;
+	deviceCreateInfo.pNext = getDeviceFeatures();
 	deviceCreateInfo.queueCreateInfoCount = 1;
 	deviceCreateInfo.pQueueCreateInfos = &queueCreateInfo;
 	deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
 	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
 
 	device = physicalDevice.createDevice(deviceCreateInfo, nullptr);
+	VULKAN_HPP_DEFAULT_DISPATCHER.init(device);
 
 	queue = device.getQueue(queueFamilyIndex, 0);
 }
@@ -40,6 +40,12 @@ private:
 	vk::DebugUtilsMessengerEXT debugReport;
 
 protected:
+	// Returns the device extensions to enable, in addition to the swapchain.
+	virtual std::vector<const char *> getDeviceExtensions() const { return {}; }
+
+	// Returns the chain of feature structures to enable on the device, or nullptr.
+	virtual const void *getDeviceFeatures() const { return nullptr; }
+
 	const uint32_t queueFamilyIndex = 0;
 
 	vk::Instance instance;  // Owning handle